@@ -0,0 +1,420 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Checksum.hpp"
+#include "Assertion.hpp"
+#include <string.h>
+#include <zlib.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define WCDB_CHECKSUM_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+#define WCDB_CHECKSUM_NEON 1
+#include <arm_neon.h>
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+#endif
+
+namespace WCDB {
+
+namespace Checksum {
+
+#pragma mark - WAL
+/*
+ The checksum of SQLite WAL is linear. For each pair of words, (s0, s1) becomes M * (s0, s1) + (x0, x0 + x1), where M = [[1, 1], [1, 2]].
+ So a block of pairs can be folded into two sums of the products of words and the coefficients derived from the powers of M, all in modulo 2^32.
+ The sums are vectorized, and then (s0, s1) = M^n * (s0, s1) + (sum0, sum1), where n is the number of pairs in block.
+ */
+static constexpr const size_t walPairsPerBlock = 64;
+static constexpr const size_t walWordsPerBlock = walPairsPerBlock * 2;
+static constexpr const size_t walBytesPerBlock = walWordsPerBlock * sizeof(uint32_t);
+
+struct WALCoefficients {
+    WALCoefficients()
+    {
+        // M^0
+        uint32_t p = 1, q = 0, r = 0, s = 1;
+        for (size_t m = 0; m < walPairsPerBlock; ++m) {
+            // The pair at j is followed by m = walPairsPerBlock - 1 - j pairs.
+            size_t j = walPairsPerBlock - 1 - m;
+            first[2 * j] = p + q;
+            first[2 * j + 1] = q;
+            second[2 * j] = r + s;
+            second[2 * j + 1] = s;
+
+            uint32_t np = p + q, nq = p + 2 * q, nr = r + s, ns = r + 2 * s;
+            p = np, q = nq, r = nr, s = ns;
+        }
+        m00 = p, m01 = q, m10 = r, m11 = s;
+    }
+    alignas(32) uint32_t first[walWordsPerBlock];
+    alignas(32) uint32_t second[walWordsPerBlock];
+    // M^walPairsPerBlock
+    uint32_t m00, m01, m10, m11;
+};
+
+static const WALCoefficients &walCoefficients()
+{
+    // It's not allocated by new since it's over-aligned.
+    static const WALCoefficients s_coefficients;
+    return s_coefficients;
+}
+
+static inline void
+foldWALBlock(const WALCoefficients &coefficients, uint32_t sum0, uint32_t sum1, uint32_t &s0, uint32_t &s1)
+{
+    uint32_t n0 = coefficients.m00 * s0 + coefficients.m01 * s1 + sum0;
+    uint32_t n1 = coefficients.m10 * s0 + coefficients.m11 * s1 + sum1;
+    s0 = n0;
+    s1 = n1;
+}
+
+static inline uint32_t loadWord(const unsigned char *buffer, bool nativeByteOrder)
+{
+    uint32_t word;
+    memcpy(&word, buffer, sizeof(uint32_t));
+    if (!nativeByteOrder) {
+        word = ((word & 0x000000FF) << 24) + ((word & 0x0000FF00) << 8)
+               + ((word & 0x00FF0000) >> 8) + ((word & 0xFF000000) >> 24);
+    }
+    return word;
+}
+
+typedef void (*WALKernel)(const unsigned char *buffer,
+                          size_t numberOfBlocks,
+                          bool nativeByteOrder,
+                          uint32_t &s0,
+                          uint32_t &s1);
+
+#if WCDB_CHECKSUM_X86
+__attribute__((target("avx2"))) static void walAVX2(const unsigned char *buffer,
+                                                    size_t numberOfBlocks,
+                                                    bool nativeByteOrder,
+                                                    uint32_t &s0,
+                                                    uint32_t &s1)
+{
+    const WALCoefficients &coefficients = walCoefficients();
+    const __m256i swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (size_t block = 0; block < numberOfBlocks; ++block, buffer += walBytesPerBlock) {
+        __m256i sum0 = _mm256_setzero_si256();
+        __m256i sum1 = _mm256_setzero_si256();
+        for (size_t i = 0; i < walWordsPerBlock; i += 8) {
+            __m256i words = _mm256_loadu_si256((const __m256i *) (buffer + i * sizeof(uint32_t)));
+            if (!nativeByteOrder) {
+                words = _mm256_shuffle_epi8(words, swap);
+            }
+            sum0 = _mm256_add_epi32(
+            sum0,
+            _mm256_mullo_epi32(words, _mm256_load_si256((const __m256i *) &coefficients.first[i])));
+            sum1 = _mm256_add_epi32(
+            sum1,
+            _mm256_mullo_epi32(words, _mm256_load_si256((const __m256i *) &coefficients.second[i])));
+        }
+        __m128i half0 = _mm_add_epi32(_mm256_castsi256_si128(sum0), _mm256_extracti128_si256(sum0, 1));
+        __m128i half1 = _mm_add_epi32(_mm256_castsi256_si128(sum1), _mm256_extracti128_si256(sum1, 1));
+        // [a0+a1+a2+a3, b0+b1+b2+b3, ...]
+        __m128i sums = _mm_hadd_epi32(_mm_hadd_epi32(half0, half1), _mm_setzero_si128());
+        foldWALBlock(coefficients,
+                     (uint32_t) _mm_cvtsi128_si32(sums),
+                     (uint32_t) _mm_extract_epi32(sums, 1),
+                     s0,
+                     s1);
+    }
+}
+
+__attribute__((target("sse4.1"))) static void walSSE41(const unsigned char *buffer,
+                                                       size_t numberOfBlocks,
+                                                       bool nativeByteOrder,
+                                                       uint32_t &s0,
+                                                       uint32_t &s1)
+{
+    const WALCoefficients &coefficients = walCoefficients();
+    const __m128i swap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (size_t block = 0; block < numberOfBlocks; ++block, buffer += walBytesPerBlock) {
+        __m128i sum0 = _mm_setzero_si128();
+        __m128i sum1 = _mm_setzero_si128();
+        for (size_t i = 0; i < walWordsPerBlock; i += 4) {
+            __m128i words = _mm_loadu_si128((const __m128i *) (buffer + i * sizeof(uint32_t)));
+            if (!nativeByteOrder) {
+                words = _mm_shuffle_epi8(words, swap);
+            }
+            sum0 = _mm_add_epi32(
+            sum0, _mm_mullo_epi32(words, _mm_load_si128((const __m128i *) &coefficients.first[i])));
+            sum1 = _mm_add_epi32(
+            sum1, _mm_mullo_epi32(words, _mm_load_si128((const __m128i *) &coefficients.second[i])));
+        }
+        __m128i sums = _mm_hadd_epi32(_mm_hadd_epi32(sum0, sum1), _mm_setzero_si128());
+        foldWALBlock(coefficients,
+                     (uint32_t) _mm_cvtsi128_si32(sums),
+                     (uint32_t) _mm_extract_epi32(sums, 1),
+                     s0,
+                     s1);
+    }
+}
+#endif
+
+#if WCDB_CHECKSUM_NEON
+static inline uint32_t sumOfLanes(uint32x4_t vector)
+{
+    uint32x2_t sum = vadd_u32(vget_low_u32(vector), vget_high_u32(vector));
+    return vget_lane_u32(vpadd_u32(sum, sum), 0);
+}
+
+static void walNEON(const unsigned char *buffer,
+                    size_t numberOfBlocks,
+                    bool nativeByteOrder,
+                    uint32_t &s0,
+                    uint32_t &s1)
+{
+    const WALCoefficients &coefficients = walCoefficients();
+    for (size_t block = 0; block < numberOfBlocks; ++block, buffer += walBytesPerBlock) {
+        uint32x4_t sum0 = vdupq_n_u32(0);
+        uint32x4_t sum1 = vdupq_n_u32(0);
+        for (size_t i = 0; i < walWordsPerBlock; i += 4) {
+            uint8x16_t bytes = vld1q_u8(buffer + i * sizeof(uint32_t));
+            if (!nativeByteOrder) {
+                bytes = vrev32q_u8(bytes);
+            }
+            uint32x4_t words = vreinterpretq_u32_u8(bytes);
+            sum0 = vmlaq_u32(sum0, words, vld1q_u32(&coefficients.first[i]));
+            sum1 = vmlaq_u32(sum1, words, vld1q_u32(&coefficients.second[i]));
+        }
+        foldWALBlock(coefficients, sumOfLanes(sum0), sumOfLanes(sum1), s0, s1);
+    }
+}
+#endif
+
+static WALKernel getWALKernel()
+{
+    static WALKernel s_kernel = []() -> WALKernel {
+#if WCDB_CHECKSUM_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return walAVX2;
+        }
+        if (__builtin_cpu_supports("sse4.1")) {
+            return walSSE41;
+        }
+#elif WCDB_CHECKSUM_NEON
+        return walNEON;
+#endif
+        return nullptr;
+    }();
+    return s_kernel;
+}
+
+std::pair<uint32_t, uint32_t> wal(const unsigned char *buffer,
+                                  size_t size,
+                                  const std::pair<uint32_t, uint32_t> &checksum,
+                                  bool nativeByteOrder)
+{
+    WCTAssert((size & 0x00000007) == 0);
+    uint32_t s0 = checksum.first;
+    uint32_t s1 = checksum.second;
+
+    WALKernel kernel = getWALKernel();
+    if (kernel != nullptr && size >= walBytesPerBlock) {
+        size_t numberOfBlocks = size / walBytesPerBlock;
+        kernel(buffer, numberOfBlocks, nativeByteOrder, s0, s1);
+        buffer += numberOfBlocks * walBytesPerBlock;
+        size -= numberOfBlocks * walBytesPerBlock;
+    }
+
+    const unsigned char *end = buffer + size;
+    for (; buffer < end; buffer += 2 * sizeof(uint32_t)) {
+        s0 += loadWord(buffer, nativeByteOrder) + s1;
+        s1 += loadWord(buffer + sizeof(uint32_t), nativeByteOrder) + s0;
+    }
+    return { s0, s1 };
+}
+
+#pragma mark - CRC32
+typedef uint32_t (*CRC32Kernel)(uint32_t crc, const unsigned char *buffer, size_t size);
+
+#if WCDB_CHECKSUM_X86
+/*
+ Folding with carry-less multiplication, from "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction" of Intel.
+ The constants are of the bit-reflected polynomial 0xEDB88320, which is the one of zlib.
+ It takes the inverted crc, and the size should be a multiple of 16 and no less than 64.
+ */
+__attribute__((target("pclmul,sse4.1"))) static uint32_t
+crc32FoldPCLMUL(uint32_t crc, const unsigned char *buffer, size_t size)
+{
+    alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+    alignas(16) static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+    alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+    alignas(16) static const uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+    WCTAssert(size >= 64 && size % 16 == 0);
+
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+    x1 = _mm_loadu_si128((const __m128i *) (buffer + 0x00));
+    x2 = _mm_loadu_si128((const __m128i *) (buffer + 0x10));
+    x3 = _mm_loadu_si128((const __m128i *) (buffer + 0x20));
+    x4 = _mm_loadu_si128((const __m128i *) (buffer + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int) crc));
+    x0 = _mm_load_si128((const __m128i *) k1k2);
+    buffer += 64;
+    size -= 64;
+
+    // Fold by 4 blocks of 16 bytes in parallel.
+    while (size >= 64) {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+        y5 = _mm_loadu_si128((const __m128i *) (buffer + 0x00));
+        y6 = _mm_loadu_si128((const __m128i *) (buffer + 0x10));
+        y7 = _mm_loadu_si128((const __m128i *) (buffer + 0x20));
+        y8 = _mm_loadu_si128((const __m128i *) (buffer + 0x30));
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+
+        buffer += 64;
+        size -= 64;
+    }
+
+    // Fold into 128 bits.
+    x0 = _mm_load_si128((const __m128i *) k3k4);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    // Fold the remaining blocks of 16 bytes.
+    while (size >= 16) {
+        x2 = _mm_loadu_si128((const __m128i *) buffer);
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+        buffer += 16;
+        size -= 16;
+    }
+
+    // Fold 128 bits into 64 bits.
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+
+    x0 = _mm_loadl_epi64((const __m128i *) k5k0);
+
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction into 32 bits.
+    x0 = _mm_load_si128((const __m128i *) poly);
+
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return (uint32_t) _mm_extract_epi32(x1, 1);
+}
+
+static uint32_t crc32PCLMUL(uint32_t crc, const unsigned char *buffer, size_t size)
+{
+    if (size >= 64) {
+        size_t folded = size & ~(size_t) 15;
+        crc = ~crc32FoldPCLMUL(~crc, buffer, folded);
+        buffer += folded;
+        size -= folded;
+    }
+    return size > 0 ? (uint32_t)::crc32(crc, buffer, (uInt) size) : crc;
+}
+#endif
+
+#if WCDB_CHECKSUM_NEON && defined(__ARM_FEATURE_CRC32)
+// The crc32 instructions of ARMv8 are of the same polynomial as zlib.
+static uint32_t crc32ARM(uint32_t crc, const unsigned char *buffer, size_t size)
+{
+    crc = ~crc;
+    for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), buffer += sizeof(uint64_t)) {
+        uint64_t value;
+        memcpy(&value, buffer, sizeof(uint64_t));
+        crc = __crc32d(crc, value);
+    }
+    for (; size > 0; --size, ++buffer) {
+        crc = __crc32b(crc, *buffer);
+    }
+    return ~crc;
+}
+#endif
+
+static CRC32Kernel getCRC32Kernel()
+{
+    static CRC32Kernel s_kernel = []() -> CRC32Kernel {
+#if WCDB_CHECKSUM_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1")) {
+            return crc32PCLMUL;
+        }
+#elif WCDB_CHECKSUM_NEON && defined(__ARM_FEATURE_CRC32)
+        return crc32ARM;
+#endif
+        return nullptr;
+    }();
+    return s_kernel;
+}
+
+uint32_t crc32(uint32_t crc, const unsigned char *buffer, size_t size)
+{
+    CRC32Kernel kernel = getCRC32Kernel();
+    if (kernel != nullptr) {
+        return kernel(crc, buffer, size);
+    }
+    // zlib takes the size in 32 bits.
+    while (size > UINT32_MAX) {
+        crc = (uint32_t)::crc32(crc, buffer, UINT32_MAX);
+        buffer += UINT32_MAX;
+        size -= UINT32_MAX;
+    }
+    return (uint32_t)::crc32(crc, buffer, (uInt) size);
+}
+
+} //namespace Checksum
+
+} //namespace WCDB
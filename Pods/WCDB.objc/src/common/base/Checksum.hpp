@@ -0,0 +1,44 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+namespace WCDB {
+
+// Checksum kernels over pages. The vectorized ones are dispatched at runtime, and they are bit-identical to the scalar ones.
+namespace Checksum {
+
+// It's the same as `crc32` of zlib.
+uint32_t crc32(uint32_t crc, const unsigned char *buffer, size_t size);
+
+// Checksum of SQLite WAL, which reads the buffer as 32-bit words in native or swapped byte order.
+// The size should be a multiple of 8.
+std::pair<uint32_t, uint32_t> wal(const unsigned char *buffer,
+                                  size_t size,
+                                  const std::pair<uint32_t, uint32_t> &checksum,
+                                  bool nativeByteOrder);
+
+} //namespace Checksum
+
+} //namespace WCDB
@@ -29,6 +29,7 @@
 #include "Notifier.hpp"
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #ifndef _WIN32
 #include <sys/mman.h>
 #else
@@ -54,6 +55,7 @@ FileHandle::FileHandle(const UnsafeStringView &path)
 , m_mode(Mode::None)
 , m_errorIgnorable(false)
 , m_fileSize(-1)
+, m_mapProbed(false)
 {
 }
 
@@ -66,6 +68,7 @@ FileHandle::FileHandle(FileHandle &&other)
 , m_mode(other.m_mode)
 , m_errorIgnorable(false)
 , m_fileSize(other.m_fileSize)
+, m_mapProbed(other.m_mapProbed)
 {
     other.m_fd = -1;
     other.m_mode = Mode::None;
@@ -73,7 +76,7 @@ FileHandle::FileHandle(FileHandle &&other)
 
 FileHandle::~FileHandle()
 {
-    WCTAssert(!isOpened() || m_mode != Mode::OverWrite);
+    WCTAssert(!isOpened() || (m_mode != Mode::OverWrite && m_mode != Mode::ReadWrite));
     close();
 }
 
@@ -96,6 +99,10 @@ bool FileHandle::open(Mode mode)
         GetPathString(path), O_BINARY | O_CREAT | O_WRONLY | O_TRUNC, FileFullAccess);
         break;
     }
+    case Mode::ReadWrite: {
+        m_fd = wcdb_open(GetPathString(path), O_RDWR | O_BINARY);
+        break;
+    }
     default:
         WCTAssert(mode == Mode::ReadOnly);
         m_fd = wcdb_open(GetPathString(path), O_RDONLY | O_BINARY);
@@ -130,6 +137,7 @@ void FileHandle::close()
         WCDB_UNUSED(ret);
         m_fd = -1;
     }
+    m_mapProbed = false;
 }
 
 ssize_t FileHandle::size()
@@ -145,6 +153,21 @@ ssize_t FileHandle::size()
 }
 
 Data FileHandle::read(size_t size)
+{
+    return read(0, size);
+}
+
+bool FileHandle::write(const UnsafeData &unsafeData)
+{
+    if (!write(0, unsafeData)) {
+        return false;
+    }
+    m_fileSize = unsafeData.size();
+    return true;
+}
+
+#pragma mark - Positional
+Data FileHandle::read(offset_t offset, size_t size)
 {
     if (size == 0) {
         return Data::null();
@@ -154,98 +177,188 @@ Data FileHandle::read(size_t size)
     if (data.empty()) {
         return Data::null();
     }
-    offset_t offset = (offset_t) wcdb_lseek(m_fd, 0, SEEK_SET);
-    if (offset != 0) {
+    ssize_t got = positionalRead(data.buffer(), size, offset);
+    if (got == (ssize_t) size) {
+        return data;
+    }
+    if (got < 0) {
+#ifndef _WIN32
+        auto err = errno;
+        if (err == EDEVERR || err == EILSEQ || err == EINVAL) {
+            setThreadedError("This file may be permanently damaged");
+            return Data::null();
+        }
+#endif
         setThreadedError();
         return Data::null();
     }
-    ssize_t got;
-    size_t prior = 0;
-    size_t readSize = size;
-    unsigned char *buffer = data.buffer();
-    do {
-        got = ::read(m_fd, buffer, readSize);
-        if (got == readSize) {
-            break;
+    notifyShortIO("Short read.");
+    return data.subdata(got);
+}
+
+bool FileHandle::write(offset_t offset, const UnsafeData &unsafeData)
+{
+    WCTAssert(isOpened());
+    size_t size = unsafeData.size();
+    ssize_t wrote = positionalWrite(unsafeData.buffer(), size, offset);
+    if (wrote == (ssize_t) size) {
+        if (m_fileSize >= 0 && offset + (offset_t) size > m_fileSize) {
+            m_fileSize = offset + size;
         }
+        return true;
+    }
+    m_fileSize = -1;
+    if (wrote < 0) {
+        setThreadedError();
+    } else {
+        notifyShortIO("Short write.");
+    }
+    return false;
+}
+
+ssize_t FileHandle::positionalRead(unsigned char *buffer, size_t size, offset_t offset) const
+{
+    size_t prior = 0;
+    while (prior < size) {
 #ifndef _WIN32
-        if (got <= 0) {
-            auto err = errno;
-            if (err == EDEVERR || err == EILSEQ || err == EINVAL) {
-                setThreadedError("This file may be permanently damaged");
-                prior = 0;
-                break;
-            }
+        ssize_t got = ::pread(m_fd, buffer + prior, size - prior, (off_t) (offset + prior));
+#else
+        // Windows has no pread. It's not safe to be called concurrently.
+        ssize_t got = -1;
+        if (wcdb_lseek(m_fd, offset + prior, SEEK_SET) == offset + prior) {
+            got = ::read(m_fd, buffer + prior, (unsigned int) (size - prior));
         }
 #endif
         if (got < 0) {
             if (errno == EINTR) {
-                got = 1;
                 continue;
             }
-            prior = 0;
-            setThreadedError();
+            return -1;
+        } else if (got == 0) {
             break;
-        } else if (got > 0) {
-            readSize -= got;
-            prior += got;
-            buffer = got + buffer;
         }
-    } while (got > 0);
-    if (got + prior == size) {
-        return data;
+        prior += got;
     }
-    Error error;
-    error.level = m_errorIgnorable ? Error::Level::Warning : Error::Level::Error;
-    error.setSystemCode(EIO, Error::Code::IOError, "Short read.");
-    error.infos.insert_or_assign(ErrorStringKeyAssociatePath, path);
-    Notifier::shared().notify(error);
-    SharedThreadedErrorProne::setThreadedError(std::move(error));
-    return data.subdata(got + prior);
+    return prior;
 }
 
-bool FileHandle::write(const UnsafeData &unsafeData)
+ssize_t FileHandle::positionalWrite(const unsigned char *buffer, size_t size, offset_t offset)
 {
-    WCTAssert(isOpened());
-    ssize_t wrote;
-    ssize_t prior = 0;
-    size_t size = unsafeData.size();
-    const unsigned char *buffer = unsafeData.buffer();
-    offset_t offset = (offset_t) wcdb_lseek(m_fd, 0, SEEK_SET);
-    if (offset != 0) {
-        setThreadedError();
-        return false;
-    }
-    do {
-        wrote = ::write(m_fd, buffer, size);
-        if (wrote == size) {
-            break;
+    size_t prior = 0;
+    while (prior < size) {
+#ifndef _WIN32
+        ssize_t wrote = ::pwrite(m_fd, buffer + prior, size - prior, (off_t) (offset + prior));
+#else
+        ssize_t wrote = -1;
+        if (wcdb_lseek(m_fd, offset + prior, SEEK_SET) == offset + prior) {
+            wrote = ::write(m_fd, buffer + prior, (unsigned int) (size - prior));
         }
+#endif
         if (wrote < 0) {
             if (errno == EINTR) {
-                wrote = 1;
                 continue;
             }
-            setThreadedError();
+            return -1;
+        } else if (wrote == 0) {
             break;
-        } else if (wrote > 0) {
-            size -= wrote;
-            prior += wrote;
-            buffer = wrote + buffer;
         }
-    } while (wrote > 0);
-    if (wrote + prior == unsafeData.size()) {
-        m_fileSize = unsafeData.size();
-        return true;
+        prior += wrote;
     }
-    m_fileSize = -1;
+    return prior;
+}
+
+void FileHandle::notifyShortIO(const char *message)
+{
     Error error;
     error.level = m_errorIgnorable ? Error::Level::Warning : Error::Level::Error;
-    error.setSystemCode(EIO, Error::Code::IOError, "Short write.");
+    error.setSystemCode(EIO, Error::Code::IOError, message);
     error.infos.insert_or_assign(ErrorStringKeyAssociatePath, path);
     Notifier::shared().notify(error);
     SharedThreadedErrorProne::setThreadedError(std::move(error));
-    return false;
+}
+
+#pragma mark - Advice
+void FileHandle::advise(offset_t offset, size_t size, Advice advice)
+{
+    WCTAssert(isOpened());
+#if defined(__linux__) || defined(__ANDROID__)
+    int flag = POSIX_FADV_NORMAL;
+    switch (advice) {
+    case Advice::Sequential:
+        flag = POSIX_FADV_SEQUENTIAL;
+        break;
+    case Advice::Random:
+        flag = POSIX_FADV_RANDOM;
+        break;
+    case Advice::WillNeed:
+        flag = POSIX_FADV_WILLNEED;
+        break;
+    case Advice::DontNeed:
+        flag = POSIX_FADV_DONTNEED;
+        break;
+    default:
+        WCTAssert(advice == Advice::Normal);
+        break;
+    }
+    ::posix_fadvise(m_fd, (off_t) offset, (off_t) size, flag);
+#elif defined(__APPLE__)
+    switch (advice) {
+    case Advice::WillNeed: {
+        struct radvisory advisory;
+        advisory.ra_offset = (off_t) offset;
+        advisory.ra_count = (int) std::min<size_t>(size, INT_MAX);
+        ::fcntl(m_fd, F_RDADVISE, &advisory);
+    } break;
+    case Advice::Random:
+        ::fcntl(m_fd, F_RDAHEAD, 0);
+        break;
+    case Advice::Normal:
+    case Advice::Sequential:
+        ::fcntl(m_fd, F_RDAHEAD, 1);
+        break;
+    default:
+        break;
+    }
+#else
+    WCDB_UNUSED(offset);
+    WCDB_UNUSED(size);
+    WCDB_UNUSED(advice);
+#endif
+}
+
+void FileHandle::advise(const MappedData &mapped, Advice advice)
+{
+#ifndef _WIN32
+    if (mapped.size() == 0) {
+        return;
+    }
+    size_t pageSize = memoryPageSize();
+    uintptr_t begin = (uintptr_t) mapped.buffer();
+    uintptr_t alignedBegin = begin - begin % pageSize;
+    int flag = MADV_NORMAL;
+    switch (advice) {
+    case Advice::Sequential:
+        flag = MADV_SEQUENTIAL;
+        break;
+    case Advice::Random:
+        flag = MADV_RANDOM;
+        break;
+    case Advice::WillNeed:
+        flag = MADV_WILLNEED;
+        break;
+    case Advice::DontNeed:
+        // The pages of shared file mapping are reloaded from file on next access.
+        flag = MADV_DONTNEED;
+        break;
+    default:
+        WCTAssert(advice == Advice::Normal);
+        break;
+    }
+    ::madvise((void *) alignedBegin, mapped.size() + (begin - alignedBegin), flag);
+#else
+    WCDB_UNUSED(mapped);
+    WCDB_UNUSED(advice);
+#endif
 }
 
 #ifdef _WIN32
@@ -287,11 +400,12 @@ MappedData FileHandle::map(offset_t offset, size_t length, SharedHighWater highW
 #ifndef _WIN32
 
     // Avoid to mmap permanently corrupted files
-    if (offset == 0) {
-        auto testData = read(4);
+    if (offset == 0 && !m_mapProbed) {
+        auto testData = read(0, 4);
         if (testData.size() <= 0) {
             return MappedData::null();
         }
+        m_mapProbed = true;
     }
 
     void *mapped = mmap(
@@ -59,11 +59,14 @@ public:
         None = 0,
         OverWrite = 1,
         ReadOnly = 2,
+        // Read and write the existing file in place without truncating it.
+        ReadWrite = 3,
     };
     bool open(Mode mode);
     bool isOpened() const;
     void close();
     ssize_t size();
+    // Read/write the whole file from the beginning.
     Data read(size_t size);
     bool write(const UnsafeData &unsafeData);
 
@@ -72,6 +75,31 @@ protected:
     bool m_errorIgnorable;
     ssize_t m_fileSize;
 
+#pragma mark - Positional
+public:
+    // They don't change the offset of the file descriptor, so they can be called concurrently except on Windows.
+    Data read(offset_t offset, size_t size);
+    bool write(offset_t offset, const UnsafeData &unsafeData);
+
+protected:
+    // They return the number of bytes read/written, which is less than size at the end of file, or -1 with errno set.
+    ssize_t positionalRead(unsigned char *buffer, size_t size, offset_t offset) const;
+    ssize_t positionalWrite(const unsigned char *buffer, size_t size, offset_t offset);
+    void notifyShortIO(const char *message);
+
+#pragma mark - Advice
+public:
+    enum class Advice {
+        Normal,
+        Sequential,
+        Random,
+        WillNeed,
+        DontNeed,
+    };
+    // Hints of the access pattern for readahead. They are best-effort and never fail. A size of 0 means to the end of file.
+    void advise(offset_t offset, size_t size, Advice advice);
+    static void advise(const MappedData &mapped, Advice advice);
+
 #pragma mark - Memory map
 public:
     MappedData map(offset_t offset, size_t size, SharedHighWater highWater = nullptr);
@@ -79,6 +107,8 @@ public:
 
 protected:
     static const size_t &memoryPageSize();
+    // Whether the head of file is readable, which is checked once before the first map.
+    bool m_mapProbed;
 
 #pragma mark - Error
 public:
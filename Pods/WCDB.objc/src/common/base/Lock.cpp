@@ -26,6 +26,8 @@
 #include "Assertion.hpp"
 #include "CrossPlatform.h"
 #include <condition_variable>
+#include <cstdint>
+#include <new>
 
 namespace WCDB {
 
@@ -178,58 +180,289 @@ bool SharedLock::writeSafety() const
     return level() >= SharedLock::Level::Write;
 }
 
+#pragma mark - Striped Shared Lock
+StripedSharedLock::StripedSharedLock()
+: m_stripesBuffer(new unsigned char[sizeof(Stripe) * numberOfStripes + cacheLineSize])
+, m_stripes(nullptr)
+, m_activeWriters(0)
+, m_writers(0)
+, m_pendingReaders(0)
+{
+    uintptr_t address = reinterpret_cast<uintptr_t>(m_stripesBuffer.get());
+    address += cacheLineSize - address % cacheLineSize;
+    m_stripes = reinterpret_cast<Stripe *>(address);
+    for (int i = 0; i < numberOfStripes; ++i) {
+        new (&m_stripes[i]) Stripe();
+        m_stripes[i].readers.store(0, std::memory_order_relaxed);
+    }
+}
+
+StripedSharedLock::~StripedSharedLock()
+{
+    WCTRemedialAssert(m_writers == 0 && m_pendingWriters.size() == 0, "Unpaired lock", ;);
+    WCTRemedialAssert(numberOfReaders() == 0 && m_pendingReaders == 0,
+                      "Unpaired shared lock",
+                      ;);
+}
+
+int StripedSharedLock::threadedStripe()
+{
+    static std::atomic<unsigned int> *s_nextStripe = new std::atomic<unsigned int>(0);
+    thread_local int s_stripe
+    = (int) (s_nextStripe->fetch_add(1, std::memory_order_relaxed) % numberOfStripes);
+    return s_stripe;
+}
+
+int StripedSharedLock::numberOfReaders() const
+{
+    int readers = 0;
+    for (int i = 0; i < numberOfStripes; ++i) {
+        readers += m_stripes[i].readers.load();
+    }
+    return readers;
+}
+
+StripedSharedLock::ThreadedReaders &StripedSharedLock::threadedReadersOfAllLocks()
+{
+    thread_local std::unique_ptr<ThreadedReaders> s_readers(new ThreadedReaders());
+    return *s_readers;
+}
+
+int StripedSharedLock::threadedReaders() const
+{
+    for (const auto &item : threadedReadersOfAllLocks()) {
+        if (item.first == this) {
+            return item.second;
+        }
+    }
+    return 0;
+}
+
+void StripedSharedLock::increaseThreadedReaders()
+{
+    ThreadedReaders &readers = threadedReadersOfAllLocks();
+    for (auto &item : readers) {
+        if (item.first == this) {
+            ++item.second;
+            return;
+        }
+    }
+    readers.emplace_back(this, 1);
+}
+
+bool StripedSharedLock::decreaseThreadedReaders()
+{
+    ThreadedReaders &readers = threadedReadersOfAllLocks();
+    for (auto iter = readers.begin(); iter != readers.end(); ++iter) {
+        if (iter->first == this) {
+            WCTAssert(iter->second > 0);
+            if (--iter->second == 0) {
+                *iter = readers.back();
+                readers.pop_back();
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void StripedSharedLock::lockShared()
+{
+    Stripe &stripe = m_stripes[threadedStripe()];
+    // Both the increment of stripe and the check of writers are sequentially consistent.
+    // So that either the reader sees the writer here, or the writer sees the reader while draining.
+    stripe.readers.fetch_add(1);
+    if (m_activeWriters.load() == 0) {
+        increaseThreadedReaders();
+        return;
+    }
+    releaseStripe(stripe);
+    lockSharedSlowly(stripe);
+}
+
+void StripedSharedLock::lockSharedSlowly(Stripe &stripe)
+{
+    std::unique_lock<std::mutex> lockGuard(m_lock);
+    if (m_writers > 0 ? !m_locking.isCurrentThread() :
+                        (m_pendingWriters.size() > 0 && threadedReaders() == 0)) {
+        // If it is locked but not current thread, it should wait for the write lock.
+        // If it is not locked but there is someone pending to lock and current thread is not already shared locked, it should wait for the pending lock to avoid the pending lock starve.
+        ++m_pendingReaders;
+        do {
+            m_conditionalReaders.wait(lockGuard);
+        } while (m_writers > 0 || m_pendingWriters.size() > 0);
+        --m_pendingReaders;
+    }
+    // it's already locked by current thread
+    // or it's already shared locked by current thread
+    // or it's not locked
+    WCTAssert(m_locking.isCurrentThread() || threadedReaders() > 0 || m_writers == 0);
+    stripe.readers.fetch_add(1);
+    increaseThreadedReaders();
+}
+
+void StripedSharedLock::releaseStripe(Stripe &stripe)
+{
+    stripe.readers.fetch_sub(1);
+    if (m_activeWriters.load() > 0) {
+        // The pending writer may be draining readers.
+        std::unique_lock<std::mutex> lockGuard(m_lock);
+        if (m_writers == 0 && m_pendingWriters.size() > 0) {
+            m_conditionalWriters.notify_all();
+        }
+    }
+}
+
+void StripedSharedLock::unlockShared()
+{
+    WCTRemedialAssert(decreaseThreadedReaders(), "Unpaired unlock shared.", return;);
+    // Stripe is chosen by thread so the one of locking is also the one of unlocking.
+    releaseStripe(m_stripes[threadedStripe()]);
+}
+
+void StripedSharedLock::lock()
+{
+    WCTRemedialAssert(threadedReaders() == 0, "Upgrade lock is not supported.", return;);
+
+    Thread current = Thread::current();
+    std::unique_lock<std::mutex> lockGuard(m_lock);
+    if (!m_locking.equal(current)) {
+        m_pendingWriters.push_back(current);
+        m_activeWriters.fetch_add(1);
+        while (m_writers > 0 || !m_pendingWriters.front().equal(current)
+               || numberOfReaders() > 0) {
+            m_conditionalWriters.wait(lockGuard);
+        }
+        WCTAssert(m_pendingWriters.front().isCurrentThread());
+        m_pendingWriters.pop_front();
+    }
+    // it's already locked by current thread
+    // or it's not locked and it's not shared locked
+    WCTAssert(m_locking.isCurrentThread() || (m_writers == 0 && numberOfReaders() == 0));
+    ++m_writers;
+    m_locking = Thread::current();
+}
+
+bool StripedSharedLock::isLocked()
+{
+    return m_writers > 0;
+}
+
+void StripedSharedLock::unlock()
+{
+    WCTRemedialAssert(threadedReaders() == 0, "Downgrade lock is not supported.", return;);
+
+    std::unique_lock<std::mutex> lockGuard(m_lock);
+    WCTRemedialAssert(m_locking.isCurrentThread(), "Unpaired unlock.", return;);
+    WCTAssert(numberOfReaders() == 0);
+    WCTAssert(m_writers > 0);
+    if (--m_writers == 0) {
+        m_locking = nullptr;
+        m_activeWriters.fetch_sub(1);
+        // write lock first
+        if (m_pendingWriters.size() > 0) {
+            m_conditionalWriters.notify_all();
+        } else if (m_pendingReaders > 0) {
+            m_conditionalReaders.notify_all();
+        }
+    }
+}
+
+StripedSharedLock::Level StripedSharedLock::level() const
+{
+    std::unique_lock<std::mutex> lockGuard(m_lock);
+    if (m_locking.isCurrentThread()) {
+        return Level::Write;
+    } else if (threadedReaders() > 0) {
+        return Level::Read;
+    }
+    return Level::None;
+}
+
+bool StripedSharedLock::readSafety() const
+{
+    return level() >= Level::Read;
+}
+
+bool StripedSharedLock::writeSafety() const
+{
+    return level() >= Level::Write;
+}
+
 #pragma mark - Lock Guard
-LockGuard::LockGuard(const std::nullptr_t &) : m_lock(nullptr)
+LockGuard::LockGuard(const std::nullptr_t &)
+: m_lock(nullptr), m_stripedLock(nullptr)
 {
 }
 
-LockGuard::LockGuard(SharedLock &lock) : m_lock(&lock)
+LockGuard::LockGuard(SharedLock &lock) : m_lock(&lock), m_stripedLock(nullptr)
 {
     m_lock->lock();
 }
 
-LockGuard::LockGuard(LockGuard &&movable) : m_lock(movable.m_lock)
+LockGuard::LockGuard(StripedSharedLock &lock)
+: m_lock(nullptr), m_stripedLock(&lock)
+{
+    m_stripedLock->lock();
+}
+
+LockGuard::LockGuard(LockGuard &&movable)
+: m_lock(movable.m_lock), m_stripedLock(movable.m_stripedLock)
 {
     movable.m_lock = nullptr;
+    movable.m_stripedLock = nullptr;
 }
 
 LockGuard::~LockGuard()
 {
     if (m_lock != nullptr) {
         m_lock->unlock();
+    } else if (m_stripedLock != nullptr) {
+        m_stripedLock->unlock();
     }
 }
 
 bool LockGuard::valid() const
 {
-    return m_lock != nullptr;
+    return m_lock != nullptr || m_stripedLock != nullptr;
 }
 
 #pragma mark - Shared Lock Guard
 SharedLockGuard::SharedLockGuard(SharedLockGuard &&movable)
-: m_lock(movable.m_lock)
+: m_lock(movable.m_lock), m_stripedLock(movable.m_stripedLock)
 {
     movable.m_lock = nullptr;
+    movable.m_stripedLock = nullptr;
 }
 
-SharedLockGuard::SharedLockGuard(const std::nullptr_t &) : m_lock(nullptr)
+SharedLockGuard::SharedLockGuard(const std::nullptr_t &)
+: m_lock(nullptr), m_stripedLock(nullptr)
 {
 }
 
-SharedLockGuard::SharedLockGuard(SharedLock &lock) : m_lock(&lock)
+SharedLockGuard::SharedLockGuard(SharedLock &lock)
+: m_lock(&lock), m_stripedLock(nullptr)
 {
     m_lock->lockShared();
 }
 
+SharedLockGuard::SharedLockGuard(StripedSharedLock &lock)
+: m_lock(nullptr), m_stripedLock(&lock)
+{
+    m_stripedLock->lockShared();
+}
+
 bool SharedLockGuard::valid() const
 {
-    return m_lock != nullptr;
+    return m_lock != nullptr || m_stripedLock != nullptr;
 }
 
 SharedLockGuard::~SharedLockGuard()
 {
     if (m_lock != nullptr) {
         m_lock->unlockShared();
+    } else if (m_stripedLock != nullptr) {
+        m_stripedLock->unlockShared();
     }
 }
 
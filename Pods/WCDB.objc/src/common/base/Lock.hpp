@@ -29,8 +29,10 @@
 #include <atomic>
 #include <condition_variable>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <list>
+#include <vector>
 
 namespace WCDB {
 
@@ -83,10 +85,67 @@ protected:
     mutable ThreadLocal<int> m_threadedReaders;
 };
 
+#pragma mark - Striped Shared Lock
+// Same semantics as SharedLock, including writer preference and reentrancy,
+// but readers only touch the counter of their own stripe and a thread local cache when no writer is around.
+// It suits the read-mostly paths where SharedLock makes all readers contend on one mutex.
+class StripedSharedLock final {
+public:
+    typedef SharedLock::Level Level;
+    StripedSharedLock();
+    ~StripedSharedLock();
+
+    void lock();
+    bool isLocked();
+    void unlock();
+
+    void lockShared();
+    void unlockShared();
+
+    Level level() const;
+    bool readSafety() const;
+    bool writeSafety() const;
+
+protected:
+    static constexpr int numberOfStripes = 16;
+    static constexpr int cacheLineSize = 64;
+    struct alignas(cacheLineSize) Stripe {
+        std::atomic<int> readers;
+    };
+    static int threadedStripe();
+    int numberOfReaders() const;
+
+    // Shared lock counts of current thread are kept in a small thread local array,
+    // which is cheaper than the map of ThreadLocal since a thread rarely holds more than a few locks.
+    typedef std::vector<std::pair<const StripedSharedLock *, int>> ThreadedReaders;
+    static ThreadedReaders &threadedReadersOfAllLocks();
+    int threadedReaders() const;
+    void increaseThreadedReaders();
+    bool decreaseThreadedReaders();
+
+    void releaseStripe(Stripe &stripe);
+    void lockSharedSlowly(Stripe &stripe);
+
+    // The stripes are placed in a buffer of their own rather than inlined,
+    // since the owners of the lock are allocated by new, which ignores the over-alignment before C++17.
+    std::unique_ptr<unsigned char[]> m_stripesBuffer;
+    Stripe *m_stripes;
+    // Number of pending and working writers. Readers take the fast path only when it's zero.
+    std::atomic<int> m_activeWriters;
+    mutable std::mutex m_lock;
+    Conditional m_conditionalReaders;
+    Conditional m_conditionalWriters;
+    int m_writers;
+    int m_pendingReaders;
+    std::list<Thread> m_pendingWriters;
+    Thread m_locking;
+};
+
 #pragma mark - Lock Guard
 class LockGuard final {
 public:
     LockGuard(SharedLock &lock);
+    LockGuard(StripedSharedLock &lock);
     LockGuard(LockGuard &&movable);
     LockGuard(const std::nullptr_t &);
     ~LockGuard();
@@ -99,12 +158,14 @@ public:
 
 protected:
     SharedLock *m_lock;
+    StripedSharedLock *m_stripedLock;
 };
 
 #pragma mark - Shared Lock Guard
 class SharedLockGuard final {
 public:
     SharedLockGuard(SharedLock &lock);
+    SharedLockGuard(StripedSharedLock &lock);
     SharedLockGuard(SharedLockGuard &&movable);
     SharedLockGuard(const std::nullptr_t &);
     ~SharedLockGuard();
@@ -117,6 +178,7 @@ public:
 
 protected:
     SharedLock *m_lock;
+    StripedSharedLock *m_stripedLock;
 };
 
 } //namespace WCDB
@@ -67,6 +67,11 @@ bool SerializeIteration::ended() const
     return m_cursor == (offset_t) capacity();
 }
 
+offset_t SerializeIteration::getCursor() const
+{
+    return m_cursor;
+}
+
 const unsigned char *SerializeIteration::pointee() const
 {
     return data().buffer() + m_cursor;
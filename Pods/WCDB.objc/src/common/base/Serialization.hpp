@@ -40,6 +40,7 @@ public:
     bool canAdvance(size_t size) const;
     bool isEnough(size_t size) const;
     bool ended() const;
+    offset_t getCursor() const;
 
 protected:
     virtual const UnsafeData &data() const = 0;
@@ -24,8 +24,8 @@
 
 #include "UnsafeData.hpp"
 #include "Assertion.hpp"
+#include "Checksum.hpp"
 #include <string.h>
-#include <zlib.h>
 
 namespace WCDB {
 
@@ -149,7 +149,7 @@ size_t UnsafeData::size() const
 uint32_t UnsafeData::hash() const
 {
     // crc32 is pretty fast and have more collisions. BUT it's enough for checking whether corrupted.
-    return (uint32_t) crc32(0, buffer(), (uint32_t) size());
+    return Checksum::crc32(0, buffer(), size());
 }
 
 const unsigned char *UnsafeData::buffer() const
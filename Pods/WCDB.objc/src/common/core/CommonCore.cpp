@@ -27,6 +27,7 @@
 #include "BusyRetryConfig.hpp"
 #include "CompressionConst.hpp"
 #include "DecompressFunction.hpp"
+#include "DigestFunction.hpp"
 #include "FTS5AuxiliaryFunctionTemplate.hpp"
 #include "FTSConst.h"
 #include "FileManager.hpp"
@@ -67,6 +68,8 @@ CommonCore::CommonCore()
 , m_autoMigrateConfig(std::make_shared<AutoMigrateConfig>(m_operationQueue))
 // Compression
 , m_autoCompressConfig(std::make_shared<AutoCompressConfig>(m_operationQueue))
+// Incremental Vacuum
+, m_autoIncrementalVacuumConfig(std::make_shared<AutoIncrementalVacuumConfig>(m_operationQueue))
 // Trace
 , m_globalSQLTraceConfig(std::make_shared<ShareableSQLTraceConfig>())
 , m_globalPerformanceTraceConfig(std::make_shared<ShareablePerformanceTraceConfig>())
@@ -117,6 +120,8 @@ CommonCore::CommonCore()
     FTS5AuxiliaryFunctionTemplate<SubstringMatchInfo>::specializeWithContext(nullptr));
     registerScalarFunction(DecompressFunctionName,
                            ScalarFunctionTemplate<DecompressFunction>::specialize(2));
+    registerScalarFunction(DigestFunctionName,
+                           ScalarFunctionTemplate<DigestFunction>::specialize(1));
 }
 
 CommonCore::~CommonCore()
@@ -234,6 +239,11 @@ bool CommonCore::tokenizerExists(const UnsafeStringView& name) const
     return m_tokenizerModules->get(name) != nullptr;
 }
 
+const TokenizerModule* CommonCore::tokenizerModule(const UnsafeStringView& name) const
+{
+    return m_tokenizerModules->get(name);
+}
+
 std::shared_ptr<Config> CommonCore::tokenizerConfig(const UnsafeStringView& tokenizeName)
 {
     return std::make_shared<TokenizerConfig>(tokenizeName, m_tokenizerModules);
@@ -259,12 +269,13 @@ CommonCore::auxiliaryFunctionConfig(const UnsafeStringView& auxiliaryFunctionNam
 }
 
 #pragma mark - Operation
-Optional<bool> CommonCore::migrationShouldBeOperated(const UnsafeStringView& path)
+Optional<bool> CommonCore::migrationShouldBeOperated(const UnsafeStringView& path, double& interval)
 {
     RecyclableDatabase database = m_databasePool.getOrCreate(path);
     Optional<bool> done = false; // mark as no error if database is not referenced.
     if (database != nullptr) {
         done = database->stepMigration(true);
+        interval = database->getMigrationStepInterval();
     }
     return done;
 }
@@ -279,6 +290,18 @@ Optional<bool> CommonCore::compressionShouldBeOperated(const UnsafeStringView& p
     return done;
 }
 
+Optional<bool>
+CommonCore::incrementalVacuumShouldBeOperated(const UnsafeStringView& path, double& interval)
+{
+    RecyclableDatabase database = m_databasePool.getOrCreate(path);
+    Optional<bool> done = false; // mark as no error if database is not referenced.
+    if (database != nullptr) {
+        done = database->stepIncrementalVacuum(true);
+        interval = database->getIncrementalVacuumStepInterval();
+    }
+    return done;
+}
+
 void CommonCore::backupShouldBeOperated(const UnsafeStringView& path)
 {
     RecyclableDatabase database = m_databasePool.getOrCreate(path);
@@ -461,6 +484,22 @@ void CommonCore::enableAutoCompress(InnerDatabase* database, bool enable)
     }
 }
 
+#pragma mark - Incremental Vacuum
+void CommonCore::enableAutoIncrementalVacuum(InnerDatabase* database, bool enable)
+{
+    WCTAssert(database != nullptr);
+    if (enable) {
+        database->setConfig(AutoIncrementalVacuumConfigName,
+                            m_autoIncrementalVacuumConfig,
+                            WCDB::Configs::Priority::Highest);
+        m_operationQueue->registerAsRequiredIncrementalVacuum(database->getPath());
+        m_operationQueue->asyncIncrementalVacuum(database->getPath());
+    } else {
+        database->removeConfig(AutoIncrementalVacuumConfigName);
+        m_operationQueue->registerAsNoIncrementalVacuumRequired(database->getPath());
+    }
+}
+
 #pragma mark - Merge FTS Index
 void CommonCore::enableAutoMergeFTSIndex(InnerDatabase* database, bool enable)
 {
@@ -568,6 +607,11 @@ bool CommonCore::isBusyTraceEnable() const
     return m_enableBusyTrace;
 }
 
+BusyRetryConfig::WaitingHistograms CommonCore::getBusyWaitingHistograms(const UnsafeStringView& path)
+{
+    return static_cast<BusyRetryConfig*>(m_globalBusyRetryConfig.get())->getWaitingHistograms(path);
+}
+
 #pragma mark - Integrity
 
 void CommonCore::skipIntegrityCheck(const UnsafeStringView& path)
@@ -592,8 +636,9 @@ void CommonCore::removeABTestConfig(const UnsafeStringView& configName)
 Optional<UnsafeStringView> CommonCore::getABTestConfig(const UnsafeStringView& configName)
 {
     SharedLockGuard memoryGuard(m_memory);
-    if (m_abtestConfig.find(configName) != m_abtestConfig.end()) {
-        return m_abtestConfig[configName];
+    auto iter = m_abtestConfig.find(configName);
+    if (iter != m_abtestConfig.end()) {
+        return iter->second;
     }
     return NullOpt;
 }
@@ -26,6 +26,7 @@
 
 #include "OperationQueue.hpp"
 
+#include "BusyRetryConfig.hpp"
 #include "Config.hpp"
 #include "Configs.hpp"
 #include "PerformanceTraceConfig.hpp"
@@ -92,6 +93,7 @@ public:
     void registerTokenizer(const UnsafeStringView& name, const TokenizerModule& module);
     std::shared_ptr<Config> tokenizerConfig(const UnsafeStringView& tokenizeName);
     bool tokenizerExists(const UnsafeStringView& name) const;
+    const TokenizerModule* tokenizerModule(const UnsafeStringView& name) const;
 
 protected:
     std::shared_ptr<TokenizerModules> m_tokenizerModules;
@@ -116,8 +118,11 @@ public:
                                               const CorruptedNotification& notification);
 
 protected:
-    Optional<bool> migrationShouldBeOperated(const UnsafeStringView& path) override final;
+    Optional<bool>
+    migrationShouldBeOperated(const UnsafeStringView& path, double& interval) override final;
     Optional<bool> compressionShouldBeOperated(const UnsafeStringView& path) override final;
+    Optional<bool>
+    incrementalVacuumShouldBeOperated(const UnsafeStringView& path, double& interval) override final;
     void backupShouldBeOperated(const UnsafeStringView& path) override final;
     void checkpointShouldBeOperated(const UnsafeStringView& path) override final;
     void integrityShouldBeChecked(const UnsafeStringView& path) override final;
@@ -158,6 +163,13 @@ public:
 protected:
     std::shared_ptr<Config> m_autoCompressConfig;
 
+#pragma mark - Incremental Vacuum
+public:
+    void enableAutoIncrementalVacuum(InnerDatabase* database, bool enable);
+
+protected:
+    std::shared_ptr<Config> m_autoIncrementalVacuumConfig;
+
 #pragma mark - Trace
 public:
     void setNotificationForSQLGLobalTraced(const ShareableSQLTraceConfig::Notification& notification);
@@ -181,6 +193,7 @@ public:
     typedef std::function<void(const Tag&, const UnsafeStringView&, uint64_t, const UnsafeStringView)> BusyMonitor;
     void setBusyMonitor(BusyMonitor monitor, double timeOut);
     bool isBusyTraceEnable() const;
+    BusyRetryConfig::WaitingHistograms getBusyWaitingHistograms(const UnsafeStringView& path);
 
 protected:
     std::shared_ptr<Config> m_globalBusyRetryConfig;
@@ -213,7 +226,7 @@ public:
 
 protected:
     Configs m_configs;
-    mutable SharedLock m_memory;
+    mutable StripedSharedLock m_memory;
     StringViewMap<StringView> m_abtestConfig;
 };
 
@@ -26,6 +26,8 @@
 
 namespace WCDB {
 
+WCDBLiteralStringImplement(WorkerPoolName);
+
 WCDBLiteralStringImplement(OperationQueueName);
 
 WCDBLiteralStringImplement(AutoCheckpointConfigName);
@@ -36,6 +38,8 @@ WCDBLiteralStringImplement(AutoMigrateConfigName);
 
 WCDBLiteralStringImplement(AutoCompressConfigName);
 
+WCDBLiteralStringImplement(AutoIncrementalVacuumConfigName);
+
 WCDBLiteralStringImplement(AutoMergeFTSIndexConfigName);
 
 WCDBLiteralStringImplement(AutoMergeFTSIndexQueueName);
@@ -84,10 +88,13 @@ WCDBLiteralStringImplement(ErrorSourceZstd);
 
 WCDBLiteralStringImplement(ErrorTypeMigrate);
 WCDBLiteralStringImplement(ErrorTypeCompress);
+WCDBLiteralStringImplement(ErrorTypeIncrementalVacuum);
 WCDBLiteralStringImplement(ErrorTypeCheckpoint);
 WCDBLiteralStringImplement(ErrorTypeIntegrity);
 WCDBLiteralStringImplement(ErrorTypeBackup);
 WCDBLiteralStringImplement(ErrorTypeMergeIndex);
+WCDBLiteralStringImplement(ErrorTypeFTSBulkBuild);
+WCDBLiteralStringImplement(ErrorTypePageMapping);
 
 WCDBLiteralStringImplement(MonitorInfoKeyHandleCount);
 WCDBLiteralStringImplement(MonitorInfoKeyHandleOpenTime);
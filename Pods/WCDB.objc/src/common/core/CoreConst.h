@@ -32,6 +32,10 @@ namespace WCDB {
 #pragma mark - Async Queue
 static constexpr const double AsyncQueueTimeOutForExiting = 10.0;
 
+#pragma mark - Worker Pool
+WCDBLiteralStringDefine(WorkerPoolName, "WCDB.Worker");
+static constexpr const int WorkerPoolMaxNumberOfThreads = 4;
+
 #pragma mark - Operation Queue
 WCDBLiteralStringDefine(OperationQueueName, "WCDB.Operation");
 static constexpr double OperationQueueTimeIntervalForRetringAfterFailure = 5.0;
@@ -41,6 +45,9 @@ static constexpr const int OperationQueueTolerableFailuresForMigration = 5;
 #pragma mark - Operation Queue - Compression
 static constexpr const double OperationQueueTimeIntervalForCompression = 0.2;
 static constexpr const int OperationQueueTolerableFailuresForCompression = 5;
+#pragma mark - Operation Queue - Incremental Vacuum
+static constexpr const double OperationQueueTimeIntervalForIncrementalVacuum = 2.0;
+static constexpr const int OperationQueueTolerableFailuresForIncrementalVacuum = 5;
 #pragma mark - Operation Queue - Purge
 static constexpr const double OperationQueueTimeIntervalForPurgingAgain = 30.0;
 static constexpr const double OperationQueueRateForTooManyFileDescriptors = 0.7;
@@ -64,12 +71,22 @@ WCDBLiteralStringDefine(AutoBackupConfigName, "com.Tencent.WCDB.Config.AutoBacku
 WCDBLiteralStringDefine(AutoMigrateConfigName, "com.Tencent.WCDB.Config.AutoMigrate");
 #pragma mark - Config - Auto Compress
 WCDBLiteralStringDefine(AutoCompressConfigName, "com.Tencent.WCDB.Config.AutoCompress");
+#pragma mark - Config - Auto Incremental Vacuum
+WCDBLiteralStringDefine(AutoIncrementalVacuumConfigName,
+                        "com.Tencent.WCDB.Config.AutoIncrementalVacuum");
 #pragma mark - Config - Auto Merge
 WCDBLiteralStringDefine(AutoMergeFTSIndexConfigName, "com.Tencent.WCDB.Config.AutoMergeFTSIndex");
 WCDBLiteralStringDefine(AutoMergeFTSIndexQueueName, "WCDB.MergeIndex");
 static constexpr const int AutoMergeFTS5IndexMinSegmentCount = 4;
 static constexpr const double AutoMergeFTSIndexMaxExpectingDuration = 0.02;
 static constexpr const double AutoMergeFTSIndexMaxInitializeDuration = 0.005;
+// Seconds of merge work allowed per second
+static constexpr const double AutoMergeFTSIndexDefaultBudgetPerSecond = 0.2;
+#pragma mark - FTS Pretokenize
+static constexpr const int FTSPretokenizeMaxNumberOfThreads = 4;
+#pragma mark - FTS Bulk Build
+static constexpr const int FTSBulkBuildMaxNumberOfTokenizeThreads = 4;
+static constexpr const int FTSBulkBuildHashSize = 8 * 1024 * 1024;
 #pragma mark - Config - Basic
 WCDBLiteralStringDefine(BasicConfigName, "com.Tencent.WCDB.Config.Basic");
 static constexpr const int BasicConfigBusyRetryMaxAllowedNumberOfTimes = 3;
@@ -155,6 +172,9 @@ static constexpr bool handleShouldWaitWhenFull(HandleType type)
     return type == HandleType::Normal;
 }
 
+#pragma mark - Group Commit
+static constexpr const int GroupCommitMaxNumberOfTransactions = 64;
+
 #pragma mark - Backup
 static constexpr const int BackupMaxIncrementalTimes = 1000;
 static constexpr const int BackupMaxIncrementalPageCount = 1000;
@@ -162,13 +182,35 @@ static constexpr const int BackupMaxAllowIncrementalPageCount = 1000000;
 
 #pragma mark - Migrate
 static constexpr const int MigrationBatchCount = 100;
+// Each step migrates the tables in turn, one batch per slice, until the budget runs out or the database is busy.
+static constexpr const double MigrationStepTimeBudget = 0.1;
+// The interval between steps is halved after an idle step and doubled after a busy one.
+static constexpr const double MigrationMinStepInterval = 0.05;
+static constexpr const double MigrationMaxStepInterval = OperationQueueTimeIntervalForMigration;
 
 #pragma mark - Compression
 static constexpr const int CompressionBatchCount = 10;
 static constexpr const int CompressionUpdateRecordBatchCount = 1000;
+static constexpr const int CompressionRollbackBatchCount = 1000;
+static constexpr const int CompressionRollbackMaxNumberOfThreads = 4;
+// Rows written between checking the busy signal while rolling back compression.
+static constexpr const int CompressionRollbackBusyCheckInterval = 16;
+// The time to sleep after a batch of online rollback if there are writers waiting for the lock.
+static constexpr const int CompressionRollbackYieldMicroseconds = 5000;
+// The share of the progress taken by online rollback. The rest is for the rows left to the rollback while closing.
+static constexpr const double CompressionRollbackOnlineProgressWeight = 0.95;
 
 #pragma mark - Vacuum
 static constexpr const int VacuumBatchCount = 1000;
+// Each slice of incremental vacuum is a single write transaction, whose number of pages is adapted to the slice budget.
+static constexpr const int IncrementalVacuumMinPagesPerSlice = 8;
+static constexpr const int IncrementalVacuumMaxPagesPerSlice = 4096;
+static constexpr const double IncrementalVacuumSliceTimeBudget = 0.01;
+// Each step runs slices until the budget runs out or the database is busy.
+static constexpr const double IncrementalVacuumStepTimeBudget = 0.05;
+static constexpr const double IncrementalVacuumMinStepInterval = 0.1;
+static constexpr const double IncrementalVacuumMaxStepInterval
+= OperationQueueTimeIntervalForIncrementalVacuum;
 
 WCDBLiteralStringDefine(ErrorStringKeyType, "Type");
 WCDBLiteralStringDefine(ErrorStringKeySource, "Source")
@@ -200,10 +242,13 @@ WCDBLiteralStringDefine(ErrorSourceZstd, "Zstd");
 #pragma mark - Error - Type
 WCDBLiteralStringDefine(ErrorTypeMigrate, "Migrate");
 WCDBLiteralStringDefine(ErrorTypeCompress, "Compress");
+WCDBLiteralStringDefine(ErrorTypeIncrementalVacuum, "IncrementalVacuum");
 WCDBLiteralStringDefine(ErrorTypeCheckpoint, "Checkpoint");
 WCDBLiteralStringDefine(ErrorTypeIntegrity, "Integrity");
 WCDBLiteralStringDefine(ErrorTypeBackup, "Backup")
 WCDBLiteralStringDefine(ErrorTypeMergeIndex, "MergeIndex")
+WCDBLiteralStringDefine(ErrorTypeFTSBulkBuild, "FTSBulkBuild")
+WCDBLiteralStringDefine(ErrorTypePageMapping, "PageMapping")
 
 #pragma mark - Moniter
 WCDBLiteralStringDefine(MonitorInfoKeyHandleCount, "HandleCount");
@@ -220,6 +265,7 @@ WCDBLiteralStringDefine(DecoratorMigratingHandleStatement, "MigratingHandleState
 WCDBLiteralStringDefine(DecoratorMigratingHandle, "MigratingHandle");
 WCDBLiteralStringDefine(DecoratorCompressingHandleStatement, "CompressingHandleStatement");
 WCDBLiteralStringDefine(DecoratorCompressingHandle, "CompressingHandle");
+static constexpr const int DecoratorRewrittenStatementCacheCapacity = 256;
 
 #pragma mark - HandleOperator
 WCDBLiteralStringDefine(OperatorMigrate, "Migrate");
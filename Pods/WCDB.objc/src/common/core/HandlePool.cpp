@@ -78,7 +78,7 @@ void HandlePool::didDrain()
 
 void HandlePool::drain(const HandlePool::DrainedCallback &onDrained)
 {
-    WCTRemedialAssert(m_concurrency.level() != SharedLock::Level::Read,
+    WCTRemedialAssert(m_concurrency.level() != StripedSharedLock::Level::Read,
                       "There are some threaded handles not invalidated.",
                       return;);
     LockGuard concurrencyGuard(m_concurrency);
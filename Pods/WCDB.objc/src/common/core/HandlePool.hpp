@@ -68,7 +68,7 @@ public:
 
 protected:
     virtual void didDrain();
-    mutable SharedLock m_concurrency;
+    mutable StripedSharedLock m_concurrency;
 
 private:
     bool isNumberOfHandlesAllowed() const;
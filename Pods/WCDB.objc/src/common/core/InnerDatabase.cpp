@@ -62,11 +62,15 @@ InnerDatabase::InnerDatabase(const UnsafeStringView &path)
 , m_tag(Tag::invalid())
 , m_isReadOnly(false)
 , m_fullSQLTrace(false)
+, m_ftsPretokenize(false)
 , m_liteModeEnable(false)
+, m_groupCommitEnable(false)
+, m_groupCommitLeading(false)
 , m_factory(path)
 , m_needLoadIncremetalMaterial(false)
 , m_migration(this)
 , m_migratedCallback(nullptr)
+, m_migratingCallback(nullptr)
 , m_compression(this)
 , m_compressedCallback(nullptr)
 , m_isInMemory(false)
@@ -250,6 +254,11 @@ void InnerDatabase::setFullSQLTraceEnable(bool enable)
     m_fullSQLTrace = enable;
 }
 
+void InnerDatabase::setFTSPretokenizeEnable(bool enable)
+{
+    m_ftsPretokenize = enable;
+}
+
 void InnerDatabase::setLiteModeEnable(bool enable)
 {
     if (m_liteModeEnable != enable) {
@@ -385,6 +394,7 @@ bool InnerDatabase::setupHandle(HandleType type, InnerHandle *handle)
     handle->setType(type);
     handle->setLiteModeEnable(m_liteModeEnable);
     handle->setFullSQLTraceEnable(m_fullSQLTrace);
+    handle->setFTSPretokenizeEnable(m_ftsPretokenize);
     handle->setBusyTraceEnable(CommonCore::shared().isBusyTraceEnable());
     HandleSlot slot = slotOfHandleType(type);
     handle->enableWriteMainDB(m_liteModeEnable || slot == HandleSlotAutoTask
@@ -518,6 +528,11 @@ void InnerDatabase::rollbackTransaction()
 
 bool InnerDatabase::runTransaction(const TransactionCallback &transaction)
 {
+    // Savepoint can't be rolled back in lite mode.
+    if (m_groupCommitEnable.load() && !m_isInMemory && !m_liteModeEnable
+        && getHandle(true, true) == nullptr) {
+        return runGroupedTransaction(transaction);
+    }
     RecyclableHandle handle = getHandle(true);
     if (handle == nullptr) return false;
     if (!handle->runTransaction(transaction)) {
@@ -539,6 +554,125 @@ bool InnerDatabase::runPausableTransactionWithOneLoop(const TransactionCallbackF
     return true;
 }
 
+#pragma mark - Group Commit
+void InnerDatabase::setGroupCommitEnable(bool enable)
+{
+    m_groupCommitEnable.store(enable);
+}
+
+bool InnerDatabase::groupCommitEnable() const
+{
+    return m_groupCommitEnable.load();
+}
+
+InnerDatabase::GroupedTransaction::GroupedTransaction(const TransactionCallback &transaction_)
+: transaction(transaction_), leading(false), done(false), succeed(false)
+{
+}
+
+bool InnerDatabase::runGroupedTransaction(const TransactionCallback &transaction)
+{
+    GroupedTransaction grouped(transaction);
+    std::unique_lock<std::mutex> lockGuard(m_groupCommitLock);
+    m_groupedTransactions.push_back(&grouped);
+    if (!m_groupCommitLeading) {
+        m_groupCommitLeading = true;
+        grouped.leading = true;
+    }
+    while (!grouped.leading && !grouped.done) {
+        grouped.conditional.wait(lockGuard);
+    }
+    if (grouped.leading) {
+        // The leading one is always at the front, so it's done within the group it runs.
+        WCTAssert(m_groupedTransactions.front() == &grouped);
+        std::vector<GroupedTransaction *> group;
+        while (!m_groupedTransactions.empty()
+               && (int) group.size() < GroupCommitMaxNumberOfTransactions) {
+            group.push_back(m_groupedTransactions.front());
+            m_groupedTransactions.pop_front();
+        }
+        lockGuard.unlock();
+        runTransactionsInGroup(group);
+        lockGuard.lock();
+        for (GroupedTransaction *other : group) {
+            other->done = true;
+            if (other != &grouped) {
+                other->conditional.notify_one();
+            }
+        }
+        // Hand off to the first one of the next group.
+        if (!m_groupedTransactions.empty()) {
+            m_groupedTransactions.front()->leading = true;
+            m_groupedTransactions.front()->conditional.notify_one();
+        } else {
+            m_groupCommitLeading = false;
+        }
+    }
+    WCTAssert(grouped.done);
+    lockGuard.unlock();
+    if (!grouped.succeed) {
+        setThreadedError(std::move(grouped.error));
+    }
+    return grouped.succeed;
+}
+
+void InnerDatabase::runTransactionsInGroup(const std::vector<GroupedTransaction *> &group)
+{
+    RecyclableHandle handle = getHandle(true);
+    if (handle == nullptr) {
+        for (GroupedTransaction *grouped : group) {
+            grouped->error = getThreadedError();
+        }
+        return;
+    }
+    auto begin = group.begin();
+    while (begin != group.end()) {
+        if (!handle->beginTransaction()) {
+            for (auto iter = begin; iter != group.end(); ++iter) {
+                (*iter)->error = handle->getError();
+            }
+            return;
+        }
+        std::vector<GroupedTransaction *> committings;
+        auto iter = begin;
+        while (iter != group.end()) {
+            GroupedTransaction *grouped = *iter++;
+            // savepoint
+            bool succeed = handle->beginTransaction();
+            if (succeed) {
+                if (grouped->transaction(handle.get())) {
+                    succeed = handle->commitTransaction();
+                } else {
+                    handle->rollbackTransaction();
+                    succeed = false;
+                }
+            }
+            if (succeed) {
+                committings.push_back(grouped);
+            } else {
+                grouped->error = handle->getError();
+            }
+            if (!handle->isInTransaction()) {
+                // The whole transaction is rolled back by sqlite automatically in some case. e.g. interrupt step
+                break;
+            }
+        }
+        bool committed = false;
+        if (handle->isInTransaction()) {
+            committed = handle->commitOrRollbackTransaction();
+        } else {
+            handle->rollbackTransaction();
+        }
+        for (GroupedTransaction *grouped : committings) {
+            grouped->succeed = committed;
+            if (!committed) {
+                grouped->error = handle->getError();
+            }
+        }
+        begin = iter;
+    }
+}
+
 #pragma mark - File
 bool InnerDatabase::removeFiles()
 {
@@ -655,10 +789,10 @@ void InnerDatabase::tryLoadIncremetalMaterial()
     bool useMaterial = false;
     if (cipherHandle->isCipherDB()) {
         material->setCipherDelegate(cipherHandle);
-        useMaterial = material->decryptedDeserialize(materialPath, false);
+        useMaterial = material->chunkedDeserialize(materialPath, true, false);
         material->setCipherDelegate(nullptr);
     } else {
-        useMaterial = material->deserialize(materialPath);
+        useMaterial = material->chunkedDeserialize(materialPath, false, false);
     }
     if (useMaterial) {
         if (material->pages.size() < BackupMaxAllowIncrementalPageCount) {
@@ -916,13 +1050,13 @@ void InnerDatabase::checkIntegrity(bool interruptible)
 
 #pragma mark - Vacuum
 
-bool InnerDatabase::vacuum(const ProgressCallback &onProgressUpdated)
+bool InnerDatabase::vacuum(const ProgressCallback &onProgressUpdated, bool rebuildByPages)
 {
     if (m_isInMemory) {
         return true;
     }
     bool result = false;
-    close([&result, &onProgressUpdated, this]() {
+    close([&result, &onProgressUpdated, rebuildByPages, this]() {
         InitializedGuard initializedGuard = initialize();
         if (!initializedGuard.valid()) {
             return;
@@ -937,6 +1071,7 @@ bool InnerDatabase::vacuum(const ProgressCallback &onProgressUpdated)
 
         Repair::FactoryVacuum vacuummer = m_factory.vacuumer();
         VacuumHandleOperator vacuumOperator(vacuumHandle.get());
+        vacuumOperator.enableRebuildingByPages(rebuildByPages);
         vacuummer.setVacuumDelegate(&vacuumOperator);
         vacuummer.setProgressCallback(onProgressUpdated);
 
@@ -983,6 +1118,42 @@ bool InnerDatabase::incrementalVacuum(int pages)
     return succeed;
 }
 
+Optional<bool> InnerDatabase::stepIncrementalVacuum(bool interruptible)
+{
+    InitializedGuard initializedGuard = initialize();
+    if (!initializedGuard.valid()) {
+        return NullOpt;
+    }
+    WCTRemedialAssert(!isInTransaction(),
+                      "Incremental vacuum can't be run in transaction.",
+                      return NullOpt;);
+    if (m_isInMemory) {
+        return true;
+    }
+    Optional<bool> done;
+    RecyclableHandle handle = flowOut(HandleType::AutoVacuum);
+    if (handle != nullptr) {
+        if (interruptible) {
+            if (checkShouldInterruptWhenClosing(ErrorTypeIncrementalVacuum)) {
+                return false;
+            }
+            handle->markAsCanBeSuspended(true);
+        }
+        handle->markErrorAsIgnorable(Error::Code::Busy);
+
+        done = m_incrementalVacuum.step(handle.get());
+        if (!done.succeed() && handle->getError().isIgnorable()) {
+            done = false;
+        }
+    }
+    return done;
+}
+
+double InnerDatabase::getIncrementalVacuumStepInterval() const
+{
+    return m_incrementalVacuum.getIntervalForNextStep();
+}
+
 #pragma mark - Migration
 Optional<bool> InnerDatabase::stepMigration(bool interruptible)
 {
@@ -1015,6 +1186,11 @@ Optional<bool> InnerDatabase::stepMigration(bool interruptible)
     return done;
 }
 
+double InnerDatabase::getMigrationStepInterval() const
+{
+    return m_migration.getIntervalForNextStep();
+}
+
 void InnerDatabase::didMigrate(const MigrationBaseInfo *info)
 {
     MigratedCallback callback = nullptr;
@@ -1033,6 +1209,24 @@ void InnerDatabase::setNotificationWhenMigrated(const MigratedCallback &callback
     m_migratedCallback = callback;
 }
 
+void InnerDatabase::didStepMigration(const MigrationBaseInfo *info, const MigrationProgress &progress)
+{
+    MigratingCallback callback = nullptr;
+    {
+        SharedLockGuard lockGuard(m_memory);
+        callback = m_migratingCallback;
+    }
+    if (callback != nullptr) {
+        callback(this, info, progress);
+    }
+}
+
+void InnerDatabase::setNotificationWhenMigrating(const MigratingCallback &callback)
+{
+    LockGuard lockGuard(m_memory);
+    m_migratingCallback = callback;
+}
+
 void InnerDatabase::addMigration(const UnsafeStringView &sourcePath,
                                  const UnsafeData &sourceCipher,
                                  const MigrationTableFilter &filter)
@@ -1125,11 +1319,59 @@ bool InnerDatabase::isCompressed() const
     return m_compression.isCompressed();
 }
 
-bool InnerDatabase::rollbackCompression(const ProgressCallback &callback)
+bool InnerDatabase::rollbackCompression(const ProgressCallback &callback, bool parallel)
 {
     WCTRemedialAssert(
     !isInTransaction(), "Can't revert compression in transaction.", return false;);
 
+    // Both passes restart their own progress, so they are mapped into one range here.
+    double reportedProgress = 0;
+    bool cancelled = false;
+    auto mapProgress = [&](double base, double weight) -> ProgressCallback {
+        return [&, base, weight](double progress, double) {
+            double mappedProgress = base + weight * progress;
+            if (mappedProgress <= reportedProgress) {
+                return true;
+            }
+            double increment = mappedProgress - reportedProgress;
+            reportedProgress = mappedProgress;
+            if (callback != nullptr && !callback(mappedProgress, increment)) {
+                cancelled = true;
+                return false;
+            }
+            return true;
+        };
+    };
+
+    bool canCompressNewData = m_compression.canCompressNewData();
+    // The rows are reverted online at first, one write transaction per batch, so that the others can still read and write.
+    // Any row missed or compressed meanwhile is reverted while closing.
+    {
+        InitializedGuard initializedGuard = initialize();
+        if (!initializedGuard.valid()) {
+            return false;
+        }
+        m_compression.setCanCompressNewData(false);
+        m_compression.setProgressCallback(
+        mapProgress(0, CompressionRollbackOnlineProgressWeight));
+
+        RecyclableHandle handle = flowOut(HandleType::Compress);
+        if (handle != nullptr) {
+            CompressHandleOperator &compressOperator
+            = handle.getDecorative()->getOrCreateOperator<CompressHandleOperator>(OperatorCompress);
+            handle->markErrorAsIgnorable(Error::Code::Busy);
+
+            compressOperator.setNumberOfRollbackThreads(
+            parallel ? CompressionRollbackMaxNumberOfThreads : 1);
+            m_compression.rollbackCompression(compressOperator, true);
+            compressOperator.setNumberOfRollbackThreads(1);
+        }
+    }
+    if (cancelled) {
+        m_compression.setCanCompressNewData(canCompressNewData);
+        return false;
+    }
+
     bool ret = false;
     close([&]() {
         InitializedGuard initializedGuard = initialize();
@@ -1137,19 +1379,25 @@ bool InnerDatabase::rollbackCompression(const ProgressCallback &callback)
             return; // mark as succeed if it's not an auto initialize action.
         }
 
-        m_compression.setProgressCallback(callback);
+        m_compression.setProgressCallback(mapProgress(
+        CompressionRollbackOnlineProgressWeight, 1 - CompressionRollbackOnlineProgressWeight));
 
         RecyclableHandle handle = flowOut(HandleType::Compress);
         if (handle != nullptr) {
             CompressHandleOperator &compressOperator
             = handle.getDecorative()->getOrCreateOperator<CompressHandleOperator>(OperatorCompress);
 
-            ret = m_compression.rollbackCompression(compressOperator);
+            compressOperator.setNumberOfRollbackThreads(
+            parallel ? CompressionRollbackMaxNumberOfThreads : 1);
+            ret = m_compression.rollbackCompression(compressOperator, false);
+            compressOperator.setNumberOfRollbackThreads(1);
             if (ret) {
                 CommonCore::shared().enableAutoCompress(this, false);
             }
         }
     });
+    m_compression.setCanCompressNewData(canCompressNewData);
+    m_compression.setProgressCallback(nullptr);
     return ret;
 }
 
@@ -1210,4 +1458,39 @@ RecyclableHandle InnerDatabase::getMergeIndexHandle()
     return flowOut(HandleType::MergeIndex);
 }
 
+void InnerDatabase::setMergeFTSIndexBudget(double budgetPerSecond)
+{
+    m_mergeLogic.setMergeBudget(budgetPerSecond);
+}
+
+uint64_t InnerDatabase::getMergeFTSIndexDebt() const
+{
+    return m_mergeLogic.getMergeDebt();
+}
+
+#pragma mark - FTS Bulk Build
+Optional<InnerDatabase::FTSBulkBuildStatistics>
+InnerDatabase::bulkBuildFTSIndex(const UnsafeStringView &table,
+                                 const Columns &columns,
+                                 const FTSRowsProvider &provider)
+{
+    InitializedGuard initializedGuard = initialize();
+    if (!initializedGuard.valid()) {
+        return NullOpt;
+    }
+    RecyclableHandle handle = getHandle(true);
+    if (handle == nullptr) {
+        return NullOpt;
+    }
+    m_mergeLogic.suspend(true);
+    FTSBulkBuilder builder(handle.get());
+    bool succeed = builder.build(table, columns, provider);
+    m_mergeLogic.suspend(false);
+    if (!succeed) {
+        setThreadedError(handle->getError());
+        return NullOpt;
+    }
+    return builder.getStatistics();
+}
+
 } //namespace WCDB
@@ -26,13 +26,20 @@
 
 #include "Compression.hpp"
 #include "Configs.hpp"
+#include "FTSBulkBuilder.hpp"
 #include "Factory.hpp"
 #include "HandlePool.hpp"
+#include "IncrementalVacuum.hpp"
+#include "Lock.hpp"
 #include "MergeFTSIndexLogic.hpp"
 #include "Migration.hpp"
 #include "Tag.hpp"
 #include "ThreadLocal.hpp"
 #include "WINQ.h"
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <vector>
 
 namespace WCDB {
 
@@ -105,12 +112,14 @@ public:
                    int priority = Configs::Priority::Default);
     void removeConfig(const UnsafeStringView &name);
     void setFullSQLTraceEnable(bool enable);
+    void setFTSPretokenizeEnable(bool enable);
     void setLiteModeEnable(bool enable);
     bool liteModeEnable();
 
 private:
     Configs m_configs;
     bool m_fullSQLTrace = false;
+    bool m_ftsPretokenize = false;
     bool m_liteModeEnable = false;
 
 #pragma mark - Transaction
@@ -126,6 +135,33 @@ public:
     bool runTransaction(const TransactionCallback &transaction);
     bool runPausableTransactionWithOneLoop(const TransactionCallbackForOneLoop &transaction);
 
+#pragma mark - Group Commit
+public:
+    // Transactions run from different threads are queued and merged into one transaction, so that they share one commit.
+    // Each of them runs in its own savepoint, and the ones queued while a group is committing form the next group.
+    // The transaction of the thread that is holding a handle is not grouped.
+    void setGroupCommitEnable(bool enable);
+    bool groupCommitEnable() const;
+
+protected:
+    struct GroupedTransaction {
+        GroupedTransaction(const TransactionCallback &transaction);
+        const TransactionCallback &transaction;
+        Conditional conditional;
+        bool leading;
+        bool done;
+        bool succeed;
+        Error error;
+    };
+    bool runGroupedTransaction(const TransactionCallback &transaction);
+    void runTransactionsInGroup(const std::vector<GroupedTransaction *> &group);
+
+private:
+    std::atomic<bool> m_groupCommitEnable;
+    std::mutex m_groupCommitLock;
+    std::list<GroupedTransaction *> m_groupedTransactions;
+    bool m_groupCommitLeading;
+
 #pragma mark - File
 public:
     const StringView &getPath() const override;
@@ -160,10 +196,18 @@ private:
 
 #pragma mark - Vacuum
 public:
-    bool vacuum(const ProgressCallback &onProgressUpdated);
+    // Rowid tables are rebuilt by pages instead of being copied by SQL if `rebuildByPages` is true and the database is eligible.
+    bool vacuum(const ProgressCallback &onProgressUpdated, bool rebuildByPages = false);
     void enableAutoVacuum(bool incremental);
     bool incrementalVacuum(int pages);
 
+    // It moves a bounded number of pages per slice, which only works with auto_vacuum=incremental.
+    Optional<bool> stepIncrementalVacuum(bool interruptible);
+    double getIncrementalVacuumStepInterval() const;
+
+private:
+    IncrementalVacuum m_incrementalVacuum; // thread-safe
+
 #pragma mark - Migration
 public:
     typedef Migration::TableFilter MigrationTableFilter;
@@ -174,7 +218,12 @@ public:
     typedef std::function<void(InnerDatabase *, const MigrationBaseInfo *)> MigratedCallback;
     void setNotificationWhenMigrated(const MigratedCallback &callback);
 
+    // It's called after each slice of migration with the progress of the table. The MigratedCallback is still called when the table is finished.
+    typedef std::function<void(InnerDatabase *, const MigrationBaseInfo *, const MigrationProgress &)> MigratingCallback;
+    void setNotificationWhenMigrating(const MigratingCallback &callback);
+
     Optional<bool> stepMigration(bool interruptible);
+    double getMigrationStepInterval() const;
 
     bool isMigrated() const;
 
@@ -182,8 +231,11 @@ public:
 
 protected:
     void didMigrate(const MigrationBaseInfo *info) override final;
+    void didStepMigration(const MigrationBaseInfo *info,
+                          const MigrationProgress &progress) override final;
     Migration m_migration; // thread-safe
     MigratedCallback m_migratedCallback;
+    MigratingCallback m_migratingCallback;
 
 #pragma mark - Compression
 public:
@@ -199,7 +251,8 @@ public:
 
     bool isCompressed() const;
 
-    bool rollbackCompression(const ProgressCallback &callback);
+    // Compressed values are decompressed by the worker threads in parallel if needed, while they are always written back serially.
+    bool rollbackCompression(const ProgressCallback &callback, bool parallel = false);
 
 protected:
     void didCompress(const CompressionTableBaseInfo *info) override final;
@@ -230,9 +283,19 @@ public:
     Optional<bool> mergeFTSIndex(TableArray newTables, TableArray modifiedTables);
     void proccessMerge();
     RecyclableHandle getMergeIndexHandle() override final;
+    void setMergeFTSIndexBudget(double budgetPerSecond);
+    uint64_t getMergeFTSIndexDebt() const;
 
 private:
     MergeFTSIndexLogic m_mergeLogic;
+
+#pragma mark - FTS Bulk Build
+public:
+    typedef FTSBulkBuilder::RowsProvider FTSRowsProvider;
+    typedef FTSBulkBuilder::Statistics FTSBulkBuildStatistics;
+    Optional<FTSBulkBuildStatistics> bulkBuildFTSIndex(const UnsafeStringView &table,
+                                                       const Columns &columns,
+                                                       const FTSRowsProvider &provider);
 };
 
 } //namespace WCDB
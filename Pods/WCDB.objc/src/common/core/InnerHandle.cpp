@@ -27,6 +27,7 @@
 #include "BusyRetryConfig.hpp"
 #include "CipherConfig.hpp"
 #include "CoreConst.h"
+#include "FTSTokenCache.hpp"
 
 namespace WCDB {
 
@@ -34,6 +35,7 @@ InnerHandle::InnerHandle()
 : m_type(HandleType::Normal)
 , m_writeHint(false)
 , m_mainStatement(nullptr)
+, m_ftsPretokenize(false)
 {
     m_mainStatement = getStatement();
 }
@@ -167,6 +169,11 @@ bool InnerHandle::configure()
     return true;
 }
 
+const Configs &InnerHandle::getConfigs() const
+{
+    return m_pendings;
+}
+
 #pragma mark - Statement
 bool InnerHandle::execute(const Statement &statement)
 {
@@ -421,6 +428,34 @@ bool InnerHandle::runPausableTransactionWithOneLoop(const TransactionCallbackFor
     return true;
 }
 
+#pragma mark - FTS Pretokenize
+void InnerHandle::setFTSPretokenizeEnable(bool enable)
+{
+    m_ftsPretokenize = enable;
+}
+
+bool InnerHandle::isFTSPretokenizeEnabled() const
+{
+    return m_ftsPretokenize;
+}
+
+bool InnerHandle::prepareFTSTokenCache(const UnsafeStringView &table, FTSTokenCache &cache)
+{
+    Optional<StringViewSet> sqls
+    = getValues(StatementSelect()
+                .select(Column("sql"))
+                .from("sqlite_master")
+                .where(Column("type") == "table" && Column("name") == table),
+                0);
+    if (!sqls.succeed()) {
+        return false;
+    }
+    if (!sqls.value().empty()) {
+        cache.useTokenizerOfTable(*sqls.value().begin());
+    }
+    return true;
+}
+
 ConfiguredHandle::~ConfiguredHandle() = default;
 
 } //namespace WCDB
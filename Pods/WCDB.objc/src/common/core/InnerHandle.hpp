@@ -32,6 +32,7 @@ namespace WCDB {
 
 class Handle;
 class HandleDecorator;
+class FTSTokenCache;
 
 HandleStatement *GetMainHandleStatement(InnerHandle *handle);
 
@@ -61,6 +62,7 @@ public:
 
 protected:
     bool configure();
+    const Configs &getConfigs() const;
 
 private:
     Configs m_invokeds;
@@ -128,6 +130,19 @@ public:
     bool runTransaction(const TransactionCallback &transaction);
     bool runTransactionIfNotInTransaction(const TransactionCallback &transaction);
     bool runPausableTransactionWithOneLoop(const TransactionCallbackForOneLoop &transaction);
+
+#pragma mark - FTS Pretokenize
+public:
+    // When inserting a batch of rows into a fts5 table, their texts are tokenized in parallel before the transaction begins,
+    // so that the tokenizer only replays the cached tokens while holding the write lock.
+    void setFTSPretokenizeEnable(bool enable);
+    bool isFTSPretokenizeEnabled() const;
+
+    // The cache is left without tokenizer if the table doesn't use a fts5 tokenizer registered in WCDB.
+    bool prepareFTSTokenCache(const UnsafeStringView &table, FTSTokenCache &cache);
+
+private:
+    bool m_ftsPretokenize;
 };
 
 class ConfiguredHandle final : public InnerHandle {
@@ -115,6 +115,7 @@ bool CipherHandle::openCipherInMemory()
 
 void CipherHandle::closeCipher()
 {
+    m_forks.clear();
     InnerHandle::close();
 }
 
@@ -150,11 +151,47 @@ bool CipherHandle::setCipherSalt(const UnsafeStringView &salt)
 
 bool CipherHandle::switchCipherSalt(const UnsafeStringView &salt)
 {
-    closeCipher();
+    // The forks might be in use. They are renewed when the contexts are acquired next time.
+    InnerHandle::close();
     if (!openCipherInMemory()) {
         return false;
     }
     return AbstractHandle::setCipherSalt(salt);
 }
 
+#pragma mark - Fork
+std::vector<void *> CipherHandle::getConcurrentCipherContexts(int count)
+{
+    WCTAssert(isOpened());
+    std::vector<void *> contexts;
+    StringView salt = getCipherSalt();
+    for (int i = 0; i < count; ++i) {
+        if (i < (int) m_forks.size() && !isForkUpToDate(m_forks[i].get(), salt)) {
+            m_forks.resize(i);
+        }
+        if (i == (int) m_forks.size()) {
+            std::unique_ptr<CipherHandle> fork(new CipherHandle());
+            fork->reconfigure(getConfigs());
+            if (!fork->openCipherInMemory()
+                || (!salt.empty() && !fork->setCipherSalt(salt))) {
+                break;
+            }
+            m_forks.push_back(std::move(fork));
+        }
+        void *context = m_forks[i]->getCipherContext();
+        if (context == nullptr) {
+            break;
+        }
+        contexts.push_back(context);
+    }
+    return contexts;
+}
+
+bool CipherHandle::isForkUpToDate(CipherHandle *fork, const UnsafeStringView &salt)
+{
+    WCTAssert(fork != nullptr);
+    return fork->isOpened() && fork->getConfigs() == getConfigs()
+           && fork->getCipherSalt() == salt;
+}
+
 } // namespace WCDB
@@ -51,6 +51,15 @@ public:
     bool setCipherSalt(const UnsafeStringView &salt) override final;
     bool switchCipherSalt(const UnsafeStringView &salt) override final;
     bool m_isInitializing;
+
+#pragma mark - Fork
+public:
+    std::vector<void *> getConcurrentCipherContexts(int count) override final;
+
+protected:
+    // The forks are configured with the configs of this handle, which contain the cipher key, and are renewed once the key or the salt changes.
+    bool isForkUpToDate(CipherHandle *fork, const UnsafeStringView &salt);
+    std::vector<std::unique_ptr<CipherHandle>> m_forks;
 };
 
 } // namespace WCDB
@@ -30,8 +30,11 @@
 #include "CoreConst.h"
 #include "Notifier.hpp"
 #include "Time.hpp"
+#include "WorkerPool.hpp"
+#include <atomic>
 #include <stdlib.h>
 #include <string.h>
+#include <thread>
 
 namespace WCDB {
 
@@ -45,6 +48,8 @@ CompressHandleOperator::CompressHandleOperator(InnerHandle* handle)
 , m_deleteRowStatement(handle->getStatement(DecoratorAllType))
 , m_insertNewRowStatement(handle->getStatement(DecoratorAllType))
 , m_updateRecordStatement(handle->getStatement(DecoratorAllType))
+, m_updateTuningStatement(handle->getStatement(DecoratorAllType))
+, m_numberOfRollbackThreads(1)
 {
 }
 
@@ -52,6 +57,7 @@ CompressHandleOperator::~CompressHandleOperator()
 {
     finalizeCompressionStatements();
     m_updateRecordStatement->finalize();
+    m_updateTuningStatement->finalize();
     InnerHandle* handle = getHandle();
     WCTAssert(handle != nullptr);
     handle->returnStatement(m_selectRowidStatement);
@@ -59,6 +65,7 @@ CompressHandleOperator::~CompressHandleOperator()
     handle->returnStatement(m_deleteRowStatement);
     handle->returnStatement(m_insertNewRowStatement);
     handle->returnStatement(m_updateRecordStatement);
+    handle->returnStatement(m_updateTuningStatement);
 }
 
 #pragma mark - Stepper
@@ -106,12 +113,20 @@ bool CompressHandleOperator::filterComplessingTables(std::set<const CompressionT
         allRecordsMap.emplace(row[0].textValue(),
                               { row[1].textValue(), row[2].intValue() });
     }
+    auto allTunings = getAllTunings();
+    if (allTunings.failed()) {
+        return false;
+    }
     for (auto iter = allTableInfos.begin(); iter != allTableInfos.end();) {
         auto recordIter = allRecordsMap.find((*iter)->getTable());
         if (recordIter == allRecordsMap.end()) {
             iter++;
             continue;
         }
+        auto tuningIter = allTunings.value().find((*iter)->getTable());
+        if (tuningIter != allTunings.value().end()) {
+            (*iter)->restoreTuning(tuningIter->second);
+        }
         const StringView& compression = recordIter->second.first;
         if (!(*iter)->shouldReplaceCompression()) {
             auto compressedColumns = parseColumns(compression);
@@ -311,8 +326,25 @@ bool CompressHandleOperator::compressRow(OneRowValue& row)
         }
 
         Value& compressedType = row[column.getTypeColumnIndex()];
+        if (column.hasSidecar()) {
+            if (column.getHashColumnIndex() >= row.size()
+                || column.getPrefixColumnIndex() >= row.size()) {
+                getHandle()->notifyError(
+                Error::Code::Error,
+                nullptr,
+                StringView::formatted("Sidecar columns of %s with index %u, %u out of range",
+                                      column.getColumn().data(),
+                                      column.getHashColumnIndex(),
+                                      column.getPrefixColumnIndex()));
+                return false;
+            }
+        }
         if (valueType < ColumnType::Text) {
             compressedType = CompressedType::None;
+            if (column.hasSidecar()) {
+                row[column.getHashColumnIndex()] = nullptr;
+                row[column.getPrefixColumnIndex()] = nullptr;
+            }
             continue;
         }
         UnsafeData data;
@@ -345,18 +377,26 @@ bool CompressHandleOperator::compressRow(OneRowValue& row)
             }
         }
 
+        if (column.hasSidecar()) {
+            row[column.getHashColumnIndex()] = CompressionColumnInfo::digest(data);
+            if (valueType == ColumnType::Text) {
+                row[column.getPrefixColumnIndex()]
+                = StringView(CompressionColumnInfo::prefix(value.textValue()));
+            } else {
+                row[column.getPrefixColumnIndex()] = nullptr;
+            }
+        }
+
         CompressedType toCompressedType = CompressedType::ZSTDDict;
         Optional<UnsafeData> compressedValue;
 
         switch (column.getCompressionType()) {
         case CompressionType::Normal: {
             toCompressedType = CompressedType::ZSTDNormal;
-            compressedValue
-            = CompressionCenter::shared().compressContent(data, 0, getHandle());
+            compressedValue = column.compressContent(data, 0, getHandle());
         } break;
         case CompressionType::Dict: {
-            compressedValue = CompressionCenter::shared().compressContent(
-            data, column.getDictId(), getHandle());
+            compressedValue = column.compressContent(data, column.getDictId(), getHandle());
         } break;
         case CompressionType::VariousDict: {
             if (column.getMatchColumnIndex() >= row.size()) {
@@ -369,7 +409,7 @@ bool CompressHandleOperator::compressRow(OneRowValue& row)
                 return false;
             }
             Value& matchValue = row[column.getMatchColumnIndex()];
-            compressedValue = CompressionCenter::shared().compressContent(
+            compressedValue = column.compressContent(
             data, column.getMatchDictId(matchValue), getHandle());
         } break;
         }
@@ -456,9 +496,56 @@ bool CompressHandleOperator::updateCompressionRecord()
     m_compressingTableInfo->getMinCompressedRowid(), 3);
     bool ret = m_updateRecordStatement->step();
     m_updateRecordStatement->reset();
+    return ret && updateCompressionTuning();
+}
+
+bool CompressHandleOperator::updateCompressionTuning()
+{
+    StringView tuning = m_compressingTableInfo->getTuningDescription();
+    if (tuning.empty()) {
+        // The tuning table is only created for the adaptive columns.
+        return true;
+    }
+    if (!m_updateTuningStatement->isPrepared()
+        && (!execute(CompressionTuning::getCreateTableStatement())
+            || !m_updateTuningStatement->prepare(CompressionTuning::getInsertValueStatement()))) {
+        return false;
+    }
+    m_updateTuningStatement->bindText(m_compressingTableInfo->getTable(), 1);
+    m_updateTuningStatement->bindText(tuning, 2);
+    bool ret = m_updateTuningStatement->step();
+    m_updateTuningStatement->reset();
     return ret;
 }
 
+Optional<StringViewMap<StringView>> CompressHandleOperator::getAllTunings()
+{
+    InnerHandle* handle = getHandle();
+    StringViewMap<StringView> allTunings;
+    auto exists = handle->tableExists(Schema::main(), CompressionTuning::tableName);
+    if (exists.failed()) {
+        return NullOpt;
+    }
+    if (!exists.value()) {
+        return allTunings;
+    }
+    StatementSelect select = StatementSelect()
+                             .select({ Column(CompressionTuning::columnTable), Column(CompressionTuning::columnTuning) })
+                             .from(CompressionTuning::tableName);
+    if (!handle->prepare(select)) {
+        return NullOpt;
+    }
+    auto rows = handle->getAllRows();
+    handle->finalize();
+    if (rows.failed()) {
+        return NullOpt;
+    }
+    for (auto& row : rows.value()) {
+        allTunings.emplace(row[0].textValue(), row[1].textValue());
+    }
+    return allTunings;
+}
+
 void CompressHandleOperator::reportPerformance(const UnsafeStringView& table)
 {
     Error error(Error::Code::Notice, Error::Level::Notice, "Compression performance");
@@ -482,7 +569,12 @@ InnerHandle* CompressHandleOperator::getCurrentHandle() const
     return getHandle();
 }
 
-bool CompressHandleOperator::rollbackCompression(const CompressionTableInfo* info)
+void CompressHandleOperator::setNumberOfRollbackThreads(int numberOfThreads)
+{
+    m_numberOfRollbackThreads = std::max(1, numberOfThreads);
+}
+
+bool CompressHandleOperator::rollbackCompression(const CompressionTableInfo* info, bool online)
 {
     clearProgress();
     auto compressedColumns = getCompressedColumns(info);
@@ -493,23 +585,85 @@ bool CompressHandleOperator::rollbackCompression(const CompressionTableInfo* inf
         finishProgress();
         return true;
     }
+    auto totalCount = getCompressedRowCount(info, compressedColumns.value());
+    if (totalCount.failed()) {
+        return false;
+    }
 
-    int64_t maxRowId = 0;
-    int64_t curMaxRowid = std::numeric_limits<int64_t>::max();
-    bool succeed = true;
-    while (curMaxRowid > 0) {
-        auto nextMaxRowid = batchRollbackCompression(
-        info, compressedColumns.value(), maxRowId, curMaxRowid);
-        succeed = nextMaxRowid.succeed() && getHandle()->checkpoint();
+    InnerHandle* handle = getHandle();
+    HandleStatement* selectCompressedRows = handle->getStatement(DecoratorAllType);
+    HandleStatement* updateCompressedColumn = handle->getStatement(DecoratorAllType);
+    bool succeed = selectCompressedRows->prepare(
+                   info->getSelectCompressedRowsStatement(&compressedColumns.value()))
+                   && updateCompressedColumn->prepare(
+                   info->getUpdateCompressColumnStatement(&compressedColumns.value()));
+    int64_t maxRowid = std::numeric_limits<int64_t>::max();
+    int64_t revertedCount = 0;
+    size_t batchCount = CompressionRollbackBatchCount;
+    bool finished = false;
+    while (succeed && !finished) {
+        size_t numberOfWrittenRows = 0;
+        // Rows are read and written in the same transaction so that the values written back are never stale.
+        succeed = handle->runTransaction([&](InnerHandle*) {
+            selectCompressedRows->reset();
+            selectCompressedRows->bindInteger(maxRowid, 1);
+            selectCompressedRows->bindInteger(batchCount, 2);
+            auto rows = selectCompressedRows->getAllRows();
+            selectCompressedRows->reset();
+            if (rows.failed()) {
+                return false;
+            }
+            if (rows.value().empty()) {
+                finished = true;
+                return true;
+            }
+            if (!decompressRows(info, compressedColumns.value(), rows.value())
+                || !writeDecompressedRows(info,
+                                          compressedColumns.value(),
+                                          rows.value(),
+                                          updateCompressedColumn,
+                                          numberOfWrittenRows)) {
+                return false;
+            }
+            WCTAssert(numberOfWrittenRows > 0);
+            // The unwritten rows of the batch are selected again in the next transaction.
+            maxRowid = rows.value()[numberOfWrittenRows - 1][0].intValue();
+            finished = numberOfWrittenRows == rows.value().size()
+                       && rows.value().size() < batchCount;
+            if (numberOfWrittenRows < rows.value().size()) {
+                // Select no more than what can be written between two busy signals, so that the decompressed values are not wasted.
+                batchCount = std::max<size_t>(CompressionRollbackBusyCheckInterval,
+                                              numberOfWrittenRows);
+            } else {
+                batchCount = std::min<size_t>(CompressionRollbackBatchCount, batchCount * 2);
+            }
+            return true;
+        });
         if (!succeed) {
-            return false;
+            break;
+        }
+        revertedCount += numberOfWrittenRows;
+        if (totalCount.value() > 0
+            && !updateProgress(std::min(1.0, (double) revertedCount / totalCount.value()))) {
+            succeed = false;
+            break;
+        }
+        succeed = handle->checkpoint();
+        if (succeed && online && handle->checkHasBusyRetry()) {
+            // Sleep after committing so that the foreground writers can take the lock before the next batch.
+            std::this_thread::sleep_for(
+            std::chrono::microseconds(CompressionRollbackYieldMicroseconds));
         }
-        curMaxRowid = nextMaxRowid.value();
     }
-    if (succeed) {
+    selectCompressedRows->finalize();
+    updateCompressedColumn->finalize();
+    handle->returnStatement(selectCompressedRows);
+    handle->returnStatement(updateCompressedColumn);
+
+    if (succeed && !online) {
         succeed
         = execute(CompressionRecord::getDeleteRecordStatement(info->getTable()));
-        succeed = succeed && getHandle()->checkpoint();
+        succeed = succeed && handle->checkpoint();
     }
     if (succeed) {
         finishProgress();
@@ -517,74 +671,76 @@ bool CompressHandleOperator::rollbackCompression(const CompressionTableInfo* inf
     return succeed;
 }
 
-Optional<int64_t> CompressHandleOperator::batchRollbackCompression(
-const CompressionTableInfo* info,
-const std::list<const CompressionColumnInfo*>& compressedColumns,
-int64_t& maxRowId,
-int64_t curRowId)
+Optional<int64_t>
+CompressHandleOperator::getCompressedRowCount(const CompressionTableInfo* info,
+                                              CompressionTableInfo::ColumnInfoPtrList& compressedColumns)
 {
-    bool ret = getHandle()->runTransaction([&](InnerHandle*) {
-        HandleStatement* selectRowid = getHandle()->getStatement(DecoratorAllType);
-        HandleStatement* selectCompressedColumn
-        = getHandle()->getStatement(DecoratorAllType);
-        HandleStatement* updateCompressedColumn
-        = getHandle()->getStatement(DecoratorAllType);
-
-        bool succeed
-        = selectRowid->prepare(info->getSelectCompressedRowIdStatement(curRowId));
-        succeed = succeed
-                  && selectCompressedColumn->prepare(
-                  info->getSelectCompressedRowStatement(&compressedColumns));
-        succeed = succeed
-                  && updateCompressedColumn->prepare(
-                  info->getUpdateCompressColumnStatement(&compressedColumns));
-
-        int updatedRowCount = 0;
-        if (succeed) {
-            while ((succeed = selectRowid->step()) && !selectRowid->done()) {
-                curRowId = selectRowid->getInteger();
-                if (maxRowId == 0) {
-                    maxRowId = curRowId;
-                }
-
-                succeed = info->stepSelectAndUpdateCompressedRowStatement(
-                selectCompressedColumn, updateCompressedColumn, curRowId);
-                if (!succeed) {
-                    break;
-                }
-
-                if (maxRowId > 0 && !updateProgress(((double) maxRowId - curRowId) / maxRowId)) {
-                    succeed = false;
-                    break;
-                }
+    HandleStatement* handleStatement = getHandle()->getStatement(DecoratorAllType);
+    Optional<int64_t> count;
+    if (handleStatement->prepare(info->getCountCompressedRowStatement(&compressedColumns))
+        && handleStatement->step()) {
+        count = handleStatement->getInteger();
+    }
+    handleStatement->finalize();
+    getHandle()->returnStatement(handleStatement);
+    return count;
+}
 
-                if (++updatedRowCount > 10 * CompressionBatchCount) {
-                    break;
-                }
-            }
-            if (selectRowid->done()) {
-                curRowId = 0;
+bool CompressHandleOperator::decompressRows(const CompressionTableInfo* info,
+                                            CompressionTableInfo::ColumnInfoPtrList& compressedColumns,
+                                            MultiRowsValue& rows)
+{
+    int numberOfThreads = std::min(m_numberOfRollbackThreads, (int) rows.size());
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    Error error;
+    WorkerPool::shared().parallel(numberOfThreads, [&](int) {
+        Error localError;
+        size_t index;
+        while (!failed.load() && (index = next++) < rows.size()) {
+            if (!info->decompressRow(rows[index], localError, &compressedColumns)
+                && !failed.exchange(true)) {
+                error = std::move(localError);
             }
         }
-
-        selectRowid->finalize();
-        selectCompressedColumn->finalize();
-        updateCompressedColumn->finalize();
-        getHandle()->returnStatement(selectRowid);
-        getHandle()->returnStatement(selectCompressedColumn);
-        getHandle()->returnStatement(updateCompressedColumn);
-        return succeed;
     });
-    if (ret) {
-        return curRowId;
-    } else {
-        return NullOpt;
+    if (failed.load()) {
+        getHandle()->notifyError(error.code(), nullptr, error.getMessage());
+        return false;
     }
+    return true;
+}
+
+bool CompressHandleOperator::writeDecompressedRows(const CompressionTableInfo* info,
+                                                   CompressionTableInfo::ColumnInfoPtrList& compressedColumns,
+                                                   const MultiRowsValue& rows,
+                                                   HandleStatement* update,
+                                                   size_t& numberOfWrittenRows)
+{
+    InnerHandle* handle = getHandle();
+    bool succeed = true;
+    while (numberOfWrittenRows < rows.size()) {
+        if (!info->stepUpdateDecompressedRowStatement(
+            update, rows[numberOfWrittenRows], &compressedColumns)) {
+            succeed = false;
+            break;
+        }
+        ++numberOfWrittenRows;
+        if (numberOfWrittenRows % CompressionRollbackBusyCheckInterval == 0
+            && handle->checkHasBusyRetry()) {
+            // Commit what is done and give way to the others.
+            break;
+        }
+    }
+    update->reset();
+    return succeed;
 }
 
 bool CompressHandleOperator::deleteCompressionRecord()
 {
-    return execute(CompressionRecord::getDropTableStatement());
+    m_updateTuningStatement->finalize();
+    return execute(CompressionRecord::getDropTableStatement())
+           && execute(CompressionTuning::getDropTableStatement());
 }
 
 bool CompressHandleOperator::execute(const Statement& statement)
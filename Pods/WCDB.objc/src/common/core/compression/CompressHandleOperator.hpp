@@ -40,9 +40,12 @@ public:
     Optional<StringViewSet> getAllTables() override final;
     bool filterComplessingTables(std::set<const CompressionTableInfo*>& allTableInfos) override final;
     Optional<bool> compressRows(const CompressionTableInfo* info) override final;
-    bool rollbackCompression(const CompressionTableInfo* info) override final;
+    bool rollbackCompression(const CompressionTableInfo* info, bool online) override final;
     bool deleteCompressionRecord() override final;
 
+    // Values are decompressed in parallel by the workers while rolling back if it's greater than 1, and they are always written by the current handle.
+    void setNumberOfRollbackThreads(int numberOfThreads);
+
 private:
     std::set<StringView> parseColumns(const StringView& compressRecord);
 
@@ -62,12 +65,19 @@ private:
     void resetCompressionStatements();
     void finalizeCompressionStatements();
     bool updateCompressionRecord();
+    bool updateCompressionTuning();
+    Optional<StringViewMap<StringView>> getAllTunings();
 
-    Optional<int64_t>
-    batchRollbackCompression(const CompressionTableInfo* info,
-                             const std::list<const CompressionColumnInfo*>& compressedColumns,
-                             int64_t& maxRowId,
-                             int64_t curRowId);
+    Optional<int64_t> getCompressedRowCount(const CompressionTableInfo* info,
+                                            CompressionTableInfo::ColumnInfoPtrList& compressedColumns);
+    bool decompressRows(const CompressionTableInfo* info,
+                        CompressionTableInfo::ColumnInfoPtrList& compressedColumns,
+                        MultiRowsValue& rows);
+    bool writeDecompressedRows(const CompressionTableInfo* info,
+                               CompressionTableInfo::ColumnInfoPtrList& compressedColumns,
+                               const MultiRowsValue& rows,
+                               HandleStatement* update,
+                               size_t& numberOfWrittenRows);
     bool execute(const Statement& statement);
     Optional<std::list<const CompressionColumnInfo*>>
     getCompressedColumns(const CompressionTableInfo* info);
@@ -80,6 +90,9 @@ private:
     HandleStatement* m_deleteRowStatement;
     HandleStatement* m_insertNewRowStatement;
     HandleStatement* m_updateRecordStatement;
+    HandleStatement* m_updateTuningStatement;
+
+    int m_numberOfRollbackThreads;
 
     CompressionPerformance m_performance;
     void reportPerformance(const UnsafeStringView& table);
@@ -32,6 +32,8 @@
 #include "StringView.hpp"
 #include "WINQ.h"
 #include <algorithm>
+#include <string.h>
+#include <vector>
 
 namespace WCDB {
 
@@ -43,6 +45,7 @@ CompressingStatementDecorator::CompressingStatementDecorator(Compression::Binder
 , m_processing(false)
 , m_compressFail(false)
 , m_compressionTableInfo(nullptr)
+, m_rewriting(nullptr)
 {
 }
 
@@ -52,6 +55,7 @@ CompressingStatementDecorator::CompressingStatementDecorator(CompressingStatemen
 , m_currentStatementType(other.m_currentStatementType)
 , m_processing(other.m_processing)
 , m_additionalStatements(std::move(other.m_additionalStatements))
+, m_rewriting(nullptr)
 {
     other.m_compressionBinder = nullptr;
     other.m_processing = false;
@@ -91,16 +95,10 @@ bool CompressingStatementDecorator::prepare(const Statement& statement)
     m_currentStatementType = statement.getType();
     switch (m_currentStatementType) {
     case StatementType::InsertSTMT:
-        ret = processInsert(static_cast<const StatementInsert&>(statement));
-        break;
     case StatementType::UpdateSTMT:
-        ret = processUpdate(static_cast<const StatementUpdate&>(statement));
-        break;
     case StatementType::SelectSTMT:
-        ret = processSelect(static_cast<const StatementSelect&>(statement));
-        break;
     case StatementType::DeleteSTMT:
-        ret = processDelete(static_cast<const StatementDelete&>(statement));
+        ret = prepareRewrittenStatement(statement);
         break;
     case StatementType::CreateTableSTMT:
         ret = processCreateTable(static_cast<const StatementCreateTable&>(statement));
@@ -179,6 +177,7 @@ void CompressingStatementDecorator::bindInteger(const Integer& value, int index)
             }
         } else {
             Super::bindInteger((Integer) CompressedType::None, info->typeBindIndex);
+            bindNullSidecarInInfo(info);
         }
     } else if (m_currentStatementType == StatementType::UpdateSTMT
                && !m_additionalStatements.empty()
@@ -205,6 +204,7 @@ void CompressingStatementDecorator::bindDouble(const Float& value, int index)
         }
         WCTAssert(index != info->typeBindIndex);
         Super::bindInteger((Integer) CompressedType::None, info->typeBindIndex);
+        bindNullSidecarInInfo(info);
     } else if (m_currentStatementType == StatementType::UpdateSTMT
                && !m_additionalStatements.empty()
                && m_additionalStatements.front().getBindParameterCount() >= index) {
@@ -231,7 +231,7 @@ void CompressingStatementDecorator::bindText(const Text& value, int index)
             if (!info->bindedValue.isNull()) {
                 Optional<UnsafeData> compressedValue;
                 if (m_compressionBinder->canCompressNewData()) {
-                    compressedValue = CompressionCenter::shared().compressContent(
+                    compressedValue = info->columnInfo->compressContent(
                     data,
                     info->columnInfo->getMatchDictId(info->bindedValue.intValue()),
                     static_cast<InnerHandle*>(getHandle()));
@@ -242,6 +242,7 @@ void CompressingStatementDecorator::bindText(const Text& value, int index)
                     m_compressFail = true;
                     return;
                 }
+                bindSidecarInInfo(info, data, true);
                 if (compressedValue.value().size() < value.size()) {
                     Super::bindBLOB(compressedValue.value(), info->columnBindIndex);
                     Super::bindInteger(WCDBMergeCompressionType(
@@ -265,7 +266,7 @@ void CompressingStatementDecorator::bindText(const Text& value, int index)
             = info->columnInfo->getCompressionType() == CompressionType::Dict;
             Optional<UnsafeData> compressedValue;
             if (m_compressionBinder->canCompressNewData()) {
-                compressedValue = CompressionCenter::shared().compressContent(
+                compressedValue = info->columnInfo->compressContent(
                 data,
                 usingDict ? info->columnInfo->getDictId() : 0,
                 static_cast<InnerHandle*>(getHandle()));
@@ -276,6 +277,7 @@ void CompressingStatementDecorator::bindText(const Text& value, int index)
                 m_compressFail = true;
                 return;
             }
+            bindSidecarInInfo(info, data, true);
             if (compressedValue.value().size() < value.size()) {
                 Super::bindBLOB(compressedValue.value(), info->columnBindIndex);
                 Super::bindInteger(
@@ -341,7 +343,7 @@ void CompressingStatementDecorator::bindBLOB(const BLOB& value, int index)
             if (!info->bindedValue.isNull()) {
                 Optional<UnsafeData> compressedValue;
                 if (m_compressionBinder->canCompressNewData()) {
-                    compressedValue = CompressionCenter::shared().compressContent(
+                    compressedValue = info->columnInfo->compressContent(
                     value,
                     info->columnInfo->getMatchDictId(info->bindedValue.intValue()),
                     static_cast<InnerHandle*>(getHandle()));
@@ -352,6 +354,7 @@ void CompressingStatementDecorator::bindBLOB(const BLOB& value, int index)
                     m_compressFail = true;
                     return;
                 }
+                bindSidecarInInfo(info, value, false);
                 if (compressedValue.value().size() < value.size()) {
                     Super::bindBLOB(compressedValue.value(), info->columnBindIndex);
                     Super::bindInteger(WCDBMergeCompressionType(
@@ -375,7 +378,7 @@ void CompressingStatementDecorator::bindBLOB(const BLOB& value, int index)
             = info->columnInfo->getCompressionType() == CompressionType::Dict;
             Optional<UnsafeData> compressedValue;
             if (m_compressionBinder->canCompressNewData()) {
-                compressedValue = CompressionCenter::shared().compressContent(
+                compressedValue = info->columnInfo->compressContent(
                 value,
                 usingDict ? info->columnInfo->getDictId() : 0,
                 static_cast<InnerHandle*>(getHandle()));
@@ -386,6 +389,7 @@ void CompressingStatementDecorator::bindBLOB(const BLOB& value, int index)
                 m_compressFail = true;
                 return;
             }
+            bindSidecarInInfo(info, value, false);
             if (compressedValue.value().size() < value.size()) {
                 Super::bindBLOB(compressedValue.value(), info->columnBindIndex);
                 Super::bindInteger(
@@ -434,6 +438,7 @@ void CompressingStatementDecorator::bindNull(int index)
             return;
         }
         Super::bindInteger((Integer) CompressedType::None, info->typeBindIndex);
+        bindNullSidecarInInfo(info);
     } else if (m_currentStatementType == StatementType::UpdateSTMT
                && !m_additionalStatements.empty()
                && m_additionalStatements.front().getBindParameterCount() >= index) {
@@ -457,12 +462,161 @@ void CompressingStatementDecorator::bindPointer(void* ptr,
     }
 }
 
+#pragma mark - Rewrite
+void CompressingStatementDecorator::Rewritten::addStatement(const Statement& statement)
+{
+    statements.push_back(statement);
+}
+
+void CompressingStatementDecorator::Rewritten::addMainStatement(const Statement& statement)
+{
+    WCTAssert(mainStatementIndex < 0);
+    mainStatementIndex = (int) statements.size();
+    statements.push_back(statement);
+}
+
+RewrittenStatementCache<CompressingStatementDecorator::Rewritten>&
+CompressingStatementDecorator::rewrittenStatementCache()
+{
+    static RewrittenStatementCache<Rewritten>* s_cache
+    = new RewrittenStatementCache<Rewritten>(DecoratorRewrittenStatementCacheCapacity);
+    return *s_cache;
+}
+
+bool CompressingStatementDecorator::prepareRewrittenStatement(const Statement& statement)
+{
+    const StringView& fingerprint = statement.getDescription();
+    uint64_t generation = m_compressionBinder->getGeneration();
+    std::shared_ptr<const Rewritten> rewritten
+    = rewrittenStatementCache().find(fingerprint, generation);
+    if (rewritten != nullptr) {
+        auto replayed = tryReplayTableInfos(*rewritten);
+        if (replayed.failed()) {
+            return false;
+        }
+        if (replayed.value()) {
+            restoreCompressionStatus(*rewritten);
+        } else {
+            rewritten = nullptr;
+        }
+    }
+    if (rewritten == nullptr) {
+        rewritten = process(statement);
+        if (rewritten == nullptr) {
+            return false;
+        }
+        rewrittenStatementCache().insert(fingerprint, generation, rewritten);
+    }
+    return prepareStatements(*rewritten);
+}
+
+std::shared_ptr<const CompressingStatementDecorator::Rewritten>
+CompressingStatementDecorator::process(const Statement& statement)
+{
+    std::shared_ptr<Rewritten> rewritten = std::make_shared<Rewritten>();
+    m_rewriting = rewritten.get();
+    bool succeed = false;
+    switch (statement.getType()) {
+    case StatementType::InsertSTMT:
+        succeed = processInsert(static_cast<const StatementInsert&>(statement), *rewritten);
+        break;
+    case StatementType::UpdateSTMT:
+        succeed = processUpdate(static_cast<const StatementUpdate&>(statement), *rewritten);
+        break;
+    case StatementType::SelectSTMT:
+        succeed = processSelect(static_cast<const StatementSelect&>(statement), *rewritten);
+        break;
+    case StatementType::DeleteSTMT:
+        succeed = processDelete(static_cast<const StatementDelete&>(statement), *rewritten);
+        break;
+    default:
+        WCTAssert(false);
+        break;
+    }
+    m_rewriting = nullptr;
+    if (!succeed) {
+        return nullptr;
+    }
+    WCTAssert(rewritten->mainStatementIndex >= 0);
+    saveCompressionStatus(*rewritten);
+    return rewritten;
+}
+
+Optional<bool> CompressingStatementDecorator::tryReplayTableInfos(const Rewritten& rewritten)
+{
+    // Infos are got again since it may check and add the compression columns for current handle.
+    for (const auto& tableInfo : rewritten.tableInfos) {
+        auto optionalTableInfo = m_compressionBinder->tryGetCompressionInfo(tableInfo.first);
+        if (!optionalTableInfo.hasValue()) {
+            return NullOpt;
+        }
+        if (optionalTableInfo.value() != tableInfo.second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CompressingStatementDecorator::saveCompressionStatus(Rewritten& rewritten) const
+{
+    rewritten.compressionTableInfo = m_compressionTableInfo;
+    rewritten.bindInfos = m_bindInfoList;
+    for (const auto& iter : m_bindInfoMap) {
+        if (iter.second == nullptr) {
+            continue;
+        }
+        int offset = 0;
+        for (const auto& bindInfo : m_bindInfoList) {
+            if (&bindInfo == iter.second) {
+                break;
+            }
+            offset++;
+        }
+        WCTAssert(offset < m_bindInfoList.size());
+        rewritten.bindInfoIndexes.emplace_back(iter.first, offset);
+    }
+    rewritten.compressingUpdateColumns = m_compressingUpdateColumns;
+}
+
+void CompressingStatementDecorator::restoreCompressionStatus(const Rewritten& rewritten)
+{
+    m_compressionTableInfo = rewritten.compressionTableInfo;
+    m_bindInfoList = rewritten.bindInfos;
+    std::vector<BindInfo*> bindInfos;
+    bindInfos.reserve(m_bindInfoList.size());
+    for (auto& bindInfo : m_bindInfoList) {
+        bindInfos.push_back(&bindInfo);
+    }
+    for (const auto& index : rewritten.bindInfoIndexes) {
+        WCTAssert(index.second < bindInfos.size());
+        m_bindInfoMap.emplace(index.first, bindInfos[index.second]);
+    }
+    m_compressingUpdateColumns = rewritten.compressingUpdateColumns;
+}
+
+bool CompressingStatementDecorator::prepareStatements(const Rewritten& rewritten)
+{
+    int index = 0;
+    for (const auto& statement : rewritten.statements) {
+        if (index++ == rewritten.mainStatementIndex) {
+            if (!Super::prepare(statement)) {
+                return false;
+            }
+        } else if (!addNewHandleStatement().prepare(statement)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 #pragma mark - Process Statement
-bool CompressingStatementDecorator::processInsert(const StatementInsert& insert)
+bool CompressingStatementDecorator::processInsert(const StatementInsert& insert,
+                                                  Rewritten& rewritten)
 {
     const Syntax::InsertSTMT& insertSTMT = insert.syntax();
     if (insertSTMT.switcher == Syntax::InsertSTMT::Switch::Default) {
-        return Super::prepare(insert);
+        rewritten.addMainStatement(insert);
+        return true;
     }
 
     // Get compression info
@@ -508,7 +662,8 @@ bool CompressingStatementDecorator::processInsert(const StatementInsert& insert)
     if (!needCompress && insertSTMT.switcher == Syntax::InsertSTMT::Switch::Values
         && !insertSTMT.upsertClause.hasValue()
         && insertSTMT.commonTableExpressions.empty()) {
-        return Super::prepare(insert);
+        rewritten.addMainStatement(insert);
+        return true;
     }
 
     StatementInsert newInsert = insert;
@@ -546,10 +701,19 @@ bool CompressingStatementDecorator::processInsert(const StatementInsert& insert)
             bindInfo.typeBindIndex = maxBindIndex;
             WCTAssert(m_bindInfoMap.find(maxBindIndex) == m_bindInfoMap.end());
             m_bindInfoMap.emplace(maxBindIndex, &bindInfo);
+            if (bindInfo.columnInfo->hasSidecar()) {
+                // ..., WCDB_CH_columnA, WCDB_CP_columnA) VALUES(...)
+                newInsertSTMT.columns.push_back(Column(bindInfo.columnInfo->getHashColumn()));
+                newInsertSTMT.expressionsValues.front().push_back(
+                Expression(BindParameter(++maxBindIndex)));
+                bindInfo.hashBindIndex = maxBindIndex;
+                newInsertSTMT.columns.push_back(Column(bindInfo.columnInfo->getPrefixColumn()));
+                newInsertSTMT.expressionsValues.front().push_back(
+                Expression(BindParameter(++maxBindIndex)));
+                bindInfo.prefixBindIndex = maxBindIndex;
+            }
         }
-        if (!Super::prepare(newInsert)) {
-            return false;
-        }
+        rewritten.addMainStatement(newInsert);
     } else {
         if (needCompress && newInsertSTMT.upsertClause.hasValue()) {
             const Syntax::UpsertClause& upsert = insertSTMT.upsertClause.value();
@@ -568,26 +732,17 @@ bool CompressingStatementDecorator::processInsert(const StatementInsert& insert)
                 }
             }
         }
-        if (!Super::prepare(newInsert)) {
-            return false;
-        }
+        rewritten.addMainStatement(newInsert);
         if (needCompress) {
-            HandleStatement& selectUncompressRow = addNewHandleStatement();
-            if (!selectUncompressRow.prepare(
-                m_compressionTableInfo->getSelectUncompressRowStatement())) {
-                return false;
-            }
-            HandleStatement& updateUncompressRow = addNewHandleStatement();
-            if (!updateUncompressRow.prepare(
-                m_compressionTableInfo->getUpdateCompressColumnStatement())) {
-                return false;
-            }
+            rewritten.addStatement(m_compressionTableInfo->getSelectUncompressRowStatement());
+            rewritten.addStatement(m_compressionTableInfo->getUpdateCompressColumnStatement());
         }
     }
     return true;
 }
 
-bool CompressingStatementDecorator::processUpdate(const StatementUpdate& update)
+bool CompressingStatementDecorator::processUpdate(const StatementUpdate& update,
+                                                  Rewritten& rewritten)
 {
     const Syntax::UpdateSTMT& updateSTMT = update.syntax();
 
@@ -654,15 +809,21 @@ bool CompressingStatementDecorator::processUpdate(const StatementUpdate& update)
             bindInfo.typeBindIndex = maxBindIndex;
             WCTAssert(m_bindInfoMap.find(maxBindIndex) == m_bindInfoMap.end());
             m_bindInfoMap.emplace(maxBindIndex, &bindInfo);
+            if (bindInfo.columnInfo->hasSidecar()) {
+                newUpdateSTMT.columnsList.push_back(
+                { Column(bindInfo.columnInfo->getHashColumn()) });
+                newUpdateSTMT.expressions.push_back(Expression(BindParameter(++maxBindIndex)));
+                bindInfo.hashBindIndex = maxBindIndex;
+                newUpdateSTMT.columnsList.push_back(
+                { Column(bindInfo.columnInfo->getPrefixColumn()) });
+                newUpdateSTMT.expressions.push_back(Expression(BindParameter(++maxBindIndex)));
+                bindInfo.prefixBindIndex = maxBindIndex;
+            }
         }
-        if (!Super::prepare(newUpdate)) {
-            return false;
-        }
+        rewritten.addMainStatement(newUpdate);
     } else {
         if (m_bindInfoList.empty()) {
-            if (!Super::prepare(newUpdate)) {
-                return false;
-            }
+            rewritten.addMainStatement(newUpdate);
         } else {
             // SELECT rowid[, dictMatchTypeColumn] FROM compressingTable WHERE ... ORDER BY ... LIMIT ... OFFSET ...
             StatementSelect selectRowid
@@ -715,6 +876,18 @@ bool CompressingStatementDecorator::processUpdate(const StatementUpdate& update)
                     bindInfo.typeBindIndex = maxBindIndex;
                     WCTAssert(m_bindInfoMap.find(maxBindIndex) == m_bindInfoMap.end());
                     m_bindInfoMap.emplace(maxBindIndex, &bindInfo);
+                    if (bindInfo.columnInfo->hasSidecar()) {
+                        newUpdateSTMT.columnsList.push_back(
+                        { Column(bindInfo.columnInfo->getHashColumn()) });
+                        newUpdateSTMT.expressions.push_back(
+                        Expression(BindParameter(++maxBindIndex)));
+                        bindInfo.hashBindIndex = maxBindIndex;
+                        newUpdateSTMT.columnsList.push_back(
+                        { Column(bindInfo.columnInfo->getPrefixColumn()) });
+                        newUpdateSTMT.expressions.push_back(
+                        Expression(BindParameter(++maxBindIndex)));
+                        bindInfo.prefixBindIndex = maxBindIndex;
+                    }
                 }
             } else {
                 // Set null to compressed type
@@ -728,27 +901,13 @@ bool CompressingStatementDecorator::processUpdate(const StatementUpdate& update)
             //Rowid must be binded to the largest index
             newUpdate.where(Column::rowid() == BindParameter(++maxBindIndex));
 
-            HandleStatement& selectRowidSTMT = addNewHandleStatement();
-            if (!selectRowidSTMT.prepare(selectRowid)) {
-                return false;
-            }
-
-            if (!Super::prepare(newUpdate)) {
-                return false;
-            }
-
+            rewritten.addStatement(selectRowid);
+            rewritten.addMainStatement(newUpdate);
             if (!selectMatchType) {
-                HandleStatement& selectUncompressRow = addNewHandleStatement();
-                if (!selectUncompressRow.prepare(m_compressionTableInfo->getSelectUncompressRowStatement(
-                    &m_compressingUpdateColumns))) {
-                    return false;
-                }
-
-                HandleStatement& updateUncompressRow = addNewHandleStatement();
-                if (!updateUncompressRow.prepare(m_compressionTableInfo->getUpdateCompressColumnStatement(
-                    &m_compressingUpdateColumns))) {
-                    return false;
-                }
+                rewritten.addStatement(m_compressionTableInfo->getSelectUncompressRowStatement(
+                &m_compressingUpdateColumns));
+                rewritten.addStatement(m_compressionTableInfo->getUpdateCompressColumnStatement(
+                &m_compressingUpdateColumns));
             }
         }
     }
@@ -815,16 +974,32 @@ HandleStatement& CompressingStatementDecorator::addNewHandleStatement()
     return m_additionalStatements.back();
 }
 
-bool CompressingStatementDecorator::processSelect(const StatementSelect& select)
+bool CompressingStatementDecorator::prepareTuningStatement(const Statement& statement)
+{
+    // The tuning table only exists when there are adaptive columns.
+    auto exists = getHandle()->tableExists(Schema::main(), CompressionTuning::tableName);
+    if (exists.failed()) {
+        return false;
+    }
+    if (!exists.value()) {
+        return true;
+    }
+    return addNewHandleStatement().prepare(statement);
+}
+
+bool CompressingStatementDecorator::processSelect(const StatementSelect& select,
+                                                  Rewritten& rewritten)
 {
     StatementSelect newSelect = select;
     if (!adaptCompressingColumn(newSelect)) {
         return false;
     }
-    return Super::prepare(newSelect);
+    rewritten.addMainStatement(newSelect);
+    return true;
 }
 
-bool CompressingStatementDecorator::processDelete(const StatementDelete& delete_)
+bool CompressingStatementDecorator::processDelete(const StatementDelete& delete_,
+                                                  Rewritten& rewritten)
 {
     const Syntax::DeleteSTMT& deleteSTMT = delete_.syntax();
 
@@ -836,7 +1011,8 @@ bool CompressingStatementDecorator::processDelete(const StatementDelete& delete_
     if (!adaptCompressingColumn(newDelete, nullptr, m_compressionTableInfo)) {
         return false;
     }
-    return Super::prepare(newDelete);
+    rewritten.addMainStatement(newDelete);
+    return true;
 }
 
 bool CompressingStatementDecorator::processCreateTable(const StatementCreateTable& createTable)
@@ -856,6 +1032,12 @@ bool CompressingStatementDecorator::processCreateTable(const StatementCreateTabl
     for (auto columnInfo : compressingColumns.value()) {
         newStatement.define(ColumnDef(columnInfo.getTypeColumn(), ColumnType::Integer)
                             .constraint(ColumnConstraint().default_(nullptr)));
+        if (columnInfo.hasSidecar()) {
+            newStatement.define(ColumnDef(columnInfo.getHashColumn(), ColumnType::Integer)
+                                .constraint(ColumnConstraint().default_(nullptr)));
+            newStatement.define(ColumnDef(columnInfo.getPrefixColumn(), ColumnType::Text)
+                                .constraint(ColumnConstraint().default_(nullptr)));
+        }
     }
     return Super::prepare(newStatement);
 }
@@ -887,7 +1069,8 @@ bool CompressingStatementDecorator::processDropTable(const StatementDropTable& d
             return false;
         }
     }
-    return true;
+    return prepareTuningStatement(
+    CompressionTuning::getDeleteTuningStatement(dropTable.syntax().table));
 }
 
 bool CompressingStatementDecorator::processAlterTable(const StatementAlterTable& alterTable)
@@ -928,14 +1111,15 @@ bool CompressingStatementDecorator::processAlterTable(const StatementAlterTable&
         }
         return false;
     }
-    return true;
+    return prepareTuningStatement(CompressionTuning::getUpdateTuningStatement(
+    alterTable.syntax().table, alterTable.syntax().newTable));
 }
 
 bool CompressingStatementDecorator::initCompressionTableInfo(const Syntax::Schema& schema,
                                                              const UnsafeStringView& table)
 {
     if (schema.isMain()) {
-        auto optionalTableInfo = m_compressionBinder->tryGetCompressionInfo(table);
+        auto optionalTableInfo = tryGetCompressionInfo(table);
         if (optionalTableInfo.failed()) {
             return false;
         }
@@ -944,6 +1128,24 @@ bool CompressingStatementDecorator::initCompressionTableInfo(const Syntax::Schem
     return true;
 }
 
+Optional<const CompressionTableInfo*>
+CompressingStatementDecorator::tryGetCompressionInfo(const UnsafeStringView& table)
+{
+    auto optionalTableInfo = m_compressionBinder->tryGetCompressionInfo(table);
+    if (m_rewriting != nullptr && optionalTableInfo.hasValue()) {
+        auto& tableInfos = m_rewriting->tableInfos;
+        if (std::find_if(tableInfos.begin(),
+                         tableInfos.end(),
+                         [&table](const std::pair<StringView, const CompressionTableInfo*>& tableInfo) {
+                             return tableInfo.first.equal(table);
+                         })
+            == tableInfos.end()) {
+            tableInfos.emplace_back(table, optionalTableInfo.value());
+        }
+    }
+    return optionalTableInfo;
+}
+
 /*
  Adapt compresssing columns in expression to decompress function.
  Eg:
@@ -961,7 +1163,8 @@ bool CompressingStatementDecorator::adaptCompressingColumn(Statement& statement,
         tableInfoStack.back().insert_or_assign(curInfo->getTable(), curInfo);
     }
     bool succeed = true;
-    std::unordered_map<Syntax::Expression*, const CompressionColumnInfo*> compressingColumns;
+    CompressingExpressions compressingColumns;
+    std::vector<Syntax::Expression*> predicates;
     statement.iterate([&](Syntax::Identifier& identifier, bool isBegin, bool& stop) {
         if (identifier.getType() == StatementType::SelectSTMT) {
             if (!isBegin) {
@@ -1027,6 +1230,10 @@ bool CompressingStatementDecorator::adaptCompressingColumn(Statement& statement,
                 return;
             }
             Syntax::Expression& expression = (Syntax::Expression&) identifier;
+            if (expression.switcher == Syntax::Expression::Switch::BinaryOperation) {
+                predicates.push_back(&expression);
+                return;
+            }
             if (expression.switcher == Syntax::Expression::Switch::BindParameter) {
                 if (expression.bindParameter().switcher
                     != Syntax::BindParameter::Switch::QuestionSign) {
@@ -1094,9 +1301,107 @@ bool CompressingStatementDecorator::adaptCompressingColumn(Statement& statement,
         expression.useWildcard = false;
     }
 
+    // Predicates are visited in preorder, so the inner ones are rewritten before the outer ones.
+    for (auto iter = predicates.rbegin(); iter != predicates.rend(); ++iter) {
+        tryFilterBySidecar(**iter, compressingColumns);
+    }
+
     return succeed;
 }
 
+/*
+ Check the sidecars before decompressing if possible.
+ Eg:
+    compressingColumnA = ?1
+ will be changed to
+    (WCDB_CT_compressingColumnA ISNULL OR WCDB_CH_compressingColumnA ISNULL OR WCDB_CH_compressingColumnA == wcdb_compression_digest(?1))
+    AND wcdb_decompress(compressingColumnA, WCDB_CT_compressingColumnA) = ?1
+ and
+    compressingColumnA LIKE 'abc%def'
+ will be changed to
+    (WCDB_CT_compressingColumnA ISNULL OR WCDB_CP_compressingColumnA ISNULL OR WCDB_CP_compressingColumnA LIKE 'abc%')
+    AND wcdb_decompress(compressingColumnA, WCDB_CT_compressingColumnA) LIKE 'abc%def'
+ Sidecars are only trusted when the row is compressed, since the uncompressed rows may not maintain them.
+ The stale ones, whose content is changed without them, are already reset by the trigger of CompressionTableInfo::getCreateSidecarTriggerStatement.
+ */
+void CompressingStatementDecorator::tryFilterBySidecar(Syntax::Expression& predicate,
+                                                       const CompressingExpressions& compressingExpressions)
+{
+    using BinaryOperator = Syntax::Expression::BinaryOperator;
+    if (predicate.expressions.size() != 2 || predicate.isNot || predicate.escape) {
+        return;
+    }
+    bool isEqual = predicate.binaryOperator == BinaryOperator::Equal;
+    bool isLike = predicate.binaryOperator == BinaryOperator::Like;
+    bool isGlob = predicate.binaryOperator == BinaryOperator::GLOB;
+    if (!isEqual && !isLike && !isGlob) {
+        return;
+    }
+    Syntax::Expression* decompressed = &predicate.expressions.front();
+    Syntax::Expression* operand = &predicate.expressions.back();
+    auto iter = compressingExpressions.find(decompressed);
+    if (iter == compressingExpressions.end() && isEqual) {
+        std::swap(decompressed, operand);
+        iter = compressingExpressions.find(decompressed);
+    }
+    if (iter == compressingExpressions.end() || !iter->second->hasSidecar()) {
+        return;
+    }
+    const CompressionColumnInfo* columnInfo = iter->second;
+    WCTAssert(decompressed->switcher == Syntax::Expression::Switch::Function
+              && decompressed->expressions.size() == 2);
+    const StringView& table = decompressed->expressions.front().column().table;
+
+    Expression sidecarCondition;
+    if (isEqual) {
+        // The operand is evaluated twice, so only literal values and numbered bind parameters are accepted.
+        if (operand->switcher == Syntax::Expression::Switch::BindParameter) {
+            if (operand->bindParameter().n <= 0) {
+                return;
+            }
+        } else if (operand->switcher != Syntax::Expression::Switch::LiteralValue) {
+            return;
+        }
+        Column hashColumn(columnInfo->getHashColumn());
+        hashColumn.syntax().table = table;
+        sidecarCondition = Expression(hashColumn).isNull()
+                           || Expression(hashColumn)
+                              == Expression::function(DigestFunctionName)
+                                 .invoke()
+                                 .arguments(Expression(Syntax::Expression(*operand)));
+    } else {
+        if (operand->switcher != Syntax::Expression::Switch::LiteralValue
+            || operand->literalValue().switcher != Syntax::LiteralValue::Switch::StringView) {
+            return;
+        }
+        // Any matched value starts with the leading characters before the first wildcard.
+        const StringView& pattern = operand->literalValue().stringValue;
+        const char* wildcards = isLike ? "%_" : "*?[";
+        size_t prefixLength = 0;
+        while (prefixLength < pattern.length()
+               && strchr(wildcards, pattern.data()[prefixLength]) == nullptr) {
+            prefixLength++;
+        }
+        if (prefixLength == 0) {
+            return;
+        }
+        UnsafeStringView prefix
+        = CompressionColumnInfo::prefix(UnsafeStringView(pattern.data(), prefixLength));
+        std::ostringstream stream;
+        stream << prefix << (isLike ? "%" : "*");
+        Column prefixColumn(columnInfo->getPrefixColumn());
+        prefixColumn.syntax().table = table;
+        Expression prefixPattern = LiteralValue(StringView(stream.str()));
+        sidecarCondition = Expression(prefixColumn).isNull()
+                           || (isLike ? Expression(prefixColumn).like(prefixPattern) :
+                                        Expression(prefixColumn).glob(prefixPattern));
+    }
+    Column typeColumn(columnInfo->getTypeColumn());
+    typeColumn.syntax().table = table;
+    Expression filter = Expression(typeColumn).isNull() || sidecarCondition;
+    predicate = filter && Expression(Syntax::Expression(predicate));
+}
+
 bool CompressingStatementDecorator::parseTable(const std::list<Syntax::TableOrSubquery>& tables,
                                                StringViewMap<const CompressionTableInfo*>& tableInfos)
 {
@@ -1105,8 +1410,7 @@ bool CompressingStatementDecorator::parseTable(const std::list<Syntax::TableOrSu
             if (!table.schema.isMain()) {
                 return true;
             }
-            auto tableInfo
-            = m_compressionBinder->tryGetCompressionInfo(table.tableOrFunction);
+            auto tableInfo = tryGetCompressionInfo(table.tableOrFunction);
             if (!tableInfo.hasValue()) {
                 return false;
             }
@@ -1148,7 +1452,7 @@ void CompressingStatementDecorator::bindValueInInfo(const BindInfo* info, const
     }
     Optional<UnsafeData> compressedValue;
     if (m_compressionBinder->canCompressNewData()) {
-        compressedValue = CompressionCenter::shared().compressContent(
+        compressedValue = info->columnInfo->compressContent(
         data,
         info->columnInfo->getMatchDictId(matchValue),
         static_cast<InnerHandle*>(getHandle()));
@@ -1159,6 +1463,7 @@ void CompressingStatementDecorator::bindValueInInfo(const BindInfo* info, const
         m_compressFail = true;
         return;
     }
+    bindSidecarInInfo(info, data, valueType == Value::Type::Text);
     if (compressedValue.value().size() < data.size()) {
         Super::bindBLOB(compressedValue.value(), info->columnBindIndex);
         Super::bindInteger(WCDBMergeCompressionType(CompressedType::ZSTDDict, valueType),
@@ -1178,6 +1483,32 @@ void CompressingStatementDecorator::bindValueInInfo(const BindInfo* info, const
     }
 }
 
+void CompressingStatementDecorator::bindSidecarInInfo(const BindInfo* info,
+                                                      const UnsafeData& value,
+                                                      bool isText)
+{
+    if (info->hashBindIndex <= 0) {
+        return;
+    }
+    Super::bindInteger(CompressionColumnInfo::digest(value), info->hashBindIndex);
+    if (isText) {
+        Super::bindText(CompressionColumnInfo::prefix(UnsafeStringView(
+                        (const char*) value.buffer(), value.size())),
+                        info->prefixBindIndex);
+    } else {
+        Super::bindNull(info->prefixBindIndex);
+    }
+}
+
+void CompressingStatementDecorator::bindNullSidecarInInfo(const BindInfo* info)
+{
+    if (info->hashBindIndex <= 0) {
+        return;
+    }
+    Super::bindNull(info->hashBindIndex);
+    Super::bindNull(info->prefixBindIndex);
+}
+
 #pragma mark - Step Statement
 
 bool CompressingStatementDecorator::realStep()
@@ -26,8 +26,10 @@
 
 #include "Compression.hpp"
 #include "DecorativeHandleStatement.hpp"
+#include "RewrittenStatementCache.hpp"
 #include <limits.h>
 #include <list>
+#include <memory>
 #include <unordered_map>
 
 namespace WCDB {
@@ -69,10 +71,11 @@ public:
 
 #pragma mark - Process Statement
 protected:
-    bool processInsert(const StatementInsert &insert);
-    bool processUpdate(const StatementUpdate &update);
-    bool processSelect(const StatementSelect &select);
-    bool processDelete(const StatementDelete &delete_);
+    struct Rewritten;
+    bool processInsert(const StatementInsert &insert, Rewritten &rewritten);
+    bool processUpdate(const StatementUpdate &update, Rewritten &rewritten);
+    bool processSelect(const StatementSelect &select, Rewritten &rewritten);
+    bool processDelete(const StatementDelete &delete_, Rewritten &rewritten);
 
     bool processCreateTable(const StatementCreateTable &createTable);
     bool processCreateView(const StatementCreateView &createView);
@@ -80,15 +83,20 @@ protected:
     bool processAlterTable(const StatementAlterTable &alterTable);
 
     bool initCompressionTableInfo(const Syntax::Schema &schema, const UnsafeStringView &table);
+    Optional<const CompressionTableInfo *> tryGetCompressionInfo(const UnsafeStringView &table);
     bool adaptCompressingColumn(Statement &statement,
                                 int *maxBindIndex = nullptr,
                                 const CompressionTableInfo *curInfo = nullptr);
+    typedef std::unordered_map<Syntax::Expression *, const CompressionColumnInfo *> CompressingExpressions;
+    static void tryFilterBySidecar(Syntax::Expression &predicate,
+                                   const CompressingExpressions &compressingExpressions);
     typedef StringViewMap<const CompressionTableInfo *> TableInfos;
     bool parseTable(const std::list<Syntax::TableOrSubquery> &tables, TableInfos &tableInfos);
     bool checkBindParametersExist(std::list<Syntax::Expression> &exps);
     Optional<int>
     getBindParameter(std::list<Syntax::Expression> &exps, std::pair<int, int> &index);
     HandleStatement &addNewHandleStatement();
+    bool prepareTuningStatement(const Statement &statement);
 
     void resetCompressionStatus();
 
@@ -98,12 +106,16 @@ protected:
         int columnBindIndex = 0;
         int typeBindIndex = 0;
         int matchColumnBindIndex = 0;
+        int hashBindIndex = 0;
+        int prefixBindIndex = 0;
         Value bindedValue;
         const CompressionColumnInfo *columnInfo = nullptr;
     } BindInfo;
 
     static const int SelectedMatchValueBindIndex = INT_MAX;
     void bindValueInInfo(const BindInfo *bindInfo, const Integer &matchValue);
+    void bindSidecarInInfo(const BindInfo *bindInfo, const UnsafeData &value, bool isText);
+    void bindNullSidecarInInfo(const BindInfo *bindInfo);
 
     using StatementType = Syntax::Identifier::Type;
     StatementType m_currentStatementType;
@@ -115,6 +127,35 @@ protected:
     std::unordered_map<int, BindInfo *> m_bindInfoMap;
     std::list<HandleStatement> m_additionalStatements;
 
+#pragma mark - Rewrite
+protected:
+    // Rewriting of DML only depends on the statement and the infos of the tables it visits,
+    // so it's shared among all handles and reused as long as the infos are the same.
+    struct Rewritten {
+        std::list<std::pair<StringView, const CompressionTableInfo *>> tableInfos;
+        const CompressionTableInfo *compressionTableInfo = nullptr;
+        std::list<BindInfo> bindInfos;
+        // bind index -> offset of bind info in bindInfos
+        std::list<std::pair<int, int>> bindInfoIndexes;
+        std::list<const CompressionColumnInfo *> compressingUpdateColumns;
+        // Statements are prepared in order. The main one is prepared by the decorated statement and the others are additional.
+        std::list<Statement> statements;
+        int mainStatementIndex = -1;
+
+        void addStatement(const Statement &statement);
+        void addMainStatement(const Statement &statement);
+    };
+    static RewrittenStatementCache<Rewritten> &rewrittenStatementCache();
+
+    bool prepareRewrittenStatement(const Statement &statement);
+    std::shared_ptr<const Rewritten> process(const Statement &statement);
+    // NullOpt for getting info failed and false for the infos are changed.
+    Optional<bool> tryReplayTableInfos(const Rewritten &rewritten);
+    void saveCompressionStatus(Rewritten &rewritten) const;
+    void restoreCompressionStatus(const Rewritten &rewritten);
+    bool prepareStatements(const Rewritten &rewritten);
+    Rewritten *m_rewriting;
+
 #pragma mark - Step Statement
 protected:
     bool realStep();
@@ -39,10 +39,12 @@ Compression::Compression(CompressionEvent* event)
 : m_dataVersion(0)
 , m_hasCreatedRecord(false)
 , m_canCompressNewData(true)
+, m_generation(0)
 , m_tableAcquired(false)
 , m_compressed(false)
 , m_event(event)
 {
+    updateGeneration();
 }
 
 void Compression::setTableFilter(const TableFilter& tableFilter)
@@ -70,6 +72,7 @@ void Compression::purge()
     m_filted.clear();
     // Invalidate all thread local data.
     m_dataVersion++;
+    updateGeneration();
 }
 
 void Compression::tryResetLocalStatus()
@@ -141,6 +144,7 @@ bool Compression::initInfo(InfoInitializer& initializer, const UnsafeStringView&
             const CompressionTableInfo* hold = &m_holder.back();
             m_filted.insert_or_assign(targetTable, hold);
             m_hints.erase(targetTable);
+            updateGeneration();
         }
     } else {
         iter->second->setNeedCheckColumns(true);
@@ -153,6 +157,7 @@ void Compression::markAsNoNeedToCompress(const UnsafeStringView& table)
     LockGuard lockGuard(m_lock);
     if (m_filted.find(table) == m_filted.end()) {
         m_filted.insert_or_assign(table, nullptr);
+        updateGeneration();
     }
     m_hints.erase(table);
 }
@@ -190,7 +195,7 @@ void Compression::markAsCompressed(const CompressionTableInfo* info)
 Optional<const CompressionTableInfo*> Compression::getInfo(const UnsafeStringView& table)
 {
     tryResetLocalStatus();
-    auto localFilted = m_localFilted.getOrCreate();
+    auto& localFilted = m_localFilted.getOrCreate();
     auto localIter = localFilted.find(table);
     if (localIter != localFilted.end()) {
         return localIter->second;
@@ -336,9 +341,12 @@ Compression::InfoInitializer::checkCompressingColumns(const CompressionTableInfo
         return NullOpt;
     }
     uint16_t newColumnIndex = (uint16_t) curColumns.size();
+    bool createdTrigger = false;
     for (auto& compressingColumn : compressingColumns) {
         uint16_t columnIndex = 0;
         bool findTypeColumn = false;
+        bool findHashColumn = false;
+        bool findPrefixColumn = false;
         for (const auto& column : curColumns) {
             if (column.equal(compressingColumn.getColumn())) {
                 compressingColumn.setColumnIndex(columnIndex);
@@ -347,6 +355,14 @@ Compression::InfoInitializer::checkCompressingColumns(const CompressionTableInfo
                 findTypeColumn = true;
             } else if (column.equal(compressingColumn.getMatchColumn())) {
                 compressingColumn.setMatchColumnIndex(columnIndex);
+            } else if (compressingColumn.hasSidecar()
+                       && column.equal(compressingColumn.getHashColumn())) {
+                compressingColumn.setHashColumnIndex(columnIndex);
+                findHashColumn = true;
+            } else if (compressingColumn.hasSidecar()
+                       && column.equal(compressingColumn.getPrefixColumn())) {
+                compressingColumn.setPrefixColumnIndex(columnIndex);
+                findPrefixColumn = true;
             }
             columnIndex++;
         }
@@ -361,8 +377,40 @@ Compression::InfoInitializer::checkCompressingColumns(const CompressionTableInfo
             compressingColumn.setTypeColumnIndex(newColumnIndex);
             newColumnIndex++;
         }
+        if (!compressingColumn.hasSidecar()) {
+            continue;
+        }
+        // Sidecars of existing rows stay null until they are compressed again.
+        if (!findHashColumn) {
+            if (!handle->addColumn(
+                Schema::main(),
+                tableName,
+                ColumnDef(compressingColumn.getHashColumn(), ColumnType::Integer)
+                .constraint(ColumnConstraint().default_(nullptr)))) {
+                return NullOpt;
+            }
+            compressingColumn.setHashColumnIndex(newColumnIndex);
+            newColumnIndex++;
+        }
+        if (!findPrefixColumn) {
+            if (!handle->addColumn(
+                Schema::main(),
+                tableName,
+                ColumnDef(compressingColumn.getPrefixColumn(), ColumnType::Text)
+                .constraint(ColumnConstraint().default_(nullptr)))) {
+                return NullOpt;
+            }
+            compressingColumn.setPrefixColumnIndex(newColumnIndex);
+            newColumnIndex++;
+        }
+        // Stale sidecars are reset by trigger, so that they are never trusted.
+        if (!handle->execute(info.getCreateSidecarTriggerStatement(compressingColumn))) {
+            return NullOpt;
+        }
+        // The trigger might be just created, which should be checked again if the transaction is rolled back.
+        createdTrigger = true;
     }
-    if (newColumnIndex != curColumns.size()) {
+    if (newColumnIndex != curColumns.size() || createdTrigger) {
         return true;
     }
     return false;
@@ -402,6 +450,11 @@ bool Compression::Binder::canCompressNewData() const
     return m_compression.canCompressNewData();
 }
 
+uint64_t Compression::Binder::getGeneration() const
+{
+    return m_compression.getGeneration();
+}
+
 bool Compression::canCompressNewData() const
 {
     return m_canCompressNewData;
@@ -412,6 +465,19 @@ void Compression::setCanCompressNewData(bool canCompress)
     m_canCompressNewData = canCompress;
 }
 
+#pragma mark - Generation
+uint64_t Compression::getGeneration() const
+{
+    return m_generation.load(std::memory_order_acquire);
+}
+
+void Compression::updateGeneration()
+{
+    // Shared by all compressions so that the generations of different databases never collide.
+    static std::atomic<uint64_t>* s_generation = new std::atomic<uint64_t>(0);
+    m_generation.store(++(*s_generation), std::memory_order_release);
+}
+
 #pragma mark - Step
 Compression::Stepper::~Stepper() = default;
 
@@ -444,7 +510,7 @@ Optional<bool> Compression::step(Compression::Stepper& stepper)
     return true;
 }
 
-bool Compression::rollbackCompression(Compression::Stepper& stepper)
+bool Compression::rollbackCompression(Compression::Stepper& stepper, bool online)
 {
     clearProgress();
     auto worked = tryAcquireTables(stepper);
@@ -462,7 +528,7 @@ bool Compression::rollbackCompression(Compression::Stepper& stepper)
         }
     }
     if (needRevertInfos.size() == 0) {
-        return stepper.deleteCompressionRecord();
+        return online || stepper.deleteCompressionRecord();
     }
 
     double tableWeight = 1.0 / needRevertInfos.size();
@@ -471,12 +537,16 @@ bool Compression::rollbackCompression(Compression::Stepper& stepper)
         return updateProgress(currentProgress + tableWeight * progress);
     });
     for (auto& info : needRevertInfos) {
-        bool ret = stepper.rollbackCompression(info);
+        bool ret = stepper.rollbackCompression(info, online);
         if (!ret) {
             return false;
         }
         currentProgress += tableWeight;
     }
+    if (online) {
+        finishProgress();
+        return true;
+    }
     bool ret = stepper.deleteCompressionRecord();
     if (ret) {
         finishProgress();
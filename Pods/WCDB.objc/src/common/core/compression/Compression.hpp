@@ -28,6 +28,7 @@
 #include "Lock.hpp"
 #include "Progress.hpp"
 #include "ThreadLocal.hpp"
+#include <atomic>
 #include <functional>
 #include <map>
 #include <set>
@@ -119,6 +120,7 @@ public:
         tryGetCompressingColumnsForNewTable(const UnsafeStringView& table);
         void notifyTransactionCommitted(bool committed);
         bool canCompressNewData() const;
+        uint64_t getGeneration() const;
 
     private:
         Compression& m_compression;
@@ -130,6 +132,17 @@ public:
 private:
     volatile bool m_canCompressNewData;
 
+#pragma mark - Generation
+public:
+    // It changes whenever the info of any table changes, and it's unique in process.
+    uint64_t getGeneration() const;
+
+protected:
+    void updateGeneration();
+
+private:
+    std::atomic<uint64_t> m_generation;
+
 #pragma mark - Step
 public:
     class Stepper : public InfoInitializer, public Progress {
@@ -146,13 +159,15 @@ public:
         virtual Optional<bool> compressRows(const CompressionTableInfo* info) = 0;
 
         typedef std::function<void(double)> ProgressCallback;
-        virtual bool rollbackCompression(const CompressionTableInfo* info) = 0;
+        // Rows are reverted in batches of write transactions. The record of the table is kept if it's online, since the others may still write compressed rows.
+        virtual bool rollbackCompression(const CompressionTableInfo* info, bool online) = 0;
         virtual bool deleteCompressionRecord() = 0;
     };
 
     Optional<bool> step(Compression::Stepper& stepper);
 
-    bool rollbackCompression(Compression::Stepper& stepper);
+    // Online rollback reverts the existing rows while the others are still working, and leaves the records and the configs to the one while closing.
+    bool rollbackCompression(Compression::Stepper& stepper, bool online);
 
 protected:
     // worked
@@ -38,6 +38,7 @@
 namespace WCDB {
 
 CompressionCenter::CompressionCenter()
+: m_decompressedValues(CompressionDecompressedCacheBudget)
 {
     m_dicts = (ZSTDDict**) calloc(MaxDictId, sizeof(ZSTDDict*));
     WCTAssert(m_dicts != nullptr);
@@ -54,6 +55,28 @@ CompressionCenter& CompressionCenter::shared()
     return *g_dictCenter;
 }
 
+void CompressionCenter::setDecompressedValueCacheBudget(size_t budget)
+{
+    m_decompressedValues.setBudget(budget);
+}
+
+CompressionCenter::DecompressedValueCacheStatistics
+CompressionCenter::getDecompressedValueCacheStatistics() const
+{
+    return m_decompressedValues.getStatistics();
+}
+
+Optional<UnsafeData>
+CompressionCenter::decompressContent(const UnsafeData& data, bool usingDict, InnerHandle* handle)
+{
+    Error error;
+    auto decompressed = decompressContent(data, usingDict, error);
+    if (decompressed.failed()) {
+        handle->notifyError(error.code(), nullptr, error.getMessage());
+    }
+    return decompressed;
+}
+
 ZSTDDict* CompressionCenter::getDict(DictId id) const
 {
     if (id >= MaxDictId || id == 0) {
@@ -174,7 +197,10 @@ Optional<Data> CompressionCenter::trainDict(DictId dictId, TrainDataEnumerator d
 }
 
 Optional<UnsafeData>
-CompressionCenter::compressContent(const UnsafeData& data, DictId dictId, InnerHandle* errorReportHandle)
+CompressionCenter::compressContent(const UnsafeData& data,
+                                   DictId dictId,
+                                   InnerHandle* errorReportHandle,
+                                   int level)
 {
     if (data.size() == 0) {
         return data;
@@ -219,6 +245,8 @@ CompressionCenter::compressContent(const UnsafeData& data, DictId dictId, InnerH
                                                 data.size(),
                                                 (ZSTD_CDict*) dict->getCDict());
     } else {
+        ZSTD_CCtx_setParameter(
+        (ZSTD_CCtx*) ctx.getOrCreateCCtx(), ZSTD_c_compressionLevel, level);
         compressSize = ZSTD_compress2((ZSTD_CCtx*) ctx.getOrCreateCCtx(),
                                       buffer,
                                       boundSize,
@@ -243,6 +271,17 @@ void CompressionCenter::decompressContent(const UnsafeData& data,
                                           ColumnType originType,
                                           ScalarFunctionAPI& resultAPI)
 {
+    auto cached = m_decompressedValues.find(data, usingDict);
+    if (cached != nullptr) {
+        const UnsafeData& value = cached->second;
+        if (originType == ColumnType::Text) {
+            resultAPI.setTextResult(
+            UnsafeStringView((const char*) value.buffer(), value.size()));
+        } else {
+            resultAPI.setBlobResult(value);
+        }
+        return;
+    }
     int64_t frameSize = ZSTD_getFrameContentSize(data.buffer(), data.size());
     if (ZSTD_isError(frameSize)) {
         resultAPI.setErrorResult(Error::Code::ZstdError,
@@ -292,6 +331,9 @@ void CompressionCenter::decompressContent(const UnsafeData& data,
                                           ZSTD_getErrorName(decompressSize)));
         Notifier::shared().notify(error);
         decompressSize = 0;
+    } else {
+        m_decompressedValues.insert(
+        data, usingDict, UnsafeData((unsigned char*) buffer, decompressSize));
     }
     if (originType == ColumnType::Text) {
         resultAPI.setTextResult(UnsafeStringView((char*) buffer, decompressSize));
@@ -301,34 +343,34 @@ void CompressionCenter::decompressContent(const UnsafeData& data,
 }
 
 Optional<UnsafeData>
-CompressionCenter::decompressContent(const UnsafeData& data, bool usingDict, InnerHandle* handle)
+CompressionCenter::decompressContent(const UnsafeData& data, bool usingDict, Error& error)
 {
     int64_t frameSize = ZSTD_getFrameContentSize(data.buffer(), data.size());
     if (ZSTD_isError(frameSize)) {
-        handle->notifyError(Error::Code::ZstdError,
-                            nullptr,
-                            StringView::formatted("Get compress content frame size fail: %s",
-                                                  ZSTD_getErrorName(frameSize)));
+        error = Error(Error::Code::ZstdError,
+                      Error::Level::Error,
+                      StringView::formatted("Get compress content frame size fail: %s",
+                                            ZSTD_getErrorName(frameSize)));
         return NullOpt;
     }
     ZSTDContext& ctx = m_ctxes.getOrCreate();
     void* buffer = ctx.getOrCreateBuffer(frameSize);
     if (buffer == nullptr) {
-        handle->notifyError(Error::Code::NoMemory, nullptr, "Decompress fail due to no memory");
+        error = Error(Error::Code::NoMemory, Error::Level::Error, "Decompress fail due to no memory");
         return NullOpt;
     }
     int64_t decompressSize = 0;
     if (usingDict) {
         DictId dictId = (DictId) ZSTD_getDictID_fromFrame(data.buffer(), data.size());
         if (dictId == 0) {
-            handle->notifyError(Error::Code::ZstdError, nullptr, "Can not decode dictid");
+            error = Error(Error::Code::ZstdError, Error::Level::Error, "Can not decode dictid");
             return NullOpt;
         }
         ZSTDDict* dict = getDict(dictId);
         if (dict == nullptr) {
-            handle->notifyError(
+            error = Error(
             Error::Code::ZstdError,
-            nullptr,
+            Error::Level::Error,
             StringView::formatted("Can not find decompress dict with id: %d", dictId));
             return NullOpt;
         }
@@ -348,11 +390,11 @@ CompressionCenter::decompressContent(const UnsafeData& data, bool usingDict, Inn
 
     if (ZSTD_isError(decompressSize)) {
         // The data is corrupted and not recoverable. Just ignore it.
-        Error error(Error::Code::ZstdError,
-                    Error::Level::Error,
-                    StringView::formatted("Decompress fail: %s",
-                                          ZSTD_getErrorName(decompressSize)));
-        Notifier::shared().notify(error);
+        Error corruptedError(Error::Code::ZstdError,
+                             Error::Level::Error,
+                             StringView::formatted("Decompress fail: %s",
+                                                   ZSTD_getErrorName(decompressSize)));
+        Notifier::shared().notify(corruptedError);
         decompressSize = 0;
     }
     return UnsafeData((unsigned char*) buffer, decompressSize);
@@ -427,7 +469,7 @@ Optional<Data> CompressionCenter::trainDict(DictId, TrainDataEnumerator)
 }
 
 Optional<UnsafeData>
-CompressionCenter::compressContent(const UnsafeData&, DictId, InnerHandle* errorReportHandle)
+CompressionCenter::compressContent(const UnsafeData&, DictId, InnerHandle* errorReportHandle, int)
 {
     errorReportHandle->notifyError(
     Error::Code::ZstdError, nullptr, "You need to build WCDB with WCDB_ZSTD macro");
@@ -435,10 +477,10 @@ CompressionCenter::compressContent(const UnsafeData&, DictId, InnerHandle* error
 }
 
 Optional<UnsafeData>
-CompressionCenter::decompressContent(const UnsafeData& data, bool usingDict, InnerHandle* handle)
+CompressionCenter::decompressContent(const UnsafeData&, bool, Error& error)
 {
-    handle->notifyError(
-    Error::Code::ZstdError, nullptr, "You need to build WCDB with WCDB_ZSTD macro");
+    error = Error(
+    Error::Code::ZstdError, Error::Level::Error, "You need to build WCDB with WCDB_ZSTD macro");
     return NullOpt;
 }
 
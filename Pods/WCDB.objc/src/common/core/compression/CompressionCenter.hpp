@@ -26,6 +26,7 @@
 
 #include "ColumnType.hpp"
 #include "CompressionConst.hpp"
+#include "DecompressedValueCache.hpp"
 #include "ThreadLocal.hpp"
 #include "ZSTDContext.hpp"
 #include "ZSTDDict.hpp"
@@ -52,23 +53,35 @@ public:
     typedef std::function<Optional<UnsafeData>()> TrainDataEnumerator;
     Optional<Data> trainDict(DictId dictId, TrainDataEnumerator dataEnummerator);
 
-    Optional<UnsafeData>
-    compressContent(const UnsafeData& data, DictId dictId, InnerHandle* errorReportHandle);
+    // Level only works without dict, since the level of dict is fixed when it's loaded. 0 for the default level.
+    Optional<UnsafeData> compressContent(const UnsafeData& data,
+                                         DictId dictId,
+                                         InnerHandle* errorReportHandle,
+                                         int level = 0);
     void decompressContent(const UnsafeData& data,
                            bool usingDict,
                            ColumnType originType,
                            ScalarFunctionAPI& resultAPI);
     Optional<UnsafeData>
     decompressContent(const UnsafeData& data, bool usingDict, InnerHandle* handle);
+    // It can be called in the threads without handle, and the error is returned instead of being reported.
+    Optional<UnsafeData>
+    decompressContent(const UnsafeData& data, bool usingDict, Error& error);
 
     bool testContentCanBeDecompressed(const UnsafeData& data,
                                       bool usingDict,
                                       InnerHandle* errorReportHandle);
 
+    // 0 to disable the cache of decompressed values.
+    void setDecompressedValueCacheBudget(size_t budget);
+    typedef DecompressedValueCache::Statistics DecompressedValueCacheStatistics;
+    DecompressedValueCacheStatistics getDecompressedValueCacheStatistics() const;
+
 private:
     ZSTDDict* getDict(DictId id) const;
     ZSTDDict** m_dicts;
     ThreadLocal<ZSTDContext> m_ctxes;
+    DecompressedValueCache m_decompressedValues;
 };
 
 } // namespace WCDB
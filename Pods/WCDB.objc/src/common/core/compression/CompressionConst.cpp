@@ -27,12 +27,20 @@
 namespace WCDB {
 
 WCDBLiteralStringImplement(DecompressFunctionName);
+WCDBLiteralStringImplement(DigestFunctionName);
 
 WCDBLiteralStringImplement(CompressionRecordTable);
 WCDBLiteralStringImplement(CompressionRecordColumn_Table);
 WCDBLiteralStringImplement(CompressionRecordColumn_Columns);
 WCDBLiteralStringImplement(CompressionRecordColumn_Rowid);
 
+WCDBLiteralStringImplement(CompressionTuningTable);
+WCDBLiteralStringImplement(CompressionTuningColumn_Table);
+WCDBLiteralStringImplement(CompressionTuningColumn_Tuning);
+
 WCDBLiteralStringImplement(CompressionColumnTypePrefix);
+WCDBLiteralStringImplement(CompressionColumnHashPrefix);
+WCDBLiteralStringImplement(CompressionColumnPrefixPrefix);
+WCDBLiteralStringImplement(CompressionSidecarTriggerPrefix);
 
 } // namespace WCDB
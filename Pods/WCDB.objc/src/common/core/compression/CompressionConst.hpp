@@ -43,14 +43,48 @@ enum class CompressedType {
     ((((mergeType) & 0x1) > 0) ? WCDB::ColumnType::BLOB : WCDB::ColumnType::Text)
 
 WCDBLiteralStringDefine(DecompressFunctionName, "wcdb_decompress");
+WCDBLiteralStringDefine(DigestFunctionName, "wcdb_compression_digest");
 
 WCDBLiteralStringDefine(CompressionRecordTable, "wcdb_builtin_compression_record");
 WCDBLiteralStringDefine(CompressionRecordColumn_Table, "tableName");
 WCDBLiteralStringDefine(CompressionRecordColumn_Columns, "columns");
 WCDBLiteralStringDefine(CompressionRecordColumn_Rowid, "rowid");
 
+WCDBLiteralStringDefine(CompressionTuningTable, "wcdb_builtin_compression_tuning");
+WCDBLiteralStringDefine(CompressionTuningColumn_Table, "tableName");
+WCDBLiteralStringDefine(CompressionTuningColumn_Tuning, "tuning");
+
 const char CompressionRecordColumnSeperater = ' ';
 
 WCDBLiteralStringDefine(CompressionColumnTypePrefix, "WCDB_CT_")
+WCDBLiteralStringDefine(CompressionColumnHashPrefix, "WCDB_CH_")
+WCDBLiteralStringDefine(CompressionColumnPrefixPrefix, "WCDB_CP_")
+WCDBLiteralStringDefine(CompressionSidecarTriggerPrefix, "wcdb_sidecar_")
+
+// Count of utf8 characters kept in the prefix sidecar column.
+const int CompressionSidecarPrefixLength = 16;
+
+// Memory budget of the decompressed values cached among all handles.
+const size_t CompressionDecompressedCacheBudget = 4 * 1024 * 1024;
+// Values larger than 1/ratio of the budget are not cached, so that a few huge ones won't flush the cache.
+const size_t CompressionDecompressedCacheEntryRatio = 16;
+
+// A size bucket of values is not worth compressing when less than 1/ratio of it is saved.
+const int CompressionTunerMinSavingRatio = 16;
+// Samples needed before a size bucket can be judged, and the samples it keeps at most before decaying.
+const uint32_t CompressionTunerMinSamples = 16;
+const uint32_t CompressionTunerMaxSamples = 256;
+// One of the values below the learned min size is still compressed per interval to keep probing.
+const uint32_t CompressionTunerProbeInterval = 32;
+// Count of compressions spent on trying levels in each retune interval.
+const uint32_t CompressionTunerLevelTrialCount = 128;
+const uint32_t CompressionTunerRetuneInterval = 4096;
+// Bytes that a microsecond of cpu time is worth when picking level.
+const double CompressionTunerBytesPerMicrosecond = 2;
+
+#define WCDBIsCompressionColumn(name)                                          \
+    ((name).hasPrefix(WCDB::CompressionColumnTypePrefix)                       \
+     || (name).hasPrefix(WCDB::CompressionColumnHashPrefix)                    \
+     || (name).hasPrefix(WCDB::CompressionColumnPrefixPrefix))
 
 } //namespace WCDB
@@ -29,6 +29,7 @@
 #include "CoreConst.h"
 #include "HandleStatement.hpp"
 #include "InnerHandle.hpp"
+#include "Time.hpp"
 #include "WINQ.h"
 
 namespace WCDB {
@@ -38,6 +39,8 @@ CompressionColumnInfo::CompressionColumnInfo(const Column &column, CompressionTy
 : m_columnIndex(UINT16_MAX)
 , m_typeColumnIndex(UINT16_MAX)
 , m_matchColumnIndex(UINT16_MAX)
+, m_hashColumnIndex(UINT16_MAX)
+, m_prefixColumnIndex(UINT16_MAX)
 , m_compressionType(type)
 , m_commonDictID(-1)
 {
@@ -51,6 +54,8 @@ CompressionColumnInfo::CompressionColumnInfo(const Column &column, const Column
 , m_typeColumnIndex(UINT16_MAX)
 , m_matchColumn(matchColumn.syntax().name)
 , m_matchColumnIndex(UINT16_MAX)
+, m_hashColumnIndex(UINT16_MAX)
+, m_prefixColumnIndex(UINT16_MAX)
 , m_compressionType(CompressionType::VariousDict)
 , m_commonDictID(-1)
 {
@@ -65,6 +70,11 @@ CompressionColumnInfo::CompressionColumnInfo(const CompressionColumnInfo &other)
 , m_typeColumnIndex(other.m_typeColumnIndex.load())
 , m_matchColumn(other.m_matchColumn)
 , m_matchColumnIndex(other.m_matchColumnIndex.load())
+, m_hashColumn(other.m_hashColumn)
+, m_hashColumnIndex(other.m_hashColumnIndex.load())
+, m_prefixColumn(other.m_prefixColumn)
+, m_prefixColumnIndex(other.m_prefixColumnIndex.load())
+, m_tuner(other.m_tuner)
 , m_compressionType(other.m_compressionType)
 , m_commonDictID(other.m_commonDictID)
 , m_matchDicts(other.m_matchDicts)
@@ -77,6 +87,11 @@ CompressionColumnInfo::CompressionColumnInfo(CompressionColumnInfo &&other)
 , m_typeColumnIndex(other.m_typeColumnIndex.load())
 , m_matchColumn(std::move(other.m_matchColumn))
 , m_matchColumnIndex(other.m_matchColumnIndex.load())
+, m_hashColumn(std::move(other.m_hashColumn))
+, m_hashColumnIndex(other.m_hashColumnIndex.load())
+, m_prefixColumn(std::move(other.m_prefixColumn))
+, m_prefixColumnIndex(other.m_prefixColumnIndex.load())
+, m_tuner(std::move(other.m_tuner))
 , m_compressionType(other.m_compressionType)
 , m_commonDictID(other.m_commonDictID)
 , m_matchDicts(std::move(other.m_matchDicts))
@@ -90,6 +105,11 @@ CompressionColumnInfo &CompressionColumnInfo::operator=(const CompressionColumnI
     m_typeColumnIndex = other.m_typeColumnIndex.load();
     m_matchColumn = other.m_matchColumn;
     m_matchColumnIndex = other.m_matchColumnIndex.load();
+    m_hashColumn = other.m_hashColumn;
+    m_hashColumnIndex = other.m_hashColumnIndex.load();
+    m_prefixColumn = other.m_prefixColumn;
+    m_prefixColumnIndex = other.m_prefixColumnIndex.load();
+    m_tuner = other.m_tuner;
     m_compressionType = other.m_compressionType;
     m_commonDictID = other.m_commonDictID;
     m_matchDicts = other.m_matchDicts;
@@ -103,6 +123,11 @@ CompressionColumnInfo &CompressionColumnInfo::operator=(CompressionColumnInfo &&
     m_typeColumnIndex = other.m_typeColumnIndex.load();
     m_matchColumn = std::move(other.m_matchColumn);
     m_matchColumnIndex = other.m_matchColumnIndex.load();
+    m_hashColumn = std::move(other.m_hashColumn);
+    m_hashColumnIndex = other.m_hashColumnIndex.load();
+    m_prefixColumn = std::move(other.m_prefixColumn);
+    m_prefixColumnIndex = other.m_prefixColumnIndex.load();
+    m_tuner = std::move(other.m_tuner);
     m_compressionType = other.m_compressionType;
     m_commonDictID = other.m_commonDictID;
     m_matchDicts = std::move(other.m_matchDicts);
@@ -157,6 +182,121 @@ uint16_t CompressionColumnInfo::getMatchColumnIndex() const
     return m_matchColumnIndex;
 }
 
+void CompressionColumnInfo::enableSidecar()
+{
+    StringView column = getColumn();
+    std::ostringstream stringStream;
+    stringStream << CompressionColumnHashPrefix << column;
+    m_hashColumn = StringView(stringStream.str());
+    stringStream.str("");
+    stringStream << CompressionColumnPrefixPrefix << column;
+    m_prefixColumn = StringView(stringStream.str());
+}
+
+bool CompressionColumnInfo::hasSidecar() const
+{
+    return !m_hashColumn.empty();
+}
+
+void CompressionColumnInfo::enableAdaptiveCompression()
+{
+    m_tuner = std::make_shared<CompressionTuner>(m_compressionType == CompressionType::Normal);
+}
+
+bool CompressionColumnInfo::isAdaptive() const
+{
+    return m_tuner != nullptr;
+}
+
+CompressionTuner *CompressionColumnInfo::getTuner() const
+{
+    return m_tuner.get();
+}
+
+Optional<UnsafeData> CompressionColumnInfo::compressContent(const UnsafeData &data,
+                                                            DictId dictId,
+                                                            InnerHandle *handle) const
+{
+    if (m_tuner == nullptr) {
+        return CompressionCenter::shared().compressContent(data, dictId, handle);
+    }
+    CompressionTuner::Decision decision = m_tuner->decide(data.size());
+    if (!decision.compress) {
+        return data;
+    }
+    SteadyClock start = SteadyClock::now();
+    auto compressed
+    = CompressionCenter::shared().compressContent(data, dictId, handle, decision.level);
+    if (compressed.succeed()) {
+        m_tuner->didCompress(decision,
+                             data.size(),
+                             compressed.value().size(),
+                             SteadyClock::timeIntervalSinceSteadyClockToNow(start));
+    }
+    return compressed;
+}
+
+const StringView &CompressionColumnInfo::getHashColumn() const
+{
+    return m_hashColumn;
+}
+
+void CompressionColumnInfo::setHashColumnIndex(uint16_t index) const
+{
+    m_hashColumnIndex = index;
+}
+
+uint16_t CompressionColumnInfo::getHashColumnIndex() const
+{
+    WCTAssert(m_hashColumnIndex != UINT16_MAX);
+    return m_hashColumnIndex;
+}
+
+const StringView &CompressionColumnInfo::getPrefixColumn() const
+{
+    return m_prefixColumn;
+}
+
+void CompressionColumnInfo::setPrefixColumnIndex(uint16_t index) const
+{
+    m_prefixColumnIndex = index;
+}
+
+uint16_t CompressionColumnInfo::getPrefixColumnIndex() const
+{
+    WCTAssert(m_prefixColumnIndex != UINT16_MAX);
+    return m_prefixColumnIndex;
+}
+
+CompressionColumnInfo::Integer CompressionColumnInfo::digest(const UnsafeData &content)
+{
+    // 64-bit FNV-1a, with the length folded into the low bits so that contents of different lengths rarely share a digest.
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const unsigned char *buffer = content.buffer();
+    size_t size = content.size();
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= buffer[i];
+        hash *= 0x100000001b3ULL;
+    }
+    hash ^= (uint64_t) size;
+    return (Integer) hash;
+}
+
+UnsafeStringView CompressionColumnInfo::prefix(const UnsafeStringView &text)
+{
+    const unsigned char *data = (const unsigned char *) text.data();
+    size_t length = text.length();
+    size_t offset = 0;
+    for (int count = 0; count < CompressionSidecarPrefixLength && offset < length; ++count) {
+        // skip the continuation bytes of current character
+        offset++;
+        while (offset < length && (data[offset] & 0xC0) == 0x80) {
+            offset++;
+        }
+    }
+    return UnsafeStringView(text.data(), offset);
+}
+
 CompressionType CompressionColumnInfo::getCompressionType() const
 {
     return m_compressionType;
@@ -237,6 +377,28 @@ void CompressionTableUserInfo::addCompressingColumn(const CompressionColumnInfo
     m_compressingColumns.push_back(info);
 }
 
+bool CompressionTableUserInfo::enableSidecar(const Column &column)
+{
+    for (auto &info : m_compressingColumns) {
+        if (info.getColumn().equal(column.syntax().name)) {
+            info.enableSidecar();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CompressionTableUserInfo::enableAdaptiveCompression(const Column &column)
+{
+    for (auto &info : m_compressingColumns) {
+        if (info.getColumn().equal(column.syntax().name)) {
+            info.enableAdaptiveCompression();
+            return true;
+        }
+    }
+    return false;
+}
+
 void CompressionTableUserInfo::enableReplaceCompresssion()
 {
     m_replaceCompression = true;
@@ -316,6 +478,55 @@ bool CompressionTableInfo::shouldReplaceCompression() const
     return m_replaceCompression;
 }
 
+StringView CompressionTableInfo::getTuningDescription() const
+{
+    StringViewMap<const CompressionColumnInfo *> orderedInfos;
+    for (const auto &info : m_compressingColumns) {
+        if (info.isAdaptive()) {
+            orderedInfos[info.getColumn()] = &info;
+        }
+    }
+    std::ostringstream stream;
+    bool isFirst = true;
+    for (const auto &iter : orderedInfos) {
+        if (!isFirst) {
+            stream << ",";
+        } else {
+            isFirst = false;
+        }
+        stream << iter.second->getTuner()->getDescription() << ":" << iter.first;
+    }
+    return StringView(stream.str());
+}
+
+void CompressionTableInfo::restoreTuning(const UnsafeStringView &description) const
+{
+    size_t start = 0;
+    while (start < description.length()) {
+        size_t end = description.find(",", start);
+        if (end == UnsafeStringView::npos) {
+            end = description.length();
+        }
+        UnsafeStringView tuning = description.subStr(start, end - start);
+        start = end + 1;
+        size_t colonPos = tuning.find(":");
+        if (colonPos == UnsafeStringView::npos) {
+            continue;
+        }
+        colonPos = tuning.find(":", colonPos + 1);
+        if (colonPos == UnsafeStringView::npos || colonPos + 1 >= tuning.length()) {
+            continue;
+        }
+        UnsafeStringView column = tuning.subStr(colonPos + 1);
+        for (const auto &info : m_compressingColumns) {
+            if (info.isAdaptive() && info.getColumn().equal(column)) {
+                info.getTuner()->restore(tuning.subStr(0, colonPos));
+                break;
+            }
+        }
+    }
+}
+
 #pragma mark - Compress Statements
 
 StatementSelect CompressionTableInfo::getSelectNeedCompressRowIdStatement() const
@@ -369,6 +580,10 @@ CompressionTableInfo::getSelectUncompressRowStatement(ColumnInfoPtrList *columnL
         if (column->getCompressionType() == CompressionType::VariousDict) {
             resultColumns.emplace_back(Column(column->getMatchColumn()));
         }
+        if (column->hasSidecar()) {
+            resultColumns.emplace_back(Column(column->getHashColumn()));
+            resultColumns.emplace_back(Column(column->getPrefixColumn()));
+        }
     }
     return StatementSelect().select(resultColumns).from(m_table).where(Column::rowid() == BindParameter());
 }
@@ -384,6 +599,10 @@ CompressionTableInfo::getUpdateCompressColumnStatement(ColumnInfoPtrList *column
     while ((column = columnIter.nextInfo()) != nullptr) {
         update.set(Column(column->getColumn())).to(BindParameter(index++));
         update.set(Column(column->getTypeColumn())).to(BindParameter(index++));
+        if (column->hasSidecar()) {
+            update.set(Column(column->getHashColumn())).to(BindParameter(index++));
+            update.set(Column(column->getPrefixColumn())).to(BindParameter(index++));
+        }
     }
     return update;
 }
@@ -402,15 +621,19 @@ HandleStatement *select, HandleStatement *update, int64_t rowid, ColumnInfoPtrLi
     update->reset();
     update->bindInteger(rowid);
 
-    int preOffset = 0;
-    int columnIndex = 0;
+    int selectIndex = 0;
+    int updateIndex = 2;
     ColumnInfoIter columnIter(&getColumnInfos(), columnList);
     const CompressionColumnInfo *column = nullptr;
     while ((column = columnIter.nextInfo()) != nullptr) {
-        int selectIndex = 2 * columnIndex + preOffset;
-        int updateIndex = 2 * columnIndex + 2;
+        int typeIndex = selectIndex + 1;
+        int matchIndex = typeIndex;
+        if (column->getCompressionType() == CompressionType::VariousDict) {
+            matchIndex++;
+        }
+        int sidecarIndex = matchIndex + 1;
         ColumnType valueType = select->getType(selectIndex);
-        bool isUncompressed = select->getType(selectIndex + 1) == ColumnType::Null;
+        bool isUncompressed = select->getType(typeIndex) == ColumnType::Null;
 
         if (valueType >= ColumnType::Text && isUncompressed) {
             UnsafeData value = select->getBLOB(selectIndex);
@@ -419,17 +642,16 @@ HandleStatement *select, HandleStatement *update, int64_t rowid, ColumnInfoPtrLi
             switch (column->getCompressionType()) {
             case CompressionType::Normal: {
                 compressedType = CompressedType::ZSTDNormal;
-                compressedValue = CompressionCenter::shared().compressContent(
+                compressedValue = column->compressContent(
                 value, 0, static_cast<InnerHandle *>(select->getHandle()));
             } break;
             case CompressionType::Dict: {
-                compressedValue = CompressionCenter::shared().compressContent(
+                compressedValue = column->compressContent(
                 value, column->getDictId(), static_cast<InnerHandle *>(select->getHandle()));
             } break;
             case CompressionType::VariousDict: {
-                int64_t matchValue = select->getInteger(selectIndex + 2);
-                preOffset++;
-                compressedValue = CompressionCenter::shared().compressContent(
+                int64_t matchValue = select->getInteger(matchIndex);
+                compressedValue = column->compressContent(
                 value,
                 column->getMatchDictId(matchValue),
                 static_cast<InnerHandle *>(select->getHandle()));
@@ -440,6 +662,17 @@ HandleStatement *select, HandleStatement *update, int64_t rowid, ColumnInfoPtrLi
             }
             WCTAssert(compressedValue.value().size() <= value.size());
 
+            if (column->hasSidecar()) {
+                update->bindInteger(CompressionColumnInfo::digest(value), updateIndex + 2);
+                if (valueType == ColumnType::Text) {
+                    update->bindText(
+                    CompressionColumnInfo::prefix(select->getText(selectIndex)),
+                    updateIndex + 3);
+                } else {
+                    update->bindNull(updateIndex + 3);
+                }
+            }
+
             if (compressedValue.value().size() < value.size()) {
                 update->bindBLOB(compressedValue.value(), updateIndex);
                 update->bindInteger(
@@ -471,9 +704,20 @@ HandleStatement *select, HandleStatement *update, int64_t rowid, ColumnInfoPtrLi
                 update->bindBLOB(select->getBLOB(selectIndex), updateIndex);
                 break;
             }
-            update->bindInteger(select->getInteger(selectIndex + 1), updateIndex + 1);
+            update->bindInteger(select->getInteger(typeIndex), updateIndex + 1);
+            if (column->hasSidecar()) {
+                if (isUncompressed) {
+                    // Non-text values have no sidecar.
+                    update->bindNull(updateIndex + 2);
+                    update->bindNull(updateIndex + 3);
+                } else {
+                    update->bindValue(select->getValue(sidecarIndex), updateIndex + 2);
+                    update->bindValue(select->getValue(sidecarIndex + 1), updateIndex + 3);
+                }
+            }
         }
-        columnIndex++;
+        selectIndex = column->hasSidecar() ? sidecarIndex + 2 : sidecarIndex;
+        updateIndex += column->hasSidecar() ? 4 : 2;
     }
     if (!update->step()) {
         return false;
@@ -481,82 +725,147 @@ HandleStatement *select, HandleStatement *update, int64_t rowid, ColumnInfoPtrLi
     return true;
 }
 
-StatementSelect CompressionTableInfo::getSelectCompressedRowIdStatement(int64_t maxRowId) const
+#pragma mark - Sidecar
+StatementCreateTrigger
+CompressionTableInfo::getCreateSidecarTriggerStatement(const CompressionColumnInfo &columnInfo) const
+{
+    WCTAssert(columnInfo.hasSidecar());
+    // The length of table is added so that the names of different tables and columns won't be ambiguous.
+    StringView trigger = StringView::formatted("%s%zu_%s_%s",
+                                               CompressionSidecarTriggerPrefix.data(),
+                                               m_table.length(),
+                                               m_table.data(),
+                                               columnInfo.getColumn().data());
+    Column newContent = Column(columnInfo.getColumn()).table("NEW");
+    Column oldContent = Column(columnInfo.getColumn()).table("OLD");
+    Column newType = Column(columnInfo.getTypeColumn()).table("NEW");
+    Column oldType = Column(columnInfo.getTypeColumn()).table("OLD");
+    Column newHash = Column(columnInfo.getHashColumn()).table("NEW");
+    Column newPrefix = Column(columnInfo.getPrefixColumn()).table("NEW");
+    Column oldHash = Column(columnInfo.getHashColumn()).table("OLD");
+    return StatementCreateTrigger()
+    .createTrigger(trigger)
+    .schema(Schema::main())
+    .ifNotExists()
+    .after()
+    .update()
+    .column(Column(columnInfo.getColumn()))
+    .column(Column(columnInfo.getTypeColumn()))
+    .on(m_table)
+    .forEachRow()
+    // Rewriting the same content, e.g. by compressing the other columns of the row, keeps the sidecars.
+    .when((newContent.isNot(oldContent) || newType.isNot(oldType)) && newHash.is(oldHash)
+          && (newHash.notNull() || newPrefix.notNull()))
+    .execute(StatementUpdate()
+             .update(m_table)
+             .set(Column(columnInfo.getHashColumn()))
+             .to(nullptr)
+             .set(Column(columnInfo.getPrefixColumn()))
+             .to(nullptr)
+             .where(Column::rowid() == Column::rowid().table("NEW")));
+}
+
+#pragma mark - Revert compression
+StatementSelect
+CompressionTableInfo::getCountCompressedRowStatement(ColumnInfoPtrList *columnList) const
 {
     Expression condition;
-    for (auto &column : m_compressingColumns) {
+    ColumnInfoIter columnIter(&m_compressingColumns, columnList);
+    const CompressionColumnInfo *column = nullptr;
+    while ((column = columnIter.nextInfo()) != nullptr) {
         if (condition.syntax().isValid()) {
-            condition = condition || Column(column.getTypeColumn()).notNull();
+            condition = condition || Column(column->getTypeColumn()).notNull();
         } else {
-            condition = Column(column.getTypeColumn()).notNull();
+            condition = Column(column->getTypeColumn()).notNull();
         }
     }
-    return StatementSelect()
-    .select(Column::rowid())
-    .from(m_table)
-    .where(condition && Column::rowid() < maxRowId)
-    .order(Column::rowid().asOrder(Order::DESC));
+    return StatementSelect().select(Column::all().count()).from(m_table).where(condition);
 }
 
 StatementSelect
-CompressionTableInfo::getSelectCompressedRowStatement(ColumnInfoPtrList *columnList) const
+CompressionTableInfo::getSelectCompressedRowsStatement(ColumnInfoPtrList *columnList) const
 {
-    ResultColumns resultColumns;
+    ResultColumns resultColumns = { Column::rowid() };
+    Expression condition;
     ColumnInfoIter columnIter(&m_compressingColumns, columnList);
     const CompressionColumnInfo *column = nullptr;
     while ((column = columnIter.nextInfo()) != nullptr) {
-        resultColumns.emplace_back(CoreFunction::decompress(
-        Column(column->getColumn()), Column(column->getTypeColumn())));
+        resultColumns.emplace_back(Column(column->getColumn()));
+        resultColumns.emplace_back(Column(column->getTypeColumn()));
+        if (condition.syntax().isValid()) {
+            condition = condition || Column(column->getTypeColumn()).notNull();
+        } else {
+            condition = Column(column->getTypeColumn()).notNull();
+        }
     }
-    return StatementSelect().select(resultColumns).from(m_table).where(Column::rowid() == BindParameter());
+    return StatementSelect()
+    .select(resultColumns)
+    .from(m_table)
+    .where(Column::rowid() < BindParameter(1) && condition)
+    .order(Column::rowid().asOrder(Order::DESC))
+    .limit(BindParameter(2));
 }
 
-bool CompressionTableInfo::stepSelectAndUpdateCompressedRowStatement(
-HandleStatement *select, HandleStatement *update, int64_t rowid, ColumnInfoPtrList *columnList) const
+bool CompressionTableInfo::decompressRow(OneRowValue &row, Error &error, ColumnInfoPtrList *columnList) const
 {
-    select->bindInteger(rowid);
-    if (!select->step()) {
-        return false;
-    }
-    if (select->done()) {
-        return true;
-    }
-    update->bindInteger(rowid);
-
-    int columnIndex = 0;
+    size_t valueIndex = 1;
     ColumnInfoIter columnIter(&getColumnInfos(), columnList);
-    while (columnIter.nextInfo() != nullptr) {
-        int selectIndex = columnIndex;
-        int updateIndex = 2 * columnIndex + 2;
-        ColumnType valueType = select->getType(selectIndex);
-
-        switch (valueType) {
-        case ColumnType::Null:
-            update->bindNull(updateIndex);
-            break;
-        case ColumnType::Integer:
-            update->bindInteger(select->getInteger(selectIndex), updateIndex);
-            break;
-        case ColumnType::Float:
-            update->bindDouble(select->getDouble(selectIndex), updateIndex);
-            break;
-        case ColumnType::Text:
-            update->bindText(select->getText(selectIndex), updateIndex);
-            break;
-        case ColumnType::BLOB:
-            update->bindBLOB(select->getBLOB(selectIndex), updateIndex);
-            break;
+    const CompressionColumnInfo *column = nullptr;
+    while ((column = columnIter.nextInfo()) != nullptr) {
+        WCTAssert(valueIndex + 1 < row.size());
+        Value &value = row[valueIndex];
+        const Value &type = row[valueIndex + 1];
+        valueIndex += 2;
+        if (type.isNull() || value.getType() != ColumnType::BLOB) {
+            continue;
+        }
+        CompressedType compressedType = WCDBGetCompressedType(type.intValue());
+        if (compressedType <= CompressedType::None
+            || compressedType > CompressedType::ZSTDNormal) {
+            continue;
+        }
+        UnsafeData data = value.blobValue();
+        if (data.size() == 0) {
+            continue;
+        }
+        auto decompressed = CompressionCenter::shared().decompressContent(
+        data, compressedType == CompressedType::ZSTDDict, error);
+        if (decompressed.failed()) {
+            return false;
+        }
+        if (WCDBGetOriginType(type.intValue()) == ColumnType::Text) {
+            value = StringView((const char *) decompressed.value().buffer(),
+                               decompressed.value().size());
+        } else {
+            value = decompressed.value();
         }
-        update->bindNull(updateIndex + 1);
-        columnIndex++;
-    }
-    if (!update->step()) {
-        return false;
     }
+    return true;
+}
 
-    select->reset();
+bool CompressionTableInfo::stepUpdateDecompressedRowStatement(HandleStatement *update,
+                                                              const OneRowValue &row,
+                                                              ColumnInfoPtrList *columnList) const
+{
     update->reset();
-    return true;
+    update->bindInteger(row[0].intValue(), 1);
+
+    size_t valueIndex = 1;
+    int updateIndex = 2;
+    ColumnInfoIter columnIter(&getColumnInfos(), columnList);
+    const CompressionColumnInfo *column = nullptr;
+    while ((column = columnIter.nextInfo()) != nullptr) {
+        WCTAssert(valueIndex < row.size());
+        update->bindValue(row[valueIndex], updateIndex);
+        update->bindNull(updateIndex + 1);
+        valueIndex += 2;
+        updateIndex += 2;
+        if (column->hasSidecar()) {
+            update->bindNull(updateIndex++);
+            update->bindNull(updateIndex++);
+        }
+    }
+    return update->step();
 }
 
 CompressionTableInfo::ColumnInfoIter::ColumnInfoIter(const ColumnInfoList *infoList,
@@ -26,7 +26,10 @@
 
 #include "Column.hpp"
 #include "ColumnType.hpp"
+#include "CompressionTuner.hpp"
+#include "Data.hpp"
 #include "StringView.hpp"
+#include "Value.hpp"
 #include "ZSTDDict.hpp"
 #include <atomic>
 #include <list>
@@ -35,7 +38,9 @@
 
 namespace WCDB {
 
+class Error;
 class HandleStatement;
+class InnerHandle;
 class CompressionTableInfo;
 
 enum class CompressionType : char {
@@ -70,6 +75,32 @@ public:
     void setMatchColumnIndex(uint16_t index) const;
     uint16_t getMatchColumnIndex() const;
 
+    // Sidecars are maintained at compress time so that predicates can be checked without decompressing.
+    void enableSidecar();
+    bool hasSidecar() const;
+
+    const StringView &getHashColumn() const;
+    void setHashColumnIndex(uint16_t index) const;
+    uint16_t getHashColumnIndex() const;
+
+    const StringView &getPrefixColumn() const;
+    void setPrefixColumnIndex(uint16_t index) const;
+    uint16_t getPrefixColumnIndex() const;
+
+    // Digest of content mixed with its length. It's stable across platforms since it's persisted.
+    static Integer digest(const UnsafeData &content);
+    // The leading CompressionSidecarPrefixLength utf8 characters of text.
+    static UnsafeStringView prefix(const UnsafeStringView &text);
+
+    // Values will be compressed with the decisions learned by CompressionTuner.
+    void enableAdaptiveCompression();
+    bool isAdaptive() const;
+    CompressionTuner *getTuner() const;
+
+    // Content itself will be returned if it's not worth compressing.
+    Optional<UnsafeData>
+    compressContent(const UnsafeData &data, DictId dictId, InnerHandle *handle) const;
+
     CompressionType getCompressionType() const;
     DictId getDictId() const;
     DictId getMatchDictId(const Integer &matchValue) const;
@@ -83,6 +114,11 @@ private:
     mutable std::atomic_ushort m_typeColumnIndex;
     StringView m_matchColumn;
     mutable std::atomic_ushort m_matchColumnIndex;
+    StringView m_hashColumn;
+    mutable std::atomic_ushort m_hashColumnIndex;
+    StringView m_prefixColumn;
+    mutable std::atomic_ushort m_prefixColumnIndex;
+    std::shared_ptr<CompressionTuner> m_tuner;
 
     CompressionType m_compressionType;
     DictId m_commonDictID;
@@ -110,6 +146,10 @@ public:
     CompressionTableUserInfo(const UnsafeStringView &table,
                              const std::list<CompressionColumnInfo> &columns);
     void addCompressingColumn(const CompressionColumnInfo &info);
+    // Return false if the column is not added.
+    bool enableSidecar(const Column &column);
+    // Return false if the column is not added.
+    bool enableAdaptiveCompression(const Column &column);
     void enableReplaceCompresssion();
 };
 
@@ -129,6 +169,10 @@ public:
     StringView getCompressionDescription() const;
     bool shouldReplaceCompression() const;
 
+    // "minSize:level:column,..." of the adaptive columns, which is saved in compression record.
+    StringView getTuningDescription() const;
+    void restoreTuning(const UnsafeStringView &description) const;
+
 private:
     mutable int64_t m_minCompressedRowid;
     mutable bool m_needCheckColumn;
@@ -162,7 +206,8 @@ public:
 
     /*
      SELECT compressingColumnA, WCDB_CT_compressingColumnA,
-     compressingColumnB, WCDB_CT_compressingColumnB ...
+     compressingColumnB, WCDB_CT_compressingColumnB, [matchColumnB,]
+     [WCDB_CH_compressingColumnB, WCDB_CP_compressingColumnB] ...
      FROM compressingTable
      WHERE rowid == ?
      */
@@ -172,7 +217,8 @@ public:
     /*
      UPDATE compressingTable
      SET compressingColumnA = ?2, WCDB_CT_compressingColumnA = ?3,
-     compressingColumnB = ?4, WCDB_CT_compressingColumnB = ?5 ...
+     compressingColumnB = ?4, WCDB_CT_compressingColumnB = ?5,
+     [WCDB_CH_compressingColumnB = ?6, WCDB_CP_compressingColumnB = ?7] ...
      WHERE rowid == ?1
      */
     StatementUpdate
@@ -184,29 +230,52 @@ public:
                                                    ColumnInfoPtrList *columnList
                                                    = nullptr) const;
 
+#pragma mark - Sidecar
+public:
+    /*
+     CREATE TRIGGER IF NOT EXISTS main.wcdb_sidecar_[length of table]_compressingTable_compressingColumnA
+     AFTER UPDATE OF compressingColumnA, WCDB_CT_compressingColumnA ON compressingTable
+     FOR EACH ROW
+     WHEN (NEW.compressingColumnA IS NOT OLD.compressingColumnA
+           OR NEW.WCDB_CT_compressingColumnA IS NOT OLD.WCDB_CT_compressingColumnA)
+     AND NEW.WCDB_CH_compressingColumnA IS OLD.WCDB_CH_compressingColumnA
+     AND (NEW.WCDB_CH_compressingColumnA NOTNULL OR NEW.WCDB_CP_compressingColumnA NOTNULL)
+     BEGIN
+        UPDATE compressingTable
+        SET WCDB_CH_compressingColumnA = NULL, WCDB_CP_compressingColumnA = NULL
+        WHERE rowid == NEW.rowid;
+     END
+     The trigger is saved in the database, so the sidecars are reset even if the content is changed by raw SQL or the versions that don't maintain sidecars.
+     */
+    StatementCreateTrigger
+    getCreateSidecarTriggerStatement(const CompressionColumnInfo &columnInfo) const;
+
 #pragma mark - Revert compression
 public:
     /*
-     SELECT rowid FROM compressingTable
-     WHERE rowid < ? AND (WCDB_CT_compressingColumnA NOTNULL OR WCDB_CT_compressingColumnB NOTNULL ...)
-     ORDER BY rowid DESC
+     SELECT count(*) FROM compressingTable
+     WHERE WCDB_CT_compressingColumnA NOTNULL OR WCDB_CT_compressingColumnB NOTNULL ...
      */
-    StatementSelect getSelectCompressedRowIdStatement(int64_t maxRowId) const;
+    StatementSelect getCountCompressedRowStatement(ColumnInfoPtrList *columnList = nullptr) const;
 
     /*
-     SELECT wcdb_decompress(compressingColumnA, WCDB_CT_compressingColumnA),
-     wcdb_decompress(compressingColumnB, WCDB_CT_compressingColumnB) ...
+     SELECT rowid, compressingColumnA, WCDB_CT_compressingColumnA,
+     compressingColumnB, WCDB_CT_compressingColumnB ...
      FROM compressingTable
-     WHERE rowid == ?
+     WHERE rowid < ?1 AND (WCDB_CT_compressingColumnA NOTNULL OR WCDB_CT_compressingColumnB NOTNULL ...)
+     ORDER BY rowid DESC
+     LIMIT ?2
      */
-    StatementSelect
-    getSelectCompressedRowStatement(ColumnInfoPtrList *columnList = nullptr) const;
+    StatementSelect getSelectCompressedRowsStatement(ColumnInfoPtrList *columnList = nullptr) const;
 
-    bool stepSelectAndUpdateCompressedRowStatement(HandleStatement *select,
-                                                   HandleStatement *update,
-                                                   int64_t rowid,
-                                                   ColumnInfoPtrList *columnList
-                                                   = nullptr) const;
+    // Decompress a row selected by getSelectCompressedRowsStatement in place. It can be called in any thread.
+    bool decompressRow(OneRowValue &row, Error &error, ColumnInfoPtrList *columnList = nullptr) const;
+
+    // Write a row decompressed by decompressRow back with getUpdateCompressColumnStatement, and clear its compression status.
+    bool stepUpdateDecompressedRowStatement(HandleStatement *update,
+                                            const OneRowValue &row,
+                                            ColumnInfoPtrList *columnList
+                                            = nullptr) const;
 
 private:
     class ColumnInfoIter {
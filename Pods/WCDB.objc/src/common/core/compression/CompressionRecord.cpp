@@ -71,4 +71,46 @@ StatementDropTable CompressionRecord::getDropTableStatement()
     return StatementDropTable().dropTable(tableName).ifExists();
 }
 
+const StringView &CompressionTuning::tableName = CompressionTuningTable;
+const StringView &CompressionTuning::columnTable = CompressionTuningColumn_Table;
+const StringView &CompressionTuning::columnTuning = CompressionTuningColumn_Tuning;
+
+StatementCreateTable CompressionTuning::getCreateTableStatement()
+{
+    StatementCreateTable createTable;
+    createTable.createTable(tableName).ifNotExists();
+    createTable.define(
+    ColumnDef(columnTable, ColumnType::Text).constraint(ColumnConstraint().primaryKey()));
+    createTable.define(
+    ColumnDef(columnTuning, ColumnType::Text).constraint(ColumnConstraint().notNull()));
+    createTable.withoutRowID();
+    return createTable;
+}
+
+StatementInsert CompressionTuning::getInsertValueStatement()
+{
+    return StatementInsert()
+    .insertIntoTable(tableName)
+    .orReplace()
+    .columns({ columnTable, columnTuning })
+    .values(BindParameter::bindParameters(2));
+}
+
+StatementDelete CompressionTuning::getDeleteTuningStatement(const UnsafeStringView &table)
+{
+    return StatementDelete().deleteFrom(tableName).where(Column(columnTable) == table);
+}
+
+StatementUpdate
+CompressionTuning::getUpdateTuningStatement(const UnsafeStringView &oldTable,
+                                            const UnsafeStringView &newTable)
+{
+    return StatementUpdate().update(tableName).set(columnTable).to(newTable).where(Column(columnTable) == oldTable);
+}
+
+StatementDropTable CompressionTuning::getDropTableStatement()
+{
+    return StatementDropTable().dropTable(tableName).ifExists();
+}
+
 } //namespace WCDB
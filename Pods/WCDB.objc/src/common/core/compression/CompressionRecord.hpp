@@ -75,4 +75,48 @@ typedef struct CompressionRecord {
     static StatementDropTable getDropTableStatement();
 } CompressionRecord;
 
+// Learned decisions of the adaptive columns. They are kept out of the record table so that the old versions can still read the records.
+typedef struct CompressionTuning {
+    static const StringView& tableName;
+
+    StringView table;
+    static const StringView& columnTable;
+
+    StringView tuning;
+    static const StringView& columnTuning;
+
+    /*
+     CREATE TABLE IF NOT EXIST wcdb_builtin_compression_tuning
+     (tableName TEXT PRIMARY KEY, tuning TEXT NOT NULL)
+     WITHOUT ROWID
+     */
+    static StatementCreateTable getCreateTableStatement();
+
+    /*
+     INSERT OR REPLACE INTO wcdb_builtin_compression_tuning
+     (tableName, tuning)
+     VALUES(?1, ?2)
+     */
+    static StatementInsert getInsertValueStatement();
+
+    /*
+     DELETE FROM wcdb_builtin_compression_tuning
+     WHERE tableName == xxx
+     */
+    static StatementDelete getDeleteTuningStatement(const UnsafeStringView& table);
+
+    /*
+     UPDATE wcdb_builtin_compression_tuning
+     SET tableName = newTable
+     WHERE tableName == oldTable
+     */
+    static StatementUpdate getUpdateTuningStatement(const UnsafeStringView& oldTable,
+                                                    const UnsafeStringView& newTable);
+
+    /*
+     DROP TABLE IF EXIST wcdb_builtin_compression_tuning
+     */
+    static StatementDropTable getDropTableStatement();
+} CompressionTuning;
+
 } // namespace WCDB
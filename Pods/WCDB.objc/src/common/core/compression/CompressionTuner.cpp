@@ -0,0 +1,197 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "CompressionTuner.hpp"
+#include "CompressionConst.hpp"
+#include <algorithm>
+#include <sstream>
+#include <stdlib.h>
+
+namespace WCDB {
+
+CompressionTuner::Bucket::Bucket() : samples(0), originalSize(0), savedSize(0)
+{
+}
+
+CompressionTuner::LevelTrial::LevelTrial()
+: originalSize(0), compressedSize(0), seconds(0)
+{
+}
+
+CompressionTuner::CompressionTuner(bool tuneLevel)
+: m_tuneLevel(tuneLevel)
+, m_minSize(0)
+, m_restoredMinSize(0)
+, m_skippedCount(0)
+, m_trialCount(0)
+, m_level(0)
+, m_compressedCount(0)
+{
+}
+
+const std::array<int, CompressionTuner::TrialLevelCount>& CompressionTuner::trialLevels()
+{
+    static const std::array<int, TrialLevelCount>* s_levels
+    = new std::array<int, TrialLevelCount>({ 1, 3, 6, 9 });
+    return *s_levels;
+}
+
+int CompressionTuner::bucketIndex(size_t size)
+{
+    int index = 0;
+    while (size > 1 && index < BucketCount - 1) {
+        size >>= 1;
+        ++index;
+    }
+    return index;
+}
+
+CompressionTuner::Decision CompressionTuner::decide(size_t size)
+{
+    std::lock_guard<std::mutex> lockGuard(m_lock);
+    Decision decision;
+    decision.compress = true;
+    decision.level = m_level;
+    decision.trial = false;
+    if (size < m_minSize && ++m_skippedCount % CompressionTunerProbeInterval != 0) {
+        decision.compress = false;
+        return decision;
+    }
+    if (m_tuneLevel
+        && m_compressedCount % CompressionTunerRetuneInterval < CompressionTunerLevelTrialCount) {
+        decision.level = trialLevels()[m_compressedCount % TrialLevelCount];
+        decision.trial = true;
+    }
+    ++m_compressedCount;
+    return decision;
+}
+
+void CompressionTuner::didCompress(const Decision& decision,
+                                   size_t size,
+                                   size_t compressedSize,
+                                   double seconds)
+{
+    if (!decision.compress || size == 0) {
+        return;
+    }
+    // Values that grow after compressing are stored as they are, so they save nothing.
+    compressedSize = std::min(compressedSize, size);
+    std::lock_guard<std::mutex> lockGuard(m_lock);
+    Bucket& bucket = m_buckets[bucketIndex(size)];
+    if (bucket.samples >= CompressionTunerMaxSamples) {
+        // Decay so that the decisions follow the changes of data.
+        bucket.samples /= 2;
+        bucket.originalSize /= 2;
+        bucket.savedSize /= 2;
+    }
+    ++bucket.samples;
+    bucket.originalSize += size;
+    bucket.savedSize += size - compressedSize;
+    updateMinSize();
+
+    if (!decision.trial) {
+        return;
+    }
+    for (int i = 0; i < TrialLevelCount; ++i) {
+        if (trialLevels()[i] == decision.level) {
+            LevelTrial& trial = m_trials[i];
+            trial.originalSize += size;
+            trial.compressedSize += compressedSize;
+            trial.seconds += seconds;
+            break;
+        }
+    }
+    if (++m_trialCount >= CompressionTunerLevelTrialCount) {
+        pickLevel();
+    }
+}
+
+void CompressionTuner::updateMinSize()
+{
+    // The smaller buckets that are all not worth compressing.
+    size_t minSize = 0;
+    for (int i = 0; i < BucketCount - 1; ++i) {
+        const Bucket& bucket = m_buckets[i];
+        size_t upperBound = (size_t) 2 << i;
+        if (bucket.samples < CompressionTunerMinSamples) {
+            // Trust the restored decision until enough samples are collected.
+            if (upperBound <= m_restoredMinSize) {
+                minSize = upperBound;
+                continue;
+            }
+            if (bucket.samples == 0) {
+                continue;
+            }
+            break;
+        }
+        if (bucket.savedSize * CompressionTunerMinSavingRatio >= bucket.originalSize) {
+            break;
+        }
+        minSize = upperBound;
+    }
+    m_minSize = minSize;
+}
+
+void CompressionTuner::pickLevel()
+{
+    double minCost = 0;
+    for (int i = 0; i < TrialLevelCount; ++i) {
+        const LevelTrial& trial = m_trials[i];
+        if (trial.originalSize == 0) {
+            continue;
+        }
+        double cost
+        = (trial.compressedSize + trial.seconds * 1000000 * CompressionTunerBytesPerMicrosecond)
+          / trial.originalSize;
+        if (minCost == 0 || cost < minCost) {
+            minCost = cost;
+            m_level = trialLevels()[i];
+        }
+    }
+    m_trials = std::array<LevelTrial, TrialLevelCount>();
+    m_trialCount = 0;
+}
+
+StringView CompressionTuner::getDescription() const
+{
+    std::lock_guard<std::mutex> lockGuard(m_lock);
+    return StringView::formatted("%zu:%d", m_minSize, m_level);
+}
+
+void CompressionTuner::restore(const UnsafeStringView& description)
+{
+    size_t colonPos = description.find(":");
+    if (colonPos == UnsafeStringView::npos) {
+        return;
+    }
+    StringView minSize = description.subStr(0, colonPos);
+    StringView level = description.subStr(colonPos + 1);
+    std::lock_guard<std::mutex> lockGuard(m_lock);
+    m_restoredMinSize = (size_t) strtoull(minSize.data(), nullptr, 10);
+    updateMinSize();
+    if (m_tuneLevel) {
+        m_level = atoi(level.data());
+        // Skip the first trials since the level is already learned.
+        m_compressedCount = CompressionTunerLevelTrialCount;
+    }
+}
+
+} // namespace WCDB
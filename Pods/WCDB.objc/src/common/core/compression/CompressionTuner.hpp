@@ -0,0 +1,89 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "StringView.hpp"
+#include <array>
+#include <mutex>
+
+namespace WCDB {
+
+/*
+ Adaptive decisions of compressing the values of a column, learned from the values compressed before.
+ 1. Values smaller than the learned min size are not worth compressing since the zstd frame overhead eats the savings. They are stored uncompressed, except for a small part of them which are still compressed to keep probing.
+ 2. For the columns compressed without dict, a few levels are tried in turn periodically, and the one with the lowest cost of compressed size plus cpu time is picked.
+ None of the decisions is needed for decompressing, since the compressed type of each value is saved alongside it.
+ */
+class CompressionTuner final {
+public:
+    CompressionTuner(bool tuneLevel);
+
+    struct Decision {
+        bool compress;
+        // 0 for the default level of zstd.
+        int level;
+        bool trial;
+    };
+    Decision decide(size_t size);
+    void didCompress(const Decision& decision, size_t size, size_t compressedSize, double seconds);
+
+    // "minSize:level"
+    StringView getDescription() const;
+    void restore(const UnsafeStringView& description);
+
+private:
+    struct Bucket {
+        Bucket();
+        uint32_t samples;
+        uint64_t originalSize;
+        uint64_t savedSize;
+    };
+    struct LevelTrial {
+        LevelTrial();
+        uint64_t originalSize;
+        uint64_t compressedSize;
+        double seconds;
+    };
+    static constexpr const int BucketCount = 16;
+    static constexpr const int TrialLevelCount = 4;
+    static const std::array<int, TrialLevelCount>& trialLevels();
+    static int bucketIndex(size_t size);
+
+    void updateMinSize();
+    void pickLevel();
+
+    const bool m_tuneLevel;
+    mutable std::mutex m_lock;
+
+    std::array<Bucket, BucketCount> m_buckets;
+    size_t m_minSize;
+    size_t m_restoredMinSize;
+    uint32_t m_skippedCount;
+
+    std::array<LevelTrial, TrialLevelCount> m_trials;
+    uint32_t m_trialCount;
+    int m_level;
+    // Trials run in the first CompressionTunerLevelTrialCount compressions of each CompressionTunerRetuneInterval.
+    uint32_t m_compressedCount;
+};
+
+} // namespace WCDB
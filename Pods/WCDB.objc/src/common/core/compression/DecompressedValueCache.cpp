@@ -0,0 +1,121 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "DecompressedValueCache.hpp"
+#include "CompressionConst.hpp"
+
+namespace WCDB {
+
+DecompressedValueCache::Statistics::Statistics()
+: hits(0), misses(0), savedBytes(0), usedBytes(0)
+{
+}
+
+double DecompressedValueCache::Statistics::hitRate() const
+{
+    uint64_t total = hits + misses;
+    return total > 0 ? (double) hits / total : 0;
+}
+
+DecompressedValueCache::DecompressedValueCache(size_t budget) : m_budget(budget)
+{
+}
+
+void DecompressedValueCache::setBudget(size_t budget)
+{
+    std::lock_guard<std::mutex> lockGuard(m_lock);
+    m_budget = budget;
+    while (shouldPurge()) {
+        purge();
+    }
+}
+
+DecompressedValueCache::Value
+DecompressedValueCache::find(const UnsafeData& compressed, bool usingDict)
+{
+    std::lock_guard<std::mutex> lockGuard(m_lock);
+    if (m_budget == 0) {
+        return nullptr;
+    }
+    auto iter = m_map.find(Key(compressed.hash(), compressed.size(), usingDict));
+    if (iter == m_map.end() || iter->second->second->first != compressed) {
+        ++m_statistics.misses;
+        return nullptr;
+    }
+    retain(iter);
+    const Value& value = iter->second->second;
+    ++m_statistics.hits;
+    m_statistics.savedBytes += value->second.size();
+    return value;
+}
+
+void DecompressedValueCache::insert(const UnsafeData& compressed,
+                                    bool usingDict,
+                                    const UnsafeData& decompressed)
+{
+    std::lock_guard<std::mutex> lockGuard(m_lock);
+    if (compressed.size() + decompressed.size()
+        > m_budget / CompressionDecompressedCacheEntryRatio) {
+        return;
+    }
+    Key key(compressed.hash(), compressed.size(), usingDict);
+    auto iter = m_map.find(key);
+    if (iter != m_map.end()) {
+        // Replace the colliding one.
+        erase(iter);
+    }
+    Value value = std::make_shared<const std::pair<Data, Data>>(compressed, decompressed);
+    m_statistics.usedBytes += footprint(value);
+    put(key, value);
+    while (shouldPurge()) {
+        purge();
+    }
+}
+
+DecompressedValueCache::Statistics DecompressedValueCache::getStatistics() const
+{
+    std::lock_guard<std::mutex> lockGuard(m_lock);
+    return m_statistics;
+}
+
+size_t DecompressedValueCache::footprint(const Value& value)
+{
+    return value->first.size() + value->second.size();
+}
+
+void DecompressedValueCache::erase(const typename Super::MapIterator& iter)
+{
+    m_statistics.usedBytes -= footprint(iter->second->second);
+    m_list.erase(iter->second);
+    m_map.erase(iter);
+}
+
+bool DecompressedValueCache::shouldPurge() const
+{
+    return !empty() && m_statistics.usedBytes > m_budget;
+}
+
+void DecompressedValueCache::willPurge(const Key&, const Value& value)
+{
+    m_statistics.usedBytes -= footprint(value);
+}
+
+} // namespace WCDB
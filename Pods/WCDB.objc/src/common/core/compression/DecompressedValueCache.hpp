@@ -0,0 +1,77 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "Data.hpp"
+#include "LRUCache.hpp"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+namespace WCDB {
+
+/*
+ The decompressed values of the hot compressed contents, shared among all handles and bounded by the memory they take up.
+ It's keyed by the compressed content itself rather than the row it comes from, so that an updated or deleted row can never hit a stale value. Stale values just wait to be purged.
+ The crc32 of the content is only used to locate the entry, and the content is fully compared once found.
+ */
+class DecompressedValueCache final
+: protected LRUCache<std::tuple<uint32_t, size_t, bool>, std::shared_ptr<const std::pair<Data, Data>>> {
+    using Key = std::tuple<uint32_t, size_t, bool>;
+    // compressed content and decompressed value
+    using Value = std::shared_ptr<const std::pair<Data, Data>>;
+    using Super = LRUCache<Key, Value>;
+
+public:
+    DecompressedValueCache(size_t budget);
+
+    // 0 to disable the cache.
+    void setBudget(size_t budget);
+
+    Value find(const UnsafeData& compressed, bool usingDict);
+    void insert(const UnsafeData& compressed, bool usingDict, const UnsafeData& decompressed);
+
+    struct Statistics {
+        Statistics();
+        uint64_t hits;
+        uint64_t misses;
+        // Total size of the decompressed values served by the cache.
+        uint64_t savedBytes;
+        size_t usedBytes;
+        double hitRate() const;
+    };
+    Statistics getStatistics() const;
+
+protected:
+    static size_t footprint(const Value& value);
+    void erase(const typename Super::MapIterator& iter);
+
+    bool shouldPurge() const override final;
+    void willPurge(const Key& key, const Value& value) override final;
+
+    size_t m_budget;
+    Statistics m_statistics;
+    mutable std::mutex m_lock;
+};
+
+} // namespace WCDB
@@ -0,0 +1,60 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "DigestFunction.hpp"
+#include "Assertion.hpp"
+#include "CompressionInfo.hpp"
+#include "WCDBError.hpp"
+
+namespace WCDB {
+
+DigestFunction::DigestFunction(void* userContext, ScalarFunctionAPI& apiObj)
+: AbstractScalarFunctionObject(userContext, apiObj)
+{
+}
+
+DigestFunction::~DigestFunction() = default;
+
+void DigestFunction::process(ScalarFunctionAPI& apiObj)
+{
+    WCTAssert(apiObj.getValueCount() == 1);
+    if (apiObj.getValueCount() != 1) {
+        apiObj.setErrorResult(Error::Code::Misuse,
+                              StringView::formatted("Invalid parameter count for digest function: %d",
+                                                    apiObj.getValueCount()));
+        return;
+    }
+    switch (apiObj.getValueType(0)) {
+    case ColumnType::Text: {
+        const UnsafeStringView text = apiObj.getTextValue(0);
+        apiObj.setIntResult(CompressionColumnInfo::digest(
+        UnsafeData((unsigned char*) text.data(), text.length())));
+    } break;
+    case ColumnType::BLOB:
+        apiObj.setIntResult(CompressionColumnInfo::digest(apiObj.getBlobValue(0)));
+        break;
+    default:
+        apiObj.setNullResult();
+        break;
+    }
+}
+
+} // namespace WCDB
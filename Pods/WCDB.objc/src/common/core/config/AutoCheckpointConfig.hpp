@@ -55,7 +55,7 @@ protected:
     std::shared_ptr<AutoCheckpointOperator> m_operator;
     Statement m_disableAutoCheckpoint;
     StringViewMap<int> m_frames;
-    mutable SharedLock m_lock;
+    mutable StripedSharedLock m_lock;
 };
 
 } //namespace WCDB
@@ -100,8 +100,37 @@ void BusyRetryConfig::setBusyMonitor(const BusyMonitor& monitor, double timeOut)
     }
 }
 
+#pragma mark - Waiting Histogram
+BusyRetryConfig::WaitingHistogram::WaitingHistogram()
+: buckets(), numberOfWaitings(0), totalTime(0), maxTime(0)
+{
+}
+
+void BusyRetryConfig::WaitingHistogram::record(double seconds)
+{
+    int bucket = 0;
+    for (double milliseconds = seconds * 1000; milliseconds >= 1 && bucket < NumberOfBuckets - 1;
+         milliseconds /= 2) {
+        ++bucket;
+    }
+    ++buckets[bucket];
+    ++numberOfWaitings;
+    totalTime += seconds;
+    maxTime = std::max(maxTime, seconds);
+}
+
+BusyRetryConfig::WaitingHistograms
+BusyRetryConfig::getWaitingHistograms(const UnsafeStringView& path)
+{
+    return getOrCreateState(path).getWaitingHistograms();
+}
+
 #pragma mark - State
-BusyRetryConfig::Expecting::Expecting() : m_category(Category::None)
+BusyRetryConfig::Expecting::Expecting()
+: m_category(Category::None)
+, m_shmType(ShmLockType::Shared)
+, m_shmMask(0)
+, m_pagerType(PagerLockType::None)
 {
 }
 
@@ -168,6 +197,63 @@ bool BusyRetryConfig::Expecting::satisfied(int sharedMask, int exclusiveMask) co
     return satisified;
 }
 
+bool BusyRetryConfig::Expecting::isExpectingPager() const
+{
+    return m_category == Category::Pager;
+}
+
+bool BusyRetryConfig::Expecting::isExpectingShm(int mask) const
+{
+    return m_category == Category::Shm && (m_shmMask & mask) != 0;
+}
+
+bool BusyRetryConfig::Expecting::conflicts(const Expecting& other) const
+{
+    if (m_category != other.m_category) {
+        return false;
+    }
+    bool conflicts = false;
+    switch (m_category) {
+    case Category::Pager:
+        conflicts = m_pagerType >= PagerLockType::Reserved
+                    && other.m_pagerType >= PagerLockType::Reserved;
+        break;
+    case Category::Shm:
+        conflicts = (m_shmMask & other.m_shmMask) != 0
+                    && (m_shmType == ShmLockType::Exclusive
+                        || other.m_shmType == ShmLockType::Exclusive);
+        break;
+    default:
+        break;
+    }
+    return conflicts;
+}
+
+const char* BusyRetryConfig::Expecting::getLockName() const
+{
+    const char* name = "None";
+    if (m_category == Category::Pager) {
+        switch (m_pagerType) {
+        case PagerLockType::Shared:
+            name = "PagerShared";
+            break;
+        case PagerLockType::Reserved:
+            name = "PagerReserved";
+            break;
+        case PagerLockType::Pending:
+            name = "PagerPending";
+            break;
+        default:
+            WCTAssert(m_pagerType == PagerLockType::Exclusive);
+            name = "PagerExclusive";
+            break;
+        }
+    } else if (m_category == Category::Shm) {
+        name = m_shmType == ShmLockType::Shared ? "ShmShared" : "ShmExclusive";
+    }
+    return name;
+}
+
 BusyRetryConfig::State::ShmMask::ShmMask() : shared(0), exclusive(0)
 {
 }
@@ -203,12 +289,19 @@ BusyRetryConfig::State& BusyRetryConfig::getOrCreateState(const UnsafeStringView
 BusyRetryConfig::State::State()
 : m_pagerType(PagerLockType::None)
 , m_pagerChangeTid(0)
+, m_mainThreadWaiting(nullptr)
 , m_mainThreadBusyTrying(nullptr)
+, m_handoffTid(0)
 , m_busyMonitor(nullptr)
 , m_timeOut(0)
 {
 }
 
+BusyRetryConfig::State::Waiting::Waiting(const Expecting& expecting_)
+: expecting(expecting_), tid(Thread::getCurrentThreadId()), notified(false)
+{
+}
+
 void BusyRetryConfig::State::updatePagerLock(PagerLockType type)
 {
     std::lock_guard<std::mutex> lockGuard(m_lock);
@@ -217,8 +310,10 @@ void BusyRetryConfig::State::updatePagerLock(PagerLockType type)
         m_pagerType = type;
         m_localPagerType.getOrCreate() = type;
         m_pagerChangeTid = Thread::getCurrentThreadId();
-        if (notify) {
-            tryNotify();
+        if (m_handoffTid == m_pagerChangeTid) {
+            tryFinishHandoff();
+        } else if (notify) {
+            tryNotify(m_pagerWaitings, 0);
         }
     }
 }
@@ -226,19 +321,24 @@ void BusyRetryConfig::State::updatePagerLock(PagerLockType type)
 void BusyRetryConfig::State::updateShmLock(void* identifier, int sharedMask, int exclusiveMask)
 {
     std::lock_guard<std::mutex> lockGuard(m_lock);
-    bool notify = false;
+    int releasedMask = 0;
     if (sharedMask == 0 && exclusiveMask == 0) {
-        m_shmMasks.erase(identifier);
-        notify = true;
+        auto iter = m_shmMasks.find(identifier);
+        if (iter != m_shmMasks.end()) {
+            releasedMask = iter->second.shared | iter->second.exclusive;
+            m_shmMasks.erase(iter);
+        }
     } else {
         State::ShmMask& mask = m_shmMasks[identifier];
-        notify = sharedMask < mask.shared || exclusiveMask < mask.exclusive;
+        releasedMask = (mask.shared & ~sharedMask) | (mask.exclusive & ~exclusiveMask);
         mask.shared = sharedMask;
         mask.exclusive = exclusiveMask;
         mask.tid = Thread::getCurrentThreadId();
     }
-    if (notify) {
-        tryNotify();
+    if (m_handoffTid == Thread::getCurrentThreadId()) {
+        tryFinishHandoff();
+    } else if (releasedMask != 0) {
+        tryNotify(m_shmWaitings, releasedMask);
     }
 }
 
@@ -280,30 +380,35 @@ bool BusyRetryConfig::State::localShouldWait(const Expecting& expecting) const
 
 bool BusyRetryConfig::State::wait(Trying& trying)
 {
-    static_assert(Exclusivity::Must < Exclusivity::NoMatter, "");
-
     double timeOut = m_busyMonitor != nullptr && m_timeOut > 0 ? m_timeOut : BusyRetryTimeOut;
     int timeOutTimes = 0;
     std::unique_lock<std::mutex> lockGuard(m_lock);
-    while (shouldWait(trying)) {
-        Thread currentThread = Thread::current();
-        // main thread first
-        Exclusivity exclusivity
-        = Thread::isMain() ? Exclusivity::Must : Exclusivity::NoMatter;
-
-        m_waitings.insert(currentThread, trying, exclusivity);
-
-        if (exclusivity == Exclusivity::Must) {
-            m_mainThreadBusyTrying = &trying;
-        }
+    if (m_handoffTid == Thread::getCurrentThreadId()) {
+        // It fails to obtain the lock handed off to it.
+        tryFinishHandoff();
+    }
+    if (!shouldWait(trying)) {
+        return true;
+    }
 
-        bool notified = m_conditional.wait_for(lockGuard, timeOut);
+    SteadyClock begin = SteadyClock::now();
+    // main thread first
+    bool isMain = Thread::isMain();
+    Waiting waiting(trying);
+    Waitings& waitings = getWaitings(trying);
+    auto iter = waitings.insert(isMain ? waitings.begin() : waitings.end(), &waiting);
+    if (isMain) {
+        m_mainThreadWaiting = &waiting;
+        m_mainThreadBusyTrying = &trying;
+    }
 
-        if (exclusivity == Exclusivity::Must) {
-            m_mainThreadBusyTrying = nullptr;
+    // It keeps its place in queue until the expecting lock is available.
+    do {
+        if (m_handoffTid == waiting.tid) {
+            tryFinishHandoff();
         }
-
-        m_waitings.erase(currentThread);
+        waiting.notified = false;
+        bool notified = waiting.conditional.wait_for(lockGuard, timeOut);
 
         if (!notified) {
             if (m_busyMonitor != nullptr) {
@@ -313,11 +418,11 @@ bool BusyRetryConfig::State::wait(Trying& trying)
                     m_busyMonitor(m_path, m_pagerChangeTid);
                     timeOutTimes++;
                 } else {
-                    for (const auto& iter : m_shmMasks) {
-                        if (!trying.satisfied(iter.second.shared, iter.second.exclusive)) {
-                            WCTAssert(iter.second.tid != 0
-                                      && iter.second.tid != Thread::getCurrentThreadId());
-                            m_busyMonitor(m_path, iter.second.tid);
+                    for (const auto& shmMask : m_shmMasks) {
+                        if (!trying.satisfied(shmMask.second.shared, shmMask.second.exclusive)) {
+                            WCTAssert(shmMask.second.tid != 0
+                                      && shmMask.second.tid != Thread::getCurrentThreadId());
+                            m_busyMonitor(m_path, shmMask.second.tid);
                             timeOutTimes++;
                             break;
                         }
@@ -331,7 +436,20 @@ bool BusyRetryConfig::State::wait(Trying& trying)
                 break;
             }
         }
+    } while (shouldWait(trying));
+
+    if (isMain) {
+        m_mainThreadWaiting = nullptr;
+        m_mainThreadBusyTrying = nullptr;
+    }
+    waitings.erase(iter);
+
+    StringView lockName = StringView(trying.getLockName());
+    auto histogram = m_waitingHistograms.find(lockName);
+    if (histogram == m_waitingHistograms.end()) {
+        histogram = m_waitingHistograms.emplace(lockName, WaitingHistogram()).first;
     }
+    histogram->second.record(SteadyClock::timeIntervalSinceSteadyClockToNow(begin));
     // never timeout
     return true;
 }
@@ -351,7 +469,7 @@ bool BusyRetryConfig::State::checkMainThreadBusyRetry()
 bool BusyRetryConfig::State::checkHasBusyRetry()
 {
     std::unique_lock<std::mutex> lockGuard(m_lock);
-    return m_waitings.size() > 0;
+    return m_pagerWaitings.size() > 0 || m_shmWaitings.size() > 0;
 }
 
 void BusyRetryConfig::State::setBusyMonitor(const BusyMonitor& monitor, double timeOut)
@@ -361,27 +479,57 @@ void BusyRetryConfig::State::setBusyMonitor(const BusyMonitor& monitor, double t
     m_timeOut = timeOut;
 }
 
-void BusyRetryConfig::State::tryNotify()
+BusyRetryConfig::State::Waitings&
+BusyRetryConfig::State::getWaitings(const Expecting& expecting)
 {
-    for (auto iter = m_waitings.begin(); iter != m_waitings.end();) {
-        if (shouldWait(iter->value())) {
-            if (iter->order() == Exclusivity::Must) {
-                // stop so that the main thread can hold the mutex first.
-                return;
-            }
-            ++iter;
-        } else {
-#ifdef __APPLE__
-            m_conditional.notify(iter->key());
-            iter = m_waitings.erase(iter);
-#else
-            m_conditional.notify_all();
-            return;
-#endif
+    return expecting.isExpectingPager() ? m_pagerWaitings : m_shmWaitings;
+}
+
+void BusyRetryConfig::State::tryNotify(Waitings& waitings, int releasedShmMask)
+{
+    if (m_mainThreadWaiting != nullptr && !m_mainThreadWaiting->notified
+        && shouldWait(m_mainThreadWaiting->expecting)) {
+        // stop so that the main thread can hold the mutex first.
+        return;
+    }
+    for (Waiting* waiting : waitings) {
+        const Expecting& expecting = waiting->expecting;
+        if (waiting->notified
+            || (releasedShmMask != 0 && !expecting.isExpectingShm(releasedShmMask))
+            || shouldWait(expecting)
+            || (m_handoffTid != 0 && m_handoff.conflicts(expecting))) {
+            continue;
+        }
+        waiting->notified = true;
+        waiting->conditional.notify_one();
+        if (expecting.conflicts(expecting)) {
+            m_handoffTid = waiting->tid;
+            m_handoff = expecting;
         }
     }
 }
 
+void BusyRetryConfig::State::tryNotify()
+{
+    tryNotify(m_pagerWaitings, 0);
+    tryNotify(m_shmWaitings, 0);
+}
+
+void BusyRetryConfig::State::tryFinishHandoff()
+{
+    WCTAssert(m_handoffTid != 0);
+    m_handoffTid = 0;
+    m_handoff = Expecting();
+    // Waitings conflicting with the handoff one might be available now.
+    tryNotify();
+}
+
+BusyRetryConfig::WaitingHistograms BusyRetryConfig::State::getWaitingHistograms()
+{
+    std::unique_lock<std::mutex> lockGuard(m_lock);
+    return m_waitingHistograms;
+}
+
 #pragma mark - Trying
 void BusyRetryConfig::Trying::expecting(const UnsafeStringView& path, ShmLockType type, int mask)
 {
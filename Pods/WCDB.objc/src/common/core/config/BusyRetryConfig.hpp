@@ -29,7 +29,7 @@
 #include "Lock.hpp"
 #include "StringView.hpp"
 #include "ThreadLocal.hpp"
-#include "UniqueList.hpp"
+#include <list>
 
 namespace WCDB {
 
@@ -57,6 +57,24 @@ private:
     BusyMonitor m_busyMonitor;
     double m_timeOut;
 
+#pragma mark - Waiting Histogram
+public:
+    struct WaitingHistogram {
+        WaitingHistogram();
+        void record(double seconds);
+
+        // The first bucket counts the waitings shorter than 1ms and the n-th one counts [2^(n-2), 2^(n-1)) ms.
+        // The last one counts all the longer waitings.
+        static constexpr int NumberOfBuckets = 16;
+        uint64_t buckets[NumberOfBuckets];
+        uint64_t numberOfWaitings;
+        double totalTime;
+        double maxTime;
+    };
+    // Keyed by the type of the lock waiting for, e.g. PagerReserved and ShmExclusive.
+    typedef StringViewMap<WaitingHistogram> WaitingHistograms;
+    WaitingHistograms getWaitingHistograms(const UnsafeStringView& path);
+
 #pragma mark - Lock Event
 protected:
     typedef Global::PagerLock PagerLockType;
@@ -75,6 +93,12 @@ protected:
         bool satisfied(PagerLockType type) const;
         bool satisfied(int sharedMask, int exclusiveMask) const;
 
+        bool isExpectingPager() const;
+        bool isExpectingShm(int mask) const;
+        // Two expectings conflict if they can't obtain the lock at the same time.
+        bool conflicts(const Expecting& other) const;
+        const char* getLockName() const;
+
     protected:
         void expecting(ShmLockType type, int mask);
         void expecting(PagerLockType type);
@@ -121,19 +145,40 @@ protected:
         typedef struct ShmMask ShmMask;
         std::map<void* /* identifier */, ShmMask> m_shmMasks;
 
-        void tryNotify();
         std::mutex m_lock;
-        Conditional m_conditional;
 
-        enum class Exclusivity {
-            Must = 0,
-            NoMatter = 1,
+        // Each waiting thread is woken up by its own conditional, so that only the ones expecting the released lock are woken up.
+        struct Waiting {
+            Waiting(const Expecting& expecting);
+            const Expecting& expecting;
+            uint64_t tid;
+            Conditional conditional;
+            bool notified;
         };
+        typedef std::list<Waiting*> Waitings;
+        // Pager waitings and shm waitings are queued separately, in FIFO order except that the main thread is always at the front.
+        Waitings& getWaitings(const Expecting& expecting);
+        Waitings m_pagerWaitings;
+        Waitings m_shmWaitings;
+        Waiting* m_mainThreadWaiting;
         Trying* m_mainThreadBusyTrying;
-        UniqueList<Thread, Expecting, Exclusivity> m_waitings;
+
+        // The waitings are woken up in order, but only the first one of the conflicting waitings is woken up.
+        // Others are handed off until the woken one obtains the lock or fails to.
+        void tryNotify(Waitings& waitings, int releasedShmMask);
+        void tryNotify();
+        void tryFinishHandoff();
+        uint64_t m_handoffTid;
+        Expecting m_handoff;
 
         BusyMonitor m_busyMonitor;
         double m_timeOut;
+
+    public:
+        WaitingHistograms getWaitingHistograms();
+
+    protected:
+        WaitingHistograms m_waitingHistograms;
     };
 
     State& getOrCreateState(const UnsafeStringView& path);
@@ -0,0 +1,320 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FTSBulkBuilder.hpp"
+#include "Assertion.hpp"
+#include "CommonCore.hpp"
+#include "CoreConst.h"
+#include "Notifier.hpp"
+#include "Time.hpp"
+#include <limits>
+
+namespace WCDB {
+
+// Default values of fts5, used when the table has no such configuration.
+static constexpr const int64_t FTS5DefaultAutomerge = 4;
+static constexpr const int64_t FTS5DefaultHashSize = 1024 * 1024;
+
+FTSBulkBuilder::Statistics::Statistics()
+: numberOfRows(0)
+, numberOfTokens(0)
+, tokenizeTime(0)
+, insertTime(0)
+, optimizeTime(0)
+, totalTime(0)
+{
+}
+
+FTSBulkBuilder::FTSBulkBuilder(InnerHandle* handle)
+: m_handle(handle), m_rowidIndex(-1), m_maxRowid(0)
+{
+    WCTAssert(m_handle != nullptr);
+}
+
+FTSBulkBuilder::~FTSBulkBuilder() = default;
+
+const FTSBulkBuilder::Statistics& FTSBulkBuilder::getStatistics() const
+{
+    return m_statistics;
+}
+
+bool FTSBulkBuilder::build(const UnsafeStringView& table,
+                           const Columns& columns,
+                           const RowsProvider& provider)
+{
+    WCTRemedialAssert(!m_handle->isInTransaction(),
+                      "FTS index can't be built in bulk in transaction.",
+                      return false;);
+    m_statistics = Statistics();
+    SteadyClock start = SteadyClock::now();
+
+    if (!prepareTokenizer(table)) {
+        return false;
+    }
+    prepareRowids(columns);
+    Optional<int64_t> automerge = getConfig(table, "automerge");
+    if (!automerge.succeed()) {
+        return false;
+    }
+    Optional<int64_t> hashSize = getConfig(table, "hashsize");
+    if (!hashSize.succeed()) {
+        return false;
+    }
+    bool succeed = setConfig(table, "automerge", 0)
+                   && setConfig(table, "hashsize", FTSBulkBuildHashSize);
+
+    MultiRowsValue rows;
+    while (succeed) {
+        rows.clear();
+        if (!provider(rows)) {
+            succeed = false;
+            break;
+        }
+        if (rows.empty()) {
+            break;
+        }
+        if (!assignRowids(table, rows)) {
+            succeed = false;
+            break;
+        }
+        tokenize(rows);
+        succeed = insert(table, columns, rows);
+        m_cache.clear();
+    }
+
+    // Restore the configurations even if failed.
+    bool restored = setConfig(table, "automerge", automerge.value())
+                    && setConfig(table, "hashsize", hashSize.value());
+    succeed = succeed && restored && optimize(table);
+
+    m_statistics.totalTime = SteadyClock::timeIntervalSinceSteadyClockToNow(start);
+    if (succeed) {
+        reportStatistics(table);
+    }
+    return succeed;
+}
+
+bool FTSBulkBuilder::prepareTokenizer(const UnsafeStringView& table)
+{
+    return m_handle->prepareFTSTokenCache(table, m_cache);
+}
+
+void FTSBulkBuilder::prepareRowids(const Columns& columns)
+{
+    m_rowidIndex = -1;
+    int index = 0;
+    for (const Column& column : columns) {
+        const StringView& name = column.syntax().name;
+        if (name.caseInsensitiveEqual("rowid") || name.caseInsensitiveEqual("oid")
+            || name.caseInsensitiveEqual("_rowid_")) {
+            m_rowidIndex = index;
+            break;
+        }
+        ++index;
+    }
+}
+
+Optional<int64_t> FTSBulkBuilder::getMaxRowid(const UnsafeStringView& table)
+{
+    if (!m_handle->prepare(StatementSelect()
+                           .select(Column::rowid())
+                           .from(table)
+                           .order(Column::rowid().asOrder(Order::DESC))
+                           .limit(1))) {
+        return NullOpt;
+    }
+    if (!m_handle->step()) {
+        m_handle->finalize();
+        return NullOpt;
+    }
+    int64_t maxRowid = m_handle->done() ? 0 : m_handle->getInteger(0);
+    m_handle->finalize();
+    return maxRowid;
+}
+
+bool FTSBulkBuilder::assignRowids(const UnsafeStringView& table, const MultiRowsValue& rows)
+{
+    m_rowids.clear();
+    if (m_rowidIndex >= 0) {
+        // Rows without an integer rowid are not pretokenized.
+        for (const auto& row : rows) {
+            if ((size_t) m_rowidIndex < row.size()
+                && row[m_rowidIndex].getType() == ColumnType::Integer) {
+                m_rowids.push_back(row[m_rowidIndex].intValue());
+            } else {
+                m_rowids.push_back(std::numeric_limits<int64_t>::min());
+            }
+        }
+        return true;
+    }
+    Optional<int64_t> maxRowid = getMaxRowid(table);
+    if (!maxRowid.succeed()) {
+        return false;
+    }
+    m_maxRowid = maxRowid.value();
+    for (size_t i = 0; i < rows.size(); ++i) {
+        m_rowids.push_back(m_maxRowid + 1 + (int64_t) i);
+    }
+    return true;
+}
+
+bool FTSBulkBuilder::tokenize(const MultiRowsValue& rows)
+{
+    if (!m_cache.hasTokenizer()) {
+        return false;
+    }
+    WCTAssert(m_rowids.size() == rows.size());
+    SteadyClock start = SteadyClock::now();
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (m_rowids[i] == std::numeric_limits<int64_t>::min()) {
+            continue;
+        }
+        for (const Value& value : rows[i]) {
+            if (value.getType() == ColumnType::Text) {
+                m_cache.addDocument(m_rowids[i], value.textValue());
+            }
+        }
+    }
+    bool succeed = m_cache.tokenize(FTSBulkBuildMaxNumberOfTokenizeThreads);
+    if (succeed) {
+        m_statistics.numberOfTokens += m_cache.numberOfTokens();
+    } else {
+        // Fallback to tokenize during insertion.
+        m_cache.clear();
+    }
+    m_statistics.tokenizeTime += SteadyClock::timeIntervalSinceSteadyClockToNow(start);
+    return succeed;
+}
+
+bool FTSBulkBuilder::insert(const UnsafeStringView& table,
+                            const Columns& columns,
+                            const MultiRowsValue& rows)
+{
+    SteadyClock start = SteadyClock::now();
+    bool assignRowid = m_rowidIndex < 0;
+    Columns insertColumns = columns;
+    if (assignRowid) {
+        insertColumns.push_back(Column::rowid());
+    }
+    bool succeed = m_handle->runTransaction([&](InnerHandle* handle) {
+        if (assignRowid) {
+            // Rows may be inserted by others since the rowids are assigned, and then these rowids are given up.
+            Optional<int64_t> maxRowid = getMaxRowid(table);
+            if (!maxRowid.succeed()) {
+                return false;
+            }
+            if (maxRowid.value() != m_maxRowid) {
+                m_cache.clear();
+                m_maxRowid = maxRowid.value();
+                for (size_t i = 0; i < m_rowids.size(); ++i) {
+                    m_rowids[i] = m_maxRowid + 1 + (int64_t) i;
+                }
+            }
+        }
+        if (!handle->prepare(StatementInsert()
+                             .insertIntoTable(table)
+                             .columns(insertColumns)
+                             .values(BindParameter::bindParameters(insertColumns.size())))) {
+            return false;
+        }
+        for (size_t i = 0; i < rows.size(); ++i) {
+            handle->reset();
+            handle->bindRow(rows[i]);
+            if (assignRowid) {
+                handle->bindInteger(m_rowids[i], (int) insertColumns.size());
+            }
+            m_cache.activate(m_rowids[i]);
+            bool stepped = handle->step();
+            FTSTokenCache::deactivate();
+            if (!stepped) {
+                handle->finalize();
+                return false;
+            }
+        }
+        handle->finalize();
+        return true;
+    });
+    if (succeed) {
+        m_statistics.numberOfRows += rows.size();
+    }
+    m_statistics.insertTime += SteadyClock::timeIntervalSinceSteadyClockToNow(start);
+    return succeed;
+}
+
+bool FTSBulkBuilder::optimize(const UnsafeStringView& table)
+{
+    SteadyClock start = SteadyClock::now();
+    bool succeed = m_handle->execute(StatementInsert()
+                                     .insertIntoTable(table)
+                                     .column(Column(table))
+                                     .value("optimize"));
+    m_statistics.optimizeTime = SteadyClock::timeIntervalSinceSteadyClockToNow(start);
+    return succeed;
+}
+
+Optional<int64_t> FTSBulkBuilder::getConfig(const UnsafeStringView& table, const UnsafeStringView& key)
+{
+    if (!m_handle->prepare(StatementSelect()
+                           .select(Column("v"))
+                           .from(StringView::formatted("%s_config", table.data()))
+                           .where(Column("k") == key))) {
+        return NullOpt;
+    }
+    if (!m_handle->step()) {
+        m_handle->finalize();
+        return NullOpt;
+    }
+    int64_t value = 0;
+    if (m_handle->done()) {
+        value = key.caseInsensitiveEqual("automerge") ? FTS5DefaultAutomerge : FTS5DefaultHashSize;
+    } else {
+        value = m_handle->getInteger(0);
+    }
+    m_handle->finalize();
+    return value;
+}
+
+bool FTSBulkBuilder::setConfig(const UnsafeStringView& table, const UnsafeStringView& key, int64_t value)
+{
+    return m_handle->execute(StatementInsert()
+                             .insertIntoTable(table)
+                             .columns({ Column(table), Column("rank") })
+                             .values({ key, value }));
+}
+
+void FTSBulkBuilder::reportStatistics(const UnsafeStringView& table) const
+{
+    Error error(Error::Code::Notice, Error::Level::Notice, "FTS index is built in bulk.");
+    error.infos.insert_or_assign(ErrorStringKeyPath, m_handle->getPath());
+    error.infos.insert_or_assign(ErrorStringKeyType, ErrorTypeFTSBulkBuild);
+    error.infos.insert_or_assign("Table", table);
+    error.infos.insert_or_assign("Rows", m_statistics.numberOfRows);
+    error.infos.insert_or_assign("Tokens", m_statistics.numberOfTokens);
+    error.infos.insert_or_assign("TokenizeTime", m_statistics.tokenizeTime);
+    error.infos.insert_or_assign("InsertTime", m_statistics.insertTime);
+    error.infos.insert_or_assign("OptimizeTime", m_statistics.optimizeTime);
+    if (m_statistics.totalTime > 0) {
+        error.infos.insert_or_assign("RowsPerSecond",
+                                     m_statistics.numberOfRows / m_statistics.totalTime);
+    }
+    Notifier::shared().notify(error);
+}
+
+} //namespace WCDB
@@ -0,0 +1,80 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "FTSTokenCache.hpp"
+#include "InnerHandle.hpp"
+#include "WINQ.h"
+#include <functional>
+#include <vector>
+
+namespace WCDB {
+
+/*
+ Build the index of a fts5 table from a large amount of rows.
+ The automerge of fts5 is disabled during building, and each batch of rows is tokenized in parallel
+ and then inserted in one transaction. All the segments are merged by a single optimize at the end.
+ */
+class FTSBulkBuilder final {
+public:
+    FTSBulkBuilder(InnerHandle* handle);
+    ~FTSBulkBuilder();
+
+    // Fill the next batch into rows. Leave it empty to finish, or return false to abort.
+    // Rows are given rowids after the existing ones unless the rowid is one of the columns.
+    typedef std::function<bool(MultiRowsValue& rows)> RowsProvider;
+    bool build(const UnsafeStringView& table, const Columns& columns, const RowsProvider& provider);
+
+    struct Statistics {
+        Statistics();
+        uint64_t numberOfRows;
+        uint64_t numberOfTokens;
+        double tokenizeTime;
+        double insertTime;
+        double optimizeTime;
+        double totalTime;
+    };
+    const Statistics& getStatistics() const;
+
+private:
+    bool prepareTokenizer(const UnsafeStringView& table);
+    void prepareRowids(const Columns& columns);
+    Optional<int64_t> getMaxRowid(const UnsafeStringView& table);
+    bool assignRowids(const UnsafeStringView& table, const MultiRowsValue& rows);
+    bool tokenize(const MultiRowsValue& rows);
+    bool insert(const UnsafeStringView& table, const Columns& columns, const MultiRowsValue& rows);
+    bool optimize(const UnsafeStringView& table);
+
+    Optional<int64_t> getConfig(const UnsafeStringView& table, const UnsafeStringView& key);
+    bool setConfig(const UnsafeStringView& table, const UnsafeStringView& key, int64_t value);
+
+    void reportStatistics(const UnsafeStringView& table) const;
+
+    InnerHandle* m_handle;
+    FTSTokenCache m_cache;
+    // Index of the rowid in the columns, or -1 if rowids are assigned by the builder.
+    int m_rowidIndex;
+    int64_t m_maxRowid;
+    std::vector<int64_t> m_rowids;
+    Statistics m_statistics;
+};
+
+} //namespace WCDB
@@ -27,8 +27,10 @@
 #include "CommonCore.hpp"
 #include "CoreConst.h"
 #include "Notifier.hpp"
+#include "Serialization.hpp"
 #include "WCDBError.hpp"
 #include <cmath>
+#include <limits>
 
 namespace WCDB {
 
@@ -39,11 +41,15 @@ MergeFTSIndexLogic::MergeFTSIndexLogic(MergeFTSIndexHandleProvider *handleProvid
 , m_hasInit(false)
 , m_processing(false)
 , m_errorCount(0)
+, m_suspended(0)
 , m_getTableStatement(StatementSelect()
                       .select(Column("name"))
                       .from("sqlite_master")
                       .where(Column("type") == "table"
                              && Column("sql").like("CREATE VIRTUAL TABLE % USING fts5(%")))
+, m_budgetPerSecond(AutoMergeFTSIndexDefaultBudgetPerSecond)
+, m_budget(AutoMergeFTSIndexDefaultBudgetPerSecond)
+, m_lastBudgetRefill(SteadyClock::now())
 {
 }
 
@@ -52,8 +58,7 @@ bool MergeFTSIndexLogic::tryInit(InnerHandle &handle)
     if (m_hasInit) {
         return true;
     }
-    m_mergedTables.clear();
-    m_mergingTables.clear();
+    m_tableStates.clear();
 
     if (!handle.prepare(m_getTableStatement)) {
         return false;
@@ -62,14 +67,14 @@ bool MergeFTSIndexLogic::tryInit(InnerHandle &handle)
     while ((success = handle.step()) && !handle.done()) {
         UnsafeStringView table = handle.getText(0);
         WCTAssert(!table.empty());
-        m_mergingTables.emplace(table);
+        m_tableStates.emplace(table, TableState());
     }
     handle.finalize();
     if (!success) {
         return false;
     }
-    for (const StringView &element : m_mergingTables) {
-        if (!tryConfigUserMerge(handle, element, false)) {
+    for (const auto &element : m_tableStates) {
+        if (!tryConfigUserMerge(handle, element.first, false)) {
             return false;
         }
     }
@@ -149,40 +154,46 @@ MergeFTSIndexLogic::triggerMerge(InnerHandle &handle, TableArray newTables, Tabl
         increaseErrorCount();
         return NullOpt;
     }
-    if (m_mergingTables.size() == 0) {
+    bool hasDebt = false;
+    for (const auto &element : m_tableStates) {
+        if (element.second.needRefresh() || element.second.debtSegments > 0) {
+            hasDebt = true;
+            break;
+        }
+    }
+    if (!hasDebt) {
         return true;
     }
-    if (m_processing) {
+    if (m_processing || m_suspended.load() > 0) {
         return false;
     }
-    OperationQueue::shared().async(handle.getPath(), [](const UnsafeStringView &path) {
-        RecyclableDatabase database = CommonCore::shared().getOrCreateDatabase(path);
-        if (database != nullptr) {
-            database->proccessMerge();
-        }
-    });
+    asyncProcessMerge(handle.getPath(), 0);
     return false;
 }
 
 void MergeFTSIndexLogic::proccessMerge()
 {
-    StringView table;
     {
         SharedLockGuard lockGuard(m_lock);
         if (m_errorCount > 5) {
             return;
         }
-        if (m_mergingTables.size() == 0) {
+        if (m_tableStates.size() == 0) {
             return;
         }
-        table = *m_mergingTables.begin();
+    }
+    bool processing = false;
+    if (!m_processing.compare_exchange_strong(processing, true)) {
+        return;
     }
     RecyclableHandle recyclableHandle = m_handleProvider->getMergeIndexHandle();
     if (recyclableHandle == nullptr) {
+        m_processing = false;
         return;
     }
     WCTRemedialAssert(!recyclableHandle->isInTransaction(),
                       "Merge Index can't be run in transaction.",
+                      m_processing = false;
                       return;);
 
     InnerHandle *handle = recyclableHandle.get();
@@ -190,55 +201,29 @@ void MergeFTSIndexLogic::proccessMerge()
     handle->markErrorAsIgnorable(Error::Code::Busy);
     handle->setTableMonitorEnable(false);
 
-    while (!table.empty()) {
-        if (!mergeTable(*handle, table)) {
-            if (!handle->getError().isIgnorable()) {
-                increaseErrorCount();
-            }
-            break;
-        }
-        SharedLockGuard lockGuard(m_lock);
-        m_mergingTables.erase(table);
-        m_mergedTables.emplace(table);
-        if (m_mergingTables.size() > 0) {
-            table = *m_mergingTables.begin();
+    Optional<double> delay = mergeTables(*handle);
+    if (!delay.succeed()) {
+        if (handle->getError().isIgnorable()) {
+            delay = OperationQueueTimeIntervalForMergeFTSIndex;
         } else {
-            break;
+            increaseErrorCount();
         }
     }
     handle->setTableMonitorEnable(true);
+    m_processing = false;
+    if (delay.succeed() && delay.value() >= 0) {
+        asyncProcessMerge(handle->getPath(), delay.value());
+    }
 }
 
-bool MergeFTSIndexLogic::mergeTable(InnerHandle &handle, const StringView &table)
+void MergeFTSIndexLogic::asyncProcessMerge(const UnsafeStringView &path, double delay)
 {
-    int preChangeCount;
-    Statement mergeSTM
-    = StatementInsert()
-      .insertIntoTable(table)
-      .columns({ Column(table), Column("rank"), Column().rowid() })
-      .values({ UnsafeStringView("merge"), 256, WCDB::BindParameter(1) });
-    if (!handle.prepare(mergeSTM)) {
-        return false;
-    }
-    void **callbackPointer = new void *[2];
-    callbackPointer[0] = (void *) MergeFTSIndexLogic::userMergeCallback;
-    callbackPointer[1] = &handle;
-    do {
-        preChangeCount = handle.getTotalChange();
-        handle.bindPointer(callbackPointer, 1, "fts5_user_merge_callback", nullptr);
-        if (!handle.step()) {
-            handle.finalize();
-            delete[] callbackPointer;
-            return false;
-        } else {
-            handle.reset();
+    OperationQueue::shared().async(path, delay, [](const UnsafeStringView &path) {
+        RecyclableDatabase database = CommonCore::shared().getOrCreateDatabase(path);
+        if (database != nullptr) {
+            database->proccessMerge();
         }
-        //Use prime numbers to reduce the probability of collision with external logic
-        std::this_thread::sleep_for(std::chrono::microseconds(1229));
-    } while (handle.getTotalChange() - preChangeCount > 1);
-    handle.finalize();
-    delete[] callbackPointer;
-    return true;
+    });
 }
 
 void MergeFTSIndexLogic::userMergeCallback(InnerHandle *handle,
@@ -275,16 +260,14 @@ bool MergeFTSIndexLogic::checkModifiedTables(InnerHandle &handle,
         TableArray fts5Tables(new std::vector<StringView>());
 
         for (const auto &element : *newTables) {
-            if (m_mergedTables.find(element) != m_mergedTables.end()) {
-                m_mergedTables.erase(element);
-            }
+            m_tableStates.erase(element);
             handle.bindText(element.data(), 1);
             if (!handle.step()) {
                 handle.finalize();
                 return false;
             }
             if (!handle.done()) {
-                m_mergingTables.emplace(element);
+                m_tableStates.emplace(element, TableState());
                 fts5Tables->push_back(element);
             }
             handle.reset();
@@ -301,15 +284,261 @@ bool MergeFTSIndexLogic::checkModifiedTables(InnerHandle &handle,
 
     if (modifiedTables != nullptr && modifiedTables->size() > 0) {
         for (const auto &element : *modifiedTables) {
-            if (m_mergedTables.find(element) != m_mergedTables.end()) {
-                m_mergedTables.erase(element);
-                m_mergingTables.emplace(element);
+            auto iter = m_tableStates.find(element);
+            if (iter != m_tableStates.end()) {
+                iter->second.modifiedGeneration++;
             }
         }
     }
     return true;
 }
 
+#pragma mark - Schedule
+MergeFTSIndexLogic::TableState::TableState()
+: modifiedGeneration(1), refreshedGeneration(0), debtSegments(0), debtPages(0)
+{
+}
+
+bool MergeFTSIndexLogic::TableState::needRefresh() const
+{
+    return modifiedGeneration != refreshedGeneration;
+}
+
+void MergeFTSIndexLogic::setMergeBudget(double budgetPerSecond)
+{
+    m_budgetPerSecond.store(budgetPerSecond);
+}
+
+uint64_t MergeFTSIndexLogic::getMergeDebt() const
+{
+    SharedLockGuard lockGuard(m_lock);
+    uint64_t debt = 0;
+    for (const auto &element : m_tableStates) {
+        debt += element.second.debtSegments;
+    }
+    return debt;
+}
+
+void MergeFTSIndexLogic::suspend(bool suspend)
+{
+    if (suspend) {
+        ++m_suspended;
+    } else {
+        WCTAssert(m_suspended.load() > 0);
+        --m_suspended;
+    }
+}
+
+Optional<double> MergeFTSIndexLogic::mergeTables(InnerHandle &handle)
+{
+    while (true) {
+        if (m_suspended.load() > 0) {
+            return OperationQueueTimeIntervalForMergeFTSIndex;
+        }
+        if (!refreshTableStates(handle)) {
+            return NullOpt;
+        }
+        StringView table = pickTableToMerge();
+        if (table.empty()) {
+            return -1;
+        }
+        double budget = consumableBudget();
+        if (budget <= 0) {
+            // Wait until the budget is enough for an expected merge step.
+            return (AutoMergeFTSIndexMaxExpectingDuration - budget) / m_budgetPerSecond.load();
+        }
+
+        SteadyClock start = SteadyClock::now();
+        Optional<bool> merged = mergeTable(handle, table);
+        consumeBudget(SteadyClock::timeIntervalSinceSteadyClockToNow(start));
+        if (!merged.succeed()) {
+            return NullOpt;
+        }
+        {
+            LockGuard lockGuard(m_lock);
+            auto iter = m_tableStates.find(table);
+            if (iter != m_tableStates.end()) {
+                if (merged.value()) {
+                    iter->second.debtSegments = 0;
+                    iter->second.debtPages = 0;
+                } else {
+                    // Reread the structure to see what is left
+                    iter->second.refreshedGeneration = iter->second.modifiedGeneration - 1;
+                }
+            }
+        }
+        // Give way to the foreground writers
+        if (handle.checkHasBusyRetry()) {
+            return OperationQueueTimeIntervalForMergeFTSIndex;
+        }
+        //Use prime numbers to reduce the probability of collision with external logic
+        std::this_thread::sleep_for(std::chrono::microseconds(1229));
+    }
+}
+
+bool MergeFTSIndexLogic::refreshTableStates(InnerHandle &handle)
+{
+    std::vector<std::pair<StringView, uint32_t>> tables;
+    {
+        SharedLockGuard lockGuard(m_lock);
+        for (const auto &element : m_tableStates) {
+            if (element.second.needRefresh()) {
+                tables.emplace_back(element.first, element.second.modifiedGeneration);
+            }
+        }
+    }
+    for (const auto &table : tables) {
+        TableState state;
+        if (!readTableState(handle, table.first, state)) {
+            return false;
+        }
+        LockGuard lockGuard(m_lock);
+        auto iter = m_tableStates.find(table.first);
+        if (iter == m_tableStates.end()) {
+            continue;
+        }
+        iter->second.debtSegments = state.debtSegments;
+        iter->second.debtPages = state.debtPages;
+        iter->second.refreshedGeneration = table.second;
+    }
+    return true;
+}
+
+bool MergeFTSIndexLogic::readTableState(InnerHandle &handle,
+                                        const UnsafeStringView &table,
+                                        TableState &state)
+{
+    // The structure record of fts5 index, whose rowid is FTS5_STRUCTURE_ROWID.
+    Statement selectStructure
+    = StatementSelect()
+      .select(Column("block"))
+      .from(StringView().formatted("%s_data", table.data()))
+      .where(Column("id") == 10);
+    if (!handle.prepare(selectStructure)) {
+        return false;
+    }
+    if (!handle.step()) {
+        handle.finalize();
+        return false;
+    }
+    state.debtSegments = 0;
+    state.debtPages = 0;
+    if (!handle.done()) {
+        /*
+         | cookie (4 bytes) | level count | segment count | write counter |
+         | for each level: merging segment count | segment count |
+         |     for each segment: segment id | first page | last page |
+         All the numbers except cookie are varints.
+         */
+        Deserialization decoder(handle.getBLOB(0));
+        auto advanceVarint = [&decoder](uint64_t &value) {
+            auto result = decoder.advanceVarint();
+            value = result.second;
+            return result.first > 0;
+        };
+        uint64_t levelCount = 0;
+        uint64_t unused = 0;
+        bool valid = decoder.canAdvance(4);
+        if (valid) {
+            decoder.advance(4);
+            valid = advanceVarint(levelCount) && advanceVarint(unused)
+                    && advanceVarint(unused);
+        }
+        for (uint64_t level = 0; valid && level < levelCount; ++level) {
+            uint64_t segmentCount = 0;
+            valid = advanceVarint(unused) && advanceVarint(segmentCount);
+            uint64_t pages = 0;
+            for (uint64_t segment = 0; valid && segment < segmentCount; ++segment) {
+                uint64_t firstPage = 0;
+                uint64_t lastPage = 0;
+                valid = advanceVarint(unused) && advanceVarint(firstPage)
+                        && advanceVarint(lastPage) && lastPage >= firstPage;
+                pages += lastPage - firstPage + 1;
+            }
+            if (valid && segmentCount > 1) {
+                state.debtSegments += (uint32_t) segmentCount - 1;
+                state.debtPages += pages;
+            }
+        }
+        if (!valid) {
+            // Leave the corruption to be reported by fts5 itself.
+            state.debtSegments = 0;
+            state.debtPages = 0;
+        }
+    }
+    handle.finalize();
+    return true;
+}
+
+StringView MergeFTSIndexLogic::pickTableToMerge() const
+{
+    // Each redundant segment costs one more b-tree lookup for every query,
+    // so prefer the table that removes the most segments per page rewritten.
+    SharedLockGuard lockGuard(m_lock);
+    StringView table;
+    uint32_t bestSegments = 0;
+    uint64_t bestPages = 0;
+    for (const auto &element : m_tableStates) {
+        const TableState &state = element.second;
+        if (state.debtSegments == 0) {
+            continue;
+        }
+        if (bestSegments == 0
+            || (uint64_t) state.debtSegments * bestPages
+               > (uint64_t) bestSegments * state.debtPages) {
+            table = element.first;
+            bestSegments = state.debtSegments;
+            bestPages = state.debtPages;
+        }
+    }
+    return table;
+}
+
+Optional<bool> MergeFTSIndexLogic::mergeTable(InnerHandle &handle, const StringView &table)
+{
+    Statement mergeSTM
+    = StatementInsert()
+      .insertIntoTable(table)
+      .columns({ Column(table), Column("rank"), Column().rowid() })
+      .values({ UnsafeStringView("merge"), 256, WCDB::BindParameter(1) });
+    if (!handle.prepare(mergeSTM)) {
+        return NullOpt;
+    }
+    void *callbackPointer[2];
+    callbackPointer[0] = (void *) MergeFTSIndexLogic::userMergeCallback;
+    callbackPointer[1] = &handle;
+    int preChangeCount = handle.getTotalChange();
+    handle.bindPointer(callbackPointer, 1, "fts5_user_merge_callback", nullptr);
+    bool succeed = handle.step();
+    handle.finalize();
+    if (!succeed) {
+        return NullOpt;
+    }
+    // Nothing left to merge if no page is written.
+    return handle.getTotalChange() - preChangeCount <= 1;
+}
+
+double MergeFTSIndexLogic::consumableBudget()
+{
+    double budgetPerSecond = m_budgetPerSecond.load();
+    if (budgetPerSecond <= 0) {
+        return std::numeric_limits<double>::max();
+    }
+    SteadyClock now = SteadyClock::now();
+    m_budget = std::min(
+    m_budget + now.timeIntervalSinceSteadyClock(m_lastBudgetRefill) * budgetPerSecond,
+    budgetPerSecond);
+    m_lastBudgetRefill = now;
+    return m_budget;
+}
+
+void MergeFTSIndexLogic::consumeBudget(double cost)
+{
+    if (m_budgetPerSecond.load() > 0) {
+        m_budget -= cost;
+    }
+}
+
 void MergeFTSIndexLogic::increaseErrorCount()
 {
     m_errorCount++;
@@ -341,9 +570,10 @@ MergeFTSIndexLogic::OperationQueue::OperationQueue(const UnsafeStringView &name)
 }
 
 void MergeFTSIndexLogic::OperationQueue::async(const UnsafeStringView &path,
+                                               double delay,
                                                const OperationCallBack &callback)
 {
-    m_timedQueue.queue(StringView(path), 0, callback, AsyncMode::ForwardOnly);
+    m_timedQueue.queue(StringView(path), delay, callback, AsyncMode::ForwardOnly);
 }
 
 void MergeFTSIndexLogic::OperationQueue::cancelOperation(const UnsafeStringView &path)
@@ -29,6 +29,7 @@
 #include "Lock.hpp"
 #include "RecyclableHandle.hpp"
 #include "StringView.hpp"
+#include "Time.hpp"
 #include "TimedQueue.hpp"
 #include <array>
 
@@ -52,14 +53,21 @@ public:
     Optional<bool> triggerMerge(TableArray newTables, TableArray modifiedTables);
     void proccessMerge();
 
+    // Seconds of merge work allowed per second. Non-positive value means unlimited.
+    void setMergeBudget(double budgetPerSecond);
+    // The number of redundant segments in all fts5 tables, which slow down every query on them.
+    uint64_t getMergeDebt() const;
+    // Merging is paused until the suspensions are all resumed.
+    void suspend(bool suspend);
+
 private:
     bool tryInit(InnerHandle& handle);
     Optional<bool>
     triggerMerge(InnerHandle& handle, TableArray newTables, TableArray modifiedTables);
     bool tryConfigUserMerge(InnerHandle& handle, const UnsafeStringView& table, bool isNew);
     bool checkModifiedTables(InnerHandle& handle, TableArray newTables, TableArray modifiedTables);
-    bool mergeTable(InnerHandle& handle, const StringView& table);
     void increaseErrorCount();
+    static void asyncProcessMerge(const UnsafeStringView& path, double delay);
 
     static void
     userMergeCallback(InnerHandle* handle, int* remainPages, int totalPagesWriten, int* lastCheckPages);
@@ -69,12 +77,40 @@ private:
     bool m_hasInit;
     std::atomic<bool> m_processing;
     std::atomic<int> m_errorCount;
+    std::atomic<int> m_suspended;
 
-    SharedLock m_lock;
+    mutable SharedLock m_lock;
 
     Statement m_getTableStatement;
-    StringViewSet m_mergingTables;
-    StringViewSet m_mergedTables;
+
+#pragma mark - Schedule
+private:
+    struct TableState {
+        TableState();
+        uint32_t modifiedGeneration;
+        uint32_t refreshedGeneration;
+        // Segments that are expected to be merged with others in the same level.
+        uint32_t debtSegments;
+        // Pages to be rewritten to pay off the debt.
+        uint64_t debtPages;
+
+        bool needRefresh() const;
+    };
+    StringViewMap<TableState> m_tableStates;
+
+    // Return the delay for next merging, or a negative value if all tables are merged.
+    Optional<double> mergeTables(InnerHandle& handle);
+    bool refreshTableStates(InnerHandle& handle);
+    bool readTableState(InnerHandle& handle, const UnsafeStringView& table, TableState& state);
+    StringView pickTableToMerge() const;
+    Optional<bool> mergeTable(InnerHandle& handle, const StringView& table);
+
+    // Token bucket of the merge budget in seconds.
+    double consumableBudget();
+    void consumeBudget(double cost);
+    std::atomic<double> m_budgetPerSecond;
+    double m_budget;
+    SteadyClock m_lastBudgetRefill;
 
 private:
     class OperationQueue : public AsyncQueue {
@@ -84,7 +120,7 @@ private:
         static OperationQueue& shared();
 
         using OperationCallBack = std::function<void(const UnsafeStringView&)>;
-        void async(const UnsafeStringView& path, const OperationCallBack& callback);
+        void async(const UnsafeStringView& path, double delay, const OperationCallBack& callback);
         void cancelOperation(const UnsafeStringView& path);
 
     private:
@@ -24,6 +24,7 @@
 
 #include "SubstringMatchInfo.hpp"
 #include "Assertion.hpp"
+#include <cstdio>
 #include <cstring>
 
 namespace WCDB {
@@ -41,6 +42,7 @@ SubstringMatchInfo::SubstringMatchInfo(void *userContext, FTS5AuxiliaryFunctionA
 , m_tokenPos(0)
 , m_bytePos(0)
 , m_curLevelStartPos(0)
+, m_curGroup(0)
 {
     WCTAssert(apiObj.getValueCount() == 2);
     if (apiObj.getValueCount() != 2) {
@@ -69,7 +71,7 @@ void SubstringMatchInfo::resetStatusFromLevel(int level)
     if (level < m_seperators.length()) {
         memset(&m_matchIndex[level], 0, (m_seperators.length() - level) * sizeof(int));
     }
-    m_output.clear();
+    m_body.clear();
     m_curLevelStartPos = m_bytePos;
 }
 
@@ -101,12 +103,18 @@ int tflags, const char *pToken, int nToken, int iStartOff, int iEndOff)
     int rc = FTSError::OK();
     m_tokenPos++;
 
+    int curPhaseStart = -1;
+    int curPhaseEnd = -1;
+    if (m_curGroup < m_phaseInstGroups.size()) {
+        curPhaseStart = m_phaseInstGroups[m_curGroup].start;
+        curPhaseEnd = m_phaseInstGroups[m_curGroup].end;
+    }
+
     int level = checkSeperator(pToken[0]);
     if (level >= 0) {
         if (m_substringPhaseMatchCount >= m_currentPhaseMatchCount) {
             WCTAssert(m_substringPhaseMatchCount == m_currentPhaseMatchCount);
-            m_output.emplace_back(std::make_pair(
-            UnsafeStringView(&m_input[m_bytePos], iStartOff - m_bytePos), -1));
+            appendText(UnsafeStringView(&m_input[m_bytePos], iStartOff - m_bytePos));
             m_bytePos = iStartOff;
             return FTSError::Done();
         } else {
@@ -114,28 +122,20 @@ int tflags, const char *pToken, int nToken, int iStartOff, int iEndOff)
             m_bytePos = iEndOff;
             resetStatusFromLevel(level + 1);
         }
-    } else if (iPos == m_pIter.m_curPhaseStart) {
+    } else if (iPos == curPhaseStart) {
         if (iStartOff > m_bytePos) {
-            m_output.emplace_back(std::make_pair(
-            UnsafeStringView(&m_input[m_bytePos], iStartOff - m_bytePos), -1));
+            appendText(UnsafeStringView(&m_input[m_bytePos], iStartOff - m_bytePos));
         }
         m_bytePos = iStartOff;
     }
-    if (iPos == m_pIter.m_curPhaseEnd) {
-        m_output.emplace_back(std::make_pair(
-        UnsafeStringView(&m_input[m_bytePos], iEndOff - m_bytePos),
-        m_bytePos - m_curLevelStartPos));
+    if (iPos == curPhaseEnd) {
+        appendMatchedText(UnsafeStringView(&m_input[m_bytePos], iEndOff - m_bytePos),
+                          m_bytePos - m_curLevelStartPos);
         m_bytePos = iEndOff;
-        for (int phaseIndex : m_pIter.m_phaseIndexes) {
-            if (!m_phaseMatchResult[phaseIndex]) {
-                m_phaseMatchResult[phaseIndex] = true;
-                m_substringPhaseMatchCount++;
-            }
-        }
-        if (m_pIter.m_iInst < m_pIter.m_nInst
-            && m_substringPhaseMatchCount < m_currentPhaseMatchCount) {
-            rc = m_pIter.next(m_columnNum);
-        } else {
+        markPhaseMatched(m_phaseInstGroups[m_curGroup], m_substringPhaseMatchCount);
+        m_curGroup++;
+        if (m_curGroup >= m_phaseInstGroups.size()
+            || m_substringPhaseMatchCount >= m_currentPhaseMatchCount) {
             rc = FTSError::Done();
         }
     }
@@ -155,29 +155,9 @@ void SubstringMatchInfo::process(FTS5AuxiliaryFunctionAPI &apiObj)
         if (!m_phaseMatchResult) {
             m_phaseMatchResult = new bool[m_phaseCount];
         }
-        m_pIter = PhaseInstIter();
-        rc = m_pIter.init(&apiObj);
-        if (FTSError::isOK(rc)) {
-            m_currentPhaseMatchCount = 0;
-            memset(m_phaseMatchResult, 0, m_phaseCount * sizeof(bool));
-            rc = m_pIter.next(m_columnNum);
-            while (FTSError::isOK(rc)) {
-                for (int phaseIndex : m_pIter.m_phaseIndexes) {
-                    if (!m_phaseMatchResult[phaseIndex]) {
-                        m_phaseMatchResult[phaseIndex] = true;
-                        m_currentPhaseMatchCount++;
-                    }
-                }
-                if (m_pIter.m_iInst >= m_pIter.m_nInst) {
-                    break;
-                }
-                rc = m_pIter.next(m_columnNum);
-            }
-            m_pIter.m_iInst = 0;
-            rc = m_pIter.next(m_columnNum);
-        }
+        rc = collectPhaseInstGroups(apiObj);
         resetStatusFromLevel(0);
-        if (FTSError::isOK(rc)) {
+        if (FTSError::isOK(rc) && !m_phaseInstGroups.empty()) {
             rc = apiObj.tokenize(m_input, this, tokenCallback);
         }
         if (m_bytePos < m_input.length()) {
@@ -185,23 +165,16 @@ void SubstringMatchInfo::process(FTS5AuxiliaryFunctionAPI &apiObj)
             for (; i < m_input.length(); i++) {
                 int level = checkSeperator(m_input[i]);
                 if (level >= 0) {
-                    m_output.emplace_back(std::make_pair(
-                    UnsafeStringView(&m_input[m_bytePos], i - m_bytePos), -1));
                     break;
                 }
             }
-            if (i == m_input.length()) {
-                m_output.emplace_back(std::make_pair(
-                UnsafeStringView(&m_input[m_bytePos], i - m_bytePos), -1));
-            }
+            appendText(UnsafeStringView(&m_input[m_bytePos], i - m_bytePos));
         }
         if ((FTSError::isOK(rc) || FTSError::isDone(rc))
             && m_substringPhaseMatchCount >= m_currentPhaseMatchCount) {
             WCTAssert(m_substringPhaseMatchCount == m_currentPhaseMatchCount);
-            std::ostringstream stream;
-            generateOutput(stream);
-            StringView output = stream.str();
-            apiObj.setTextResult(output);
+            generateOutput();
+            apiObj.setTextResult(UnsafeStringView(m_result.data(), m_result.size()));
         }
     }
     if (!FTSError::isOK(rc) && !FTSError::isDone(rc)) {
@@ -210,75 +183,89 @@ void SubstringMatchInfo::process(FTS5AuxiliaryFunctionAPI &apiObj)
     }
 }
 
-void SubstringMatchInfo::generateOutput(std::ostringstream &stream)
+#pragma mark - Phase Instance
+int SubstringMatchInfo::collectPhaseInstGroups(FTS5AuxiliaryFunctionAPI &apiObj)
 {
-    for (int i = 0; i < m_seperators.length(); i++) {
-        if (i != 0) {
-            stream << ',';
+    m_phaseInstGroups.clear();
+    m_groupPhaseIndexes.clear();
+    m_curGroup = 0;
+    m_currentPhaseMatchCount = 0;
+    memset(m_phaseMatchResult, 0, m_phaseCount * sizeof(bool));
+
+    int instCount = 0;
+    int rc = apiObj.instCount(&instCount);
+    for (int iInst = 0; FTSError::isOK(rc) && iInst < instCount; iInst++) {
+        int ic;
+        int io;
+        int ip;
+        rc = apiObj.inst(iInst, &ip, &ic, &io);
+        if (!FTSError::isOK(rc) || ic != m_columnNum) {
+            continue;
         }
-        stream << m_matchIndex[i];
-    }
-    stream << m_seperators[0];
-    for (auto &output : m_output) {
-        if (output.second >= 0) {
-            stream << m_seperators[0];
-            stream << output.first;
-            stream << m_seperators[0];
-            stream << output.second;
-            stream << m_seperators[0];
-        } else {
-            stream << output.first;
+        int iEnd = io - 1 + apiObj.getPhraseSize(ip);
+        if (m_phaseInstGroups.empty() || io > m_phaseInstGroups.back().end) {
+            if (!m_phaseInstGroups.empty()) {
+                markPhaseMatched(m_phaseInstGroups.back(), m_currentPhaseMatchCount);
+            }
+            int phaseIndexBegin = (int) m_groupPhaseIndexes.size();
+            m_phaseInstGroups.push_back({ io, iEnd, phaseIndexBegin, phaseIndexBegin });
+        } else if (iEnd > m_phaseInstGroups.back().end) {
+            m_phaseInstGroups.back().end = iEnd;
         }
+        m_groupPhaseIndexes.push_back(ip);
+        m_phaseInstGroups.back().phaseIndexEnd++;
+    }
+    if (!m_phaseInstGroups.empty()) {
+        markPhaseMatched(m_phaseInstGroups.back(), m_currentPhaseMatchCount);
     }
+    return rc;
 }
 
-#pragma mark - PhaseInstIter
-
-SubstringMatchInfo::PhaseInstIter::PhaseInstIter()
-: m_curPhaseStart(-1), m_curPhaseEnd(-1), m_iInst(0), m_nInst(0)
+void SubstringMatchInfo::markPhaseMatched(const PhaseInstGroup &group, int &matchCount)
 {
+    for (int i = group.phaseIndexBegin; i < group.phaseIndexEnd; i++) {
+        int phaseIndex = m_groupPhaseIndexes[i];
+        if (!m_phaseMatchResult[phaseIndex]) {
+            m_phaseMatchResult[phaseIndex] = true;
+            matchCount++;
+        }
+    }
 }
 
-SubstringMatchInfo::PhaseInstIter::~PhaseInstIter() = default;
+#pragma mark - Output
+void SubstringMatchInfo::appendText(const UnsafeStringView &text)
+{
+    m_body.append(text.data(), text.length());
+}
 
-int SubstringMatchInfo::PhaseInstIter::init(FTS5AuxiliaryFunctionAPI *apiObj)
+static void appendInteger(std::string &output, int value)
 {
-    m_apiObj = apiObj;
-    return m_apiObj->instCount(&m_nInst);
+    char buffer[16];
+    int length = snprintf(buffer, sizeof(buffer), "%d", value);
+    output.append(buffer, length);
 }
 
-int SubstringMatchInfo::PhaseInstIter::next(int iCol)
+void SubstringMatchInfo::appendMatchedText(const UnsafeStringView &text, int offset)
 {
-    int rc = FTSError::OK();
-    m_curPhaseStart = -1;
-    m_curPhaseEnd = -1;
-    m_phaseIndexes.clear();
+    char seperator = m_seperators[0];
+    m_body.push_back(seperator);
+    m_body.append(text.data(), text.length());
+    m_body.push_back(seperator);
+    appendInteger(m_body, offset);
+    m_body.push_back(seperator);
+}
 
-    while (FTSError::isOK(rc) && m_iInst < m_nInst) {
-        int ic;
-        int io;
-        int ip;
-        rc = m_apiObj->inst(m_iInst, &ip, &ic, &io);
-        if (FTSError::isOK(rc)) {
-            if (ic == iCol) {
-                int iEnd = io - 1 + m_apiObj->getPhraseSize(ip);
-                if (m_curPhaseEnd < 0) {
-                    m_phaseIndexes.emplace_back(ip);
-                    m_curPhaseStart = io;
-                    m_curPhaseEnd = iEnd;
-                } else if (io <= m_curPhaseEnd) {
-                    m_phaseIndexes.emplace_back(ip);
-                    if (iEnd > m_curPhaseEnd) {
-                        m_curPhaseEnd = iEnd;
-                    }
-                } else {
-                    break;
-                }
-            }
-            m_iInst++;
+void SubstringMatchInfo::generateOutput()
+{
+    m_result.clear();
+    for (int i = 0; i < m_seperators.length(); i++) {
+        if (i != 0) {
+            m_result.push_back(',');
         }
+        appendInteger(m_result, m_matchIndex[i]);
     }
-    return rc;
+    m_result.push_back(m_seperators[0]);
+    m_result.append(m_body);
 }
 
 } // namespace WCDB
@@ -25,6 +25,7 @@
 #pragma once
 
 #include "AuxiliaryFunctionModule.hpp"
+#include <string>
 #include <vector>
 
 namespace WCDB {
@@ -39,27 +40,23 @@ public:
     int internalTokenCallback(int tflags, const char *pToken, int nToken, int iStartOff, int iEndOff);
 
 private:
-    class PhaseInstIter final {
-        friend class SubstringMatchInfo;
-
-    public:
-        PhaseInstIter();
-        ~PhaseInstIter();
-        int init(FTS5AuxiliaryFunctionAPI *apiObj);
-        int next(int iCol);
-
-    private:
-        FTS5AuxiliaryFunctionAPI *m_apiObj;
-        int m_curPhaseStart;
-        int m_curPhaseEnd;
-        int m_iInst;
-        int m_nInst;
-        std::vector<int> m_phaseIndexes;
+    // Overlapping phrase instances of the matched column are merged into one group.
+    // Groups are collected once per row and then consumed by the tokenizer callback,
+    // so that the instances are not iterated twice.
+    struct PhaseInstGroup {
+        int start;
+        int end;
+        int phaseIndexBegin;
+        int phaseIndexEnd;
     };
+    int collectPhaseInstGroups(FTS5AuxiliaryFunctionAPI &apiObj);
+    void markPhaseMatched(const PhaseInstGroup &group, int &matchCount);
 
     void resetStatusFromLevel(int level);
     int checkSeperator(char sep);
-    void generateOutput(std::ostringstream &stream);
+    void appendText(const UnsafeStringView &text);
+    void appendMatchedText(const UnsafeStringView &text, int offset);
+    void generateOutput();
 
     UnsafeStringView m_input;
     int m_columnNum;
@@ -76,8 +73,13 @@ private:
     int m_curLevelStartPos;
 
     StringView m_seperators;
-    std::vector<std::pair<UnsafeStringView, int>> m_output;
-    PhaseInstIter m_pIter;
+
+    // Buffers below are reused across rows of the same cursor.
+    std::vector<PhaseInstGroup> m_phaseInstGroups;
+    std::vector<int> m_groupPhaseIndexes;
+    size_t m_curGroup;
+    std::string m_body;
+    std::string m_result;
 };
 
 } // namespace WCDB
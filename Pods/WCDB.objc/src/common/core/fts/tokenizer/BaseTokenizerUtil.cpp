@@ -24,6 +24,7 @@
 
 #include "BaseTokenizerUtil.hpp"
 #include "Assertion.hpp"
+#include "CompiledTokenizerDict.hpp"
 #include "FTSError.hpp"
 
 namespace WCDB {
@@ -139,8 +140,19 @@ BaseTokenizerUtil::UnicodeNormalizer& BaseTokenizerUtil::getUnicodeNormalizer()
 const std::vector<StringView>
 BaseTokenizerUtil::getPinYin(const UnsafeStringView& chineseCharacter)
 {
-    WCTAssert(g_pinyinDict != nullptr || getPinyinConverter() != nullptr);
-    if (g_pinyinDict != nullptr) {
+    std::shared_ptr<CompiledTokenizerDict> compiledDict = getCompiledPinyinDict();
+    WCTAssert(g_pinyinDict != nullptr || compiledDict != nullptr
+              || getPinyinConverter() != nullptr);
+    if (compiledDict != nullptr) {
+        // They are copied since the dict may be released once it returns.
+        CompiledTokenizerDict::Values values = compiledDict->find(chineseCharacter);
+        std::vector<StringView> pinyins;
+        pinyins.reserve(values.size());
+        for (size_t i = 0; i < values.size(); ++i) {
+            pinyins.push_back(StringView(values[i]));
+        }
+        return pinyins;
+    } else if (g_pinyinDict != nullptr) {
         auto iter = g_pinyinDict->find(chineseCharacter);
         if (iter != g_pinyinDict->end()) {
             return iter->second;
@@ -151,22 +163,67 @@ BaseTokenizerUtil::getPinYin(const UnsafeStringView& chineseCharacter)
     return std::vector<StringView>();
 }
 
+void BaseTokenizerUtil::getPinYin(const CompiledTokenizerDict* compiledDict,
+                                  const UnsafeStringView& chineseCharacter,
+                                  std::vector<StringView>& pinyins)
+{
+    pinyins.clear();
+    if (compiledDict != nullptr) {
+        CompiledTokenizerDict::Values values = compiledDict->find(chineseCharacter);
+        for (size_t i = 0; i < values.size(); ++i) {
+            pinyins.push_back(StringView::makeConstant(values[i].data()));
+        }
+    } else if (g_pinyinDict != nullptr) {
+        auto iter = g_pinyinDict->find(chineseCharacter);
+        if (iter != g_pinyinDict->end()) {
+            pinyins.assign(iter->second.begin(), iter->second.end());
+        }
+    } else if (getPinyinConverter() != nullptr) {
+        pinyins = getPinyinConverter()(chineseCharacter);
+    }
+}
+
+std::shared_ptr<CompiledTokenizerDict> BaseTokenizerUtil::getCompiledPinyinDict()
+{
+    return std::atomic_load(&compiledPinyinDict());
+}
+
+std::shared_ptr<CompiledTokenizerDict>& BaseTokenizerUtil::compiledPinyinDict()
+{
+    static std::shared_ptr<CompiledTokenizerDict>& dict
+    = *new std::shared_ptr<CompiledTokenizerDict>();
+    return dict;
+}
+
 WCDB::StringViewMap<std::vector<WCDB::StringView>>* BaseTokenizerUtil::g_pinyinDict = nullptr;
-void BaseTokenizerUtil::configPinyinDict(WCDB::StringViewMap<std::vector<WCDB::StringView>>* dict)
+
+void BaseTokenizerUtil::clearPinyinDict()
 {
     if (g_pinyinDict != nullptr) {
         delete g_pinyinDict;
         g_pinyinDict = nullptr;
     }
+    std::atomic_store(&compiledPinyinDict(), std::shared_ptr<CompiledTokenizerDict>());
+}
+
+void BaseTokenizerUtil::configPinyinDict(WCDB::StringViewMap<std::vector<WCDB::StringView>>* dict)
+{
+    clearPinyinDict();
     g_pinyinDict = dict;
 }
 
+void BaseTokenizerUtil::configPinyinDict(CompiledTokenizerDict* dict)
+{
+    WCTRemedialAssert(dict == nullptr || dict->type() == CompiledTokenizerDict::Type::Pinyin,
+                      "Compiled dict is not a pinyin dict.",
+                      return;);
+    clearPinyinDict();
+    std::atomic_store(&compiledPinyinDict(), std::shared_ptr<CompiledTokenizerDict>(dict));
+}
+
 void BaseTokenizerUtil::configPinyinConverter(PinYinConverter converter)
 {
-    if (g_pinyinDict != nullptr) {
-        delete g_pinyinDict;
-        g_pinyinDict = nullptr;
-    }
+    clearPinyinDict();
     getPinyinConverter() = converter;
 }
 
@@ -180,9 +237,17 @@ BaseTokenizerUtil::PinYinConverter& BaseTokenizerUtil::getPinyinConverter()
 
 const StringView BaseTokenizerUtil::getSimplifiedChinese(const UnsafeStringView& chineseCharacter)
 {
-    WCTAssert(g_traditionalChineseDict != nullptr
+    std::shared_ptr<CompiledTokenizerDict> compiledDict
+    = std::atomic_load(&compiledTraditionalChineseDict());
+    WCTAssert(g_traditionalChineseDict != nullptr || compiledDict != nullptr
               || getTraditionalChineseConverter() != nullptr);
-    if (g_traditionalChineseDict != nullptr) {
+    if (compiledDict != nullptr) {
+        CompiledTokenizerDict::Values values = compiledDict->find(chineseCharacter);
+        if (!values.empty()) {
+            // It's copied since the dict may be released once it returns.
+            return StringView(values[0]);
+        }
+    } else if (g_traditionalChineseDict != nullptr) {
         auto iter = g_traditionalChineseDict->find(chineseCharacter);
         if (iter != g_traditionalChineseDict->end() && iter->second.length() > 0) {
             return iter->second;
@@ -198,21 +263,43 @@ const StringView BaseTokenizerUtil::getSimplifiedChinese(const UnsafeStringView&
 }
 
 WCDB::StringViewMap<WCDB::StringView>* BaseTokenizerUtil::g_traditionalChineseDict = nullptr;
-void BaseTokenizerUtil::configTraditionalChineseDict(WCDB::StringViewMap<WCDB::StringView>* dict)
+
+std::shared_ptr<CompiledTokenizerDict>& BaseTokenizerUtil::compiledTraditionalChineseDict()
+{
+    static std::shared_ptr<CompiledTokenizerDict>& dict
+    = *new std::shared_ptr<CompiledTokenizerDict>();
+    return dict;
+}
+
+void BaseTokenizerUtil::clearTraditionalChineseDict()
 {
     if (g_traditionalChineseDict != nullptr) {
         delete g_traditionalChineseDict;
         g_traditionalChineseDict = nullptr;
     }
+    std::atomic_store(&compiledTraditionalChineseDict(), std::shared_ptr<CompiledTokenizerDict>());
+}
+
+void BaseTokenizerUtil::configTraditionalChineseDict(WCDB::StringViewMap<WCDB::StringView>* dict)
+{
+    clearTraditionalChineseDict();
     g_traditionalChineseDict = dict;
 }
 
+void BaseTokenizerUtil::configTraditionalChineseDict(CompiledTokenizerDict* dict)
+{
+    WCTRemedialAssert(dict == nullptr
+                      || dict->type() == CompiledTokenizerDict::Type::TraditionalChinese,
+                      "Compiled dict is not a traditional chinese dict.",
+                      return;);
+    clearTraditionalChineseDict();
+    std::atomic_store(&compiledTraditionalChineseDict(),
+                      std::shared_ptr<CompiledTokenizerDict>(dict));
+}
+
 void BaseTokenizerUtil::configTraditionalChineseConverter(TraditionalChineseConverter converter)
 {
-    if (g_traditionalChineseDict != nullptr) {
-        delete g_traditionalChineseDict;
-        g_traditionalChineseDict = nullptr;
-    }
+    clearTraditionalChineseDict();
     getTraditionalChineseConverter() = converter;
 }
 
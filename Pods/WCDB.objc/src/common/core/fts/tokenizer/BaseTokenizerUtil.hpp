@@ -26,10 +26,13 @@
 
 #include "StringView.hpp"
 #include <functional>
+#include <memory>
 #include <vector>
 
 namespace WCDB {
 
+class CompiledTokenizerDict;
+
 class WCDB_API BaseTokenizerUtil {
 public:
     enum class UnicodeType : unsigned int {
@@ -53,24 +56,37 @@ public:
     static StringView normalizeToken(UnsafeStringView& token);
 
     static const std::vector<StringView> getPinYin(const UnsafeStringView& chineseCharacter);
+    // The compiled dict stays alive for its holders after it's replaced or cleared.
+    static std::shared_ptr<CompiledTokenizerDict> getCompiledPinyinDict();
+    // Reuse the buffer of pinyins to avoid allocation. Pinyins are looked up in the compiled dict if it's not null.
+    // They are referenced in place of the compiled dict, so the dict should be held as long as they are used.
+    static void getPinYin(const CompiledTokenizerDict* compiledDict,
+                          const UnsafeStringView& chineseCharacter,
+                          std::vector<StringView>& pinyins);
     typedef std::function<std::vector<StringView>(const UnsafeStringView&)> PinYinConverter;
     static void configPinyinConverter(PinYinConverter converter);
     static void
     configPinyinDict(WCDB::StringViewMap<std::vector<WCDB::StringView>>* dict);
+    static void configPinyinDict(CompiledTokenizerDict* dict);
 
     static const StringView getSimplifiedChinese(const UnsafeStringView& chineseCharacter);
     typedef std::function<const StringView(const UnsafeStringView&)> TraditionalChineseConverter;
     static void configTraditionalChineseConverter(TraditionalChineseConverter converter);
     static void configTraditionalChineseDict(WCDB::StringViewMap<WCDB::StringView>* dict);
+    static void configTraditionalChineseDict(CompiledTokenizerDict* dict);
 
 private:
     static PinYinConverter& getPinyinConverter();
     static WCDB::StringViewMap<std::vector<WCDB::StringView>>* g_pinyinDict;
+    static std::shared_ptr<CompiledTokenizerDict>& compiledPinyinDict();
+    static void clearPinyinDict();
 
     static SymbolDetector& getSymbolDetector();
     static UnicodeNormalizer& getUnicodeNormalizer();
     static TraditionalChineseConverter& getTraditionalChineseConverter();
     static WCDB::StringViewMap<WCDB::StringView>* g_traditionalChineseDict;
+    static std::shared_ptr<CompiledTokenizerDict>& compiledTraditionalChineseDict();
+    static void clearTraditionalChineseDict();
 };
 
 } //namespace WCDB
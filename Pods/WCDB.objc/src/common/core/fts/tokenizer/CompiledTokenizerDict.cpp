@@ -0,0 +1,421 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CompiledTokenizerDict.hpp"
+#include "Assertion.hpp"
+#include "CoreConst.h"
+#include "FileHandle.hpp"
+#include "FileManager.hpp"
+#include "Notifier.hpp"
+#include "WCDBError.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace WCDB {
+
+CompiledTokenizerDict::CompiledTokenizerDict(const UnsafeData& data)
+: m_data(data)
+, m_denseIndex(nullptr)
+, m_sparseIndex(nullptr)
+, m_entries(nullptr)
+, m_pool(nullptr)
+, m_firstCodepoint(0)
+, m_denseCount(0)
+, m_sparseCount(0)
+{
+    const unsigned char* base = m_data.buffer();
+    m_firstCodepoint = get4BytesUInt(base + 3 * sizeof(uint32_t));
+    m_denseCount = get4BytesUInt(base + 4 * sizeof(uint32_t));
+    m_sparseCount = get4BytesUInt(base + 5 * sizeof(uint32_t));
+    uint32_t entryCount = get4BytesUInt(base + 6 * sizeof(uint32_t));
+    m_denseIndex = base + headerSize;
+    m_sparseIndex = m_denseIndex + (m_denseCount + 1) * sizeof(uint32_t);
+    m_entries = m_sparseIndex + m_sparseCount * sparseItemSize;
+    m_pool = (const char*) (m_entries + entryCount * entrySize);
+}
+
+CompiledTokenizerDict::~CompiledTokenizerDict() = default;
+
+CompiledTokenizerDict::Type CompiledTokenizerDict::type() const
+{
+    return (Type) get4BytesUInt(m_data.buffer() + 2 * sizeof(uint32_t));
+}
+
+size_t CompiledTokenizerDict::memoryUsage() const
+{
+    return m_data.size();
+}
+
+uint32_t CompiledTokenizerDict::get4BytesUInt(const unsigned char* p)
+{
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16)
+           | ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+#pragma mark - Compile
+Data CompiledTokenizerDict::compile(const StringViewMap<std::vector<StringView>>& pinyinDict)
+{
+    CompilingItems items;
+    items.reserve(pinyinDict.size());
+    for (const auto& iter : pinyinDict) {
+        uint32_t codepoint;
+        if (!decodeCodepoint(iter.first, codepoint)) {
+            continue;
+        }
+        std::vector<UnsafeStringView> pinyins;
+        for (const StringView& pinyin : iter.second) {
+            if (pinyin.length() > 0) {
+                pinyins.emplace_back(pinyin);
+            }
+        }
+        if (!pinyins.empty()) {
+            items.emplace_back(codepoint, std::move(pinyins));
+        }
+    }
+    return compile(Type::Pinyin, items);
+}
+
+Data CompiledTokenizerDict::compile(const StringViewMap<StringView>& traditionalChineseDict)
+{
+    CompilingItems items;
+    items.reserve(traditionalChineseDict.size());
+    for (const auto& iter : traditionalChineseDict) {
+        uint32_t codepoint;
+        if (iter.second.length() == 0 || !decodeCodepoint(iter.first, codepoint)) {
+            continue;
+        }
+        items.emplace_back(codepoint, std::vector<UnsafeStringView>({ iter.second }));
+    }
+    return compile(Type::TraditionalChinese, items);
+}
+
+Data CompiledTokenizerDict::compile(Type type, CompilingItems& items)
+{
+    std::sort(items.begin(),
+              items.end(),
+              [](const CompilingItems::value_type& left, const CompilingItems::value_type& right) {
+                  return left.first < right.first;
+              });
+
+    // Codepoints in BMP are indexed directly while the rare ones outside are searched.
+    auto sparseBegin
+    = std::find_if(items.begin(), items.end(), [](const CompilingItems::value_type& item) {
+          return item.first > maxDenseCodepoint;
+      });
+    uint32_t firstCodepoint = 0;
+    uint32_t denseCount = 0;
+    if (sparseBegin != items.begin()) {
+        firstCodepoint = items.front().first;
+        denseCount = (sparseBegin - 1)->first - firstCodepoint + 1;
+    }
+    uint32_t sparseCount = (uint32_t) (items.end() - sparseBegin);
+
+    StringViewMap<uint32_t> poolOffsets;
+    std::vector<UnsafeStringView> poolStrings;
+    uint32_t poolSize = 0;
+    uint32_t entryCount = 0;
+    for (const auto& item : items) {
+        for (const UnsafeStringView& value : item.second) {
+            if (poolOffsets.find(value) == poolOffsets.end()) {
+                poolOffsets.emplace(value, poolSize);
+                poolStrings.push_back(value);
+                poolSize += (uint32_t) value.length() + 1;
+            }
+            ++entryCount;
+        }
+    }
+
+    size_t totalSize = headerSize + (denseCount + 1) * sizeof(uint32_t)
+                       + sparseCount * sparseItemSize + entryCount * entrySize + poolSize;
+    Data data(totalSize);
+    if (data.empty()) {
+        return Data::null();
+    }
+    unsigned char* cursor = data.buffer();
+    auto put4BytesUInt = [&cursor](uint32_t value) {
+        cursor[0] = (uint8_t) (value >> 24);
+        cursor[1] = (uint8_t) (value >> 16);
+        cursor[2] = (uint8_t) (value >> 8);
+        cursor[3] = (uint8_t) value;
+        cursor += sizeof(uint32_t);
+    };
+
+    // header
+    put4BytesUInt(magic);
+    put4BytesUInt(version);
+    put4BytesUInt((uint32_t) type);
+    put4BytesUInt(firstCodepoint);
+    put4BytesUInt(denseCount);
+    put4BytesUInt(sparseCount);
+    put4BytesUInt(entryCount);
+    put4BytesUInt(poolSize);
+
+    // dense index
+    uint32_t entryOffset = 0;
+    auto iter = items.begin();
+    for (uint32_t codepoint = firstCodepoint; codepoint < firstCodepoint + denseCount; ++codepoint) {
+        put4BytesUInt(entryOffset);
+        if (iter != sparseBegin && iter->first == codepoint) {
+            entryOffset += (uint32_t) iter->second.size();
+            ++iter;
+        }
+    }
+    put4BytesUInt(entryOffset);
+
+    // sparse index
+    for (; iter != items.end(); ++iter) {
+        put4BytesUInt(iter->first);
+        put4BytesUInt(entryOffset);
+        put4BytesUInt((uint32_t) iter->second.size());
+        entryOffset += (uint32_t) iter->second.size();
+    }
+
+    // entries
+    for (const auto& item : items) {
+        for (const UnsafeStringView& value : item.second) {
+            put4BytesUInt(poolOffsets.find(value)->second);
+            put4BytesUInt((uint32_t) value.length());
+        }
+    }
+
+    // pool
+    for (const UnsafeStringView& value : poolStrings) {
+        memcpy(cursor, value.data(), value.length());
+        cursor[value.length()] = '\0';
+        cursor += value.length() + 1;
+    }
+    WCTAssert(cursor == data.buffer() + totalSize);
+    return data;
+}
+
+bool CompiledTokenizerDict::save(const UnsafeData& compiled, const UnsafeStringView& path)
+{
+    WCTRemedialAssert(!compiled.empty(), "Compiled dictionary is empty.", return false;);
+    FileHandle fileHandle(path);
+    if (!fileHandle.open(FileHandle::Mode::OverWrite)) {
+        return false;
+    }
+    bool succeed = fileHandle.write(compiled);
+    fileHandle.close();
+    FileManager::setFileProtectionCompleteUntilFirstUserAuthenticationIfNeeded(path);
+    return succeed;
+}
+
+#pragma mark - Load
+CompiledTokenizerDict* CompiledTokenizerDict::load(const UnsafeData& compiled)
+{
+    if (!isValid(compiled)) {
+        return nullptr;
+    }
+    return new CompiledTokenizerDict(compiled);
+}
+
+CompiledTokenizerDict* CompiledTokenizerDict::load(const UnsafeStringView& path)
+{
+    FileHandle fileHandle(path);
+    if (!fileHandle.open(FileHandle::Mode::ReadOnly)) {
+        return nullptr;
+    }
+    UnsafeData data = fileHandle.mapOrReadAllData();
+    fileHandle.close();
+    if (data.empty()) {
+        return nullptr;
+    }
+    return load(data);
+}
+
+bool CompiledTokenizerDict::isValid(const UnsafeData& data)
+{
+    if (data.size() < headerSize) {
+        markAsCorrupted("Header");
+        return false;
+    }
+    const unsigned char* base = data.buffer();
+    if (get4BytesUInt(base) != magic) {
+        markAsCorrupted("Magic");
+        return false;
+    }
+    if (get4BytesUInt(base + sizeof(uint32_t)) != version) {
+        markAsCorrupted("Version");
+        return false;
+    }
+    uint32_t type = get4BytesUInt(base + 2 * sizeof(uint32_t));
+    if (type != (uint32_t) Type::Pinyin && type != (uint32_t) Type::TraditionalChinese) {
+        markAsCorrupted("Type");
+        return false;
+    }
+    uint64_t denseCount = get4BytesUInt(base + 4 * sizeof(uint32_t));
+    uint64_t sparseCount = get4BytesUInt(base + 5 * sizeof(uint32_t));
+    uint64_t entryCount = get4BytesUInt(base + 6 * sizeof(uint32_t));
+    uint64_t poolSize = get4BytesUInt(base + 7 * sizeof(uint32_t));
+    if (denseCount > maxDenseCodepoint + 1
+        || headerSize + (denseCount + 1) * sizeof(uint32_t) + sparseCount * sparseItemSize
+           + entryCount * entrySize + poolSize
+           != data.size()) {
+        markAsCorrupted("Size");
+        return false;
+    }
+    // Offsets are checked once here so that lookups never need bound checks.
+    const unsigned char* denseIndex = base + headerSize;
+    uint32_t previous = 0;
+    for (uint64_t i = 0; i <= denseCount; ++i) {
+        uint32_t offset = get4BytesUInt(denseIndex + i * sizeof(uint32_t));
+        if (offset < previous || offset > entryCount) {
+            markAsCorrupted("DenseIndex");
+            return false;
+        }
+        previous = offset;
+    }
+    const unsigned char* sparseIndex = denseIndex + (denseCount + 1) * sizeof(uint32_t);
+    for (uint64_t i = 0; i < sparseCount; ++i) {
+        const unsigned char* item = sparseIndex + i * sparseItemSize;
+        uint64_t offset = get4BytesUInt(item + sizeof(uint32_t));
+        uint64_t count = get4BytesUInt(item + 2 * sizeof(uint32_t));
+        if (offset + count > entryCount
+            || (i > 0 && get4BytesUInt(item) <= get4BytesUInt(item - sparseItemSize))) {
+            markAsCorrupted("SparseIndex");
+            return false;
+        }
+    }
+    const unsigned char* entries = sparseIndex + sparseCount * sparseItemSize;
+    const unsigned char* pool = entries + entryCount * entrySize;
+    for (uint64_t i = 0; i < entryCount; ++i) {
+        const unsigned char* entry = entries + i * entrySize;
+        uint64_t offset = get4BytesUInt(entry);
+        uint64_t length = get4BytesUInt(entry + sizeof(uint32_t));
+        if (offset + length >= poolSize || pool[offset + length] != '\0') {
+            markAsCorrupted("Entry");
+            return false;
+        }
+    }
+    return true;
+}
+
+void CompiledTokenizerDict::markAsCorrupted(const UnsafeStringView& element)
+{
+    Error error(Error::Code::Corrupt, Error::Level::Error, "Compiled tokenizer dictionary is corrupted.");
+    error.infos.insert_or_assign("Element", element);
+    Notifier::shared().notify(error);
+}
+
+#pragma mark - Lookup
+CompiledTokenizerDict::Values::Values()
+: m_entries(nullptr), m_count(0), m_pool(nullptr)
+{
+}
+
+CompiledTokenizerDict::Values::Values(const unsigned char* entries, uint32_t count, const char* pool)
+: m_entries(entries), m_count(count), m_pool(pool)
+{
+}
+
+size_t CompiledTokenizerDict::Values::size() const
+{
+    return m_count;
+}
+
+bool CompiledTokenizerDict::Values::empty() const
+{
+    return m_count == 0;
+}
+
+UnsafeStringView CompiledTokenizerDict::Values::operator[](size_t index) const
+{
+    WCTAssert(index < m_count);
+    const unsigned char* entry = m_entries + index * entrySize;
+    return UnsafeStringView(m_pool + get4BytesUInt(entry),
+                            get4BytesUInt(entry + sizeof(uint32_t)));
+}
+
+CompiledTokenizerDict::Values CompiledTokenizerDict::find(const UnsafeStringView& character) const
+{
+    uint32_t codepoint;
+    if (!decodeCodepoint(character, codepoint)) {
+        return Values();
+    }
+    uint32_t begin = 0;
+    uint32_t end = 0;
+    if (codepoint <= maxDenseCodepoint) {
+        if (codepoint < m_firstCodepoint || codepoint - m_firstCodepoint >= m_denseCount) {
+            return Values();
+        }
+        const unsigned char* index
+        = m_denseIndex + (codepoint - m_firstCodepoint) * sizeof(uint32_t);
+        begin = get4BytesUInt(index);
+        end = get4BytesUInt(index + sizeof(uint32_t));
+    } else {
+        uint32_t low = 0;
+        uint32_t high = m_sparseCount;
+        while (low < high) {
+            uint32_t middle = low + (high - low) / 2;
+            const unsigned char* item = m_sparseIndex + middle * sparseItemSize;
+            uint32_t current = get4BytesUInt(item);
+            if (current == codepoint) {
+                begin = get4BytesUInt(item + sizeof(uint32_t));
+                end = begin + get4BytesUInt(item + 2 * sizeof(uint32_t));
+                break;
+            } else if (current < codepoint) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+    }
+    return Values(m_entries + begin * entrySize, end - begin, m_pool);
+}
+
+bool CompiledTokenizerDict::decodeCodepoint(const UnsafeStringView& character, uint32_t& codepoint)
+{
+    size_t length = character.length();
+    if (length == 0) {
+        return false;
+    }
+    const unsigned char* p = (const unsigned char*) character.data();
+    size_t expected;
+    if (p[0] < 0x80) {
+        codepoint = p[0];
+        expected = 1;
+    } else if (p[0] < 0xC0) {
+        return false;
+    } else if (p[0] < 0xE0) {
+        codepoint = p[0] & 0x1F;
+        expected = 2;
+    } else if (p[0] < 0xF0) {
+        codepoint = p[0] & 0x0F;
+        expected = 3;
+    } else if (p[0] < 0xF8) {
+        codepoint = p[0] & 0x07;
+        expected = 4;
+    } else {
+        return false;
+    }
+    if (length != expected) {
+        return false;
+    }
+    for (size_t i = 1; i < expected; ++i) {
+        if ((p[i] & 0xC0) != 0x80) {
+            return false;
+        }
+        codepoint = (codepoint << 6) | (p[i] & 0x3F);
+    }
+    return true;
+}
+
+} //namespace WCDB
@@ -0,0 +1,120 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Data.hpp"
+#include "StringView.hpp"
+#include <vector>
+
+namespace WCDB {
+
+/*
+ Layout of a compiled dictionary. All integers are 4-byte big-endian.
+
+ | magic | version | type | first codepoint | dense count | sparse count | entry count | pool size |
+ | dense index: (dense count + 1) entry offsets, indexed by codepoint - first codepoint |
+ | sparse index: sparse count * (codepoint, entry offset, entry count), sorted by codepoint |
+ | entries: entry count * (pool offset, length) |
+ | pool: deduplicated, null-terminated utf8 strings |
+
+ Lookups read the blob in place, so it can be mapped from file and used without parsing.
+ */
+class WCDB_API CompiledTokenizerDict final {
+public:
+    enum class Type : uint32_t {
+        Pinyin = 1,
+        TraditionalChinese = 2,
+    };
+
+    ~CompiledTokenizerDict();
+    CompiledTokenizerDict() = delete;
+    CompiledTokenizerDict(const CompiledTokenizerDict&) = delete;
+    CompiledTokenizerDict& operator=(const CompiledTokenizerDict&) = delete;
+
+#pragma mark - Compile
+public:
+    // Keys that are not a single unicode character are skipped.
+    static Data compile(const StringViewMap<std::vector<StringView>>& pinyinDict);
+    static Data compile(const StringViewMap<StringView>& traditionalChineseDict);
+    static bool save(const UnsafeData& compiled, const UnsafeStringView& path);
+
+#pragma mark - Load
+public:
+    // Return nullptr if the data is not a valid compiled dictionary.
+    static CompiledTokenizerDict* load(const UnsafeData& compiled);
+    // The file is mapped into memory if possible.
+    static CompiledTokenizerDict* load(const UnsafeStringView& path);
+
+    Type type() const;
+    size_t memoryUsage() const;
+
+protected:
+    CompiledTokenizerDict(const UnsafeData& data);
+    static bool isValid(const UnsafeData& data);
+    static void markAsCorrupted(const UnsafeStringView& element);
+
+    UnsafeData m_data;
+    const unsigned char* m_denseIndex;
+    const unsigned char* m_sparseIndex;
+    const unsigned char* m_entries;
+    const char* m_pool;
+    uint32_t m_firstCodepoint;
+    uint32_t m_denseCount;
+    uint32_t m_sparseCount;
+
+#pragma mark - Lookup
+public:
+    // Strings are referenced in place and live as long as the dictionary.
+    class WCDB_API Values final {
+    public:
+        Values();
+        Values(const unsigned char* entries, uint32_t count, const char* pool);
+
+        size_t size() const;
+        bool empty() const;
+        UnsafeStringView operator[](size_t index) const;
+
+    private:
+        const unsigned char* m_entries;
+        uint32_t m_count;
+        const char* m_pool;
+    };
+
+    Values find(const UnsafeStringView& character) const;
+
+    // Return false if the string is not exactly one well-formed utf8 character.
+    static bool decodeCodepoint(const UnsafeStringView& character, uint32_t& codepoint);
+
+private:
+    static constexpr uint32_t magic = 0x57435444; // WCTD
+    static constexpr uint32_t version = 0x01000000;
+    static constexpr size_t headerSize = 8 * sizeof(uint32_t);
+    static constexpr size_t entrySize = 2 * sizeof(uint32_t);
+    static constexpr size_t sparseItemSize = 3 * sizeof(uint32_t);
+    static constexpr uint32_t maxDenseCodepoint = 0xFFFF;
+
+    static uint32_t get4BytesUInt(const unsigned char* p);
+
+    typedef std::vector<std::pair<uint32_t, std::vector<UnsafeStringView>>> CompilingItems;
+    static Data compile(Type type, CompilingItems& items);
+};
+
+} //namespace WCDB
@@ -0,0 +1,291 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FTSTokenCache.hpp"
+#include "Assertion.hpp"
+#include "CommonCore.hpp"
+#include "SQLite.h"
+#include "WorkerPool.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace WCDB {
+
+FTSTokenCache::FTSTokenCache()
+: m_module(nullptr), m_tokenizerType(nullptr), m_numberOfDocuments(0)
+{
+}
+
+FTSTokenCache::~FTSTokenCache() = default;
+
+FTSTokenCache::Document::Document(const UnsafeStringView& text_) : text(text_)
+{
+}
+
+void FTSTokenCache::addDocument(int64_t rowid, const UnsafeStringView& text)
+{
+    m_rows[rowid].emplace_back(text);
+    ++m_numberOfDocuments;
+}
+
+void FTSTokenCache::clear()
+{
+    m_rows.clear();
+    m_numberOfDocuments = 0;
+}
+
+size_t FTSTokenCache::numberOfDocuments() const
+{
+    return m_numberOfDocuments;
+}
+
+size_t FTSTokenCache::numberOfTokens() const
+{
+    size_t count = 0;
+    for (const auto& row : m_rows) {
+        for (const Document& document : row.second) {
+            count += document.tokens.size();
+        }
+    }
+    return count;
+}
+
+bool FTSTokenCache::useTokenizerOfTable(const UnsafeStringView& createTableSQL)
+{
+    m_module = nullptr;
+    m_arguments.clear();
+    m_tokenizerType = nullptr;
+
+    std::string sql(createTableSQL.data(), createTableSQL.length());
+    std::string lowercaseSQL(sql);
+    std::transform(lowercaseSQL.begin(), lowercaseSQL.end(), lowercaseSQL.begin(), ::tolower);
+    size_t pos = lowercaseSQL.find("tokenize");
+    if (pos == std::string::npos) {
+        return false;
+    }
+    pos = sql.find_first_not_of(" \t\n", pos + strlen("tokenize"));
+    if (pos == std::string::npos || sql[pos] != '=') {
+        return false;
+    }
+    pos = sql.find_first_not_of(" \t\n", pos + 1);
+    if (pos == std::string::npos) {
+        return false;
+    }
+    size_t end;
+    if (sql[pos] == '\'' || sql[pos] == '"') {
+        end = sql.find(sql[pos], pos + 1);
+        ++pos;
+    } else {
+        end = sql.find_first_of(",)", pos);
+    }
+    if (end == std::string::npos) {
+        return false;
+    }
+    std::vector<StringView> components;
+    size_t begin = pos;
+    for (size_t i = pos; i <= end; ++i) {
+        if (i == end || isspace(sql[i])) {
+            if (i > begin) {
+                components.emplace_back(StringView(sql.data() + begin, i - begin));
+            }
+            begin = i + 1;
+        }
+    }
+    if (components.empty()) {
+        return false;
+    }
+    const TokenizerModule* module = CommonCore::shared().tokenizerModule(components.front());
+    if (module == nullptr || module->getFts5Module() == nullptr) {
+        // Tokenizers of sqlite are left to tokenize during insertion.
+        return false;
+    }
+    FTS5TokenizerModule* fts5Module = module->getFts5Module().get();
+    std::vector<const char*> azArg;
+    for (auto iter = components.begin() + 1; iter != components.end(); ++iter) {
+        azArg.push_back(iter->data());
+    }
+    // Sqlite creates its own tokenizer for the table, which is recognized by class while replaying.
+    AbstractFTSTokenizer* tokenizer = nullptr;
+    if (!FTSError::isOK(
+        fts5Module->createTokenizer(azArg.data(), (int) azArg.size(), &tokenizer))
+        || tokenizer == nullptr) {
+        return false;
+    }
+    m_tokenizerType = &typeid(*tokenizer);
+    fts5Module->destroyTokenizer(tokenizer);
+    m_module = fts5Module;
+    m_arguments.assign(components.begin() + 1, components.end());
+    return true;
+}
+
+bool FTSTokenCache::hasTokenizer() const
+{
+    return m_module != nullptr;
+}
+
+bool FTSTokenCache::tokenize(int numberOfThreads)
+{
+    WCTRemedialAssert(m_module != nullptr, "Tokenizer is not set.", return false;);
+    std::vector<const char*> azArg;
+    azArg.reserve(m_arguments.size());
+    for (const StringView& argument : m_arguments) {
+        azArg.push_back(argument.data());
+    }
+    std::vector<Document*> documents;
+    documents.reserve(m_numberOfDocuments);
+    for (auto& row : m_rows) {
+        for (Document& document : row.second) {
+            documents.push_back(&document);
+        }
+    }
+    if (numberOfThreads > (int) documents.size()) {
+        numberOfThreads = (int) documents.size();
+    }
+
+    FTS5TokenizerModule& module = *m_module;
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    WorkerPool::shared().parallel(numberOfThreads, [&](int) {
+        AbstractFTSTokenizer* tokenizer = nullptr;
+        if (!FTSError::isOK(module.createTokenizer(
+            azArg.data(), (int) azArg.size(), &tokenizer))) {
+            failed = true;
+            return;
+        }
+        size_t index;
+        while (!failed.load() && (index = next++) < documents.size()) {
+            if (!tokenize(module, tokenizer, *documents[index])) {
+                failed = true;
+            }
+        }
+        module.destroyTokenizer(tokenizer);
+    });
+    return !failed.load();
+}
+
+bool FTSTokenCache::tokenize(FTS5TokenizerModule& module,
+                             AbstractFTSTokenizer* tokenizer,
+                             Document& document)
+{
+    document.buffer.clear();
+    document.tokens.clear();
+    int rc = module.tokenize(tokenizer,
+                             &document,
+                             FTS5_TOKENIZE_DOCUMENT,
+                             document.text.data(),
+                             (int) document.text.length(),
+                             FTSTokenCache::onToken);
+    if (!FTSError::isOK(rc)) {
+        document.buffer.clear();
+        document.tokens.clear();
+        return false;
+    }
+    return true;
+}
+
+int FTSTokenCache::onToken(void* pCtx, int tflags, const char* pToken, int nToken, int iStart, int iEnd)
+{
+    Document* document = static_cast<Document*>(pCtx);
+    document->tokens.push_back({ document->buffer.size(), nToken, iStart, iEnd, tflags });
+    document->buffer.append(pToken, nToken);
+    return FTSError::OK();
+}
+
+#pragma mark - Replay
+FTSTokenCache::Activation::Activation() : row(nullptr), tokenizerType(nullptr)
+{
+}
+
+ThreadLocal<FTSTokenCache::Activation>& FTSTokenCache::activation()
+{
+    static ThreadLocal<Activation>* s_activation = new ThreadLocal<Activation>();
+    return *s_activation;
+}
+
+std::atomic<int>& FTSTokenCache::numberOfActivatedRows()
+{
+    static std::atomic<int>* s_numberOfActivatedRows = new std::atomic<int>(0);
+    return *s_numberOfActivatedRows;
+}
+
+void FTSTokenCache::activate(int64_t rowid)
+{
+    deactivate();
+    auto iter = m_rows.find(rowid);
+    if (iter == m_rows.end() || m_tokenizerType == nullptr) {
+        return;
+    }
+    Activation& activated = activation().getOrCreate();
+    activated.row = &iter->second;
+    activated.tokenizerType = m_tokenizerType;
+    ++numberOfActivatedRows();
+}
+
+void FTSTokenCache::deactivate()
+{
+    Activation& activated = activation().getOrCreate();
+    if (activated.row != nullptr) {
+        activated.row = nullptr;
+        activated.tokenizerType = nullptr;
+        --numberOfActivatedRows();
+    }
+}
+
+bool FTSTokenCache::replay(const AbstractFTSTokenizer* tokenizer,
+                           int flags,
+                           const char* pText,
+                           int nText,
+                           void* pCtx,
+                           FTS5TokenizerModule::TokenCallback callback,
+                           int& rc)
+{
+    if (numberOfActivatedRows().load(std::memory_order_relaxed) == 0
+        || flags != FTS5_TOKENIZE_DOCUMENT || tokenizer == nullptr) {
+        return false;
+    }
+    const Activation& activated = activation().getOrCreate();
+    if (activated.row == nullptr || typeid(*tokenizer) != *activated.tokenizerType) {
+        return false;
+    }
+    for (const Document& document : *activated.row) {
+        if (document.text.length() != (size_t) nText
+            || (document.text.data() != pText
+                && memcmp(document.text.data(), pText, nText) != 0)) {
+            continue;
+        }
+        rc = FTSError::OK();
+        for (const Token& token : document.tokens) {
+            rc = callback(pCtx,
+                          token.flags,
+                          document.buffer.data() + token.offset,
+                          token.length,
+                          token.start,
+                          token.end);
+            if (!FTSError::isOK(rc)) {
+                break;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+} //namespace WCDB
@@ -0,0 +1,113 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "StringView.hpp"
+#include "ThreadLocal.hpp"
+#include "TokenizerModule.hpp"
+#include <atomic>
+#include <map>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace WCDB {
+
+/*
+ Documents of the rows to be inserted are tokenized ahead, possibly on multiple threads.
+ While a row is being inserted, the tokenizer of the target table replays the cached tokens of that row on the inserting thread.
+ Tokens are keyed by the rowid of the row and the class of the tokenizer, so tokenizing texts of other tables or of other rows
+ on the same thread, such as in triggers, never replays them.
+ */
+class FTSTokenCache final {
+public:
+    FTSTokenCache();
+    ~FTSTokenCache();
+    FTSTokenCache(const FTSTokenCache&) = delete;
+    FTSTokenCache& operator=(const FTSTokenCache&) = delete;
+
+    // The text is referenced and should be kept alive until the cache is cleared.
+    void addDocument(int64_t rowid, const UnsafeStringView& text);
+    void clear();
+    size_t numberOfDocuments() const;
+    size_t numberOfTokens() const;
+
+    // Use the fts5 tokenizer registered in WCDB, which is specified by `tokenize = 'name arg1 arg2'` in the sql creating the table.
+    // Return false if there is no such tokenizer.
+    bool useTokenizerOfTable(const UnsafeStringView& createTableSQL);
+    bool hasTokenizer() const;
+
+    // Tokenize all documents concurrently in the shared worker pool.
+    bool tokenize(int numberOfThreads);
+
+private:
+    FTS5TokenizerModule* m_module;
+    std::vector<StringView> m_arguments;
+    const std::type_info* m_tokenizerType;
+
+    struct Token {
+        size_t offset;
+        int length;
+        int start;
+        int end;
+        int flags;
+    };
+    struct Document {
+        Document(const UnsafeStringView& text);
+        UnsafeStringView text;
+        std::string buffer;
+        std::vector<Token> tokens;
+    };
+    typedef std::vector<Document> Row;
+    std::map<int64_t, Row> m_rows;
+    size_t m_numberOfDocuments;
+
+    static int onToken(void* pCtx, int tflags, const char* pToken, int nToken, int iStart, int iEnd);
+    static bool tokenize(FTS5TokenizerModule& module,
+                         AbstractFTSTokenizer* tokenizer,
+                         Document& document);
+
+#pragma mark - Replay
+public:
+    void activate(int64_t rowid);
+    static void deactivate();
+
+    // Return false if the text is not cached in the activated row for this kind of tokenizer.
+    static bool replay(const AbstractFTSTokenizer* tokenizer,
+                       int flags,
+                       const char* pText,
+                       int nText,
+                       void* pCtx,
+                       FTS5TokenizerModule::TokenCallback callback,
+                       int& rc);
+
+private:
+    struct Activation {
+        Activation();
+        const Row* row;
+        const std::type_info* tokenizerType;
+    };
+    static ThreadLocal<Activation>& activation();
+    // Skip the lookup of thread local storage when no row is activated in any thread.
+    static std::atomic<int>& numberOfActivatedRows();
+};
+
+} //namespace WCDB
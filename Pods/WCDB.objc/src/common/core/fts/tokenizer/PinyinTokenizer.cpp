@@ -69,7 +69,9 @@ void PinyinTokenizer::loadInput(const char *pText, int nText, int flags)
     m_normalToken.clear();
     m_normalTokenLength = 0;
     m_pinyinTokenArr.clear();
+    m_pinyinCandidates.clear();
     m_pinyinTokenIndex = 0;
+    m_compiledPinyinDict = BaseTokenizerUtil::getCompiledPinyinDict();
 }
 
 int PinyinTokenizer::nextToken(
@@ -104,7 +106,7 @@ const char **ppToken, int *nToken, int *iStart, int *iEnd, int *tflags, int *iPo
         if (m_pinyinTokenIndex > 0) {
             *tflags = FTS5_TOKEN_COLOCATED;
         }
-        const StringView &pinyinToken = m_pinyinTokenArr[m_pinyinTokenIndex];
+        const UnsafeStringView &pinyinToken = m_pinyinTokenArr[m_pinyinTokenIndex];
         *ppToken = pinyinToken.data();
         *nToken = (int) pinyinToken.length();
         *iStart = m_startOffset;
@@ -180,35 +182,37 @@ void PinyinTokenizer::genPinyinToken()
 {
     m_pinyinTokenArr.clear();
     m_pinyinTokenIndex = 0;
-    StringViewSet pinyinSet;
     UnsafeStringView token = UnsafeStringView(m_input + m_startOffset, m_normalTokenLength);
-    const std::vector<StringView> pinyinPtr = BaseTokenizerUtil::getPinYin(token);
-    if (pinyinPtr.size() == 0) {
+    BaseTokenizerUtil::getPinYin(m_compiledPinyinDict.get(), token, m_pinyinCandidates);
+    if (m_pinyinCandidates.size() == 0) {
         if (m_preTokenType == UnicodeType::BasicMultilingualPlaneSymbol
             && token.length() > 0) {
             m_pinyinTokenArr.emplace_back(token);
         }
         return;
     }
-    for (const StringView &pinyin : pinyinPtr) {
+    // A character has only a few pinyins, so linear search is cheaper than a set.
+    auto generated = [this](const UnsafeStringView &pinyin) {
+        return std::find(m_pinyinTokenArr.begin(), m_pinyinTokenArr.end(), pinyin)
+               != m_pinyinTokenArr.end();
+    };
+    for (const StringView &pinyin : m_pinyinCandidates) {
         if (pinyin.length() == 0) {
             continue;
         }
-        if (pinyinSet.find(pinyin) != pinyinSet.end()) {
+        if (generated(pinyin)) {
             continue;
         }
         //full pinyin
         m_pinyinTokenArr.emplace_back(pinyin);
-        pinyinSet.emplace(pinyin);
         if (pinyin.length() <= 1) {
             continue;
         }
         UnsafeStringView shortPinyin = UnsafeStringView(pinyin.data(), 1);
-        if (pinyinSet.find(shortPinyin) != pinyinSet.end()) {
+        if (generated(shortPinyin)) {
             continue;
         }
         //short pinyin
-        pinyinSet.emplace(shortPinyin);
         m_pinyinTokenArr.emplace_back(shortPinyin);
     }
 }
@@ -54,8 +54,11 @@ private:
 
     std::vector<char> m_normalToken;
     int m_normalTokenLength;
-    std::vector<StringView> m_pinyinTokenArr;
-    int m_pinyinTokenIndex;
+    std::vector<UnsafeStringView> m_pinyinTokenArr;
+    std::vector<StringView> m_pinyinCandidates;
+    size_t m_pinyinTokenIndex;
+    // Pinyins of the compiled dict are referenced in place, so it's held until the next input.
+    std::shared_ptr<CompiledTokenizerDict> m_compiledPinyinDict;
 
     // Can be configed by tokenizer parameters
     bool m_needSymbol;
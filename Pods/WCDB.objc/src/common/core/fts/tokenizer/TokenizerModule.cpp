@@ -24,6 +24,7 @@
 
 #include "TokenizerModule.hpp"
 #include "Assertion.hpp"
+#include "FTSTokenCache.hpp"
 #include "SQLite.h"
 #include "SQLiteFTS3Tokenizer.h"
 #include <cstring>
@@ -195,6 +196,43 @@ void *FTS5TokenizerModule::getContext()
     return m_pCtx;
 }
 
+int FTS5TokenizerModule::createTokenizer(const char *const *azArg,
+                                         int nArg,
+                                         AbstractFTSTokenizer **ppTokenizer)
+{
+    WCTAssert(m_create != nullptr);
+    return m_create(m_pCtx, azArg, nArg, ppTokenizer);
+}
+
+int FTS5TokenizerModule::destroyTokenizer(AbstractFTSTokenizer *pTokenizer)
+{
+    WCTAssert(m_destroy != nullptr);
+    return m_destroy(pTokenizer);
+}
+
+int FTS5TokenizerModule::tokenize(AbstractFTSTokenizer *pTokenizer,
+                                  void *pCtx,
+                                  int flags,
+                                  const char *pText,
+                                  int nText,
+                                  TokenCallback callback)
+{
+    WCTAssert(m_tokenize != nullptr);
+    return m_tokenize(pTokenizer, pCtx, flags, pText, nText, callback);
+}
+
+#pragma mark - AbstractFTS5TokenizerModuleTemplate
+bool AbstractFTS5TokenizerModuleTemplate::replayCachedTokens(const AbstractFTSTokenizer *tokenizer,
+                                                             int flags,
+                                                             const char *pText,
+                                                             int nText,
+                                                             void *pCtx,
+                                                             TokenCallback callback,
+                                                             int &rc)
+{
+    return FTSTokenCache::replay(tokenizer, flags, pText, nText, pCtx, callback, rc);
+}
+
 #pragma mark - TokenizerModule
 
 TokenizerModule::TokenizerModule(std::shared_ptr<FTS3TokenizerModule> fts3Module)
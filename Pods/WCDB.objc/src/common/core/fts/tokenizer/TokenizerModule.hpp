@@ -113,6 +113,18 @@ public:
     AbstractFTS5TokenizerModuleTemplate &
     operator=(const AbstractFTS5TokenizerModuleTemplate &)
     = delete;
+
+protected:
+    typedef int (*TokenCallback)(
+    void *pCtx, int tflags, const char *pToken, int nToken, int iStart, int iEnd);
+    // Return false if the tokens of the text are not cached for this tokenizer in current thread.
+    static bool replayCachedTokens(const AbstractFTSTokenizer *tokenizer,
+                                   int flags,
+                                   const char *pText,
+                                   int nText,
+                                   void *pCtx,
+                                   TokenCallback callback,
+                                   int &rc);
 };
 
 class WCDB_API FTS5TokenizerModule final {
@@ -135,6 +147,15 @@ public:
                         void *pCtx);
     void *getContext();
 
+    int createTokenizer(const char *const *azArg, int nArg, AbstractFTSTokenizer **ppTokenizer);
+    int destroyTokenizer(AbstractFTSTokenizer *pTokenizer);
+    int tokenize(AbstractFTSTokenizer *pTokenizer,
+                 void *pCtx,
+                 int flags,
+                 const char *pText,
+                 int nText,
+                 TokenCallback callback);
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-private-field"
 private:
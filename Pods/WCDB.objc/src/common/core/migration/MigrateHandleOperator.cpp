@@ -155,7 +155,7 @@ bool MigrateHandleOperator::dropSourceTable(const MigrationInfo* info)
     return true;
 }
 
-Optional<bool> MigrateHandleOperator::migrateRows(const MigrationInfo* info)
+Optional<bool> MigrateHandleOperator::migrateRows(const MigrationInfo* info, int& migratedRows)
 {
     WCTAssert(info != nullptr);
     if (m_migratingInfo != info) {
@@ -177,8 +177,8 @@ Optional<bool> MigrateHandleOperator::migrateRows(const MigrationInfo* info)
     }
 
     Optional<bool> migrated;
-    if (getHandle()->runTransaction([&migrated, this](InnerHandle* handle) -> bool {
-            int migratedCount = 0;
+    int migratedCount = 0;
+    if (getHandle()->runTransaction([&migrated, &migratedCount, this](InnerHandle* handle) -> bool {
             do {
                 migrated = migrateRow();
                 migratedCount++;
@@ -193,11 +193,34 @@ Optional<bool> MigrateHandleOperator::migrateRows(const MigrationInfo* info)
             return migrated.succeed();
         })) {
         WCTAssert(migrated.succeed());
+        // The last step moves nothing if it finds the source table empty.
+        migratedRows = migrated.value() ? migratedCount - 1 : migratedCount;
         return migrated;
     }
     return NullOpt;
 }
 
+Optional<int64_t> MigrateHandleOperator::countRowsToMigrate(const MigrationInfo* info)
+{
+    WCTAssert(info != nullptr);
+    if (m_migratingInfo != info) {
+        if (!reAttach(info)) {
+            return NullOpt;
+        }
+        m_migratingInfo = info;
+    }
+    InnerHandle* handle = getHandle();
+    if (!handle->prepare(m_migratingInfo->getStatementForCountingRowsToMigrate())) {
+        return NullOpt;
+    }
+    Optional<int64_t> count;
+    if (handle->step()) {
+        count = handle->getInteger();
+    }
+    handle->finalize();
+    return count;
+}
+
 Optional<bool> MigrateHandleOperator::migrateRow()
 {
     WCTAssert(m_migrateStatement->isPrepared() && m_removeMigratedStatement->isPrepared());
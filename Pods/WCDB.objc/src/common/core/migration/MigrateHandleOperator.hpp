@@ -55,7 +55,8 @@ private:
 protected:
     Optional<StringViewSet> getAllTables() override final;
     bool dropSourceTable(const MigrationInfo* info) override final;
-    Optional<bool> migrateRows(const MigrationInfo* info) override final;
+    Optional<bool> migrateRows(const MigrationInfo* info, int& migratedRows) override final;
+    Optional<int64_t> countRowsToMigrate(const MigrationInfo* info) override final;
     Optional<bool> migrateRow();
 
     bool reAttachMigrationInfo(const MigrationInfo* info);
@@ -116,7 +116,7 @@ bool MigratingHandleDecorator::addColumn(const Schema& schema,
     }
 
     if (!schema.syntax().isMain()
-        || column.syntax().column.value().name.hasPrefix(CompressionColumnTypePrefix)) {
+        || WCDBIsCompressionColumn(column.syntax().column.value().name)) {
         return true;
     }
 
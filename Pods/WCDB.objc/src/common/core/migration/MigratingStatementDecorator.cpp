@@ -25,9 +25,11 @@
 #include "MigratingStatementDecorator.hpp"
 #include "Assertion.hpp"
 #include "CommonCore.hpp"
+#include "CoreConst.h"
 #include "SQLite.h"
 #include "StringView.hpp"
 #include "WINQ.h"
+#include <algorithm>
 
 namespace WCDB {
 
@@ -40,6 +42,7 @@ MigratingStatementDecorator::MigratingStatementDecorator(Migration::Binder* bind
 , m_migratingInfo(nullptr)
 , m_primaryKeyIndex(0)
 , m_rowidBindIndex(0)
+, m_rowidUpdatingInfo(nullptr)
 {
 }
 
@@ -53,6 +56,7 @@ MigratingStatementDecorator::MigratingStatementDecorator(MigratingStatementDecor
 , m_assignedPrimaryKey(std::move(other.m_assignedPrimaryKey))
 , m_primaryKeyIndex(other.m_primaryKeyIndex)
 , m_rowidBindIndex(other.m_rowidBindIndex)
+, m_rowidUpdatingInfo(other.m_rowidUpdatingInfo)
 {
     other.m_migrationBinder = nullptr;
     other.m_processing = false;
@@ -62,6 +66,7 @@ MigratingStatementDecorator::MigratingStatementDecorator(MigratingStatementDecor
     other.m_assignedPrimaryKey = NullOpt;
     other.m_primaryKeyIndex = 0;
     other.m_rowidBindIndex = 0;
+    other.m_rowidUpdatingInfo = nullptr;
 }
 
 MigratingStatementDecorator::~MigratingStatementDecorator() = default;
@@ -84,20 +89,95 @@ void MigratingStatementDecorator::decorate(Decorative* handleStatement)
 }
 
 #pragma mark - Migration
-Optional<std::list<Statement>>
+RewrittenStatementCache<MigratingStatementDecorator::Rewritten>&
+MigratingStatementDecorator::rewrittenStatementCache()
+{
+    static RewrittenStatementCache<Rewritten>* s_cache
+    = new RewrittenStatementCache<Rewritten>(DecoratorRewrittenStatementCacheCapacity);
+    return *s_cache;
+}
+
+std::shared_ptr<const MigratingStatementDecorator::Rewritten>
+MigratingStatementDecorator::rewrite(const Statement& statement)
+{
+    const StringView& fingerprint = statement.getDescription();
+    uint64_t generation = m_migrationBinder->getGeneration();
+    std::shared_ptr<const Rewritten> rewritten
+    = rewrittenStatementCache().find(fingerprint, generation);
+    if (rewritten != nullptr) {
+        auto replayed = tryReplayBinding(*rewritten);
+        if (replayed.failed()) {
+            return nullptr;
+        }
+        if (replayed.value()) {
+            return rewritten;
+        }
+    }
+    std::shared_ptr<Rewritten> processed = process(statement);
+    // Creating table hints the migration, which should not be skipped.
+    if (processed != nullptr && processed->statementType != StatementType::CreateTableSTMT) {
+        rewrittenStatementCache().insert(fingerprint, generation, processed);
+    }
+    return processed;
+}
+
+Optional<bool> MigratingStatementDecorator::tryReplayBinding(const Rewritten& rewritten)
+{
+    m_processing = true;
+    m_migrationBinder->startBinding();
+    bool succeed = true;
+    bool same = true;
+    for (const auto& boundTable : rewritten.boundTables) {
+        auto optionalInfo = m_migrationBinder->bindTable(boundTable.first);
+        if (!optionalInfo.succeed()) {
+            succeed = false;
+            break;
+        }
+        if (optionalInfo.value() != boundTable.second) {
+            same = false;
+            break;
+        }
+    }
+    bool bound = m_migrationBinder->stopBinding(succeed && same);
+    m_processing = false;
+    if (!same) {
+        return false;
+    }
+    if (!bound) {
+        return NullOpt;
+    }
+    return true;
+}
+
+void MigratingStatementDecorator::apply(const Rewritten& rewritten)
+{
+    m_currentStatementType = rewritten.statementType;
+    m_rowidBindIndex = rewritten.rowidBindIndex;
+    clearMigrateStatus();
+    if (rewritten.migratingInfo != nullptr) {
+        m_migratingInfo = rewritten.migratingInfo;
+        m_primaryKeyIndex = rewritten.primaryKeyIndex;
+        m_assignedPrimaryKey = rewritten.assignedPrimaryKey;
+        sqlite3_revertCommitOrder(getHandleStatement()->getRawHandle());
+    }
+    m_rowidUpdatingInfo = rewritten.rowidUpdatingInfo;
+}
+
+std::shared_ptr<MigratingStatementDecorator::Rewritten>
 MigratingStatementDecorator::process(const Statement& originStatement)
 {
     m_processing = true;
     bool succeed = true;
-    std::list<Statement> statements;
+    std::shared_ptr<Rewritten> rewritten = std::make_shared<Rewritten>();
+    std::list<Statement>& statements = rewritten->statements;
+    int& rowidBindIndex = rewritten->rowidBindIndex;
     do {
         m_migrationBinder->startBinding();
 
         // It's dangerous to use origin statement after tampering since all the tokens are not fit.
         Statement falledBackStatement = originStatement;
         // fallback
-        falledBackStatement.iterate([&succeed, this, &originStatement](
-                                    Syntax::Identifier& identifier, bool isBegin, bool& stop) {
+        falledBackStatement.iterate([&](Syntax::Identifier& identifier, bool isBegin, bool& stop) {
             if (!isBegin) {
                 return;
             }
@@ -106,41 +186,46 @@ MigratingStatementDecorator::process(const Statement& originStatement)
                 // main.table -> temp.unionedView
                 Syntax::TableOrSubquery& syntax = (Syntax::TableOrSubquery&) identifier;
                 if (syntax.switcher == Syntax::TableOrSubquery::Switch::Table) {
-                    succeed = tryFallbackToUnionedView(syntax.schema, syntax.tableOrFunction);
+                    succeed = tryFallbackToUnionedView(
+                    *rewritten, syntax.schema, syntax.tableOrFunction);
                 }
             } break;
             case Syntax::Identifier::Type::QualifiedTableName: {
                 // main.table -> schemaForSourceDatabase.sourceTable
                 Syntax::QualifiedTableName& syntax = (Syntax::QualifiedTableName&) identifier;
-                succeed = tryFallbackToSourceTable(syntax.schema, syntax.table);
+                succeed
+                = tryFallbackToSourceTable(*rewritten, syntax.schema, syntax.table);
             } break;
             case Syntax::Identifier::Type::InsertSTMT: {
                 // main.table -> schemaForSourceDatabase.sourceTable
                 Syntax::InsertSTMT& syntax = (Syntax::InsertSTMT&) identifier;
-                succeed = tryFallbackToSourceTable(syntax.schema, syntax.table);
+                succeed
+                = tryFallbackToSourceTable(*rewritten, syntax.schema, syntax.table);
             } break;
             case Syntax::Identifier::Type::DropTableSTMT: {
                 // main.table -> schemaForSourceDatabase.sourceTable
                 Syntax::DropTableSTMT& syntax = (Syntax::DropTableSTMT&) identifier;
-                succeed = tryFallbackToSourceTable(syntax.schema, syntax.table);
+                succeed
+                = tryFallbackToSourceTable(*rewritten, syntax.schema, syntax.table);
             } break;
             case Syntax::Identifier::Type::AlterTableSTMT: {
                 // main.table -> schemaForSourceDatabase.sourceTable
                 Syntax::AlterTableSTMT& syntax = (Syntax::AlterTableSTMT&) identifier;
-                succeed = tryFallbackToSourceTable(syntax.schema, syntax.table);
+                succeed
+                = tryFallbackToSourceTable(*rewritten, syntax.schema, syntax.table);
             } break;
             case Syntax::Identifier::Type::Expression: {
                 // main.table -> temp.unionedView
                 Syntax::Expression& syntax = (Syntax::Expression&) identifier;
                 switch (syntax.switcher) {
                 case Syntax::Expression::Switch::Column:
-                    succeed = tryFallbackToUnionedView(syntax.column().schema,
-                                                       syntax.column().table);
+                    succeed = tryFallbackToUnionedView(
+                    *rewritten, syntax.column().schema, syntax.column().table);
                     break;
                 case Syntax::Expression::Switch::In:
                     if (syntax.inSwitcher == Syntax::Expression::SwitchIn::Table) {
-                        succeed
-                        = tryFallbackToUnionedView(syntax.schema(), syntax.table());
+                        succeed = tryFallbackToUnionedView(
+                        *rewritten, syntax.schema(), syntax.table());
                     }
                     break;
                 default:
@@ -168,7 +253,7 @@ MigratingStatementDecorator::process(const Statement& originStatement)
                     "The indexes of bind parameters must be assigned in the migrating database");
                     succeed = false;
                 } else {
-                    m_rowidBindIndex = std::max(m_rowidBindIndex, bindParameter.n);
+                    rowidBindIndex = std::max(rowidBindIndex, bindParameter.n);
                 }
             } break;
             default:
@@ -182,7 +267,7 @@ MigratingStatementDecorator::process(const Statement& originStatement)
         if (!succeed) {
             break;
         }
-        m_rowidBindIndex++;
+        rowidBindIndex++;
 
         switch (originStatement.getType()) {
         case Syntax::Identifier::Type::InsertSTMT: {
@@ -201,14 +286,15 @@ MigratingStatementDecorator::process(const Statement& originStatement)
                                   "Insert statement that contains multiple values is not supported while using migration feature.",
                                   succeed = false;
                                   break;);
-                clearMigrateStatus();
                 const MigrationInfo* info
                 = m_migrationBinder->getBoundInfo(migratedInsertSTMT.table);
                 WCTAssert(info != nullptr);
-                m_migratingInfo = info;
-                info->generateStatementsForInsertMigrating(
-                falledBackStatement, statements, m_primaryKeyIndex, m_rowidBindIndex, m_assignedPrimaryKey);
-                sqlite3_revertCommitOrder(getHandleStatement()->getRawHandle());
+                rewritten->migratingInfo = info;
+                info->generateStatementsForInsertMigrating(falledBackStatement,
+                                                           statements,
+                                                           rewritten->primaryKeyIndex,
+                                                           rowidBindIndex,
+                                                           rewritten->assignedPrimaryKey);
             }
         } break;
         case Syntax::Identifier::Type::UpdateSTMT: {
@@ -225,7 +311,10 @@ MigratingStatementDecorator::process(const Statement& originStatement)
                 = m_migrationBinder->getBoundInfo(migratedTableName);
                 WCTAssert(info != nullptr);
                 info->generateStatementsForUpdateMigrating(
-                falledBackStatement, statements, m_rowidBindIndex);
+                falledBackStatement, statements, rowidBindIndex);
+                if (info->isUpdatingRowid(falledBackStatement)) {
+                    rewritten->rowidUpdatingInfo = info;
+                }
             }
         } break;
         case Syntax::Identifier::Type::DeleteSTMT: {
@@ -242,7 +331,7 @@ MigratingStatementDecorator::process(const Statement& originStatement)
                 = m_migrationBinder->getBoundInfo(migratedTableName);
                 WCTAssert(info != nullptr);
                 info->generateStatementsForDeleteMigrating(
-                falledBackStatement, statements, m_rowidBindIndex);
+                falledBackStatement, statements, rowidBindIndex);
             }
         } break;
         case Syntax::Identifier::Type::DropTableSTMT: {
@@ -281,19 +370,35 @@ MigratingStatementDecorator::process(const Statement& originStatement)
         }
     } while (false);
     m_processing = false;
-    if (succeed) {
-        m_currentStatementType = originStatement.getType();
-        return std::move(statements);
-    } else {
-        return NullOpt;
+    if (!succeed) {
+        return nullptr;
     }
+    rewritten->statementType = originStatement.getType();
+    return rewritten;
 }
 
-bool MigratingStatementDecorator::tryFallbackToUnionedView(Syntax::Schema& schema,
+Optional<const MigrationInfo*>
+MigratingStatementDecorator::bindTable(Rewritten& rewritten, const StringView& table)
+{
+    auto optionalInfo = m_migrationBinder->bindTable(table);
+    if (optionalInfo.succeed() && !table.empty()
+        && std::find_if(rewritten.boundTables.begin(),
+                        rewritten.boundTables.end(),
+                        [&table](const std::pair<StringView, const MigrationInfo*>& boundTable) {
+                            return boundTable.first.equal(table);
+                        })
+           == rewritten.boundTables.end()) {
+        rewritten.boundTables.emplace_back(table, optionalInfo.value());
+    }
+    return optionalInfo;
+}
+
+bool MigratingStatementDecorator::tryFallbackToUnionedView(Rewritten& rewritten,
+                                                           Syntax::Schema& schema,
                                                            StringView& table)
 {
     if (schema.isMain()) {
-        auto optionalInfo = m_migrationBinder->bindTable(table);
+        auto optionalInfo = bindTable(rewritten, table);
         if (!optionalInfo.succeed()) {
             return false;
         }
@@ -306,11 +411,12 @@ bool MigratingStatementDecorator::tryFallbackToUnionedView(Syntax::Schema& schem
     return true;
 }
 
-bool MigratingStatementDecorator::tryFallbackToSourceTable(Syntax::Schema& schema,
+bool MigratingStatementDecorator::tryFallbackToSourceTable(Rewritten& rewritten,
+                                                           Syntax::Schema& schema,
                                                            StringView& table)
 {
     if (schema.isMain()) {
-        auto optionalInfo = m_migrationBinder->bindTable(table);
+        auto optionalInfo = bindTable(rewritten, table);
         if (!optionalInfo.succeed()) {
             return false;
         }
@@ -330,19 +436,20 @@ bool MigratingStatementDecorator::prepare(const Statement& statement)
                       "Last statement is not finalized.",
                       finalize(););
     WCTAssert(!m_processing);
-    auto optionalStatements = process(statement);
-    if (!optionalStatements.succeed()) {
+    std::shared_ptr<const Rewritten> rewritten = rewrite(statement);
+    if (rewritten == nullptr) {
         return false;
     }
-    auto& statements = optionalStatements.value();
+    apply(*rewritten);
+    const auto& statements = rewritten->statements;
     WCTAssert(!statements.empty());
     WCTAssert(m_additionalStatements.empty());
     // The last statement must be targeted at the main scheme
     if (!Super::prepare(statements.back())) {
         return false;
     }
-    statements.pop_back();
-    for (const auto& stmt : statements) {
+    for (auto iter = statements.begin(); iter != std::prev(statements.end()); ++iter) {
+        const Statement& stmt = *iter;
         m_additionalStatements.emplace_back(getHandle());
         m_additionalStatements.back().enableAutoAddColumn();
         if (!m_additionalStatements.back().prepare(stmt)) {
@@ -362,6 +469,7 @@ void MigratingStatementDecorator::finalize()
     m_additionalStatements.clear();
     m_currentStatementType = StatementType::Invalid;
     m_rowidBindIndex = 0;
+    m_rowidUpdatingInfo = nullptr;
     clearMigrateStatus();
 }
 
@@ -551,31 +659,37 @@ bool MigratingStatementDecorator::stepInsert()
 
     int64_t maxId = 1;
 
-    if (!m_migratingInfo->getIntegerPrimaryKey().empty()) {
-        if (m_assignedPrimaryKey.hasValue()) {
-            maxId = m_assignedPrimaryKey.value();
-        } else {
-            WCTAssert(iter != m_additionalStatements.end());
-            if (!iter->step()) {
-                return false;
-            }
-            if (!iter->done()) {
-                maxId = std::max(maxId, iter->getInteger());
-            }
-        }
+    if (!m_migratingInfo->getIntegerPrimaryKey().empty() && m_assignedPrimaryKey.hasValue()) {
+        maxId = m_assignedPrimaryKey.value();
+        m_migratingInfo->didAssignRowid(maxId);
     } else {
+        // The max id is only selected when the allocator is not seeded.
         WCTAssert(iter != m_additionalStatements.end());
-        maxId = std::max(maxId, rowid);
-        if (!iter->step()) {
+        HandleStatement& selectMaxIdStatement = *iter;
+        auto allocated = m_migratingInfo->allocateRowid(
+        m_migratingInfo->getIntegerPrimaryKey().empty() ? std::max(maxId, rowid) : maxId,
+        [&selectMaxIdStatement]() -> Optional<int64_t> {
+            selectMaxIdStatement.reset();
+            if (!selectMaxIdStatement.step()) {
+                return NullOpt;
+            }
+            int64_t selected = 0;
+            if (!selectMaxIdStatement.done()) {
+                selected = selectMaxIdStatement.getInteger();
+            }
+            selectMaxIdStatement.reset();
+            return selected;
+        });
+        if (!allocated.succeed()) {
             return false;
         }
-        if (!iter->done()) {
-            maxId = std::max(maxId, iter->getInteger());
-        }
+        maxId = allocated.value();
     }
     Super::bindInteger(maxId, m_rowidBindIndex);
     if (!Super::step()) {
         if (getHandle()->getError().code() == Error::Code::Constraint) {
+            // The rows might be changed without the allocator, e.g. by other process.
+            m_migratingInfo->markAsRowidChanged();
             Error error = Error(
             Error::Code::Warning,
             Error::Level::Warning,
@@ -621,6 +735,10 @@ bool MigratingStatementDecorator::stepUpdateOrDelete()
             return false;
         }
     }
+    if (m_rowidUpdatingInfo != nullptr) {
+        // The write lock is still held here, so the allocator will be seeded with the updated rowids.
+        m_rowidUpdatingInfo->markAsRowidChanged();
+    }
     return true;
 }
 
@@ -24,7 +24,9 @@
 
 #include "DecorativeHandleStatement.hpp"
 #include "Migration.hpp"
+#include "RewrittenStatementCache.hpp"
 #include <list>
+#include <memory>
 
 namespace WCDB {
 
@@ -65,13 +67,37 @@ public:
 
 #pragma mark - Migration
 protected:
+    using StatementType = Syntax::Identifier::Type;
+
+    // Rewriting only depends on the statement and the infos of the tables it binds,
+    // so it's shared among all handles and reused as long as the same infos are bound.
+    struct Rewritten {
+        std::list<std::pair<StringView, const MigrationInfo *>> boundTables;
+        // The last one is targeted at the main scheme and the others are additional.
+        std::list<Statement> statements;
+        StatementType statementType = StatementType::Invalid;
+        int rowidBindIndex = 0;
+        // For the insert statement on a migrating table only.
+        const MigrationInfo *migratingInfo = nullptr;
+        int primaryKeyIndex = 0;
+        Optional<int64_t> assignedPrimaryKey;
+        // For the update statement that changes the rowids of a migrating table only.
+        const MigrationInfo *rowidUpdatingInfo = nullptr;
+    };
+
+    static RewrittenStatementCache<Rewritten> &rewrittenStatementCache();
+
     bool realStep();
-    Optional<std::list<Statement>> process(const Statement &statement);
-    bool tryFallbackToUnionedView(Syntax::Schema &schema, StringView &table);
-    bool tryFallbackToSourceTable(Syntax::Schema &schema, StringView &table);
+    std::shared_ptr<const Rewritten> rewrite(const Statement &statement);
+    std::shared_ptr<Rewritten> process(const Statement &statement);
+    // NullOpt for binding failed and false for the infos are changed.
+    Optional<bool> tryReplayBinding(const Rewritten &rewritten);
+    void apply(const Rewritten &rewritten);
+    Optional<const MigrationInfo *> bindTable(Rewritten &rewritten, const StringView &table);
+    bool tryFallbackToUnionedView(Rewritten &rewritten, Syntax::Schema &schema, StringView &table);
+    bool tryFallbackToSourceTable(Rewritten &rewritten, Syntax::Schema &schema, StringView &table);
     bool m_processing;
 
-    using StatementType = Syntax::Identifier::Type;
     StatementType m_currentStatementType;
     std::list<HandleStatement> m_additionalStatements;
 
@@ -89,6 +115,9 @@ private:
 #pragma mark - Update/Delete
 protected:
     bool stepUpdateOrDelete();
+
+private:
+    const MigrationInfo *m_rowidUpdatingInfo;
 };
 
 } // namespace WCDB
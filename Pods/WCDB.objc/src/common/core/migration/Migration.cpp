@@ -25,20 +25,43 @@
 #include "Migration.hpp"
 #include "Assertion.hpp"
 #include "CompressionConst.hpp"
+#include "CoreConst.h"
 #include "HandleStatement.hpp"
 #include "InnerHandle.hpp"
 #include "Notifier.hpp"
 #include "StringView.hpp"
 #include "WCDBError.hpp"
+#include <algorithm>
 
 namespace WCDB {
 
 MigrationEvent::~MigrationEvent() = default;
 
+#pragma mark - MigrationProgress
+MigrationProgress::MigrationProgress()
+: migratedRows(0), remainingRows(0), elapsedTime(0), estimatedTime(-1)
+{
+}
+
+double MigrationProgress::getPercentage() const
+{
+    int64_t total = migratedRows + remainingRows;
+    if (total <= 0) {
+        return 1.0;
+    }
+    return (double) migratedRows / total;
+}
+
 #pragma mark - Initialize
 Migration::Migration(MigrationEvent* event)
-: m_tableAcquired(false), m_migrated(true), m_event(event)
+: m_generation(0)
+, m_tableAcquired(false)
+, m_migrated(true)
+, m_lastMigrating(nullptr)
+, m_interval(MigrationMinStepInterval)
+, m_event(event)
 {
+    updateGeneration();
 }
 
 void Migration::addMigration(const UnsafeStringView& sourcePath,
@@ -67,6 +90,11 @@ void Migration::purge()
     m_hints.clear();
     m_tableAcquired = false;
     m_migrated = false;
+    m_lastMigrating = nullptr;
+    updateGeneration();
+
+    std::lock_guard<std::mutex> trackingLockGuard(m_trackingLock);
+    m_trackings.clear();
 }
 
 bool Migration::shouldMigrate() const
@@ -137,13 +165,13 @@ bool Migration::initInfo(InfoInitializer& initializer, const UnsafeStringView& t
                 m_hints.emplace(targetTable);
                 m_tableAcquired = false;
             } else {
-                m_holder.push_back(MigrationInfo(
-                userInfo, columns, autoincrement, integerPrimaryKey));
+                m_holder.emplace_back(userInfo, columns, autoincrement, integerPrimaryKey);
                 const MigrationInfo* hold = &m_holder.back();
                 m_migratings.emplace(hold);
                 m_referenceds.emplace(hold, 0);
                 m_filted.insert_or_assign(targetTable, hold);
                 m_hints.erase(targetTable);
+                updateGeneration();
             }
         }
         return true;
@@ -158,6 +186,7 @@ void Migration::markAsNoNeedToMigrate(const UnsafeStringView& table)
     LockGuard lockGuard(m_lock);
     if (m_filted.find(table) == m_filted.end()) {
         m_filted.insert_or_assign(table, nullptr);
+        updateGeneration();
     }
     m_hints.erase(table);
 }
@@ -202,6 +231,7 @@ void Migration::markAsMigrated(const MigrationInfo* info)
     WCTAssert(m_hints.find(info->getTable()) == m_hints.end());
     WCTAssert(m_migratings.find(info) != m_migratings.end());
     m_migratings.erase(info);
+    updateGeneration();
     auto iter = m_referenceds.find(info);
     WCTAssert(iter != m_referenceds.end());
     if (iter->second == 0) {
@@ -253,6 +283,19 @@ Optional<RecyclableMigrationInfo> Migration::getInfo(const UnsafeStringView& tab
     return NullOpt;
 }
 
+#pragma mark - Generation
+uint64_t Migration::getGeneration() const
+{
+    return m_generation.load(std::memory_order_acquire);
+}
+
+void Migration::updateGeneration()
+{
+    // Shared by all migrations so that the generations of different databases never collide.
+    static std::atomic<uint64_t>* s_generation = new std::atomic<uint64_t>(0);
+    m_generation.store(++(*s_generation), std::memory_order_release);
+}
+
 #pragma mark - Update sequence
 bool Migration::tryUpdateSequence(InfoInitializer& initializer, const MigrationInfo& info)
 {
@@ -331,7 +374,7 @@ bool Migration::InfoInitializer::getTargetTableInfo(const MigrationUserInfo& use
     }
     auto& metas = optionalMetas.value();
     for (const auto& meta : metas) {
-        if (meta.name.hasPrefix(CompressionColumnTypePrefix)) {
+        if (WCDBIsCompressionColumn(meta.name)) {
             continue;
         }
         columns.emplace(meta.name);
@@ -511,6 +554,11 @@ const MigrationInfo* Migration::Binder::getBoundInfo(const UnsafeStringView& tab
     return info;
 }
 
+uint64_t Migration::Binder::getGeneration() const
+{
+    return m_migration.getGeneration();
+}
+
 void Migration::Binder::setTableInfoCommitted(bool committed)
 {
     m_migration.setTableInfoCommitted(committed);
@@ -640,23 +688,71 @@ Optional<bool> Migration::tryDropUnreferencedTable(Migration::Stepper& stepper)
 
 Optional<bool> Migration::tryMigrateRows(Migration::Stepper& stepper)
 {
-    const MigrationInfo* info = nullptr;
-    {
-        SharedLockGuard lockGuard(m_lock);
-        if (m_migratings.empty()) {
-            return false;
+    InnerHandle* handle = stepper.getCurrentHandle();
+    WCTAssert(handle != nullptr);
+    SteadyClock start = SteadyClock::now();
+    bool worked = false;
+    bool busy = false;
+    do {
+        const MigrationInfo* info = getNextMigratingInfo();
+        if (info == nullptr) {
+            break;
         }
-        for (const auto& migrating : m_migratings) {
-            if (migrating->isCrossDatabase()) {
-                // cross database migration first to reduce additional database lock.
-                info = migrating;
-                break;
-            }
+        if (!migrateSlice(stepper, info).succeed()) {
+            adaptInterval(true);
+            return NullOpt;
         }
-        if (info == nullptr) {
-            info = *m_migratings.begin();
+        worked = true;
+        busy = handle->checkHasBusyRetry();
+    } while (!busy
+             && SteadyClock::timeIntervalSinceSteadyClockToNow(start) < MigrationStepTimeBudget);
+    if (worked) {
+        adaptInterval(busy);
+    }
+    return worked;
+}
+
+const MigrationInfo* Migration::getNextMigratingInfo()
+{
+    LockGuard lockGuard(m_lock);
+    if (m_migratings.empty()) {
+        return nullptr;
+    }
+    // m_lastMigrating is reset when purging, and the infos in holder are never erased before that.
+    const MigrationInfo* last = m_lastMigrating;
+    auto preference = [last](const MigrationInfo* info) -> int {
+        if (!info->isCrossDatabase()) {
+            return 0;
+        }
+        // cross database migration first to reduce additional database lock.
+        if (last != nullptr && last->isCrossDatabase()
+            && info->getSchemaForSourceDatabase().syntax().isTargetingSameSchema(
+            last->getSchemaForSourceDatabase().syntax())) {
+            return 2;
+        }
+        return 1;
+    };
+    // round robin, starting from the one next to the last slice.
+    auto next = m_migratings.upper_bound(last);
+    const MigrationInfo* info = nullptr;
+    int bestPreference = -1;
+    for (size_t i = 0; i < m_migratings.size(); ++i, ++next) {
+        if (next == m_migratings.end()) {
+            next = m_migratings.begin();
+        }
+        int currentPreference = preference(*next);
+        if (currentPreference > bestPreference) {
+            info = *next;
+            bestPreference = currentPreference;
         }
     }
+    WCTAssert(info != nullptr);
+    m_lastMigrating = info;
+    return info;
+}
+
+Optional<bool> Migration::migrateSlice(Migration::Stepper& stepper, const MigrationInfo* info)
+{
     WCTAssert(info != nullptr);
     InnerHandle* handle = stepper.getCurrentHandle();
     WCTAssert(handle != nullptr);
@@ -666,6 +762,7 @@ Optional<bool> Migration::tryMigrateRows(Migration::Stepper& stepper)
     }
 
     if (!exists.value()) {
+        untrackProgress(info);
         markAsMigrated(info);
         return true;
     }
@@ -674,14 +771,40 @@ Optional<bool> Migration::tryMigrateRows(Migration::Stepper& stepper)
         return NullOpt;
     }
 
-    auto migrated = stepper.migrateRows(info);
+    if (!isTracking(info)) {
+        auto numberOfRows = stepper.countRowsToMigrate(info);
+        if (!numberOfRows.succeed()) {
+            return NullOpt;
+        }
+        startTracking(info, numberOfRows.value());
+    }
+
+    int migratedRows = 0;
+    auto migrated = stepper.migrateRows(info, migratedRows);
     if (migrated.failed()) {
         return NullOpt;
     }
-    if (migrated.succeed() && migrated.value()) {
+    trackProgress(info, migratedRows, migrated.value());
+    if (migrated.value()) {
         markAsMigrated(info);
     }
-    return true;
+    return migrated;
+}
+
+void Migration::adaptInterval(bool busy)
+{
+    double interval = m_interval.load();
+    if (busy) {
+        interval = std::min(interval * 2, MigrationMaxStepInterval);
+    } else {
+        interval = std::max(interval / 2, MigrationMinStepInterval);
+    }
+    m_interval.store(interval);
+}
+
+double Migration::getIntervalForNextStep() const
+{
+    return m_interval.load();
 }
 
 Optional<bool> Migration::tryAcquireTables(Migration::Stepper& stepper)
@@ -710,6 +833,68 @@ Optional<bool> Migration::tryAcquireTables(Migration::Stepper& stepper)
     return true;
 }
 
+#pragma mark - Progress
+bool Migration::isTracking(const MigrationInfo* info)
+{
+    std::lock_guard<std::mutex> lockGuard(m_trackingLock);
+    return m_trackings.find(info) != m_trackings.end();
+}
+
+void Migration::startTracking(const MigrationInfo* info, int64_t numberOfRows)
+{
+    std::lock_guard<std::mutex> lockGuard(m_trackingLock);
+    Tracking& tracking = m_trackings[info];
+    tracking.progress = MigrationProgress();
+    tracking.progress.remainingRows = numberOfRows;
+    tracking.start = SteadyClock::now();
+}
+
+void Migration::trackProgress(const MigrationInfo* info, int migratedRows, bool done)
+{
+    MigrationProgress progress;
+    {
+        std::lock_guard<std::mutex> lockGuard(m_trackingLock);
+        auto iter = m_trackings.find(info);
+        if (iter == m_trackings.end()) {
+            // purged
+            return;
+        }
+        Tracking& tracking = iter->second;
+        progress = tracking.progress;
+        progress.migratedRows += migratedRows;
+        if (done) {
+            progress.remainingRows = 0;
+        } else {
+            // The count is stale if rows are written to source table by the other tools.
+            progress.remainingRows
+            = std::max<int64_t>(progress.remainingRows - migratedRows, 0);
+        }
+        progress.elapsedTime = SteadyClock::timeIntervalSinceSteadyClockToNow(tracking.start);
+        if (done) {
+            progress.estimatedTime = 0;
+        } else if (progress.migratedRows > 0 && progress.remainingRows > 0) {
+            progress.estimatedTime
+            = progress.elapsedTime / progress.migratedRows * progress.remainingRows;
+        } else {
+            progress.estimatedTime = -1;
+        }
+        if (done) {
+            m_trackings.erase(iter);
+        } else {
+            tracking.progress = progress;
+        }
+    }
+    if (m_event != nullptr) {
+        m_event->didStepMigration(info, progress);
+    }
+}
+
+void Migration::untrackProgress(const MigrationInfo* info)
+{
+    std::lock_guard<std::mutex> lockGuard(m_trackingLock);
+    m_trackings.erase(info);
+}
+
 #pragma mark - Event
 bool Migration::isMigrated() const
 {
@@ -28,9 +28,12 @@
 #include "MigrationInfo.hpp"
 #include "Recyclable.hpp"
 #include "ThreadLocal.hpp"
+#include "Time.hpp"
 #include "WCDBOptional.hpp"
+#include <atomic>
 #include <functional>
 #include <map>
+#include <mutex>
 #include <set>
 
 namespace WCDB {
@@ -38,6 +41,21 @@ namespace WCDB {
 typedef Recyclable<const MigrationInfo*> RecyclableMigrationInfo;
 class InnerHandle;
 
+// Progress of a migrating table, which is updated after each slice of its migration.
+struct MigrationProgress {
+    MigrationProgress();
+    // Rows migrated since the progress began to be tracked.
+    int64_t migratedRows;
+    // Rows left in the source table, which is counted once and then decreased as migrating.
+    int64_t remainingRows;
+    // Wall time since the first slice, including the intervals between steps.
+    double elapsedTime;
+    // Seconds to finish the table estimated from the rate so far. It's negative if unknown.
+    double estimatedTime;
+
+    double getPercentage() const;
+};
+
 class MigrationEvent {
 public:
     virtual ~MigrationEvent() = 0;
@@ -46,6 +64,9 @@ protected:
     friend class Migration;
     // parameter will be nullptr when all tables migrated.
     virtual void didMigrate(const MigrationBaseInfo* info) = 0;
+    virtual void didStepMigration(const MigrationBaseInfo* info,
+                                  const MigrationProgress& progress)
+    = 0;
 };
 
 // TODO: deny if user visiting source table by using authorize feature.
@@ -121,10 +142,21 @@ private:
     void retainInfo(const MigrationInfo* info);
     void releaseInfo(const MigrationInfo* info);
 
-    mutable SharedLock m_lock;
+    mutable StripedSharedLock m_lock;
 
     StringViewMap<std::shared_ptr<MigrationDatabaseInfo>> m_migrationInfo;
 
+#pragma mark - Generation
+public:
+    // It changes whenever the info of any table changes, and it's unique in process.
+    uint64_t getGeneration() const;
+
+protected:
+    void updateGeneration();
+
+private:
+    std::atomic<uint64_t> m_generation;
+
 #pragma mark - Update sequence
 public:
     bool tryUpdateSequence(InfoInitializer& initializer, const MigrationInfo& info);
@@ -150,6 +182,7 @@ public:
         Optional<const MigrationInfo*> bindTable(const UnsafeStringView& table);
         bool hintThatTableWillBeCreated(const UnsafeStringView& table);
         const MigrationInfo* getBoundInfo(const UnsafeStringView& table);
+        uint64_t getGeneration() const;
 
         virtual bool bindInfos(const StringViewMap<const MigrationInfo*>& infos) = 0;
 
@@ -181,11 +214,15 @@ public:
     protected:
         virtual Optional<StringViewSet> getAllTables() = 0;
         virtual bool dropSourceTable(const MigrationInfo* info) = 0;
-        virtual Optional<bool> migrateRows(const MigrationInfo* info) = 0;
+        // migratedRows is set to the number of rows moved, even if it's interrupted.
+        virtual Optional<bool> migrateRows(const MigrationInfo* info, int& migratedRows) = 0;
+        virtual Optional<int64_t> countRowsToMigrate(const MigrationInfo* info) = 0;
     };
 
     // done
     Optional<bool> step(Migration::Stepper& stepper);
+    // It's adapted to the foreground load observed in the last step.
+    double getIntervalForNextStep() const;
 
 protected:
     // worked
@@ -193,9 +230,32 @@ protected:
     Optional<bool> tryMigrateRows(Migration::Stepper& stepper);
     Optional<bool> tryAcquireTables(Migration::Stepper& stepper);
 
+    // Independent tables are migrated in turn, one batch in a single transaction per slice, so that the writer lock is released between slices and all tables make progress together.
+    // Cross database tables are still preferred, and the tables of the attached source database are preferred among them to avoid reattaching.
+    const MigrationInfo* getNextMigratingInfo();
+    Optional<bool> migrateSlice(Migration::Stepper& stepper, const MigrationInfo* info);
+    void adaptInterval(bool busy);
+
 private:
     bool m_tableAcquired;
     bool m_migrated;
+    const MigrationInfo* m_lastMigrating;
+    std::atomic<double> m_interval;
+
+#pragma mark - Progress
+protected:
+    struct Tracking {
+        MigrationProgress progress;
+        SteadyClock start;
+    };
+    bool isTracking(const MigrationInfo* info);
+    void startTracking(const MigrationInfo* info, int64_t numberOfRows);
+    void trackProgress(const MigrationInfo* info, int migratedRows, bool done);
+    void untrackProgress(const MigrationInfo* info);
+
+private:
+    std::mutex m_trackingLock;
+    std::map<const MigrationInfo*, Tracking> m_trackings;
 
 #pragma mark - Event
 public:
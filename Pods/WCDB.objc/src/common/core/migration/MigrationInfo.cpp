@@ -25,6 +25,7 @@
 #include "MigrationInfo.hpp"
 #include "Assertion.hpp"
 #include "StringView.hpp"
+#include <limits>
 
 namespace WCDB {
 
@@ -236,6 +237,8 @@ MigrationInfo::MigrationInfo(const MigrationUserInfo& userInfo,
 , m_autoincrement(autoincrement)
 , m_integerPrimaryKey(integerPrimaryKey)
 , m_needUpdateSequence(autoincrement)
+, m_rowidSeeded(false)
+, m_nextRowid(1)
 {
     WCTAssert(!uniqueColumns.empty());
 
@@ -300,20 +303,26 @@ MigrationInfo::MigrationInfo(const MigrationUserInfo& userInfo,
 
         m_statementForSelectingAnyRowFromSourceTable
         = StatementSelect().select(Column::all()).from(sourceTableQuery).limit(1);
+
+        m_statementForCountingRowsToMigrate = StatementSelect()
+                                              .select(Column::all().count())
+                                              .from(sourceTableQuery)
+                                              .where(m_filterCondition);
     }
 
     // Compatible
     {
-        if (m_integerPrimaryKey.empty()) {
-            m_statementForSelectingMaxID
-            = StatementSelect()
-              .select(rowid.max() + 1)
-              .from(TableOrSubquery(m_table).schema(Schema::main()));
-        } else if (!autoincrement) {
+        if (!autoincrement) {
+            Column id = m_integerPrimaryKey.empty() ? rowid : Column(m_integerPrimaryKey);
             m_statementForSelectingMaxID
             = StatementSelect()
-              .select(Column(m_integerPrimaryKey).max() + 1)
-              .from(TableOrSubquery(m_unionedView).schema(Schema::temp()));
+              .select(Column("maxID").max())
+              .from(StatementSelect()
+                    .select(ResultColumn(id.max()).as("maxID"))
+                    .from(TableOrSubquery(m_table).schema(Schema::main()))
+                    .unionAll()
+                    .select(id.max())
+                    .from(sourceTableQuery));
         }
 
         m_statementForDeletingSpecifiedRow
@@ -592,11 +601,85 @@ MigrationInfo::getStatementForDeletingFromTable(const Statement& sourceStatement
     return StatementDelete().deleteFrom(table).where(m_filterCondition);
 }
 
+bool MigrationInfo::isUpdatingRowid(const Statement& updateStatement) const
+{
+    WCTAssert(updateStatement.getType() == Syntax::Identifier::Type::UpdateSTMT);
+    const Syntax::UpdateSTMT& updateSyntax
+    = static_cast<const Syntax::UpdateSTMT&>(updateStatement.syntax());
+    for (const auto& columns : updateSyntax.columnsList) {
+        for (const auto& column : columns) {
+            if (column.name.caseInsensitiveEqual("rowid")
+                || column.name.caseInsensitiveEqual("oid")
+                || column.name.caseInsensitiveEqual("_rowid_")
+                || (!m_integerPrimaryKey.empty()
+                    && column.name.caseInsensitiveEqual(m_integerPrimaryKey))) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+#pragma mark - Rowid Allocator
+Optional<int64_t>
+MigrationInfo::allocateRowid(int64_t lowerBound, const MaxIDSelector& selector) const
+{
+    WCTAssert(!m_autoincrement);
+    if (!m_rowidSeeded.load()) {
+        std::lock_guard<std::mutex> lockGuard(m_rowidLock);
+        if (!m_rowidSeeded.load()) {
+            Optional<int64_t> maxID = selector();
+            if (!maxID.succeed()) {
+                return NullOpt;
+            }
+            advanceRowid(maxID.value());
+            m_rowidSeeded.store(true);
+        }
+    }
+    int64_t next = m_nextRowid.load();
+    int64_t allocated;
+    do {
+        allocated = std::max(next, lowerBound);
+    } while (!m_nextRowid.compare_exchange_weak(
+    next, allocated < std::numeric_limits<int64_t>::max() ? allocated + 1 : allocated));
+    return allocated;
+}
+
+void MigrationInfo::didAssignRowid(int64_t rowid) const
+{
+    advanceRowid(rowid);
+}
+
+void MigrationInfo::markAsRowidChanged() const
+{
+    m_rowidSeeded.store(false);
+}
+
+void MigrationInfo::advanceRowid(int64_t rowid) const
+{
+    if (rowid == std::numeric_limits<int64_t>::max()) {
+        // There is no larger rowid. Let the insertion fail with constraint error.
+        m_nextRowid.store(rowid);
+        return;
+    }
+    int64_t next = m_nextRowid.load();
+    while (next <= rowid) {
+        if (m_nextRowid.compare_exchange_weak(next, rowid + 1)) {
+            break;
+        }
+    }
+}
+
 const StatementSelect& MigrationInfo::getStatementForSelectingAnyRowFromSourceTable() const
 {
     return m_statementForSelectingAnyRowFromSourceTable;
 }
 
+const StatementSelect& MigrationInfo::getStatementForCountingRowsToMigrate() const
+{
+    return m_statementForCountingRowsToMigrate;
+}
+
 const StatementDropTable& MigrationInfo::getStatementForDroppingSourceTable() const
 {
     return m_statementForDroppingSourceTable;
@@ -26,7 +26,11 @@
 
 #include "Lock.hpp"
 #include "StringView.hpp"
+#include "WCDBOptional.hpp"
 #include "WINQ.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
 #include <set>
 
 namespace WCDB {
@@ -200,13 +204,15 @@ public:
      
         Note that newRowid is
         (1) the primmay key assigned from statement
-        (2) or SELECT max(primary key)+1 FROM temp.[unionedView]
+        (2) or allocated by rowid allocator
      
      3. for the tables with normal primary key or no primary key:
      
         INSERT INTO main.targetTable([columns], rowid) VALUES (..., ?rowidIndex)
      
-        Note that newRowid is SELECT max(rowid)+1 FROM temp.[unionedView]
+        Note that newRowid is allocated by rowid allocator
+     
+     The statement for selecting max id is inserted before the last one if the rowid allocator is used.
      */
     void generateStatementsForInsertMigrating(const Statement& sourceStatement,
                                               std::list<Statement>& statements,
@@ -238,10 +244,32 @@ public:
 
     StatementDelete getStatementForDeletingFromTable(const Statement& sourceStatement) const;
 
+    // Whether the update statement sets the rowid or the integer primary key.
+    bool isUpdatingRowid(const Statement& updateStatement) const;
+
 protected:
     StatementDelete m_statementForDeletingSpecifiedRow;
     StatementSelect m_statementForSelectingMaxID;
 
+#pragma mark - Rowid Allocator
+public:
+    typedef std::function<Optional<int64_t>(void)> MaxIDSelector;
+    // The allocator is seeded with the max id of both tables selected by the selector at the first time, and then advanced in memory.
+    // Allocated rowid is never reused, even if the transaction is rolled back, since the other handles might allocate after it. So it's always safe to allocate rowid for the one holding the write lock.
+    // The allocated rowid will not be less than the lower bound.
+    Optional<int64_t> allocateRowid(int64_t lowerBound, const MaxIDSelector& selector) const;
+    // Rowids that are not allocated by the allocator, e.g. the primary key assigned from statement.
+    void didAssignRowid(int64_t rowid) const;
+    // The allocator will be seeded again at the next allocation.
+    void markAsRowidChanged() const;
+
+protected:
+    void advanceRowid(int64_t rowid) const;
+
+    mutable std::mutex m_rowidLock;
+    mutable std::atomic<bool> m_rowidSeeded;
+    mutable std::atomic<int64_t> m_nextRowid;
+
 #pragma mark - Migrate
 public:
     /*
@@ -270,6 +298,11 @@ public:
      */
     const StatementSelect& getStatementForSelectingAnyRowFromSourceTable() const;
 
+    /*
+     SELECT count(*) FROM [schemaForSourceDatabase].[sourceTable] WHERE [filterCondition]
+     */
+    const StatementSelect& getStatementForCountingRowsToMigrate() const;
+
     /*
      DROP TABLE IF EXISTS [schemaForSourceDatabase].[sourceTable]
      */
@@ -280,6 +313,7 @@ protected:
     StatementDelete m_statementForDeletingMigratedOneRow;
     StatementDropTable m_statementForDroppingSourceTable;
     StatementSelect m_statementForSelectingAnyRowFromSourceTable;
+    StatementSelect m_statementForCountingRowsToMigrate;
 };
 
 } // namespace WCDB
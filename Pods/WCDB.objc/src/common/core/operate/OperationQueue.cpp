@@ -83,6 +83,9 @@ void OperationQueue::stopAllDatabaseEvent(const UnsafeStringView& path)
     Operation compress(Operation::Type::Compress, path);
     m_timedQueue.remove(compress);
 
+    Operation incrementalVacuum(Operation::Type::IncrementalVacuum, path);
+    m_timedQueue.remove(incrementalVacuum);
+
     Operation mergeIndex(Operation::Type::MergeIndex, path);
     m_timedQueue.remove(mergeIndex);
 }
@@ -214,6 +217,9 @@ void OperationQueue::onTimed(const Operation& operation, const Parameter& parame
         case Operation::Type::Compress:
             doCompress(operation.path, parameter.numberOfFailures);
             break;
+        case Operation::Type::IncrementalVacuum:
+            doIncrementalVacuum(operation.path, parameter.numberOfFailures);
+            break;
         case Operation::Type::Checkpoint:
             doCheckpoint(operation.path);
             break;
@@ -249,6 +255,7 @@ void OperationQueue::async(const Operation& operation, double delay, const Param
 OperationQueue::Record::Record()
 : registeredForMigration(false)
 , registeredForCompression(false)
+, registeredForIncrementalVacuum(false)
 , registeredForBackup(false)
 , registeredForCheckpoint(false)
 {
@@ -306,10 +313,11 @@ void OperationQueue::doMigrate(const UnsafeStringView& path, int numberOfFailure
     WCTAssert(numberOfFailures >= 0
               && numberOfFailures < OperationQueueTolerableFailuresForMigration);
 
-    auto done = m_event->migrationShouldBeOperated(path);
+    double interval = OperationQueueTimeIntervalForMigration;
+    auto done = m_event->migrationShouldBeOperated(path, interval);
     if (done.succeed()) {
         if (!done.value()) {
-            asyncMigrate(path, OperationQueueTimeIntervalForMigration, numberOfFailures);
+            asyncMigrate(path, interval, numberOfFailures);
         }
     } else {
         if (numberOfFailures + 1 < OperationQueueTolerableFailuresForMigration) {
@@ -398,6 +406,81 @@ void OperationQueue::doCompress(const UnsafeStringView& path, int numberOfFailur
     }
 }
 
+#pragma mark - Incremental Vacuum
+void OperationQueue::registerAsRequiredIncrementalVacuum(const UnsafeStringView& path)
+{
+    WCTAssert(!path.empty());
+
+    LockGuard lockGuard(m_lock);
+    m_records[path].registeredForIncrementalVacuum = true;
+}
+
+void OperationQueue::registerAsNoIncrementalVacuumRequired(const UnsafeStringView& path)
+{
+    WCTAssert(!path.empty());
+
+    LockGuard lockGuard(m_lock);
+    m_records[path].registeredForIncrementalVacuum = false;
+    Operation operation(Operation::Type::IncrementalVacuum, path);
+    m_timedQueue.remove(operation);
+}
+
+void OperationQueue::asyncIncrementalVacuum(const UnsafeStringView& path)
+{
+    asyncIncrementalVacuum(path, OperationQueueTimeIntervalForIncrementalVacuum, 0);
+}
+
+void OperationQueue::stopIncrementalVacuum(const UnsafeStringView& path)
+{
+    LockGuard lockGuard(m_lock);
+    Operation operation(Operation::Type::IncrementalVacuum, path);
+    m_timedQueue.remove(operation);
+}
+
+void OperationQueue::asyncIncrementalVacuum(const UnsafeStringView& path,
+                                            double delay,
+                                            int numberOfFailures)
+{
+    WCTAssert(!path.empty());
+    WCTAssert(numberOfFailures >= 0
+              && numberOfFailures < OperationQueueTolerableFailuresForIncrementalVacuum);
+
+    SharedLockGuard lockGuard(m_lock);
+    if (m_records[path].registeredForIncrementalVacuum) {
+        Operation operation(Operation::Type::IncrementalVacuum, path);
+        Parameter parameter;
+        parameter.numberOfFailures = numberOfFailures;
+        async(operation, delay, parameter);
+    }
+}
+
+void OperationQueue::doIncrementalVacuum(const UnsafeStringView& path, int numberOfFailures)
+{
+    WCTAssert(!path.empty());
+    WCTAssert(numberOfFailures >= 0
+              && numberOfFailures < OperationQueueTolerableFailuresForIncrementalVacuum);
+
+    double interval = OperationQueueTimeIntervalForIncrementalVacuum;
+    auto done = m_event->incrementalVacuumShouldBeOperated(path, interval);
+    if (done.succeed()) {
+        if (!done.value()) {
+            asyncIncrementalVacuum(path, interval, numberOfFailures);
+        }
+    } else {
+        if (numberOfFailures + 1 < OperationQueueTolerableFailuresForIncrementalVacuum) {
+            asyncIncrementalVacuum(
+            path, OperationQueueTimeIntervalForRetringAfterFailure, numberOfFailures + 1);
+        } else {
+            Error error(Error::Code::Notice,
+                        Error::Level::Notice,
+                        "Auto incremental vacuum is stopped due to too many errors.");
+            error.infos.insert_or_assign(ErrorStringKeyPath, path);
+            error.infos.insert_or_assign(ErrorStringKeyType, ErrorTypeIncrementalVacuum);
+            Notifier::shared().notify(error);
+        }
+    }
+}
+
 #pragma mark - Merge FTS Index
 void OperationQueue::registerAsRequiredMergeFTSIndex(const UnsafeStringView& path)
 {
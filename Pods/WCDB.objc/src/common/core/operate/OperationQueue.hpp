@@ -35,6 +35,7 @@
 #include "AutoBackupConfig.hpp"
 #include "AutoCheckpointConfig.hpp"
 #include "AutoCompressConfig.hpp"
+#include "AutoIncrementalVacuumConfig.hpp"
 #include "AutoMergeFTSIndexConfig.hpp"
 #include "AutoMigrateConfig.hpp"
 #include "OperationQueueForMemory.hpp"
@@ -47,8 +48,14 @@ public:
     virtual ~OperationEvent() = 0;
 
 protected:
-    virtual Optional<bool> migrationShouldBeOperated(const UnsafeStringView& path) = 0;
+    // interval is the delay before the next step, which is adapted to the foreground load.
+    virtual Optional<bool>
+    migrationShouldBeOperated(const UnsafeStringView& path, double& interval)
+    = 0;
     virtual Optional<bool> compressionShouldBeOperated(const UnsafeStringView& path) = 0;
+    virtual Optional<bool>
+    incrementalVacuumShouldBeOperated(const UnsafeStringView& path, double& interval)
+    = 0;
     virtual void backupShouldBeOperated(const UnsafeStringView& path) = 0;
     virtual void checkpointShouldBeOperated(const UnsafeStringView& path) = 0;
     virtual void integrityShouldBeChecked(const UnsafeStringView& path) = 0;
@@ -66,6 +73,7 @@ class OperationQueue final : public AsyncQueue,
                              public OperationQueueForMemory,
                              public AutoMigrateOperator,
                              public AutoCompressOperator,
+                             public AutoIncrementalVacuumOperator,
                              public AutoBackupOperator,
                              public AutoMergeFTSIndexOperator,
                              public AutoCheckpointOperator {
@@ -99,6 +107,7 @@ protected:
             Backup,
             Migrate,
             Compress,
+            IncrementalVacuum,
             MergeIndex,
         };
 
@@ -145,6 +154,7 @@ protected:
         Record();
         bool registeredForMigration;
         bool registeredForCompression;
+        bool registeredForIncrementalVacuum;
         bool registeredForBackup;
         bool registeredForCheckpoint;
         bool registeredForMergeFTSIndex;
@@ -174,6 +184,17 @@ protected:
     void asyncCompress(const UnsafeStringView& path, double delay, int numberOfFailures);
     void doCompress(const UnsafeStringView& path, int numberOfFailures);
 
+#pragma mark - Incremental Vacuum
+public:
+    void registerAsRequiredIncrementalVacuum(const UnsafeStringView& path);
+    void registerAsNoIncrementalVacuumRequired(const UnsafeStringView& path);
+    void asyncIncrementalVacuum(const UnsafeStringView& path) override final;
+    void stopIncrementalVacuum(const UnsafeStringView& path) override final;
+
+protected:
+    void asyncIncrementalVacuum(const UnsafeStringView& path, double delay, int numberOfFailures);
+    void doIncrementalVacuum(const UnsafeStringView& path, int numberOfFailures);
+
 #pragma mark - Merge FTS Index
 public:
     using TableArray = AutoMergeFTSIndexOperator::TableArray;
@@ -126,7 +126,7 @@ bool HandleStatement::prepare(const Statement &statement)
             return false;
         }
     } else {
-        WCTAssert(columnName.hasPrefix(CompressionColumnTypePrefix));
+        WCTAssert(WCDBIsCompressionColumn(columnName));
         DecorativeHandle *decorativeHandle
         = dynamic_cast<DecorativeHandle *>(getHandle());
         if (decorativeHandle != nullptr
@@ -255,7 +255,7 @@ bool HandleStatement::tryExtractColumnInfo(const Statement &statement,
 
     WCTAssert(tableSpecified || !schemaSpecified);
     bool findTable = !tableSpecified;
-    bool isCompressingColumn = columnName.hasPrefix(CompressionColumnTypePrefix);
+    bool isCompressingColumn = WCDBIsCompressionColumn(columnName);
     Statement copyStatement = statement;
     bool invalidStatement = false;
 
@@ -0,0 +1,77 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "LRUCache.hpp"
+#include "StringView.hpp"
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace WCDB {
+
+/*
+ The result of rewriting a statement by a statement decorator, shared among all handles.
+ It's keyed by the description of the origin statement and the generation of the infos which the rewriting depends on.
+ Generations are expected to be unique in process, so that the entries of stale or released infos will never be hit and just wait to be purged.
+ */
+template<typename Rewritten>
+class RewrittenStatementCache final
+: protected LRUCache<std::pair<StringView, uint64_t>, std::shared_ptr<const Rewritten>> {
+    using Super = LRUCache<std::pair<StringView, uint64_t>, std::shared_ptr<const Rewritten>>;
+    using Key = std::pair<StringView, uint64_t>;
+
+public:
+    RewrittenStatementCache(size_t capacity) : m_capacity(capacity) {}
+
+    std::shared_ptr<const Rewritten> find(const StringView& fingerprint, uint64_t generation)
+    {
+        if (fingerprint.empty()) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lockGuard(m_lock);
+        auto iter = this->m_map.find(Key(fingerprint, generation));
+        if (iter == this->m_map.end()) {
+            return nullptr;
+        }
+        this->retain(iter);
+        return iter->second->second;
+    }
+
+    void insert(const StringView& fingerprint,
+                uint64_t generation,
+                const std::shared_ptr<const Rewritten>& rewritten)
+    {
+        if (fingerprint.empty() || rewritten == nullptr) {
+            return;
+        }
+        std::lock_guard<std::mutex> lockGuard(m_lock);
+        this->put(Key(fingerprint, generation), rewritten);
+    }
+
+protected:
+    bool shouldPurge() const override final { return this->size() > m_capacity; }
+
+    const size_t m_capacity;
+    std::mutex m_lock;
+};
+
+} // namespace WCDB
@@ -0,0 +1,143 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "IncrementalVacuum.hpp"
+#include "Assertion.hpp"
+#include "CoreConst.h"
+#include "InnerHandle.hpp"
+#include "Notifier.hpp"
+#include "Time.hpp"
+#include <algorithm>
+
+namespace WCDB {
+
+IncrementalVacuum::IncrementalVacuum()
+: m_statementForGettingAutoVacuum(StatementPragma().pragma(Pragma::autoVacuum()))
+, m_statementForGettingFreelistCount(StatementPragma().pragma(Pragma::freelistCount()))
+, m_numberOfPagesPerSlice(IncrementalVacuumMinPagesPerSlice)
+, m_interval(OperationQueueTimeIntervalForIncrementalVacuum)
+{
+}
+
+Optional<bool> IncrementalVacuum::step(InnerHandle* handle)
+{
+    WCTAssert(handle != nullptr);
+    auto autoVacuum = getIntegerValue(handle, m_statementForGettingAutoVacuum);
+    if (autoVacuum.failed()) {
+        return NullOpt;
+    }
+    // 2 for incremental
+    if (autoVacuum.value() != 2) {
+        Error error(Error::Code::Misuse,
+                    Error::Level::Warning,
+                    "Incremental vacuum requires auto_vacuum=incremental, which takes effect after a full vacuum.");
+        error.infos.insert_or_assign(ErrorStringKeyPath, handle->getPath());
+        error.infos.insert_or_assign(ErrorStringKeyType, ErrorTypeIncrementalVacuum);
+        Notifier::shared().notify(error);
+        return true;
+    }
+
+    SteadyClock start = SteadyClock::now();
+    bool busy = false;
+    do {
+        auto numberOfFreePages = getIntegerValue(handle, m_statementForGettingFreelistCount);
+        if (numberOfFreePages.failed()) {
+            adaptInterval(true);
+            return NullOpt;
+        }
+        if (numberOfFreePages.value() == 0) {
+            return true;
+        }
+        int numberOfPages
+        = (int) std::min<int64_t>(numberOfFreePages.value(), m_numberOfPagesPerSlice.load());
+        SteadyClock sliceStart = SteadyClock::now();
+        if (!vacuumSlice(handle, numberOfPages)) {
+            adaptInterval(true);
+            return NullOpt;
+        }
+        adaptNumberOfPagesPerSlice(numberOfPages,
+                                   SteadyClock::timeIntervalSinceSteadyClockToNow(sliceStart));
+        busy = handle->checkHasBusyRetry();
+    } while (!busy
+             && SteadyClock::timeIntervalSinceSteadyClockToNow(start) < IncrementalVacuumStepTimeBudget);
+    adaptInterval(busy);
+    return false;
+}
+
+double IncrementalVacuum::getIntervalForNextStep() const
+{
+    return m_interval.load();
+}
+
+Optional<int64_t>
+IncrementalVacuum::getIntegerValue(InnerHandle* handle, const StatementPragma& statement)
+{
+    if (!handle->prepare(statement)) {
+        return NullOpt;
+    }
+    Optional<int64_t> value;
+    if (handle->step() && !handle->done()) {
+        value = handle->getInteger();
+    }
+    handle->finalize();
+    return value;
+}
+
+bool IncrementalVacuum::vacuumSlice(InnerHandle* handle, int numberOfPages)
+{
+    WCTAssert(numberOfPages > 0);
+    if (!handle->prepare(StatementPragma().pragma(Pragma::incrementalVacuum()).with(numberOfPages))) {
+        return false;
+    }
+    // Each step moves one page.
+    bool succeed = false;
+    do {
+        succeed = handle->step();
+    } while (succeed && !handle->done());
+    handle->finalize();
+    return succeed;
+}
+
+void IncrementalVacuum::adaptNumberOfPagesPerSlice(int numberOfPages, double cost)
+{
+    int next = numberOfPages * 2;
+    if (cost > 0) {
+        double expected = numberOfPages * IncrementalVacuumSliceTimeBudget / cost;
+        if (expected < next) {
+            next = (int) expected;
+        }
+    }
+    next = std::max(next, IncrementalVacuumMinPagesPerSlice);
+    next = std::min(next, IncrementalVacuumMaxPagesPerSlice);
+    m_numberOfPagesPerSlice.store(next);
+}
+
+void IncrementalVacuum::adaptInterval(bool busy)
+{
+    double interval = m_interval.load();
+    if (busy) {
+        interval = std::min(interval * 2, IncrementalVacuumMaxStepInterval);
+    } else {
+        interval = std::max(interval / 2, IncrementalVacuumMinStepInterval);
+    }
+    m_interval.store(interval);
+}
+
+} //namespace WCDB
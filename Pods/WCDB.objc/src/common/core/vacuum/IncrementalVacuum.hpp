@@ -0,0 +1,60 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "StatementPragma.hpp"
+#include "WCDBOptional.hpp"
+#include <atomic>
+
+namespace WCDB {
+
+class InnerHandle;
+
+/*
+ Online defragmentation of the database with auto_vacuum=incremental.
+ Each slice runs `PRAGMA incremental_vacuum(N)` in a single write transaction, which moves N pages at the tail of the file into the free pages in front and truncates the tail.
+ N is adapted to make a slice take about IncrementalVacuumSliceTimeBudget, so that the foreground is paused at most that long for the writer lock.
+ Pages can't be moved without the pointer map of auto_vacuum, so that the database without it should be vacuumed once after `enableAutoVacuum(true)`.
+ */
+class IncrementalVacuum final {
+public:
+    IncrementalVacuum();
+
+    // done
+    Optional<bool> step(InnerHandle* handle);
+    // It's adapted to the foreground load observed in the last step.
+    double getIntervalForNextStep() const;
+
+protected:
+    Optional<int64_t> getIntegerValue(InnerHandle* handle, const StatementPragma& statement);
+    bool vacuumSlice(InnerHandle* handle, int numberOfPages);
+    void adaptNumberOfPagesPerSlice(int numberOfPages, double cost);
+    void adaptInterval(bool busy);
+
+    const StatementPragma m_statementForGettingAutoVacuum;
+    const StatementPragma m_statementForGettingFreelistCount;
+
+private:
+    std::atomic<int> m_numberOfPagesPerSlice;
+    std::atomic<double> m_interval;
+};
+
+} //namespace WCDB
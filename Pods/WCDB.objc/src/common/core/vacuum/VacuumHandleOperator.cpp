@@ -24,6 +24,8 @@
 
 #include "VacuumHandleOperator.hpp"
 #include "CoreConst.h"
+#include "Pager.hpp"
+#include "TableRebuilder.hpp"
 #include "WINQ.h"
 
 namespace WCDB {
@@ -31,7 +33,7 @@ namespace WCDB {
 const char *VacuumHandleOperator::kOriginSchema = "origin";
 
 VacuumHandleOperator::VacuumHandleOperator(InnerHandle *handle)
-: HandleOperator(handle), Repair::VacuumDelegate(), m_tableWeight(0)
+: HandleOperator(handle), Repair::VacuumDelegate(), m_tableWeight(0), m_rebuildByPages(false)
 {
 }
 
@@ -50,6 +52,7 @@ bool VacuumHandleOperator::executeVacuum()
     }
     InnerHandle *handle = getHandle();
     WCTAssert(handle->isOpened());
+    bool rebuildable = canRebuildTables();
     auto seqIter = m_tables.find(Syntax::sequenceTable);
     if (seqIter != m_tables.end() && !copyWithouRowidTable(seqIter->second)) {
         return false;
@@ -80,12 +83,22 @@ bool VacuumHandleOperator::executeVacuum()
         } else {
             if (attribute.value().isVirtual) {
                 needCheckShadowTable = true;
+            } else if (rebuildable && !table.second.hasAutoIndex) {
+                if (!createTableForRebuilding(table.second)) {
+                    return false;
+                }
+                continue;
             }
             if (!copyNormalTable(table.second)) {
                 return false;
             }
         }
     }
+    if (!m_rebuildingTables.empty()) {
+        if (!rebuildTables() || !createIndexesOfRebuiltTables()) {
+            return false;
+        }
+    }
     for (const auto &sql : m_associatedSQLs) {
         if (!handle->execute(sql)) {
             return false;
@@ -97,6 +110,9 @@ bool VacuumHandleOperator::executeVacuum()
 
 const Error &VacuumHandleOperator::getVacuumError()
 {
+    if (!m_rebuildError.isOK()) {
+        return m_rebuildError;
+    }
     return getHandle()->getError();
 }
 
@@ -107,16 +123,7 @@ bool VacuumHandleOperator::configDatabase()
     InnerHandle *handle = getHandle();
     WCTAssert(!handle->isOpened());
     handle->setPath(m_vacuumPath);
-    if (!handle->open()) {
-        return false;
-    }
-    if (!handle->execute(StatementPragma().pragma(Pragma::journalMode()).to("OFF"))) {
-        return false;
-    }
-    if (!handle->execute(StatementPragma().pragma(Pragma::mmapSize()).to(2147418112))) {
-        return false;
-    }
-    if (!handle->execute(StatementPragma().pragma(Pragma::writableSchema()).to(true))) {
+    if (!handle->open() || !configHandle()) {
         return false;
     }
     auto attach = StatementAttach().attach(m_originalPath).as(kOriginSchema);
@@ -130,6 +137,19 @@ bool VacuumHandleOperator::configDatabase()
     return true;
 }
 
+bool VacuumHandleOperator::configHandle()
+{
+    InnerHandle *handle = getHandle();
+    WCTAssert(handle->isOpened());
+    if (!handle->execute(StatementPragma().pragma(Pragma::journalMode()).to("OFF"))) {
+        return false;
+    }
+    if (!handle->execute(StatementPragma().pragma(Pragma::mmapSize()).to(2147418112))) {
+        return false;
+    }
+    return handle->execute(StatementPragma().pragma(Pragma::writableSchema()).to(true));
+}
+
 bool VacuumHandleOperator::initTables()
 {
     InnerHandle *handle = getHandle();
@@ -154,18 +174,22 @@ bool VacuumHandleOperator::initTables()
                 TableInfo info;
                 info.name = name;
                 info.sql = row[4].textValue();
+                info.rootpage = (int) row[3].intValue();
+                info.hasAutoIndex = false;
                 WCTAssert(m_tables.find(name) == m_tables.end());
                 m_tables.insert_or_assign(name, info);
             }
         } else if (type.equal("index")) {
             const StringView &name = row[1].textValue();
+            const StringView &tblName = row[2].textValue();
+            auto iter = m_tables.find(tblName);
             if (!name.hasPrefix(Syntax::builtinTablePrefix)) {
-                const StringView &tblName = row[2].textValue();
-                auto iter = m_tables.find(tblName);
                 WCTAssert(iter != m_tables.end());
                 if (iter != m_tables.end()) {
                     iter->second.indexSQLs.push_back(row[4].textValue());
                 }
+            } else if (iter != m_tables.end()) {
+                iter->second.hasAutoIndex = true;
             }
         } else {
             m_associatedSQLs.push_back(row[4].textValue());
@@ -300,4 +324,123 @@ bool VacuumHandleOperator::copyNormalTable(const TableInfo &info)
     return true;
 }
 
+#pragma mark - Rebuild
+void VacuumHandleOperator::enableRebuildingByPages(bool enable)
+{
+    m_rebuildByPages = enable;
+}
+
+bool VacuumHandleOperator::canRebuildTables()
+{
+    InnerHandle *handle = getHandle();
+    WCTAssert(handle->isOpened());
+    if (!m_rebuildByPages || handle->hasCipher()) {
+        return false;
+    }
+    auto pageSize = getIntegerValue(StatementPragma().pragma(Pragma::pageSize()));
+    auto autoVacuum = getIntegerValue(StatementPragma().pragma(Pragma::autoVacuum()));
+    if (pageSize.failed() || autoVacuum.failed() || autoVacuum.value() != 0) {
+        return false;
+    }
+    m_sourcePager.reset(new Repair::Pager(m_originalPath));
+    if (!m_sourcePager->initialize() || m_sourcePager->getPageSize() != pageSize.value()
+        || m_sourcePager->getReservedBytes() != 0) {
+        m_sourcePager = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool VacuumHandleOperator::createTableForRebuilding(const TableInfo &info)
+{
+    InnerHandle *handle = getHandle();
+    WCTAssert(handle->isOpened());
+    if (!handle->execute(info.sql)) {
+        return false;
+    }
+    m_rebuildingTables.push_back(&info);
+    return true;
+}
+
+bool VacuumHandleOperator::rebuildTables()
+{
+    WCTAssert(m_sourcePager != nullptr);
+    InnerHandle *handle = getHandle();
+    WCTAssert(handle->isOpened());
+    if (!handle->prepare(StatementSelect()
+                         .select({ Column("name"), Column("rootpage") })
+                         .from(TableOrSubquery(Syntax::masterTable).schema(Schema::main()))
+                         .where(Column("type") == "table"))) {
+        return false;
+    }
+    StringViewMap<int> rootpages;
+    while (handle->step() && !handle->done()) {
+        rootpages.insert_or_assign(StringView(handle->getText(0)),
+                                   (int) handle->getInteger(1));
+    }
+    bool succeed = handle->done();
+    handle->finalize();
+    if (!succeed) {
+        return false;
+    }
+    // Nothing should be cached by SQLite while the pages are written.
+    handle->close();
+
+    FileHandle fileHandle(m_vacuumPath);
+    if (!fileHandle.open(FileHandle::Mode::ReadWrite)) {
+        m_rebuildError = ThreadedErrors::shared().getThreadedError();
+        return false;
+    }
+    Repair::TableRebuilder rebuilder(*m_sourcePager, fileHandle);
+    succeed = rebuilder.prepare();
+    for (auto iter = m_rebuildingTables.begin();
+         succeed && iter != m_rebuildingTables.end();
+         ++iter) {
+        auto rootpage = rootpages.find((*iter)->name);
+        WCTAssert(rootpage != rootpages.end());
+        succeed = rootpage != rootpages.end()
+                  && rebuilder.rebuild((*iter)->rootpage, rootpage->second)
+                  && increaseProgress(m_tableWeight);
+    }
+    if (succeed) {
+        succeed = rebuilder.finish();
+    }
+    fileHandle.close();
+    m_sourcePager = nullptr;
+    if (!succeed) {
+        m_rebuildError = rebuilder.getError();
+        return false;
+    }
+    return handle->open() && configHandle();
+}
+
+bool VacuumHandleOperator::createIndexesOfRebuiltTables()
+{
+    InnerHandle *handle = getHandle();
+    WCTAssert(handle->isOpened());
+    for (const auto &table : m_rebuildingTables) {
+        for (const auto &index : table->indexSQLs) {
+            if (!handle->execute(index)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+Optional<int64_t> VacuumHandleOperator::getIntegerValue(const Statement &statement)
+{
+    InnerHandle *handle = getHandle();
+    WCTAssert(handle->isOpened());
+    if (!handle->prepare(statement)) {
+        return NullOpt;
+    }
+    Optional<int64_t> value;
+    if (handle->step() && !handle->done()) {
+        value = handle->getInteger();
+    }
+    handle->finalize();
+    return value;
+}
+
 } // namespace WCDB
@@ -26,10 +26,15 @@
 #include "MasterItem.hpp"
 #include "StatementPragma.hpp"
 #include "Vacuum.hpp"
+#include <memory>
 #include <vector>
 
 namespace WCDB {
 
+namespace Repair {
+class Pager;
+}
+
 class VacuumHandleOperator : public HandleOperator, public Repair::VacuumDelegate {
 public:
     VacuumHandleOperator(InnerHandle *handle);
@@ -40,16 +45,23 @@ public:
     bool executeVacuum() override final;
     const Error &getVacuumError() override final;
 
+    // Rowid tables are copied by SQL by default.
+    void enableRebuildingByPages(bool enable);
+
 private:
     struct TableInfo {
         StringView name;
         StringView sql;
         std::list<StringView> indexSQLs;
+        int rootpage;
+        // The autoindexes of UNIQUE or non-integer PRIMARY KEY constraints are created along with the table, so the table can't be rebuilt by pages.
+        bool hasAutoIndex;
     };
 
     static const char *kOriginSchema;
 
     bool configDatabase();
+    bool configHandle();
     bool initTables();
     bool createTable(const TableInfo &info);
     bool copyWithouRowidTable(const TableInfo &info);
@@ -58,6 +70,23 @@ private:
     StringViewMap<TableInfo> m_tables;
     double m_tableWeight;
     std::list<StringView> m_associatedSQLs; // View, Trigger
+
+#pragma mark - Rebuild
+private:
+    /*
+     If enabled, rowid tables of the unencrypted database are rebuilt by pages with Repair::TableRebuilder instead of SQL, if the page formats of both databases are the same.
+     Those tables are created without indexes while the handle is opened, and then rebuilt after the handle is closed. Their indexes are created by SQL at last.
+     */
+    bool canRebuildTables();
+    bool createTableForRebuilding(const TableInfo &info);
+    bool rebuildTables();
+    bool createIndexesOfRebuiltTables();
+    Optional<int64_t> getIntegerValue(const Statement &statement);
+
+    bool m_rebuildByPages;
+    std::unique_ptr<Repair::Pager> m_sourcePager;
+    std::list<const TableInfo *> m_rebuildingTables;
+    Error m_rebuildError;
 };
 
 } //namespace WCDB
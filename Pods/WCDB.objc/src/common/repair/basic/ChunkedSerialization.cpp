@@ -0,0 +1,445 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ChunkedSerialization.hpp"
+#include "Assertion.hpp"
+#include "CoreConst.h"
+#include "FileManager.hpp"
+#include "Notifier.hpp"
+#include "SQLite.h"
+#include "WCDBError.hpp"
+#include <string.h>
+
+namespace WCDB {
+
+namespace Repair {
+
+static constexpr const size_t chunkHeaderSize = sizeof(uint32_t) * 2; // size + checksum
+static constexpr const size_t fileHeaderSize = sizeof(uint32_t) * 2;  // magic + version
+
+#pragma mark - Serializer
+ChunkedSerializer::ChunkedSerializer(const UnsafeStringView &path, CipherDelegate *cipherDelegate)
+: m_fileHandle(path)
+, m_bufferCursor(0)
+, m_fileOffset(0)
+, m_cipherDelegate(cipherDelegate)
+, m_pCodec(nullptr)
+, m_pageSize(0)
+, m_usableSize(0)
+, m_pageCursor(0)
+, m_pageNo(1)
+{
+}
+
+ChunkedSerializer::~ChunkedSerializer()
+{
+    if (m_fileHandle.isOpened()) {
+        m_fileHandle.close();
+    }
+}
+
+bool ChunkedSerializer::open(uint32_t magic, uint32_t version)
+{
+    WCTAssert(!m_fileHandle.isOpened());
+    if (m_cipherDelegate != nullptr) {
+        m_pageSize = m_cipherDelegate->getCipherPageSize();
+        if (m_pageSize == 0) {
+            setThreadedError(std::move(m_cipherDelegate->getCipherError()));
+            return false;
+        }
+        WCTAssert((m_pageSize & (m_pageSize - 1)) == 0);
+        WCTAssert(m_cipherDelegate->getCipherSalt().length() == saltBytes * 2);
+
+        m_pCodec = m_cipherDelegate->getCipherContext();
+        WCTAssert(m_pCodec != nullptr);
+        int reserveBytes = sqlcipher_codec_ctx_get_reservesize(m_pCodec);
+        WCTAssert(reserveBytes > 0);
+        m_usableSize = m_pageSize - reserveBytes;
+
+        if (!m_page.resize(m_pageSize)) {
+            return false;
+        }
+        memset(m_page.buffer(), 0, m_pageSize);
+        // The head of the first page is left for salt.
+        m_pageCursor = saltBytes;
+        m_pageNo = 1;
+    }
+    if (!m_buffer.resize(std::max((size_t) bufferSize, m_pageSize))) {
+        return false;
+    }
+    if (!m_fileHandle.open(FileHandle::Mode::OverWrite)) {
+        return false;
+    }
+    Serialization header;
+    return header.put4BytesUInt(magic) && header.put4BytesUInt(version)
+           && write(header.finalize().buffer(), fileHeaderSize);
+}
+
+Serialization &ChunkedSerializer::getChunk()
+{
+    return m_chunk;
+}
+
+bool ChunkedSerializer::flushIfNeeded()
+{
+    if ((size_t) m_chunk.getCursor() < chunkSize) {
+        return true;
+    }
+    return flushChunk();
+}
+
+bool ChunkedSerializer::flushChunk()
+{
+    Data payload = m_chunk.finalize();
+    if (payload.empty()) {
+        return true;
+    }
+    Serialization header;
+    if (!header.put4BytesUInt((uint32_t) payload.size())
+        || !header.put4BytesUInt(payload.hash())) {
+        return false;
+    }
+    if (!write(header.finalize().buffer(), chunkHeaderSize)
+        || !write(payload.buffer(), payload.size())) {
+        return false;
+    }
+    m_chunk.seek(0);
+    return true;
+}
+
+bool ChunkedSerializer::finish()
+{
+    WCTAssert(m_fileHandle.isOpened());
+    if (!flushChunk()) {
+        return false;
+    }
+    unsigned char terminator[chunkHeaderSize] = { 0 };
+    if (!write(terminator, chunkHeaderSize)) {
+        return false;
+    }
+    // The rest of the last page is padded with zero, which is the same as the terminator.
+    if (m_cipherDelegate != nullptr && m_pageCursor > 0 && !encryptPage()) {
+        return false;
+    }
+    if (!flushBuffer()) {
+        return false;
+    }
+    m_fileHandle.close();
+    FileManager::setFileProtectionCompleteUntilFirstUserAuthenticationIfNeeded(
+    m_fileHandle.path);
+    return true;
+}
+
+bool ChunkedSerializer::write(const unsigned char *buffer, size_t size)
+{
+    while (size > 0) {
+        size_t length;
+        if (m_cipherDelegate == nullptr) {
+            length = std::min(size, m_buffer.size() - m_bufferCursor);
+            memcpy(m_buffer.buffer() + m_bufferCursor, buffer, length);
+            m_bufferCursor += length;
+            if (m_bufferCursor == m_buffer.size() && !flushBuffer()) {
+                return false;
+            }
+        } else {
+            length = std::min(size, m_usableSize - m_pageCursor);
+            memcpy(m_page.buffer() + m_pageCursor, buffer, length);
+            m_pageCursor += length;
+            if (m_pageCursor == m_usableSize && !encryptPage()) {
+                return false;
+            }
+        }
+        buffer += length;
+        size -= length;
+    }
+    return true;
+}
+
+bool ChunkedSerializer::encryptPage()
+{
+    WCTAssert(m_cipherDelegate != nullptr);
+    unsigned char *pData
+    = (unsigned char *) sqlite3Codec(m_pCodec, m_page.buffer(), m_pageNo, 6);
+    WCTAssert(pData != nullptr);
+    if (pData == nullptr || (*pData == 0 && memcmp(pData, pData + 1, m_pageSize - 1) == 0)) {
+        Error error(Error::Code::Corrupt,
+                    Error::Level::Warning,
+                    StringView::formatted("fail to encrypt data at page %d", m_pageNo));
+        error.infos.insert_or_assign(ErrorStringKeySource, ErrorSourceRepair);
+        error.infos.insert_or_assign(ErrorStringKeyPath, m_fileHandle.path);
+        Notifier::shared().notify(error);
+        setThreadedError(std::move(error));
+        return false;
+    }
+    if (m_bufferCursor + m_pageSize > m_buffer.size() && !flushBuffer()) {
+        return false;
+    }
+    memcpy(m_buffer.buffer() + m_bufferCursor, pData, m_pageSize);
+    m_bufferCursor += m_pageSize;
+
+    memset(m_page.buffer(), 0, m_pageSize);
+    m_pageCursor = 0;
+    ++m_pageNo;
+    return true;
+}
+
+bool ChunkedSerializer::flushBuffer()
+{
+    if (m_bufferCursor == 0) {
+        return true;
+    }
+    if (!m_fileHandle.write(m_fileOffset, UnsafeData(m_buffer.buffer(), m_bufferCursor))) {
+        return false;
+    }
+    m_fileOffset += m_bufferCursor;
+    m_bufferCursor = 0;
+    return true;
+}
+
+#pragma mark - Deserializer
+ChunkedDeserializer::ChunkedDeserializer(const UnsafeStringView &path,
+                                         CipherDelegate *cipherDelegate,
+                                         const DecryptedDeserializable &owner)
+: m_fileHandle(path)
+, m_owner(owner)
+, m_magic(0)
+, m_version(0)
+, m_fileSize(0)
+, m_fileOffset(0)
+, m_bufferCursor(0)
+, m_windowCursor(0)
+, m_cipherDelegate(cipherDelegate)
+, m_pCodec(nullptr)
+, m_pageSize(0)
+, m_usableSize(0)
+, m_pageNo(1)
+{
+}
+
+ChunkedDeserializer::~ChunkedDeserializer() = default;
+
+bool ChunkedDeserializer::open(bool reloadSalt)
+{
+    WCTAssert(!m_fileHandle.isOpened());
+    if (!m_fileHandle.open(FileHandle::Mode::ReadOnly)) {
+        return false;
+    }
+    ssize_t fileSize = m_fileHandle.size();
+    if (fileSize < 0) {
+        return false;
+    }
+    m_fileSize = (size_t) fileSize;
+    // The file is read forward only once.
+    m_fileHandle.advise(0, 0, FileHandle::Advice::Sequential);
+
+    if (m_cipherDelegate != nullptr) {
+        m_pageSize = m_cipherDelegate->getCipherPageSize();
+        if (m_pageSize == 0) {
+            setThreadedError(std::move(m_cipherDelegate->getCipherError()));
+            return false;
+        }
+        WCTAssert((m_pageSize & (m_pageSize - 1)) == 0);
+        if (m_fileSize == 0 || m_fileSize % m_pageSize != 0) {
+            m_owner.decryptFail("Data");
+            return false;
+        }
+        if (reloadSalt) {
+            Data salt = m_fileHandle.read(0, saltBytes);
+            if (salt.size() != saltBytes) {
+                return false;
+            }
+            if (!m_cipherDelegate->switchCipherSalt(StringView::hexString(salt))) {
+                setThreadedError(std::move(m_cipherDelegate->getCipherError()));
+                return false;
+            }
+        }
+        m_pCodec = m_cipherDelegate->getCipherContext();
+        WCTAssert(m_pCodec != nullptr);
+        int reserveBytes = sqlcipher_codec_ctx_get_reservesize(m_pCodec);
+        WCTAssert(reserveBytes > 0);
+        m_usableSize = m_pageSize - reserveBytes;
+    }
+
+    unsigned char header[fileHeaderSize];
+    if (!read(header, fileHeaderSize)) {
+        return false;
+    }
+    Deserialization deserialization(UnsafeData(header, fileHeaderSize));
+    m_magic = deserialization.advance4BytesUInt();
+    m_version = deserialization.advance4BytesUInt();
+    m_chunk.setDataVersion(m_version);
+    return true;
+}
+
+void ChunkedDeserializer::close()
+{
+    m_fileHandle.close();
+}
+
+uint32_t ChunkedDeserializer::getMagic() const
+{
+    return m_magic;
+}
+
+uint32_t ChunkedDeserializer::getVersion() const
+{
+    return m_version;
+}
+
+Deserialization &ChunkedDeserializer::getChunk()
+{
+    return m_chunk;
+}
+
+Optional<bool> ChunkedDeserializer::prepareEntry()
+{
+    if (!m_chunk.ended()) {
+        return true;
+    }
+    unsigned char header[chunkHeaderSize];
+    if (!read(header, chunkHeaderSize)) {
+        return NullOpt;
+    }
+    Deserialization deserialization(UnsafeData(header, chunkHeaderSize));
+    uint32_t size = deserialization.advance4BytesUInt();
+    uint32_t checksum = deserialization.advance4BytesUInt();
+    if (size == 0) {
+        if (checksum != 0) {
+            m_owner.decryptFail("Checksum");
+            return NullOpt;
+        }
+        return false;
+    }
+    if (size > m_fileSize) {
+        m_owner.decryptFail("Chunk");
+        return NullOpt;
+    }
+    if (m_chunkData.size() < size && !m_chunkData.resize(size)) {
+        return NullOpt;
+    }
+    UnsafeData payload(m_chunkData.buffer(), size);
+    if (!read(payload.buffer(), size)) {
+        return NullOpt;
+    }
+    if (payload.hash() != checksum) {
+        m_owner.decryptFail("Checksum");
+        return NullOpt;
+    }
+    m_chunk.reset(payload);
+    return true;
+}
+
+bool ChunkedDeserializer::read(unsigned char *buffer, size_t size)
+{
+    while (size > 0) {
+        if (m_windowCursor == m_window.size() && !fill()) {
+            return false;
+        }
+        size_t length = std::min(size, m_window.size() - m_windowCursor);
+        memcpy(buffer, m_window.buffer() + m_windowCursor, length);
+        m_windowCursor += length;
+        buffer += length;
+        size -= length;
+    }
+    return true;
+}
+
+bool ChunkedDeserializer::fill()
+{
+    if (m_bufferCursor == m_buffer.size()) {
+        if (m_fileOffset >= (offset_t) m_fileSize) {
+            // Unexpected end of file.
+            m_owner.decryptFail("Chunk");
+            return false;
+        }
+        size_t size = std::min(std::max((size_t) bufferSize, m_pageSize), m_fileSize - m_fileOffset);
+        m_buffer = m_fileHandle.read(m_fileOffset, size);
+        if (m_buffer.size() != size) {
+            return false;
+        }
+        m_fileOffset += size;
+        m_bufferCursor = 0;
+    }
+    if (m_cipherDelegate == nullptr) {
+        m_window = m_buffer;
+        m_bufferCursor = m_buffer.size();
+    } else {
+        WCTAssert(m_bufferCursor + m_pageSize <= m_buffer.size());
+        unsigned char *pData = (unsigned char *) sqlite3Codec(
+        m_pCodec, m_buffer.buffer() + m_bufferCursor, m_pageNo, 4);
+        if (pData == nullptr) {
+            m_owner.decryptFail(StringView::formatted("Page %d", m_pageNo));
+            return false;
+        }
+        size_t offset = m_pageNo == 1 ? saltBytes : 0;
+        m_window = UnsafeData(pData + offset, m_usableSize - offset);
+        m_bufferCursor += m_pageSize;
+        ++m_pageNo;
+    }
+    m_windowCursor = 0;
+    return true;
+}
+
+#pragma mark - Serializable
+ChunkedSerializable::~ChunkedSerializable() = default;
+
+bool ChunkedSerializable::chunkedSerialize(const UnsafeStringView &path, bool encrypted) const
+{
+    WCTAssert(path.length() > 0);
+    CipherDelegate *cipherDelegate = nullptr;
+    if (encrypted) {
+        cipherDelegate = getCipherDelegate();
+        WCTAssert(cipherDelegate != nullptr);
+    }
+    ChunkedSerializer serializer(path, cipherDelegate);
+    return serializeChunks(serializer);
+}
+
+#pragma mark - Deserializable
+ChunkedDeserializable::~ChunkedDeserializable() = default;
+
+bool ChunkedDeserializable::chunkedDeserialize(const UnsafeStringView &path,
+                                               bool decrypted,
+                                               bool reloadSalt)
+{
+    CipherDelegate *cipherDelegate = nullptr;
+    if (decrypted) {
+        cipherDelegate = getCipherDelegate();
+        WCTAssert(cipherDelegate != nullptr);
+    }
+    ChunkedDeserializer deserializer(path, cipherDelegate, *this);
+    if (!deserializer.open(reloadSalt)) {
+        return false;
+    }
+    if (isChunkedVersion(deserializer.getVersion())) {
+        return deserializeChunks(deserializer);
+    }
+    deserializer.close();
+    // The salt is already reloaded.
+    if (decrypted) {
+        return decryptedDeserialize(path, false);
+    } else {
+        return deserialize(path);
+    }
+}
+
+} //namespace Repair
+
+} //namespace WCDB
@@ -0,0 +1,144 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "EncryptedSerialization.hpp"
+#include "FileHandle.hpp"
+#include "WCDBOptional.hpp"
+
+namespace WCDB {
+
+namespace Repair {
+
+/*
+ A chunked file starts with the magic and the version, followed by chunks of [size|checksum|payload], and it ends with a chunk of zero size.
+ Chunks are cut between entries, so that an entry can always be deserialized from a single chunk. The checksum is the crc32 of the payload.
+ If encrypted, the whole stream is encrypted page by page in the same way as `EncryptedSerializable`, with the salt at the head of the first page.
+ Both sides keep only a chunk and a buffer of file in memory, no matter how large the file is.
+ */
+class ChunkedSerializer final : protected SharedThreadedErrorProne {
+public:
+    // The file is not encrypted if cipherDelegate is null.
+    ChunkedSerializer(const UnsafeStringView &path, CipherDelegate *cipherDelegate);
+    ~ChunkedSerializer() override;
+
+    static constexpr const size_t chunkSize = 64 * 1024;
+    static constexpr const size_t bufferSize = 64 * 1024;
+
+    bool open(uint32_t magic, uint32_t version);
+    // Entries are put into the chunk directly, and `flushIfNeeded` should be called between them.
+    Serialization &getChunk();
+    bool flushIfNeeded();
+    bool finish();
+
+protected:
+    bool flushChunk();
+    bool write(const unsigned char *buffer, size_t size);
+    bool encryptPage();
+    bool flushBuffer();
+
+    FileHandle m_fileHandle;
+    Serialization m_chunk;
+
+    Data m_buffer;
+    size_t m_bufferCursor;
+    offset_t m_fileOffset;
+
+    CipherDelegate *m_cipherDelegate;
+    void *m_pCodec;
+    size_t m_pageSize;
+    size_t m_usableSize;
+    Data m_page;
+    size_t m_pageCursor;
+    int m_pageNo;
+};
+
+class ChunkedDeserializer final : protected SharedThreadedErrorProne {
+public:
+    // The file is not decrypted if cipherDelegate is null. Corruptions are reported by the decryptFail of owner.
+    ChunkedDeserializer(const UnsafeStringView &path,
+                        CipherDelegate *cipherDelegate,
+                        const DecryptedDeserializable &owner);
+    ~ChunkedDeserializer() override;
+
+    static constexpr const size_t bufferSize = 64 * 1024;
+
+    // The magic and the version are read once it's opened.
+    bool open(bool reloadSalt);
+    void close();
+    uint32_t getMagic() const;
+    uint32_t getVersion() const;
+
+    // It loads the next chunk if the current one is ended.
+    // It returns true if there are entries left in the chunk, or false if all the chunks are read.
+    Optional<bool> prepareEntry();
+    Deserialization &getChunk();
+
+protected:
+    bool read(unsigned char *buffer, size_t size);
+    bool fill();
+
+    FileHandle m_fileHandle;
+    const DecryptedDeserializable &m_owner;
+    uint32_t m_magic;
+    uint32_t m_version;
+    Data m_chunkData;
+    Deserialization m_chunk;
+
+    size_t m_fileSize;
+    offset_t m_fileOffset;
+    Data m_buffer;
+    size_t m_bufferCursor;
+    UnsafeData m_window;
+    size_t m_windowCursor;
+
+    CipherDelegate *m_cipherDelegate;
+    void *m_pCodec;
+    size_t m_pageSize;
+    size_t m_usableSize;
+    int m_pageNo;
+};
+
+#pragma mark - Serializable
+class ChunkedSerializable : public EncryptedSerializable {
+public:
+    virtual ~ChunkedSerializable() override = 0;
+    bool chunkedSerialize(const UnsafeStringView &path, bool encrypted) const;
+
+protected:
+    virtual bool serializeChunks(ChunkedSerializer &serializer) const = 0;
+};
+
+#pragma mark - Deserializable
+class ChunkedDeserializable : public DecryptedDeserializable {
+public:
+    virtual ~ChunkedDeserializable() override = 0;
+    // Files in legacy format are loaded as a whole.
+    bool chunkedDeserialize(const UnsafeStringView &path, bool decrypted, bool reloadSalt);
+
+protected:
+    virtual bool isChunkedVersion(uint32_t version) const = 0;
+    virtual bool deserializeChunks(ChunkedDeserializer &deserializer) = 0;
+};
+
+} //namespace Repair
+
+} //namespace WCDB
@@ -26,6 +26,7 @@
 
 #include "StringView.hpp"
 #include "WCDBError.hpp"
+#include <vector>
 
 namespace WCDB {
 
@@ -44,6 +45,9 @@ public:
     virtual StringView getCipherSalt() = 0;
     virtual bool setCipherSalt(const UnsafeStringView &salt) = 0;
     virtual bool switchCipherSalt(const UnsafeStringView &salt) = 0;
+    // The contexts of forked ciphers with the same key and salt, which decode pages concurrently with the one of getCipherContext.
+    // They are owned by the delegate, and less contexts are returned if some of them fail to be forked.
+    virtual std::vector<void *> getConcurrentCipherContexts(int count) = 0;
 };
 
 class CipherDelegateHolder {
@@ -113,15 +113,21 @@ void Crawlable::safeCrawl(int rootpageno, std::set<int> &crawledInteriorPages, i
     }
     crawledInteriorPages.emplace(rootpageno);
     switch (rootpage.getType()) {
-    case Page::Type::InteriorTable:
+    case Page::Type::InteriorTable: {
+        auto subpagenos = std::make_shared<std::vector<int>>();
+        subpagenos->reserve(rootpage.getNumberOfSubpages());
         for (int i = 0; i < rootpage.getNumberOfSubpages(); ++i) {
+            subpagenos->push_back(rootpage.getSubpageno(i));
+        }
+        for (size_t i = 0; i < subpagenos->size(); ++i) {
             if (m_suspend) {
                 return;
             }
-            int pageno = rootpage.getSubpageno(i);
-            safeCrawl(pageno, crawledInteriorPages, height + 1);
+            // hint again since it may be replaced by the subpages of the last page.
+            m_associatedPager->prefetchPages(subpagenos, i);
+            safeCrawl((*subpagenos)[i], crawledInteriorPages, height + 1);
         }
-        break;
+    } break;
     case Page::Type::InteriorIndex:
         for (int i = 0; i < rootpage.getNumberOfCells(); ++i) {
             if (m_suspend) {
@@ -139,17 +145,23 @@ void Crawlable::safeCrawl(int rootpageno, std::set<int> &crawledInteriorPages, i
         break;
     case Page::Type::LeafTable:
     case Page::Type::LeafIndex:
-        for (int i = 0; i < rootpage.getNumberOfCells(); ++i) {
+        rootpage.decodeCells(m_decodedCells);
+        for (int i = 0; i < m_decodedCells.getNumberOfCells(); ++i) {
             if (m_suspend) {
-                return;
+                break;
             }
-            Cell cell = rootpage.getCell(i);
+            if (!m_decodedCells.isDecoded(i)) {
+                markAsError();
+                continue;
+            }
+            Cell cell(m_decodedCells, i, m_associatedPager);
             if (cell.initialize()) {
                 onCellCrawled(cell);
             } else {
                 markAsError();
             }
         }
+        m_decodedCells.clear();
         break;
     default:
         markAsCorrupted(
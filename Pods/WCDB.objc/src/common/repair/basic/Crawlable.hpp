@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include "DecodedCells.hpp"
 #include "Pager.hpp"
 #include <set>
 
@@ -76,6 +77,8 @@ private:
     void safeCrawl(int rootpageno, std::set<int> &crawledInteriorPages, int height);
     bool m_isCrawling;
     bool m_isCrawlingIndexTable;
+    // The cells of leaf pages are decoded in bulk, and the storage is reused by all leaf pages.
+    DecodedCells m_decodedCells;
 };
 
 } //namespace Repair
@@ -64,6 +64,7 @@ int Repairman::getDisposedWalPageCount() const
 
 bool Repairman::exit()
 {
+    m_pager.reportMappingStatistics();
     if (!isErrorCritial()) {
         return finishProgress();
     }
@@ -72,6 +73,7 @@ bool Repairman::exit()
 
 bool Repairman::exit(bool result)
 {
+    m_pager.reportMappingStatistics();
     if (result) {
         return finishProgress();
     }
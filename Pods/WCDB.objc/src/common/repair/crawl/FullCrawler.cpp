@@ -25,6 +25,7 @@
 #include "FullCrawler.hpp"
 #include "Assemble.hpp"
 #include "Assertion.hpp"
+#include "CoreConst.h"
 #include "MasterItem.hpp"
 #include "Page.hpp"
 #include "SequenceCrawler.hpp"
@@ -75,6 +76,8 @@ bool FullCrawler::work()
             return exit(false);
         }
         m_pager.setCipherContext(pCodec);
+        m_pager.setConcurrentCipherContexts(
+        m_cipherDelegate->getConcurrentCipherContexts(WorkerPoolMaxNumberOfThreads));
         m_pager.setPageSize((int) pageSize);
     }
 
@@ -93,6 +96,7 @@ bool FullCrawler::work()
     if (m_pageCount != 0) {
         numbersOfLeafTablePages = m_pageCount;
     } else {
+        m_pager.setAccessPattern(FileHandle::Advice::Sequential);
         for (int i = 1; i <= m_pager.getNumberOfPages(); ++i) {
             Page page(i, &m_pager);
             auto type = page.acquireType();
@@ -104,6 +108,7 @@ bool FullCrawler::work()
     }
     // If there are only without-rowid tables in the db, numbersOfLeafTablePages will be 0
     setPageWeight(Fraction(1, numbersOfLeafTablePages == 0 ? 1 : numbersOfLeafTablePages));
+    m_pager.setAccessPattern(FileHandle::Advice::Random);
 
     if (markAsAssembling()) {
         if (!m_masterCrawler.work(this) || isErrorCritial()) {
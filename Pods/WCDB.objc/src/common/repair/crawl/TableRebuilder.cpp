@@ -0,0 +1,519 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TableRebuilder.hpp"
+#include "Assertion.hpp"
+#include "CoreConst.h"
+#include "Notifier.hpp"
+#include "Serialization.hpp"
+#include "StringView.hpp"
+#include <string.h>
+
+namespace WCDB {
+
+namespace Repair {
+
+static void put2BytesInt(unsigned char *p, int value)
+{
+    p[0] = (unsigned char) (value >> 8);
+    p[1] = (unsigned char) value;
+}
+
+static void put4BytesUInt(unsigned char *p, uint32_t value)
+{
+    p[0] = (unsigned char) (value >> 24);
+    p[1] = (unsigned char) (value >> 16);
+    p[2] = (unsigned char) (value >> 8);
+    p[3] = (unsigned char) value;
+}
+
+static int putVarint(unsigned char *p, uint64_t value)
+{
+    if (value & (((uint64_t) 0xff000000) << 32)) {
+        p[8] = (unsigned char) value;
+        value >>= 8;
+        for (int i = 7; i >= 0; i--) {
+            p[i] = (unsigned char) ((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        return 9;
+    }
+    unsigned char buf[10];
+    int n = 0;
+    do {
+        buf[n++] = (unsigned char) ((value & 0x7f) | 0x80);
+        value >>= 7;
+    } while (value != 0);
+    buf[0] &= 0x7f;
+    for (int i = 0, j = n - 1; j >= 0; j--, i++) {
+        p[i] = buf[j];
+    }
+    return n;
+}
+
+#pragma mark - Initialize
+TableRebuilder::TableRebuilder(Pager &source, FileHandle &destination)
+: Crawlable()
+, ErrorProne()
+, m_source(source)
+, m_destination(destination)
+, m_pageSize(0)
+, m_numberOfPages(0)
+, m_destinationRootpage(0)
+, m_hasRowid(false)
+, m_lastRowid(0)
+, m_firstBufferedPage(0)
+, m_numberOfBufferedPages(0)
+{
+    setAssociatedPager(&m_source);
+}
+
+TableRebuilder::~TableRebuilder() = default;
+
+bool TableRebuilder::prepare()
+{
+    WCTAssert(m_source.isInitialized());
+    WCTAssert(m_destination.isOpened());
+    if (!m_error.isOK()) {
+        return false;
+    }
+    const int headerSize = 100;
+    Data destinationHeader = m_destination.read(0, headerSize);
+    if (destinationHeader.size() != headerSize) {
+        if (destinationHeader.empty()) {
+            assignWithSharedThreadedError();
+        } else {
+            Error error(Error::Code::Corrupt, Error::Level::Error, "Header of destination is incomplete.");
+            error.infos.insert_or_assign(ErrorStringKeySource, ErrorSourceRepair);
+            error.infos.insert_or_assign(ErrorStringKeyAssociatePath, m_destination.path);
+            Notifier::shared().notify(error);
+            setError(std::move(error));
+        }
+        return false;
+    }
+    UnsafeData sourceHeader = m_source.acquirePageData(1, 0, headerSize);
+    if (sourceHeader.size() != headerSize) {
+        setError(m_source.getError());
+        return false;
+    }
+
+    Deserialization destination(destinationHeader);
+    Deserialization source(sourceHeader);
+    int pageSize = destination.get2BytesInt(16) & 0xffff;
+    if (pageSize == 1) {
+        pageSize = 65536;
+    }
+    // Cells are copied verbatim, so that they should be encoded in the same way, and no pointer map is maintained.
+    if (pageSize != m_source.getPageSize() || m_source.getReservedBytes() != 0
+        || destination.get1ByteInt(20) != 0 || destination.get4BytesInt(52) != 0
+        || destination.get4BytesInt(56) != source.get4BytesInt(56)) {
+        Error error(Error::Code::Misuse,
+                    Error::Level::Error,
+                    "Page formats of the source and the destination are different.");
+        error.infos.insert_or_assign(ErrorStringKeySource, ErrorSourceRepair);
+        error.infos.insert_or_assign(ErrorStringKeyAssociatePath, m_destination.path);
+        error.infos.insert_or_assign("SourcePageSize", m_source.getPageSize());
+        error.infos.insert_or_assign("DestinationPageSize", pageSize);
+        Notifier::shared().notify(error);
+        setError(std::move(error));
+        return false;
+    }
+
+    ssize_t fileSize = m_destination.size();
+    if (fileSize < 0) {
+        assignWithSharedThreadedError();
+        return false;
+    }
+    m_pageSize = pageSize;
+    m_numberOfPages = (uint32_t) (fileSize / m_pageSize);
+    m_buffer = Data((size_t) m_pageSize * maxNumberOfBufferedPages);
+    m_cell = Data(m_pageSize);
+    m_overflow = Data(m_pageSize);
+    if (m_buffer.empty() || m_cell.empty() || m_overflow.empty()) {
+        assignWithSharedThreadedError();
+        return false;
+    }
+    return true;
+}
+
+#pragma mark - Rebuild
+bool TableRebuilder::rebuild(int sourceRootpage, int destinationRootpage)
+{
+    WCTAssert(m_pageSize > 0);
+    WCTAssert(destinationRootpage > 1 && (uint32_t) destinationRootpage <= m_numberOfPages);
+    if (!m_error.isOK()) {
+        return false;
+    }
+    m_destinationRootpage = destinationRootpage;
+    m_hasRowid = false;
+    m_lastRowid = 0;
+    m_levels.clear();
+    m_levels.emplace_back(Page::Type::LeafTable);
+    if (!resetPage(m_levels.front())) {
+        return false;
+    }
+    if (!crawl(sourceRootpage) || !m_error.isOK()) {
+        return false;
+    }
+    bool succeed = finishTree();
+    m_levels.clear();
+    return succeed;
+}
+
+bool TableRebuilder::finish()
+{
+    WCTAssert(m_pageSize > 0);
+    if (!m_error.isOK() || !flush()) {
+        return false;
+    }
+    const int headerSize = 100;
+    Data header = m_destination.read(0, headerSize);
+    if (header.size() != headerSize) {
+        assignWithSharedThreadedError();
+        return false;
+    }
+    Deserialization deserialization(header);
+    uint32_t changeCounter = deserialization.get4BytesUInt(24) + 1;
+    unsigned char *p = header.buffer();
+    put4BytesUInt(p + 24, changeCounter);
+    put4BytesUInt(p + 28, m_numberOfPages);
+    // version-valid-for, without which the number of pages in header is ignored.
+    put4BytesUInt(p + 92, changeCounter);
+    if (!m_destination.write(0, header)) {
+        assignWithSharedThreadedError();
+        return false;
+    }
+    return true;
+}
+
+bool TableRebuilder::appendLeafCell(const Page &page,
+                                    const Deserialization &deserialization,
+                                    int index)
+{
+    const Data &data = page.getData();
+    int pointer = page.getCellPointer(index);
+
+    size_t lengthOfPayloadSize;
+    uint64_t payloadSize;
+    std::tie(lengthOfPayloadSize, payloadSize) = deserialization.getVarint(pointer);
+    size_t lengthOfRowid;
+    uint64_t rowid;
+    std::tie(lengthOfRowid, rowid)
+    = deserialization.getVarint(pointer + lengthOfPayloadSize);
+    if (lengthOfPayloadSize == 0 || lengthOfRowid == 0) {
+        markAsCorrupted(page.number, "Cell is incomplete.");
+        return false;
+    }
+    if (m_hasRowid && (int64_t) rowid <= m_lastRowid) {
+        markAsCorrupted(page.number, "Rowids are not in ascending order.");
+        return false;
+    }
+
+    // See btreeParseCellPtr of SQLite.
+    const int usableSize = m_pageSize;
+    const int maxLocal = usableSize - 35;
+    const int minLocal = (usableSize - 12) * 32 / 255 - 23;
+    int local = (int) payloadSize;
+    int numberOfOverflowPages = 0;
+    if (payloadSize > (uint64_t) maxLocal) {
+        int surplus = minLocal + (int) ((payloadSize - minLocal) % (usableSize - 4));
+        local = surplus <= maxLocal ? surplus : minLocal;
+        numberOfOverflowPages
+        = (int) ((payloadSize - local + usableSize - 5) / (usableSize - 4));
+    }
+    int size = (int) (lengthOfPayloadSize + lengthOfRowid) + local
+               + (numberOfOverflowPages > 0 ? 4 : 0);
+    if (pointer + size > (int) data.size()) {
+        markAsCorrupted(page.number, "Cell exceeds the page.");
+        return false;
+    }
+
+    const unsigned char *cell = data.buffer() + pointer;
+    if (numberOfOverflowPages > 0) {
+        uint32_t firstPageno;
+        if (!copyOverflowPages(page,
+                               deserialization.get4BytesUInt(pointer + size - 4),
+                               numberOfOverflowPages,
+                               firstPageno)) {
+            return false;
+        }
+        memcpy(m_cell.buffer(), cell, size);
+        put4BytesUInt(m_cell.buffer() + size - 4, firstPageno);
+        cell = m_cell.buffer();
+    }
+
+    if (!appendCell(m_levels.front(), cell, size)) {
+        if (!finishPage(0)) {
+            return false;
+        }
+        if (!appendCell(m_levels.front(), cell, size)) {
+            // A cell that fits in the page is always appendable to an empty page.
+            markAsCorrupted(page.number, "Cell exceeds the page.");
+            return false;
+        }
+    }
+    m_levels.front().maxRowid = (int64_t) rowid;
+    m_hasRowid = true;
+    m_lastRowid = (int64_t) rowid;
+    return true;
+}
+
+bool TableRebuilder::copyOverflowPages(const Page &page,
+                                       uint32_t sourcePageno,
+                                       int numberOfPages,
+                                       uint32_t &firstPageno)
+{
+    WCTAssert(numberOfPages > 0);
+    uint32_t pageno = allocatePage();
+    firstPageno = pageno;
+    for (int i = 0; i < numberOfPages; ++i) {
+        if (sourcePageno <= 1 || sourcePageno > (uint32_t) m_source.getNumberOfPages()) {
+            markAsCorrupted(page.number,
+                            StringView::formatted("Overflow page %u is out of range.", sourcePageno));
+            return false;
+        }
+        UnsafeData overflow = m_source.acquirePageData(sourcePageno);
+        if (overflow.size() != (size_t) m_pageSize) {
+            markAsError();
+            return false;
+        }
+        Deserialization deserialization(overflow);
+        uint32_t nextSourcePageno = deserialization.get4BytesUInt(0);
+        uint32_t nextPageno = i + 1 < numberOfPages ? allocatePage() : 0;
+        memcpy(m_overflow.buffer(), overflow.buffer(), m_pageSize);
+        put4BytesUInt(m_overflow.buffer(), nextPageno);
+        if (!writePage(pageno, m_overflow)) {
+            return false;
+        }
+        pageno = nextPageno;
+        sourcePageno = nextSourcePageno;
+    }
+    return true;
+}
+
+#pragma mark - Tree
+TableRebuilder::Level::Level(Page::Type type_)
+: type(type_)
+, numberOfCells(0)
+, cellContentOffset(0)
+, maxRowid(0)
+, rightChild(0)
+, maxRowidOfHeld(0)
+{
+}
+
+bool TableRebuilder::resetPage(Level &level)
+{
+    if (level.page.size() != (size_t) m_pageSize) {
+        level.page = Data(m_pageSize);
+        if (level.page.empty()) {
+            assignWithSharedThreadedError();
+            suspend();
+            return false;
+        }
+    }
+    memset(level.page.buffer(), 0, m_pageSize);
+    level.numberOfCells = 0;
+    level.cellContentOffset = m_pageSize;
+    level.maxRowid = 0;
+    level.rightChild = 0;
+    return true;
+}
+
+bool TableRebuilder::appendCell(Level &level, const unsigned char *cell, int size)
+{
+    int headerSize = level.type == Page::Type::LeafTable ? 8 : 12;
+    int endOfCellPointers = headerSize + 2 * (level.numberOfCells + 1);
+    if (level.cellContentOffset - size < endOfCellPointers) {
+        return false;
+    }
+    level.cellContentOffset -= size;
+    unsigned char *p = level.page.buffer();
+    memcpy(p + level.cellContentOffset, cell, size);
+    put2BytesInt(p + headerSize + 2 * level.numberOfCells, level.cellContentOffset);
+    ++level.numberOfCells;
+    return true;
+}
+
+bool TableRebuilder::finishPage(size_t level)
+{
+    WCTAssert(level < m_levels.size());
+    {
+        Level &current = m_levels[level];
+        unsigned char *p = current.page.buffer();
+        p[0] = (unsigned char) current.type;
+        put2BytesInt(p + 3, current.numberOfCells);
+        // 0 is interpreted as 65536.
+        put2BytesInt(p + 5, current.cellContentOffset == 65536 ? 0 : current.cellContentOffset);
+        if (current.type == Page::Type::InteriorTable) {
+            WCTAssert(current.rightChild != 0);
+            put4BytesUInt(p + 8, current.rightChild);
+        }
+    }
+    if (!m_levels[level].held.empty()) {
+        uint32_t pageno = allocatePage();
+        // addChild may grow m_levels.
+        if (!writePage(pageno, m_levels[level].held)
+            || !addChild(level + 1, pageno, m_levels[level].maxRowidOfHeld)) {
+            return false;
+        }
+    }
+    Level &current = m_levels[level];
+    std::swap(current.page, current.held);
+    current.maxRowidOfHeld = current.maxRowid;
+    return resetPage(current);
+}
+
+bool TableRebuilder::addChild(size_t level, uint32_t pageno, int64_t maxRowid)
+{
+    WCTAssert(level > 0 && level <= m_levels.size());
+    if (level == m_levels.size()) {
+        m_levels.emplace_back(Page::Type::InteriorTable);
+        if (!resetPage(m_levels.back())) {
+            return false;
+        }
+    }
+    if (m_levels[level].rightChild != 0) {
+        // left child and the max rowid under it
+        unsigned char cell[4 + 9];
+        put4BytesUInt(cell, m_levels[level].rightChild);
+        int size = 4 + putVarint(cell + 4, (uint64_t) m_levels[level].maxRowid);
+        // The pending right child becomes the right most page of the full page.
+        if (!appendCell(m_levels[level], cell, size) && !finishPage(level)) {
+            return false;
+        }
+    }
+    Level &current = m_levels[level];
+    current.rightChild = pageno;
+    current.maxRowid = maxRowid;
+    return true;
+}
+
+bool TableRebuilder::finishTree()
+{
+    for (size_t level = 0; level < m_levels.size(); ++level) {
+        bool hasPage;
+        if (level == 0) {
+            // An empty leaf is kept only for an empty table.
+            hasPage = m_levels[level].numberOfCells > 0 || m_levels[level].held.empty();
+        } else {
+            hasPage = m_levels[level].rightChild != 0;
+        }
+        if (hasPage && !finishPage(level)) {
+            return false;
+        }
+        WCTAssert(!m_levels[level].held.empty());
+        if (level + 1 == m_levels.size()) {
+            // Nothing is above, so that it's the root.
+            return writePage(m_destinationRootpage, m_levels[level].held) && flush();
+        }
+        uint32_t pageno = allocatePage();
+        if (!writePage(pageno, m_levels[level].held)
+            || !addChild(level + 1, pageno, m_levels[level].maxRowidOfHeld)) {
+            return false;
+        }
+        m_levels[level].held = Data();
+    }
+    WCTAssert(false);
+    return false;
+}
+
+#pragma mark - Write
+uint32_t TableRebuilder::allocatePage()
+{
+    ++m_numberOfPages;
+    // The page containing the lock bytes of SQLite is never used. See PENDING_BYTE_PAGE of SQLite.
+    if (m_numberOfPages == 0x40000000 / (uint32_t) m_pageSize + 1) {
+        ++m_numberOfPages;
+    }
+    return m_numberOfPages;
+}
+
+bool TableRebuilder::writePage(uint32_t pageno, const UnsafeData &page)
+{
+    WCTAssert(page.size() == (size_t) m_pageSize);
+    if (m_numberOfBufferedPages > 0
+        && (m_numberOfBufferedPages == maxNumberOfBufferedPages
+            || pageno != m_firstBufferedPage + m_numberOfBufferedPages)) {
+        if (!flush()) {
+            return false;
+        }
+    }
+    if (m_numberOfBufferedPages == 0) {
+        m_firstBufferedPage = pageno;
+    }
+    memcpy(m_buffer.buffer() + (size_t) m_numberOfBufferedPages * m_pageSize,
+           page.buffer(),
+           m_pageSize);
+    ++m_numberOfBufferedPages;
+    return true;
+}
+
+bool TableRebuilder::flush()
+{
+    if (m_numberOfBufferedPages == 0) {
+        return true;
+    }
+    bool succeed = m_destination.write(
+    (offset_t) (m_firstBufferedPage - 1) * m_pageSize,
+    m_buffer.subdata((size_t) m_numberOfBufferedPages * m_pageSize));
+    m_numberOfBufferedPages = 0;
+    if (!succeed) {
+        assignWithSharedThreadedError();
+        suspend();
+    }
+    return succeed;
+}
+
+#pragma mark - Crawlable
+bool TableRebuilder::willCrawlPage(const Page &page, int height)
+{
+    WCDB_UNUSED(height);
+    switch (page.getType()) {
+    case Page::Type::InteriorTable:
+        return m_error.isOK();
+    case Page::Type::LeafTable: {
+        Deserialization deserialization(page.getData());
+        for (int i = 0; i < page.getNumberOfCells(); ++i) {
+            if (m_suspend || !appendLeafCell(page, deserialization, i)) {
+                break;
+            }
+        }
+    } break;
+    default:
+        markAsCorrupted(page.number,
+                        StringView::formatted("Unexpected page type: %d", page.getType()));
+        break;
+    }
+    // Cells of leaf are copied without being parsed.
+    return false;
+}
+
+void TableRebuilder::onCrawlerError()
+{
+    if (m_error.isOK()) {
+        setError(m_source.getError());
+    }
+    suspend();
+}
+
+} //namespace Repair
+
+} //namespace WCDB
@@ -0,0 +1,115 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Crawlable.hpp"
+#include "ErrorProne.hpp"
+#include "FileHandle.hpp"
+#include "Page.hpp"
+#include <vector>
+
+namespace WCDB {
+
+namespace Repair {
+
+/*
+ It copies a rowid table from the source database into an empty table of the destination by pages rather than by SQL.
+ Leaf cells are copied verbatim in rowid order into packed leaf pages, and the interior pages are emitted bottom-up as soon as their children are finished.
+ Overflow chains are copied verbatim with their page numbers renumbered, so that all the pages except the root are appended to the destination sequentially.
+ The page formats of both databases should be the same, and the destination should not be opened by any other handle while rebuilding.
+ */
+class TableRebuilder final : public Crawlable, public ErrorProne {
+#pragma mark - Initialize
+public:
+    TableRebuilder(Pager &source, FileHandle &destination);
+    ~TableRebuilder() override;
+
+    // The source should be initialized and the destination should be opened in ReadWrite mode.
+    bool prepare();
+
+protected:
+    Pager &m_source;
+    FileHandle &m_destination;
+    int m_pageSize;
+    uint32_t m_numberOfPages;
+
+#pragma mark - Rebuild
+public:
+    // The destination rootpage should be an empty table that is just created.
+    bool rebuild(int sourceRootpage, int destinationRootpage);
+    // It should be called after all tables are rebuilt to update the header of the destination.
+    bool finish();
+
+protected:
+    bool appendLeafCell(const Page &page, const Deserialization &deserialization, int index);
+    bool copyOverflowPages(const Page &page, uint32_t sourcePageno, int numberOfPages, uint32_t &firstPageno);
+
+    int m_destinationRootpage;
+    bool m_hasRowid;
+    int64_t m_lastRowid;
+    Data m_cell;
+    Data m_overflow;
+
+#pragma mark - Tree
+protected:
+    // Level 0 is the leaf level.
+    struct Level {
+        Level(Page::Type type);
+
+        Page::Type type;
+        Data page;
+        int numberOfCells;
+        int cellContentOffset;
+        // It's the max rowid of the leaf page, or the max rowid under the right child of the interior page.
+        int64_t maxRowid;
+        uint32_t rightChild;
+        // The last finished page is held until the next one begins, since the root is not known to be the root until then.
+        Data held;
+        int64_t maxRowidOfHeld;
+    };
+    std::vector<Level> m_levels;
+
+    bool resetPage(Level &level);
+    bool appendCell(Level &level, const unsigned char *cell, int size);
+    bool finishPage(size_t level);
+    bool addChild(size_t level, uint32_t pageno, int64_t maxRowid);
+    bool finishTree();
+
+#pragma mark - Write
+protected:
+    uint32_t allocatePage();
+    bool writePage(uint32_t pageno, const UnsafeData &page);
+    bool flush();
+
+    static constexpr const int maxNumberOfBufferedPages = 64;
+    Data m_buffer;
+    uint32_t m_firstBufferedPage;
+    int m_numberOfBufferedPages;
+
+#pragma mark - Crawlable
+protected:
+    bool willCrawlPage(const Page &page, int height) override final;
+    void onCrawlerError() override final;
+};
+
+} //namespace Repair
+
+} //namespace WCDB
@@ -123,10 +123,10 @@ FactoryBackup::saveIncrementalMaterial(const UnsafeStringView& database,
     if (m_cipherDelegate->isCipherDB()) {
         material->setCipherDelegate(m_cipherDelegate);
         StringView salt = m_cipherDelegate->tryGetSaltFromDatabase(database).value();
-        succeed = material->encryptedSerialize(materialPath);
+        succeed = material->chunkedSerialize(materialPath, true);
         material->setCipherDelegate(nullptr);
     } else {
-        succeed = material->serialize(materialPath);
+        succeed = material->chunkedSerialize(materialPath, false);
     }
     if (!succeed) {
         return NullOpt;
@@ -143,12 +143,12 @@ FactoryBackup::saveMaterial(const UnsafeStringView& database, const Material& ma
         return NullOpt;
     }
     if (!m_cipherDelegate->isCipherDB()) {
-        if (!material.serialize(materialPath.value())) {
+        if (!material.chunkedSerialize(materialPath.value(), false)) {
             assignWithSharedThreadedError();
             return NullOpt;
         }
     } else {
-        if (!material.encryptedSerialize(materialPath.value())) {
+        if (!material.chunkedSerialize(materialPath.value(), true)) {
             assignWithSharedThreadedError();
             return NullOpt;
         }
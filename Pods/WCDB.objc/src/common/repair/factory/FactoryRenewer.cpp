@@ -223,10 +223,10 @@ bool FactoryRenewer::resolveInfosForDatabase(StringViewMap<Info> &infos,
         Material material;
         bool succeed = false;
         if (!m_cipherDelegate->isCipherDB()) {
-            succeed = material.deserialize(materialPath);
+            succeed = material.chunkedDeserialize(materialPath, false, false);
         } else {
             material.setCipherDelegate(m_cipherDelegate);
-            succeed = material.decryptedDeserialize(materialPath, true);
+            succeed = material.chunkedDeserialize(materialPath, true, true);
         }
         if (!succeed) {
             if (ThreadedErrors::shared().getThreadedError().isCorruption()) {
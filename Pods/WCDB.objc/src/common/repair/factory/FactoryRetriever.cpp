@@ -183,10 +183,10 @@ bool FactoryRetriever::restore(const UnsafeStringView &databasePath)
         StringView path;
         for (const auto &materialPath : materialPaths) {
             if (!m_cipherDelegate->isCipherDB()) {
-                useMaterial = material.deserialize(materialPath);
+                useMaterial = material.chunkedDeserialize(materialPath, false, false);
             } else {
                 material.setCipherDelegate(m_cipherDelegate);
-                useMaterial = material.decryptedDeserialize(materialPath, true);
+                useMaterial = material.chunkedDeserialize(materialPath, true, true);
             }
 
             if (useMaterial) {
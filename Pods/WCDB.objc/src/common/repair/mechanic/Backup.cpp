@@ -82,6 +82,7 @@ Backup::Backup(const UnsafeStringView &path)
 {
     setAssociatedPager(&m_pager);
     m_masterCrawler.setAssociatedPager(&m_pager);
+    m_pager.setAccessPattern(FileHandle::Advice::Random);
 }
 
 Backup::~Backup() = default;
@@ -116,6 +117,7 @@ bool Backup::work(SharedIncrementalMaterial incrementalMaterial)
     }
 
     updateMaterial(materialLoad.value());
+    m_pager.reportMappingStatistics();
 
     return true;
 }
@@ -136,9 +138,9 @@ Optional<bool> Backup::tryLoadLatestMaterial(SharedIncrementalMaterial increment
     bool useMaterial = false;
     if (m_cipherDelegate->isCipherDB()) {
         m_material.setCipherDelegate(m_cipherDelegate);
-        useMaterial = m_material.decryptedDeserialize(materialPath.value(), false);
+        useMaterial = m_material.chunkedDeserialize(materialPath.value(), true, false);
     } else {
-        useMaterial = m_material.deserialize(materialPath.value());
+        useMaterial = m_material.chunkedDeserialize(materialPath.value(), false, false);
     }
     if (!useMaterial) {
         m_material = Material();
@@ -185,6 +187,8 @@ bool Backup::fullBackup()
             }
             void *pCodec = m_cipherDelegate->getCipherContext();
             m_pager.setCipherContext(pCodec);
+            m_pager.setConcurrentCipherContexts(
+            m_cipherDelegate->getConcurrentCipherContexts(WorkerPoolMaxNumberOfThreads));
             m_pager.setPageSize((int) pageSize);
         }
 
@@ -227,6 +231,8 @@ bool Backup::incrementalBackup()
         }
         void *pCodec = m_cipherDelegate->getCipherContext();
         m_pager.setCipherContext(pCodec);
+        m_pager.setConcurrentCipherContexts(
+        m_cipherDelegate->getConcurrentCipherContexts(WorkerPoolMaxNumberOfThreads));
         m_pager.setPageSize((int) pageSize);
     }
     m_pager.setWalSkipped();
@@ -282,17 +288,16 @@ bool Backup::incrementalBackup()
 
     auto &contentList = m_material.contentsList;
     for (auto &content : contentList) {
-        auto &pages = content.verifiedPagenos;
-        for (auto page = pages.begin(); page != pages.end();) {
-            if (m_verifyingPagenos->find(page->number) != m_verifyingPagenos->end()) {
+        content.verifiedPagenos.removeIf([&](const Material::Page &page) {
+            if (m_verifyingPagenos->find(page.number) != m_verifyingPagenos->end()) {
                 // Need to be verified
-                page->number = 0;
-            } else if (page->number <= pageCount) {
-                m_unchangedLeaves[page->number - 1] = true;
+                return true;
+            } else if (page.number <= pageCount) {
+                m_unchangedLeaves[page.number - 1] = true;
                 m_unchangedLeavesCount++;
             }
-            page++;
-        }
+            return false;
+        });
     }
     for (auto iter = m_verifyingPagenos->begin(); iter != m_verifyingPagenos->end();) {
         auto &page = iter->second;
@@ -311,19 +316,12 @@ bool Backup::incrementalBackup()
             setError(m_pager.getError());
             return false;
         }
-        for (auto pageIter = iter->verifiedPagenos.begin();
-             pageIter != iter->verifiedPagenos.end();
-             pageIter++) {
-            if (pageIter->number > 0 && pageIter->number <= m_unchangedLeaves.size()
-                && m_unchangedLeaves[pageIter->number - 1]) {
-                // Deleted page
-                pageIter->number = 0;
-            }
-        }
+        iter->verifiedPagenos.removeIf([&](const Material::Page &page) {
+            // Deleted page
+            return page.number <= m_unchangedLeaves.size() && m_unchangedLeaves[page.number - 1];
+        });
         if (m_verifiedPagenos.size() > 0) {
-            iter->verifiedPagenos.insert(iter->verifiedPagenos.end(),
-                                         m_verifiedPagenos.begin(),
-                                         m_verifiedPagenos.end());
+            iter->verifiedPagenos.merge(m_verifiedPagenos);
             m_verifiedPagenos.clear();
             auto preIter = iter;
             iter++;
@@ -531,7 +529,9 @@ void Backup::onMasterCellCrawled(const Cell &cell, const MasterItem &master)
             if (!crawl(master.rootpage)) {
                 return;
             }
-            content.verifiedPagenos = std::move(m_verifiedPagenos);
+            content.verifiedPagenos.assign(m_verifiedPagenos);
+            // The buffer is kept for the next table.
+            m_verifiedPagenos.clear();
         } else {
             if (!master.sql.empty()) {
                 content.associatedSQLs.push_back(master.sql);
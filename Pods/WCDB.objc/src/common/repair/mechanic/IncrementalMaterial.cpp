@@ -69,6 +69,30 @@ bool IncrementalMaterial::serialize(Serialization &serialization) const
     return serializeData(serialization, encoder.finalize());
 }
 
+bool IncrementalMaterial::serializeChunks(ChunkedSerializer &serializer) const
+{
+    if (!serializer.open(magic, chunkedVersion)) {
+        return false;
+    }
+
+    //Info
+    if (!info.serialize(serializer.getChunk())) {
+        return false;
+    }
+
+    //Pages
+    for (const auto &element : pages) {
+        if (element.second.number == 0) {
+            markAsEmpty("Page");
+            return false;
+        }
+        if (!serializer.flushIfNeeded() || !element.second.serialize(serializer.getChunk())) {
+            return false;
+        }
+    }
+    return serializer.finish();
+}
+
 bool IncrementalMaterial::serializeData(Serialization &serialization, const Data &data)
 {
     uint32_t checksum = data.empty() ? 0 : data.hash();
@@ -126,6 +150,51 @@ bool IncrementalMaterial::deserialize(Deserialization &deserialization)
     return true;
 }
 
+bool IncrementalMaterial::isChunkedVersion(uint32_t versionValue) const
+{
+    return versionValue == chunkedVersion;
+}
+
+bool IncrementalMaterial::deserializeChunks(ChunkedDeserializer &deserializer)
+{
+    //Header
+    if (deserializer.getMagic() != IncrementalMaterial::magic) {
+        markAsCorrupt("Magic");
+        return false;
+    }
+    WCTAssert(deserializer.getVersion() == chunkedVersion);
+
+    //Info
+    auto prepared = deserializer.prepareEntry();
+    if (!prepared.succeed()) {
+        return false;
+    }
+    if (!prepared.value()) {
+        markAsCorrupt("Info");
+        return false;
+    }
+    if (!info.deserialize(deserializer.getChunk())) {
+        return false;
+    }
+
+    //Pages
+    while (true) {
+        prepared = deserializer.prepareEntry();
+        if (!prepared.succeed()) {
+            return false;
+        }
+        if (!prepared.value()) {
+            break;
+        }
+        Page page;
+        if (!page.deserialize(deserializer.getChunk())) {
+            return false;
+        }
+        pages[page.number] = std::move(page);
+    }
+    return true;
+}
+
 Optional<Data> IncrementalMaterial::deserializeData(Deserialization &deserialization)
 {
     if (!deserialization.canAdvance(sizeof(uint32_t))) {
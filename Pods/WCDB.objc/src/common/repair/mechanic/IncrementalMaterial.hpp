@@ -24,7 +24,7 @@
 
 #pragma once
 
-#include "EncryptedSerialization.hpp"
+#include "ChunkedSerialization.hpp"
 #include "Page.hpp"
 #include "StringView.hpp"
 #include <stdlib.h>
@@ -39,8 +39,8 @@ class Deserialization;
 
 namespace Repair {
 
-class IncrementalMaterial final : public EncryptedSerializable,
-                                  public DecryptedDeserializable,
+class IncrementalMaterial final : public ChunkedSerializable,
+                                  public ChunkedDeserializable,
                                   public CipherDelegateHolder {
 #pragma mark - Serializable
 public:
@@ -50,6 +50,7 @@ public:
     ~IncrementalMaterial() override;
 
 protected:
+    bool serializeChunks(ChunkedSerializer &serializer) const override final;
     static bool serializeData(Serialization &serialization, const Data &data);
     static void markAsEmpty(const UnsafeStringView &element);
 
@@ -59,6 +60,8 @@ public:
     using Deserializable::deserialize;
 
 protected:
+    bool isChunkedVersion(uint32_t version) const override final;
+    bool deserializeChunks(ChunkedDeserializer &deserializer) override final;
     static Optional<Data> deserializeData(Deserialization &deserialization);
     static void markAsCorrupt(const UnsafeStringView &element);
     void decryptFail(const UnsafeStringView &element) const override final;
@@ -68,6 +71,8 @@ protected:
 protected:
     static constexpr const uint32_t magic = 0x57434441;
     static constexpr const uint32_t version = 0x01000000; //1.0.0.0
+    // Pages are saved in chunks since 1.0.0.1, while the layout of each page is the same as 1.0.0.0.
+    static constexpr const uint32_t chunkedVersion = 0x01000001; //1.0.0.1
     static constexpr const int headerSize = sizeof(magic) + sizeof(version); //magic + version
 
 #pragma mark - Info
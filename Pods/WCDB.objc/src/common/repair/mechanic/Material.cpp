@@ -73,6 +73,34 @@ bool Material::serialize(Serialization &serialization) const
     return serializeData(serialization, encoder.finalize());
 }
 
+bool Material::serializeChunks(ChunkedSerializer &serializer) const
+{
+    if (!serializer.open(magic, chunkedVersion)) {
+        return false;
+    }
+
+    //Info
+    if (!info.serialize(serializer.getChunk())) {
+        return false;
+    }
+
+    //Contents
+    for (const auto &element : contentsList) {
+        if (element.tableName.empty()) {
+            markAsEmpty("TableName");
+            return false;
+        }
+        if (element.sql.length() == 0) {
+            markAsEmpty("SQL");
+            return false;
+        }
+        if (!serializer.flushIfNeeded() || !element.serializeChunks(serializer)) {
+            return false;
+        }
+    }
+    return serializer.finish();
+}
+
 bool Material::serializeData(Serialization &serialization, const Data &data)
 {
     uint32_t checksum = data.empty() ? 0 : data.hash();
@@ -132,6 +160,53 @@ bool Material::deserialize(Deserialization &deserialization)
     return true;
 }
 
+bool Material::isChunkedVersion(uint32_t versionValue) const
+{
+    return versionValue == 0x01000002 || versionValue == chunkedVersion;
+}
+
+bool Material::deserializeChunks(ChunkedDeserializer &deserializer)
+{
+    //Header
+    if (deserializer.getMagic() != Material::magic) {
+        markAsCorrupt("Magic");
+        return false;
+    }
+    WCTAssert(isChunkedVersion(deserializer.getVersion()));
+
+    //Info
+    auto prepared = deserializer.prepareEntry();
+    if (!prepared.succeed()) {
+        return false;
+    }
+    if (!prepared.value()) {
+        markAsCorrupt("Info");
+        return false;
+    }
+    if (!info.deserialize(deserializer.getChunk())) {
+        return false;
+    }
+
+    //Contents
+    while (true) {
+        prepared = deserializer.prepareEntry();
+        if (!prepared.succeed()) {
+            return false;
+        }
+        if (!prepared.value()) {
+            break;
+        }
+        contentsList.emplace_back();
+        Content &content = contentsList.back();
+        if (!content.deserializeChunks(deserializer)) {
+            return false;
+        }
+        StringView tableName = content.tableName;
+        contentsMap[tableName] = &content;
+    }
+    return true;
+}
+
 Optional<Data> Material::deserializeData(Deserialization &deserialization)
 {
     if (!deserialization.canAdvance(sizeof(uint32_t))) {
@@ -229,6 +304,243 @@ Material::Page::Page(uint32_t n, uint32_t h) : number(n), hash(h) {};
 
 Material::Page::~Page() = default;
 
+#pragma mark - CompactPages
+Material::CompactPages::CompactPages() : m_lastNumber(0)
+{
+    static_assert(pagesPerEntry % blockSize == 0, "");
+}
+
+void Material::CompactPages::assign(VerifiedPages &pages)
+{
+    std::sort(pages.begin(), pages.end(), [](const Page &a, const Page &b) {
+        return a.number < b.number;
+    });
+    clear();
+    m_hashes.reserve(pages.size());
+    m_blockOffsets.reserve(pages.size() / blockSize + 1);
+    for (const auto &page : pages) {
+        // Deleted pages are 0 and duplicated pages are dropped.
+        if (page.number > m_lastNumber) {
+            append(page.number, page.hash);
+        }
+    }
+}
+
+void Material::CompactPages::merge(VerifiedPages &pages)
+{
+    std::sort(pages.begin(), pages.end(), [](const Page &a, const Page &b) {
+        return a.number < b.number;
+    });
+    CompactPages merged;
+    merged.m_numbers.reserve(m_numbers.size() + pages.size() * 2);
+    merged.m_hashes.reserve(m_hashes.size() + pages.size());
+    auto newPage = pages.begin();
+    for (const auto &page : *this) {
+        for (; newPage != pages.end() && newPage->number <= page.number; ++newPage) {
+            if (newPage->number > merged.m_lastNumber) {
+                merged.append(newPage->number, newPage->hash);
+            }
+        }
+        if (page.number > merged.m_lastNumber) {
+            merged.append(page.number, page.hash);
+        }
+    }
+    for (; newPage != pages.end(); ++newPage) {
+        if (newPage->number > merged.m_lastNumber) {
+            merged.append(newPage->number, newPage->hash);
+        }
+    }
+    *this = std::move(merged);
+}
+
+void Material::CompactPages::removeIf(const std::function<bool(const Page &)> &shouldRemove)
+{
+    CompactPages remains;
+    remains.m_numbers.reserve(m_numbers.size());
+    remains.m_hashes.reserve(m_hashes.size());
+    for (const auto &page : *this) {
+        if (!shouldRemove(page)) {
+            remains.append(page.number, page.hash);
+        }
+    }
+    if (remains.size() != size()) {
+        *this = std::move(remains);
+    }
+}
+
+void Material::CompactPages::clear()
+{
+    m_numbers.clear();
+    m_hashes.clear();
+    m_blockOffsets.clear();
+    m_lastNumber = 0;
+}
+
+size_t Material::CompactPages::size() const
+{
+    return m_hashes.size();
+}
+
+bool Material::CompactPages::empty() const
+{
+    return m_hashes.empty();
+}
+
+void Material::CompactPages::append(uint32_t number, uint32_t hash)
+{
+    WCTAssert(number > m_lastNumber);
+    if (m_hashes.size() % blockSize == 0) {
+        m_blockOffsets.push_back((uint32_t) m_numbers.size());
+    }
+    // Big-endian varint, which is the same as `Serialization::putVarint`.
+    uint32_t delta = number - m_lastNumber;
+    unsigned char buffer[5];
+    int length = 0;
+    do {
+        buffer[length++] = (unsigned char) ((delta & 0x7f) | 0x80);
+        delta >>= 7;
+    } while (delta != 0);
+    buffer[0] &= 0x7f;
+    while (length > 0) {
+        m_numbers.push_back(buffer[--length]);
+    }
+    m_hashes.push_back(hash);
+    m_lastNumber = number;
+}
+
+int Material::CompactPages::decodeDelta(const unsigned char *numbers,
+                                        size_t size,
+                                        size_t offset,
+                                        uint32_t &delta)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < 5 && offset + i < size; ++i) {
+        unsigned char byte = numbers[offset + i];
+        value = (value << 7) | (byte & 0x7f);
+        if ((byte & 0x80) == 0) {
+            if (value > UINT32_MAX) {
+                return 0;
+            }
+            delta = (uint32_t) value;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+Material::CompactPages::Iterator Material::CompactPages::begin() const
+{
+    return Iterator(*this, 0);
+}
+
+Material::CompactPages::Iterator Material::CompactPages::end() const
+{
+    return Iterator(*this, size());
+}
+
+size_t Material::CompactPages::getNumberOfEntries() const
+{
+    return (size() + pagesPerEntry - 1) / pagesPerEntry;
+}
+
+bool Material::CompactPages::serializeEntry(Serialization &serialization, size_t index) const
+{
+    size_t begin = index * pagesPerEntry;
+    WCTAssert(begin < size());
+    size_t end = std::min(begin + pagesPerEntry, size());
+    size_t beginOffset = m_blockOffsets[begin / blockSize];
+    size_t endOffset = end < size() ? m_blockOffsets[end / blockSize] : m_numbers.size();
+    if (!serialization.putVarint(end - begin)
+        || !serialization.putSizedData(UnsafeData::immutable(
+           m_numbers.data() + beginOffset, endOffset - beginOffset))
+        || !serialization.expand((end - begin) * sizeof(uint32_t))) {
+        return false;
+    }
+    for (size_t i = begin; i < end; ++i) {
+        serialization.put4BytesUInt(m_hashes[i]);
+    }
+    return true;
+}
+
+bool Material::CompactPages::deserializeEntry(Deserialization &deserialization)
+{
+    auto count = deserialization.advanceVarint();
+    if (count.first == 0 || count.second == 0 || count.second > pagesPerEntry) {
+        return false;
+    }
+    auto numbers = deserialization.advanceSizedData();
+    if (numbers.first == 0
+        || !deserialization.canAdvance((size_t) count.second * sizeof(uint32_t))) {
+        return false;
+    }
+    // Numbers are validated and indexed before they are appended as a whole.
+    const unsigned char *encoded = numbers.second.buffer();
+    size_t encodedSize = numbers.second.size();
+    size_t offset = 0;
+    uint64_t number = m_lastNumber;
+    std::vector<uint32_t> blockOffsets;
+    for (size_t i = 0; i < count.second; ++i) {
+        uint32_t delta = 0;
+        int length = decodeDelta(encoded, encodedSize, offset, delta);
+        if (length == 0 || delta == 0 || number + delta > UINT32_MAX) {
+            return false;
+        }
+        number += delta;
+        if ((size() + i) % blockSize == 0) {
+            blockOffsets.push_back((uint32_t) (m_numbers.size() + offset));
+        }
+        offset += length;
+    }
+    if (offset != encodedSize) {
+        return false;
+    }
+    m_numbers.insert(m_numbers.end(), encoded, encoded + encodedSize);
+    m_blockOffsets.insert(m_blockOffsets.end(), blockOffsets.begin(), blockOffsets.end());
+    for (size_t i = 0; i < count.second; ++i) {
+        m_hashes.push_back(deserialization.advance4BytesUInt());
+    }
+    m_lastNumber = (uint32_t) number;
+    return true;
+}
+
+#pragma mark - Iterator
+Material::CompactPages::Iterator::Iterator(const CompactPages &pages, size_t index)
+: m_pages(pages), m_index(index), m_offset(0), m_number(0)
+{
+    if (m_index < m_pages.size()) {
+        WCTAssert(m_index == 0);
+        decode(0);
+    }
+}
+
+void Material::CompactPages::Iterator::decode(uint32_t previousNumber)
+{
+    uint32_t delta = 0;
+    int length = decodeDelta(
+    m_pages.m_numbers.data(), m_pages.m_numbers.size(), m_offset, delta);
+    WCTAssert(length > 0);
+    m_offset += length;
+    m_number = previousNumber + delta;
+}
+
+Material::Page Material::CompactPages::Iterator::operator*() const
+{
+    return Page(m_number, m_pages.m_hashes[m_index]);
+}
+
+Material::CompactPages::Iterator &Material::CompactPages::Iterator::operator++()
+{
+    if (++m_index < m_pages.size()) {
+        decode(m_number);
+    }
+    return *this;
+}
+
+bool Material::CompactPages::Iterator::operator!=(const Iterator &other) const
+{
+    return m_index != other.m_index;
+}
+
 Material::Content::Content()
 : rootPage(UnknownPageNo), sequence(0), checked(false)
 {
@@ -238,6 +550,34 @@ Material::Content::~Content() = default;
 
 #pragma mark - Serialization
 bool Material::Content::serialize(Serialization &serialization) const
+{
+    if (!serializeHeader(serialization, verifiedPagenos.size())) {
+        return false;
+    }
+    uint32_t prePageNo = 0;
+    for (const auto &page : verifiedPagenos) {
+        if (!serializePage(serialization, page, prePageNo)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Material::Content::serializeChunks(ChunkedSerializer &serializer) const
+{
+    if (!serializeHeader(serializer.getChunk(), verifiedPagenos.size())) {
+        return false;
+    }
+    for (size_t i = 0; i < verifiedPagenos.getNumberOfEntries(); ++i) {
+        if (!serializer.flushIfNeeded()
+            || !verifiedPagenos.serializeEntry(serializer.getChunk(), i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Material::Content::serializeHeader(Serialization &serialization, size_t numberOfPages) const
 {
     if (!serialization.putSizedString(tableName) || !serialization.putVarint(rootPage)
         || !serialization.putVarint(sequence) || !serialization.putSizedString(sql)) {
@@ -252,54 +592,90 @@ bool Material::Content::serialize(Serialization &serialization) const
             return false;
         }
     }
-    VerifiedPages *pages = const_cast<VerifiedPages *>(&verifiedPagenos);
-    std::sort(pages->begin(), pages->end(), [](const Page &a, const Page &b) {
-        return a.number < b.number;
-    });
-    uint32_t prePageNo = 0;
-    for (int i = 0; i < verifiedPagenos.size(); i++) {
-        const auto &page = verifiedPagenos[i];
-        if (page.number == 0) {
-            WCTAssert(prePageNo == 0);
-            // Deleted pages
-            continue;
+    // It's 0 if there is no leaf page.
+    return serialization.putVarint(numberOfPages);
+}
+
+bool Material::Content::serializePage(Serialization &serialization,
+                                      const Page &page,
+                                      uint32_t &prePageNo)
+{
+    // Page numbers are saved as the delta to the previous one.
+    WCTAssert(page.number > prePageNo);
+    if (!serialization.putVarint(page.number - prePageNo)
+        || !serialization.put4BytesUInt(page.hash)) {
+        return false;
+    }
+    prePageNo = page.number;
+    return true;
+}
+
+#pragma mark - Deserialization
+bool Material::Content::deserialize(Deserialization &deserialization)
+{
+    auto numberOfPages = deserializeHeader(deserialization);
+    if (!numberOfPages.succeed()) {
+        return false;
+    }
+    uint64_t prePageNo = 0;
+    VerifiedPages pages;
+    pages.reserve(numberOfPages.value());
+    for (int i = 0; i < numberOfPages.value(); ++i) {
+        if (!deserializePage(deserialization, pages, prePageNo)) {
+            return false;
         }
-        if (prePageNo == 0) {
-            if (!serialization.putVarint(verifiedPagenos.size() - i)) {
-                return false;
-            }
-            if (!serialization.putVarint(page.number)) {
-                return false;
-            }
-        } else {
-            WCTAssert(page.number > prePageNo);
-            if (!serialization.putVarint(page.number - prePageNo)) {
+    }
+    verifiedPagenos.assign(pages);
+    return true;
+}
+
+bool Material::Content::deserializeChunks(ChunkedDeserializer &deserializer)
+{
+    Deserialization &deserialization = deserializer.getChunk();
+    auto numberOfPages = deserializeHeader(deserialization);
+    if (!numberOfPages.succeed()) {
+        return false;
+    }
+    bool compact = deserialization.version() >= 0x01000003;
+    uint64_t prePageNo = 0;
+    VerifiedPages pages;
+    for (int i = 0; i < numberOfPages.value();) {
+        auto prepared = deserializer.prepareEntry();
+        if (!prepared.succeed()) {
+            return false;
+        }
+        if (!prepared.value()) {
+            markAsCorrupt("Pageno");
+            return false;
+        }
+        if (!compact) {
+            if (!deserializePage(deserialization, pages, prePageNo)) {
                 return false;
             }
+            ++i;
+            continue;
         }
-        prePageNo = page.number;
-        if (!serialization.put4BytesUInt(page.hash)) {
+        if (!verifiedPagenos.deserializeEntry(deserialization)
+            || verifiedPagenos.size() > (size_t) numberOfPages.value()) {
+            markAsCorrupt("Pages");
             return false;
         }
+        i = (int) verifiedPagenos.size();
     }
-
-    // No leaf page
-    if (prePageNo == 0 && !serialization.putVarint(0)) {
-        return false;
+    if (!compact) {
+        verifiedPagenos.assign(pages);
     }
-
     return true;
 }
 
-#pragma mark - Deserialization
-bool Material::Content::deserialize(Deserialization &deserialization)
+Optional<int> Material::Content::deserializeHeader(Deserialization &deserialization)
 {
     size_t lengthOfSizedString;
     StringView table;
     std::tie(lengthOfSizedString, table) = deserialization.advanceSizedString();
     if (lengthOfSizedString == 0 || table.empty()) {
         markAsCorrupt("TableName");
-        return false;
+        return NullOpt;
     }
     tableName = table;
 
@@ -309,7 +685,7 @@ bool Material::Content::deserialize(Deserialization &deserialization)
         std::tie(lengthOfPageNo, pageNo) = deserialization.advanceVarint();
         if (lengthOfPageNo == 0) {
             markAsCorrupt("rootPage");
-            return false;
+            return NullOpt;
         }
         rootPage = (uint32_t) pageNo;
         WCTAssert(rootPage != UnknownPageNo);
@@ -320,20 +696,20 @@ bool Material::Content::deserialize(Deserialization &deserialization)
     std::tie(lengthOfVarint, varint) = deserialization.advanceVarint();
     if (lengthOfVarint == 0) {
         markAsCorrupt("Sequence");
-        return false;
+        return NullOpt;
     }
     sequence = (int64_t) varint;
 
     std::tie(lengthOfSizedString, sql) = deserialization.advanceSizedString();
     if (lengthOfSizedString == 0 || sql.empty()) {
         markAsCorrupt("SQL");
-        return false;
+        return NullOpt;
     }
 
     std::tie(lengthOfVarint, varint) = deserialization.advanceVarint();
     if (lengthOfVarint == 0) {
         markAsCorrupt("SQLs");
-        return false;
+        return NullOpt;
     }
     int numberOfAssociatedSQLs = (int) varint;
     associatedSQLs.clear();
@@ -342,7 +718,7 @@ bool Material::Content::deserialize(Deserialization &deserialization)
         std::tie(lengthOfSizedString, buffer) = deserialization.advanceSizedString();
         if (lengthOfSizedString == 0 || buffer.empty()) {
             markAsCorrupt("SQLs");
-            return false;
+            return NullOpt;
         }
         associatedSQLs.push_back(std::move(buffer));
     }
@@ -350,28 +726,32 @@ bool Material::Content::deserialize(Deserialization &deserialization)
     std::tie(lengthOfVarint, varint) = deserialization.advanceVarint();
     if (lengthOfVarint == 0) {
         markAsCorrupt("NumberOfPages");
+        return NullOpt;
+    }
+    return (int) varint;
+}
+
+bool Material::Content::deserializePage(Deserialization &deserialization,
+                                        VerifiedPages &pages,
+                                        uint64_t &prePageNo)
+{
+    size_t lengthOfVarint;
+    uint64_t varint;
+    std::tie(lengthOfVarint, varint) = deserialization.advanceVarint();
+    if (lengthOfVarint == 0) {
+        markAsCorrupt("Pageno");
         return false;
     }
-    int numberOfPages = (int) varint;
-    uint64_t prePageNo = 0;
-    verifiedPagenos.reserve(numberOfPages);
-    for (int i = 0; i < numberOfPages; ++i) {
-        std::tie(lengthOfVarint, varint) = deserialization.advanceVarint();
-        if (lengthOfVarint == 0) {
-            markAsCorrupt("Pageno");
-            return false;
-        }
-        if (!deserialization.canAdvance(4)) {
-            markAsCorrupt("PageChecksum");
-            return false;
-        }
-        uint32_t checksum = deserialization.advance4BytesUInt();
-        if (deserialization.version() >= 0x01000001) {
-            verifiedPagenos.emplace_back((uint32_t) (varint + prePageNo), checksum);
-            prePageNo += varint;
-        } else {
-            verifiedPagenos.emplace_back((uint32_t) varint, checksum);
-        }
+    if (!deserialization.canAdvance(4)) {
+        markAsCorrupt("PageChecksum");
+        return false;
+    }
+    uint32_t checksum = deserialization.advance4BytesUInt();
+    if (deserialization.version() >= 0x01000001) {
+        pages.emplace_back((uint32_t) (varint + prePageNo), checksum);
+        prePageNo += varint;
+    } else {
+        pages.emplace_back((uint32_t) varint, checksum);
     }
     return true;
 }
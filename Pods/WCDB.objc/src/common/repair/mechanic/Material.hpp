@@ -24,9 +24,10 @@
 
 #pragma once
 
-#include "EncryptedSerialization.hpp"
+#include "ChunkedSerialization.hpp"
 #include "StringView.hpp"
 #include "WCDBOptional.hpp"
+#include <functional>
 #include <list>
 #include <map>
 #include <stdlib.h>
@@ -40,8 +41,8 @@ class Deserialization;
 
 namespace Repair {
 
-class Material final : public EncryptedSerializable,
-                       public DecryptedDeserializable,
+class Material final : public ChunkedSerializable,
+                       public ChunkedDeserializable,
                        public CipherDelegateHolder {
 #pragma mark - Serializable
 public:
@@ -51,6 +52,7 @@ public:
     ~Material() override;
 
 protected:
+    bool serializeChunks(ChunkedSerializer &serializer) const override final;
     static bool serializeData(Serialization &serialization, const Data &data);
     static void markAsEmpty(const UnsafeStringView &element);
 
@@ -60,6 +62,8 @@ public:
     using Deserializable::deserialize;
 
 protected:
+    bool isChunkedVersion(uint32_t version) const override final;
+    bool deserializeChunks(ChunkedDeserializer &deserializer) override final;
     static Optional<Data> deserializeData(Deserialization &deserialization);
     static void markAsCorrupt(const UnsafeStringView &element);
     void decryptFail(const UnsafeStringView &element) const override final;
@@ -69,6 +73,9 @@ protected:
 protected:
     static constexpr const uint32_t magic = 0x57434442;
     static constexpr const uint32_t version = 0x01000001; //1.0.0.1
+    // Contents are saved in chunks since 1.0.0.2, while the layout of each content is the same as 1.0.0.1.
+    // Verified pages are saved in the layout of CompactPages since 1.0.0.3.
+    static constexpr const uint32_t chunkedVersion = 0x01000003; //1.0.0.3
     static constexpr const uint8_t saltBytes = 16;
     static constexpr const int headerSize = sizeof(magic) + sizeof(version); //magic + version
 
@@ -107,6 +114,62 @@ public:
         ~Page();
     } Page;
     typedef std::vector<Page> VerifiedPages;
+
+    // Verified pages sorted by number, which are kept as delta-encoded varints of numbers and a separate column of hashes.
+    // The offset of the first page of each block is indexed, so that entries can be serialized without decoding the numbers.
+    class CompactPages final {
+    public:
+        CompactPages();
+
+        static constexpr const size_t blockSize = 64;
+        static constexpr const size_t pagesPerEntry = 4096;
+
+        // Pages are sorted in place, and the deleted ones, whose numbers are 0, are dropped.
+        void assign(VerifiedPages &pages);
+        // Existing pages are replaced by the new ones of the same number.
+        void merge(VerifiedPages &pages);
+        void removeIf(const std::function<bool(const Page &)> &shouldRemove);
+        void clear();
+
+        size_t size() const;
+        bool empty() const;
+
+        class Iterator final {
+        public:
+            Page operator*() const;
+            Iterator &operator++();
+            bool operator!=(const Iterator &other) const;
+
+        protected:
+            friend class CompactPages;
+            Iterator(const CompactPages &pages, size_t index);
+            void decode(uint32_t previousNumber);
+
+            const CompactPages &m_pages;
+            size_t m_index;
+            size_t m_offset;
+            uint32_t m_number;
+        };
+        Iterator begin() const;
+        Iterator end() const;
+
+        // Pages are serialized as entries of up to `pagesPerEntry` pages.
+        // Each entry is made up of the number of pages, the encoded numbers as sized data, and then the hashes.
+        size_t getNumberOfEntries() const;
+        bool serializeEntry(Serialization &serialization, size_t index) const;
+        bool deserializeEntry(Deserialization &deserialization);
+
+    protected:
+        void append(uint32_t number, uint32_t hash);
+        // It returns the length of the varint, or 0 if it's malformed.
+        static int decodeDelta(const unsigned char *numbers, size_t size, size_t offset, uint32_t &delta);
+
+        std::vector<unsigned char> m_numbers;
+        std::vector<uint32_t> m_hashes;
+        std::vector<uint32_t> m_blockOffsets;
+        uint32_t m_lastNumber;
+    };
+
     class Content final : public Serializable, public Deserializable {
     public:
         Content();
@@ -117,14 +180,27 @@ public:
         std::list<StringView> associatedSQLs;
         uint32_t rootPage;
         int64_t sequence;
-        VerifiedPages verifiedPagenos;
+        CompactPages verifiedPagenos;
         bool checked; //It will not be saved to file
 #pragma mark - Serializable
     public:
         bool serialize(Serialization &serialization) const override final;
+        bool serializeChunks(ChunkedSerializer &serializer) const;
+
+    protected:
+        bool serializeHeader(Serialization &serialization, size_t numberOfPages) const;
+        static bool
+        serializePage(Serialization &serialization, const Page &page, uint32_t &prePageNo);
 #pragma mark - Deserializable
     public:
         bool deserialize(Deserialization &deserialization) override final;
+        bool deserializeChunks(ChunkedDeserializer &deserializer);
+
+    protected:
+        Optional<int> deserializeHeader(Deserialization &deserialization);
+        static bool deserializePage(Deserialization &deserialization,
+                                    VerifiedPages &pages,
+                                    uint64_t &prePageNo);
     };
 
     std::list<Content> contentsList;
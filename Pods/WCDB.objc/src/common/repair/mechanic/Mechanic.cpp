@@ -70,6 +70,8 @@ bool Mechanic::work()
     WCTAssert(m_cipherDelegate != nullptr);
     if (m_cipherDelegate->isCipherDB()) {
         m_pager.setCipherContext(m_cipherDelegate->getCipherContext());
+        m_pager.setConcurrentCipherContexts(
+        m_cipherDelegate->getConcurrentCipherContexts(WorkerPoolMaxNumberOfThreads));
     }
 
     if (!m_pager.initialize()) {
@@ -84,6 +86,8 @@ bool Mechanic::work()
     }
 
     m_pager.disposeWal();
+    // The verified pages of each table are visited in ascending order.
+    m_pager.setAccessPattern(FileHandle::Advice::Sequential);
 
     int numberOfPages = 0;
     for (const auto &element : m_material->contentsMap) {
@@ -24,23 +24,40 @@
 
 #include "Cell.hpp"
 #include "Assertion.hpp"
+#include "DecodedCells.hpp"
 #include "Page.hpp"
 #include "Pager.hpp"
 #include "Serialization.hpp"
 #include "StringView.hpp"
-#include <cstring>
-#include <set>
 
 namespace WCDB {
 
 namespace Repair {
 
 Cell::Cell(int pointer, Page *page, Pager *pager)
-: PagerRelated(pager), m_page(page), m_leftChild(0), m_rowid(0), m_pointer(pointer)
+: PagerRelated(pager)
+, m_page(page)
+, m_decodedCells(nullptr)
+, m_index(-1)
+, m_leftChild(0)
+, m_rowid(0)
+, m_pointer(pointer)
 {
     WCTAssert(m_page != nullptr);
 }
 
+Cell::Cell(const DecodedCells &cells, int index, Pager *pager)
+: PagerRelated(pager)
+, m_page(const_cast<Page *>(&cells.getPage()))
+, m_decodedCells(&cells)
+, m_index(index)
+, m_leftChild(0)
+, m_rowid(0)
+, m_pointer(m_page->getCellPointer(index))
+{
+    WCTAssert(cells.isDecoded(index));
+}
+
 Cell::~Cell() = default;
 
 const Page &Cell::getPage() const
@@ -74,6 +91,22 @@ int Cell::isSerialTypeSanity(int serialType)
     return serialType >= 0 && serialType != 10 && serialType != 11;
 }
 
+int Cell::getSerialType(int index) const
+{
+    if (m_decodedCells != nullptr) {
+        return m_decodedCells->getSerialType(m_index, index);
+    }
+    return m_columns[index].first;
+}
+
+int Cell::getOffsetOfValue(int index) const
+{
+    if (m_decodedCells != nullptr) {
+        return m_decodedCells->getOffsetOfValue(m_index, index);
+    }
+    return m_columns[index].second;
+}
+
 uint32_t Cell::getLeftChild() const
 {
     WCTAssert(isInitialized());
@@ -92,15 +125,18 @@ int Cell::getCount() const
 {
     WCTAssert(isInitialized());
     WCTAssert(m_page->getType() != Page::Type::InteriorTable);
+    if (m_decodedCells != nullptr) {
+        return m_decodedCells->getNumberOfColumns(m_index);
+    }
     return (int) m_columns.size();
 }
 
 Cell::Type Cell::getValueType(int index) const
 {
     WCTAssert(isInitialized());
-    WCTAssert(index < m_columns.size());
+    WCTAssert(index < getCount());
     WCTAssert(m_page->getType() != Page::Type::InteriorTable);
-    int serialType = m_columns[index].first;
+    int serialType = getSerialType(index);
     if (serialType == 0) {
         return Type::Null;
     } else if (serialType == 7) {
@@ -125,10 +161,10 @@ int64_t Cell::integerValue(int index) const
 {
     WCTAssert(isInitialized());
     WCTAssert(m_page->getType() != Page::Type::InteriorTable);
-    WCTAssert(index < m_columns.size());
+    WCTAssert(index < getCount());
     WCTAssert(getValueType(index) == Type::Integer);
-    const auto &cell = m_columns[index];
-    int serialType = cell.first;
+    int serialType = getSerialType(index);
+    int offset = getOffsetOfValue(index);
     int64_t value = 0;
     if (serialType == 8) {
         return false;
@@ -136,25 +172,25 @@ int64_t Cell::integerValue(int index) const
         return true;
     } else {
         int length = getLengthOfSerialType(serialType);
-        WCTAssert(m_deserialization.isEnough(cell.second + length));
+        WCTAssert(m_deserialization.isEnough(offset + length));
         switch (length) {
         case 1:
-            value = m_deserialization.get1ByteInt(cell.second);
+            value = m_deserialization.get1ByteInt(offset);
             break;
         case 2:
-            value = m_deserialization.get2BytesInt(cell.second);
+            value = m_deserialization.get2BytesInt(offset);
             break;
         case 3:
-            value = m_deserialization.get3BytesInt(cell.second);
+            value = m_deserialization.get3BytesInt(offset);
             break;
         case 4:
-            value = m_deserialization.get4BytesInt(cell.second);
+            value = m_deserialization.get4BytesInt(offset);
             break;
         case 6:
-            value = m_deserialization.get6BytesInt(cell.second);
+            value = m_deserialization.get6BytesInt(offset);
             break;
         case 8:
-            value = m_deserialization.get8BytesInt(cell.second);
+            value = m_deserialization.get8BytesInt(offset);
             break;
         default:
             WCTAssert(false);
@@ -168,53 +204,61 @@ double Cell::doubleValue(int index) const
 {
     WCTAssert(isInitialized());
     WCTAssert(m_page->getType() != Page::Type::InteriorTable);
-    WCTAssert(index < m_columns.size());
+    WCTAssert(index < getCount());
     WCTAssert(getValueType(index) == Type::Real);
-    const auto &cell = m_columns[index];
-    WCTAssert(m_deserialization.isEnough(cell.second + 8));
-    return m_deserialization.get8BytesDouble(cell.second);
+    int offset = getOffsetOfValue(index);
+    WCTAssert(m_deserialization.isEnough(offset + 8));
+    return m_deserialization.get8BytesDouble(offset);
 }
 
 UnsafeStringView Cell::textValue(int index) const
 {
     WCTAssert(isInitialized());
     WCTAssert(m_page->getType() != Page::Type::InteriorTable);
-    WCTAssert(index < m_columns.size());
+    WCTAssert(index < getCount());
     WCTAssert(getValueType(index) == Type::Text);
-    const auto &cell = m_columns[index];
+    int serialType = getSerialType(index);
+    int offset = getOffsetOfValue(index);
     return UnsafeStringView(
-    reinterpret_cast<const char *>(m_payload.buffer() + cell.second),
-    getLengthOfSerialType(cell.first));
+    reinterpret_cast<const char *>(m_deserialization.data().buffer() + offset),
+    getLengthOfSerialType(serialType));
 }
 
 StringView Cell::stringValue(int index) const
 {
     WCTAssert(isInitialized());
     WCTAssert(m_page->getType() != Page::Type::InteriorTable);
-    WCTAssert(index < m_columns.size());
+    WCTAssert(index < getCount());
     WCTAssert(getValueType(index) == Type::Text);
-    const auto &cell = m_columns[index];
-    int length = getLengthOfSerialType(cell.first);
-    WCTAssert(m_deserialization.isEnough(cell.second + length));
-    return m_deserialization.getString(cell.second, length);
+    int serialType = getSerialType(index);
+    int offset = getOffsetOfValue(index);
+    int length = getLengthOfSerialType(serialType);
+    WCTAssert(m_deserialization.isEnough(offset + length));
+    return m_deserialization.getString(offset, length);
 }
 
 const UnsafeData Cell::blobValue(int index) const
 {
     WCTAssert(isInitialized());
     WCTAssert(m_page->getType() != Page::Type::InteriorTable);
-    WCTAssert(index < m_columns.size());
+    WCTAssert(index < getCount());
     WCTAssert(getValueType(index) == Type::BLOB);
-    const auto &cell = m_columns[index];
-    int size = getLengthOfSerialType(cell.first);
-    WCTAssert(m_deserialization.isEnough(cell.second + size));
-    return m_deserialization.getData(cell.second, size);
+    int serialType = getSerialType(index);
+    int offset = getOffsetOfValue(index);
+    int size = getLengthOfSerialType(serialType);
+    WCTAssert(m_deserialization.isEnough(offset + size));
+    return m_deserialization.getData(offset, size);
 }
 
 #pragma mark - Initializeable
 bool Cell::doInitialize()
 {
     WCTAssert(m_page->getType() != Page::Type::InteriorTable);
+    if (m_decodedCells != nullptr) {
+        m_rowid = m_decodedCells->getRowID(m_index);
+        m_deserialization.reset(m_decodedCells->getPayload(m_index));
+        return true;
+    }
     Deserialization deserialization(m_page->getData());
     int offsetOfPayload = m_pointer;
     deserialization.seek(m_pointer);
@@ -254,18 +298,7 @@ bool Cell::doInitialize()
         return true;
     }
     //parse local
-    int localPayloadSize = 0;
-    if (payloadSize < m_page->getMaxLocal()) {
-        localPayloadSize = payloadSize;
-    } else {
-        int k = m_page->getMinLocal()
-                + (payloadSize - m_page->getMinLocal()) % (m_pager->getUsableSize() - 4);
-        if (k <= m_page->getMaxLocal()) {
-            localPayloadSize = k;
-        } else {
-            localPayloadSize = m_page->getMinLocal();
-        }
-    }
+    int localPayloadSize = m_page->getLocalPayloadSize(payloadSize);
     if (!deserialization.canAdvance(localPayloadSize)) {
         markPagerAsCorrupted(m_page->number, "Unable to deserialize LocalPayloadSize.");
         return false;
@@ -273,70 +306,20 @@ bool Cell::doInitialize()
     //parse payload
     if (localPayloadSize < payloadSize) {
         //append overflow pages
-        deserialization.seek(offsetOfPayload + localPayloadSize);
-        if (!deserialization.canAdvance(4)) {
-            markPagerAsCorrupted(m_page->number, "Unable to deserialize OverflowPageno.");
-            return false;
-        }
-        int overflowPageno = deserialization.advance4BytesInt();
         m_overflowedPayloadHolder = Data(payloadSize);
         if (m_overflowedPayloadHolder.empty()) {
             assignWithSharedThreadedError();
             return false;
         }
-        //fill payload with local data
-        memcpy(m_overflowedPayloadHolder.buffer(),
-               m_page->getData().buffer() + offsetOfPayload,
-               localPayloadSize);
-
-        int cursorOfPayload = localPayloadSize;
-        std::set<int> overflowPagenos;
-        while (overflowPageno > 0 && cursorOfPayload < payloadSize) {
-            if (overflowPagenos.find(overflowPageno) != overflowPagenos.end()) {
-                m_pager->markAsCorrupted(
-                m_page->number,
-                StringView::formatted("Overflow page: %d is redundant.", overflowPageno));
-                return false;
-            }
-            if (overflowPageno > m_pager->getNumberOfPages()) {
-                m_pager->markAsCorrupted(
-                m_page->number,
-                StringView::formatted("Overflow page number: %d exceeds the page count: %d.",
-                                      overflowPageno,
-                                      m_pager->getNumberOfPages()));
-                return false;
-            }
-            overflowPagenos.emplace(overflowPageno);
-            //fill payload with overflow data
-            UnsafeData overflow = m_pager->acquirePageData(overflowPageno);
-            if (overflow.empty()) {
-                return false;
-            }
-            int overflowSize
-            = std::min(payloadSize - cursorOfPayload, m_pager->getUsableSize() - 4);
-            WCTAssert(cursorOfPayload + overflowSize
-                      <= m_overflowedPayloadHolder.size());
-            memcpy(m_overflowedPayloadHolder.buffer() + cursorOfPayload,
-                   overflow.buffer() + 4,
-                   overflowSize);
-            cursorOfPayload += overflowSize;
-            //next overflow page
-            Deserialization overflowDeserialization(overflow);
-            WCTAssert(overflowDeserialization.canAdvance(4));
-            overflowPageno = overflowDeserialization.advance4BytesInt();
-        }
-        if (overflowPageno != 0 || cursorOfPayload != payloadSize) {
-            markPagerAsCorrupted(m_page->number, "Unexpected termination of OverflowPage.");
+        if (!m_page->gatherOverflowedPayload(
+            offsetOfPayload, localPayloadSize, payloadSize, m_overflowedPayloadHolder.buffer())) {
             return false;
         }
-        m_payload = m_overflowedPayloadHolder;
+        m_deserialization.reset(m_overflowedPayloadHolder);
     } else {
         //non-overflow
-        m_nonOverflowedPayloadHolder
-        = m_page->getData().subdata(offsetOfPayload, localPayloadSize);
-        m_payload = m_nonOverflowedPayloadHolder;
+        m_deserialization.reset(m_page->getData().subdata(offsetOfPayload, localPayloadSize));
     }
-    m_deserialization.reset(m_payload);
     //parse value offsets
     int lengthOfOffsetOfValues, offsetOfValues;
     std::tie(lengthOfOffsetOfValues, offsetOfValues) = m_deserialization.advanceVarint();
@@ -34,10 +34,13 @@ namespace WCDB {
 namespace Repair {
 
 class Page;
+class DecodedCells;
 
 class Cell final : public PagerRelated, public Initializeable {
 public:
     Cell(int pointer, Page *page, Pager *pager);
+    // It refers to the cell decoded in bulk, which is valid until the cells are decoded again.
+    Cell(const DecodedCells &cells, int index, Pager *pager);
     ~Cell() override;
 
     const Page &getPage() const;
@@ -60,11 +63,16 @@ public:
     StringView stringValue(int index) const;
     const UnsafeData blobValue(int index) const;
 
-protected:
     static int getLengthOfSerialType(int serialType);
     static int isSerialTypeSanity(int serialType);
 
+protected:
+    int getSerialType(int index) const;
+    int getOffsetOfValue(int index) const;
+
     Page *m_page;
+    const DecodedCells *m_decodedCells;
+    int m_index;
 
     uint32_t m_leftChild;
     int64_t m_rowid;
@@ -72,8 +80,6 @@ protected:
 
     Deserialization m_deserialization;
     Data m_overflowedPayloadHolder;
-    Data m_nonOverflowedPayloadHolder;
-    Data m_payload;
     //serial type -> offset of value
     std::vector<std::pair<int, int>> m_columns;
 
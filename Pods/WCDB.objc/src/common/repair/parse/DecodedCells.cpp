@@ -0,0 +1,101 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DecodedCells.hpp"
+#include "Assertion.hpp"
+#include "Page.hpp"
+
+namespace WCDB {
+
+namespace Repair {
+
+DecodedCells::DecodedCells() : m_page(nullptr)
+{
+    m_columnBegins.push_back(0);
+}
+
+DecodedCells::~DecodedCells() = default;
+
+void DecodedCells::clear()
+{
+    m_page = nullptr;
+    m_rowids.clear();
+    m_states.clear();
+    m_offsetsOfPayload.clear();
+    m_payloadSizes.clear();
+    m_overflowedPayloads.clear();
+    m_columnBegins.resize(1);
+    m_serialTypes.clear();
+    m_offsetsOfValue.clear();
+}
+
+const Page &DecodedCells::getPage() const
+{
+    WCTAssert(m_page != nullptr);
+    return *m_page;
+}
+
+int DecodedCells::getNumberOfCells() const
+{
+    return (int) m_states.size();
+}
+
+bool DecodedCells::isDecoded(int index) const
+{
+    WCTAssert(index < getNumberOfCells());
+    return m_states[index] != State::Failed;
+}
+
+int64_t DecodedCells::getRowID(int index) const
+{
+    WCTAssert(isDecoded(index));
+    return m_rowids[index];
+}
+
+int DecodedCells::getNumberOfColumns(int index) const
+{
+    WCTAssert(index < getNumberOfCells());
+    return m_columnBegins[index + 1] - m_columnBegins[index];
+}
+
+int DecodedCells::getSerialType(int index, int column) const
+{
+    WCTAssert(column < getNumberOfColumns(index));
+    return m_serialTypes[m_columnBegins[index] + column];
+}
+
+int DecodedCells::getOffsetOfValue(int index, int column) const
+{
+    WCTAssert(column < getNumberOfColumns(index));
+    return m_offsetsOfValue[m_columnBegins[index] + column];
+}
+
+const UnsafeData DecodedCells::getPayload(int index) const
+{
+    WCTAssert(isDecoded(index));
+    const unsigned char *base = m_states[index] == State::Overflowed ?
+                                m_overflowedPayloads.data() :
+                                getPage().getData().buffer();
+    return UnsafeData::immutable(base + m_offsetsOfPayload[index], m_payloadSizes[index]);
+}
+
+} //namespace Repair
+
+} //namespace WCDB
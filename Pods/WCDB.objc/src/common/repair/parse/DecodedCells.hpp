@@ -0,0 +1,79 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "UnsafeData.hpp"
+#include <vector>
+
+namespace WCDB {
+
+namespace Repair {
+
+class Page;
+
+// The cells of a leaf page, which are decoded in bulk by Page::decodeCells into flat arrays.
+// The arrays are reused by the following pages, so that no memory is allocated for each cell.
+class DecodedCells final {
+public:
+    DecodedCells();
+    ~DecodedCells();
+    DecodedCells(const DecodedCells &) = delete;
+    DecodedCells &operator=(const DecodedCells &) = delete;
+
+    void clear();
+
+    // The page should be alive during the cells are visited.
+    const Page &getPage() const;
+    int getNumberOfCells() const;
+    // The cells failed to be decoded are marked as corrupted to pager, and they have no column.
+    bool isDecoded(int index) const;
+    int64_t getRowID(int index) const;
+    int getNumberOfColumns(int index) const;
+    int getSerialType(int index, int column) const;
+    // The offset of value within payload.
+    int getOffsetOfValue(int index, int column) const;
+    const UnsafeData getPayload(int index) const;
+
+protected:
+    friend class Page;
+
+    enum State : char {
+        Failed = 0,
+        Local = 1,
+        Overflowed = 2,
+    };
+
+    Page *m_page;
+    std::vector<int64_t> m_rowids;
+    std::vector<State> m_states;
+    // The payload is located in the data of page, or in m_overflowedPayloads if it's overflowed.
+    std::vector<int> m_offsetsOfPayload;
+    std::vector<int> m_payloadSizes;
+    std::vector<unsigned char> m_overflowedPayloads;
+    // The columns of the i-th cell are [m_columnBegins[i], m_columnBegins[i + 1]) of the following ones.
+    std::vector<int> m_columnBegins;
+    std::vector<int> m_serialTypes;
+    std::vector<int> m_offsetsOfValue;
+};
+
+} //namespace Repair
+
+} //namespace WCDB
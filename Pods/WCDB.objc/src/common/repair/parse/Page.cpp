@@ -25,9 +25,12 @@
 #include "Page.hpp"
 #include "Assertion.hpp"
 #include "Cell.hpp"
+#include "DecodedCells.hpp"
 #include "Pager.hpp"
 #include "Serialization.hpp"
 #include "StringView.hpp"
+#include <cstring>
+#include <set>
 
 namespace WCDB {
 
@@ -146,6 +149,13 @@ Cell Page::getCell(int index)
     return Cell(m_cellPointers[index], this, m_pager);
 }
 
+int Page::getCellPointer(int index) const
+{
+    WCTAssert(isInitialized());
+    WCTAssert(index < getNumberOfCells());
+    return m_cellPointers[index];
+}
+
 int Page::getNumberOfCells() const
 {
     WCTAssert(isInitialized());
@@ -169,6 +179,204 @@ int Page::getMinLocal() const
     return (m_pager->getUsableSize() - 12) * 32 / 255 - 23;
 }
 
+int Page::getLocalPayloadSize(int payloadSize) const
+{
+    if (payloadSize < getMaxLocal()) {
+        return payloadSize;
+    }
+    int k = getMinLocal() + (payloadSize - getMinLocal()) % (m_pager->getUsableSize() - 4);
+    return k <= getMaxLocal() ? k : getMinLocal();
+}
+
+bool Page::gatherOverflowedPayload(int offsetOfPayload,
+                                   int localPayloadSize,
+                                   int payloadSize,
+                                   unsigned char *payload)
+{
+    WCTAssert(localPayloadSize < payloadSize);
+    int offsetOfOverflowPageno = offsetOfPayload + localPayloadSize;
+    if (!m_deserialization.isEnough(offsetOfOverflowPageno + 4)) {
+        markPagerAsCorrupted(number, "Unable to deserialize OverflowPageno.");
+        return false;
+    }
+    int overflowPageno = m_deserialization.get4BytesInt(offsetOfOverflowPageno);
+    //fill payload with local data
+    memcpy(payload, m_data.buffer() + offsetOfPayload, localPayloadSize);
+
+    int cursorOfPayload = localPayloadSize;
+    std::set<int> overflowPagenos;
+    while (overflowPageno > 0 && cursorOfPayload < payloadSize) {
+        if (overflowPagenos.find(overflowPageno) != overflowPagenos.end()) {
+            markPagerAsCorrupted(
+            number, StringView::formatted("Overflow page: %d is redundant.", overflowPageno));
+            return false;
+        }
+        if (overflowPageno > m_pager->getNumberOfPages()) {
+            markPagerAsCorrupted(
+            number,
+            StringView::formatted("Overflow page number: %d exceeds the page count: %d.",
+                                  overflowPageno,
+                                  m_pager->getNumberOfPages()));
+            return false;
+        }
+        overflowPagenos.emplace(overflowPageno);
+        //fill payload with overflow data
+        UnsafeData overflow = m_pager->acquirePageData(overflowPageno);
+        if (overflow.empty()) {
+            return false;
+        }
+        int overflowSize = std::min(payloadSize - cursorOfPayload, m_pager->getUsableSize() - 4);
+        memcpy(payload + cursorOfPayload, overflow.buffer() + 4, overflowSize);
+        cursorOfPayload += overflowSize;
+        //next overflow page
+        Deserialization overflowDeserialization(overflow);
+        WCTAssert(overflowDeserialization.canAdvance(4));
+        overflowPageno = overflowDeserialization.advance4BytesInt();
+    }
+    if (overflowPageno != 0 || cursorOfPayload != payloadSize) {
+        markPagerAsCorrupted(number, "Unexpected termination of OverflowPage.");
+        return false;
+    }
+    return true;
+}
+
+bool Page::decodeCells(DecodedCells &cells)
+{
+    WCTAssert(isInitialized());
+    WCTAssert(isLeafPage());
+    cells.clear();
+    cells.m_page = this;
+    int numberOfCells = getNumberOfCells();
+    cells.m_rowids.reserve(numberOfCells);
+    cells.m_states.reserve(numberOfCells);
+    cells.m_offsetsOfPayload.reserve(numberOfCells);
+    cells.m_payloadSizes.reserve(numberOfCells);
+    cells.m_columnBegins.reserve(numberOfCells + 1);
+    bool succeed = true;
+    for (int i = 0; i < numberOfCells; ++i) {
+        size_t numberOfColumns = cells.m_serialTypes.size();
+        size_t sizeOfOverflowedPayloads = cells.m_overflowedPayloads.size();
+        cells.m_rowids.push_back(0);
+        cells.m_states.push_back(DecodedCells::State::Failed);
+        cells.m_offsetsOfPayload.push_back(0);
+        cells.m_payloadSizes.push_back(0);
+        if (!decodeCell(i, cells)) {
+            cells.m_states.back() = DecodedCells::State::Failed;
+            cells.m_serialTypes.resize(numberOfColumns);
+            cells.m_offsetsOfValue.resize(numberOfColumns);
+            cells.m_overflowedPayloads.resize(sizeOfOverflowedPayloads);
+            succeed = false;
+        }
+        cells.m_columnBegins.push_back((int) cells.m_serialTypes.size());
+    }
+    return succeed;
+}
+
+bool Page::decodeCell(int index, DecodedCells &cells)
+{
+    // See Cell::doInitialize for the layout.
+    int cursor = m_cellPointers[index];
+
+    //parse payload size
+    size_t lengthOfPayloadSize;
+    int payloadSize;
+    std::tie(lengthOfPayloadSize, payloadSize) = m_deserialization.getVarint(cursor);
+    if (lengthOfPayloadSize == 0) {
+        markPagerAsCorrupted(number, "Unable to deserialize PayloadSize.");
+        return false;
+    }
+    cursor += (int) lengthOfPayloadSize;
+    //parse rowid
+    if (isTablePage()) {
+        size_t lengthOfRowid;
+        uint64_t rowid;
+        std::tie(lengthOfRowid, rowid) = m_deserialization.getVarint(cursor);
+        if (lengthOfRowid == 0) {
+            markPagerAsCorrupted(number, "Unable to deserialize Rowid.");
+            return false;
+        }
+        cursor += (int) lengthOfRowid;
+        cells.m_rowids.back() = (int64_t) rowid;
+    }
+    //parse local
+    int offsetOfPayload = cursor;
+    int localPayloadSize = getLocalPayloadSize(payloadSize);
+    if (localPayloadSize < 0
+        || !m_deserialization.isEnough((size_t) offsetOfPayload + localPayloadSize)) {
+        markPagerAsCorrupted(number, "Unable to deserialize LocalPayloadSize.");
+        return false;
+    }
+    //parse payload
+    const unsigned char *payload = nullptr;
+    if (localPayloadSize < payloadSize) {
+        // The buffer is shared by all cells of page, so the size should be checked before allocating.
+        if ((int64_t) (payloadSize - localPayloadSize)
+            > (int64_t) m_pager->getNumberOfPages() * (m_pager->getUsableSize() - 4)) {
+            markPagerAsCorrupted(number, "Unexpected termination of OverflowPage.");
+            return false;
+        }
+        size_t offsetOfOverflowedPayload = cells.m_overflowedPayloads.size();
+        cells.m_overflowedPayloads.resize(offsetOfOverflowedPayload + payloadSize);
+        unsigned char *overflowedPayload
+        = cells.m_overflowedPayloads.data() + offsetOfOverflowedPayload;
+        if (!gatherOverflowedPayload(
+            offsetOfPayload, localPayloadSize, payloadSize, overflowedPayload)) {
+            return false;
+        }
+        payload = overflowedPayload;
+        cells.m_states.back() = DecodedCells::State::Overflowed;
+        cells.m_offsetsOfPayload.back() = (int) offsetOfOverflowedPayload;
+    } else {
+        payload = m_data.buffer() + offsetOfPayload;
+        cells.m_states.back() = DecodedCells::State::Local;
+        cells.m_offsetsOfPayload.back() = offsetOfPayload;
+    }
+    cells.m_payloadSizes.back() = payloadSize;
+
+    //parse value offsets
+    Deserialization deserialization(UnsafeData::immutable(payload, payloadSize));
+    size_t lengthOfOffsetOfValues;
+    uint64_t offsetOfValues;
+    std::tie(lengthOfOffsetOfValues, offsetOfValues) = deserialization.getVarint(0);
+    if (lengthOfOffsetOfValues == 0) {
+        markPagerAsCorrupted(number, "Unable to deserialize CellValueOffset.");
+        return false;
+    }
+
+    int cursorOfSerialTypes = (int) lengthOfOffsetOfValues;
+    int cursorOfValues = (int) offsetOfValues;
+    const int endOfValues = payloadSize;
+    const int endOfSerialTypes = (int) offsetOfValues;
+    while (cursorOfSerialTypes < endOfSerialTypes) {
+        size_t lengthOfSerialType;
+        uint64_t value;
+        std::tie(lengthOfSerialType, value) = deserialization.getVarint(cursorOfSerialTypes);
+        int serialType = (int) value;
+        if (lengthOfSerialType == 0) {
+            markPagerAsCorrupted(number, "Unable to deserialize SerialType.");
+            return false;
+        }
+        if (!Cell::isSerialTypeSanity(serialType)) {
+            markPagerAsCorrupted(
+            number, StringView::formatted("Serial type: %d is illegal.", serialType));
+            return false;
+        }
+        cursorOfSerialTypes += (int) lengthOfSerialType;
+        cells.m_serialTypes.push_back(serialType);
+        cells.m_offsetsOfValue.push_back(cursorOfValues);
+        cursorOfValues += Cell::getLengthOfSerialType(serialType);
+        if (cursorOfValues > endOfValues) {
+            markPagerAsCorrupted(number, "Unexpected termination of Payload.");
+            return false;
+        }
+    }
+    if (cursorOfSerialTypes != endOfSerialTypes || cursorOfValues != endOfValues) {
+        markPagerAsCorrupted(number, "Unexpected termination of Payload.");
+        return false;
+    }
+    return true;
+}
+
 #pragma mark - Common
 int Page::getOffsetOfCellPointer() const
 {
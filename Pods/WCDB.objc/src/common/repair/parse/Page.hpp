@@ -35,6 +35,7 @@ namespace WCDB {
 namespace Repair {
 
 class Cell;
+class DecodedCells;
 
 class Page final : public PagerRelated, public Initializeable {
 #pragma mark - Initialize
@@ -81,10 +82,26 @@ protected:
 #pragma mark - Leaf Table
 public:
     Cell getCell(int index);
+    // The offset of the cell in page, which is not parsed.
+    int getCellPointer(int index) const;
     int getNumberOfCells() const;
     int getMaxLocal() const;
     int getMinLocal() const;
 
+    // All cells of the leaf page are decoded at once into the reusable arrays, instead of initializing a Cell for each of them.
+    // It returns false if any of them fails, while the others are still decoded.
+    bool decodeCells(DecodedCells &cells);
+
+protected:
+    friend class Cell;
+    bool decodeCell(int index, DecodedCells &cells);
+    int getLocalPayloadSize(int payloadSize) const;
+    // Local payload is copied to the buffer, followed by the overflow pages.
+    bool gatherOverflowedPayload(int offsetOfPayload,
+                                 int localPayloadSize,
+                                 int payloadSize,
+                                 unsigned char *payload);
+
 #pragma mark - Common
 protected:
     int getOffsetOfHeader() const;
@@ -0,0 +1,125 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PageArena.hpp"
+#include "Assertion.hpp"
+#include <mutex>
+#include <stdlib.h>
+#include <vector>
+
+namespace WCDB {
+
+namespace Repair {
+
+#pragma mark - Pool
+class PageArena::Pool final {
+public:
+    Pool(size_t pageSize, SharedHighWater highWater)
+    : m_pageSize(pageSize), m_highWater(highWater)
+    {
+    }
+
+    ~Pool()
+    {
+        for (unsigned char* block : m_blocks) {
+            free(block);
+        }
+    }
+
+    unsigned char* acquire()
+    {
+        std::lock_guard<std::mutex> lockGuard(m_lock);
+        if (m_frees.empty()) {
+            unsigned char* block = (unsigned char*) malloc(
+            m_pageSize * numberOfPagesPerBlock * sizeof(unsigned char));
+            if (block == nullptr) {
+                return nullptr;
+            }
+            m_blocks.push_back(block);
+            // pop from the back in the order of address
+            for (size_t i = numberOfPagesPerBlock; i > 0; --i) {
+                m_frees.push_back(block + (i - 1) * m_pageSize);
+            }
+        }
+        unsigned char* buffer = m_frees.back();
+        m_frees.pop_back();
+        if (m_highWater != nullptr) {
+            m_highWater->increase(m_pageSize);
+        }
+        return buffer;
+    }
+
+    void recycle(unsigned char* buffer)
+    {
+        std::lock_guard<std::mutex> lockGuard(m_lock);
+        m_frees.push_back(buffer);
+        if (m_highWater != nullptr) {
+            m_highWater->decrease(m_pageSize);
+        }
+    }
+
+    const size_t m_pageSize;
+
+protected:
+    SharedHighWater m_highWater;
+    std::mutex m_lock;
+    std::vector<unsigned char*> m_blocks;
+    std::vector<unsigned char*> m_frees;
+};
+
+#pragma mark - Page
+class PageArena::Page final : public UnsafeData {
+public:
+    Page(unsigned char* buffer, const std::shared_ptr<Pool>& pool)
+    : UnsafeData(buffer,
+                 pool->m_pageSize,
+                 makeSharedBuffer(buffer, pool->m_pageSize, [pool](SharedData& data) {
+                     pool->recycle(data.buffer);
+                 }))
+    {
+    }
+};
+
+#pragma mark - PageArena
+PageArena::PageArena(size_t pageSize, SharedHighWater highWater)
+: m_pool(std::make_shared<Pool>(pageSize, highWater))
+{
+    WCTAssert(pageSize > 0);
+}
+
+PageArena::~PageArena() = default;
+
+UnsafeData PageArena::allocatePage()
+{
+    unsigned char* buffer = m_pool->acquire();
+    if (buffer == nullptr) {
+        return UnsafeData();
+    }
+    return Page(buffer, m_pool);
+}
+
+size_t PageArena::getPageSize() const
+{
+    return m_pool->m_pageSize;
+}
+
+} //namespace Repair
+
+} //namespace WCDB
@@ -0,0 +1,60 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "HighWater.hpp"
+#include "UnsafeData.hpp"
+#include <memory>
+
+namespace WCDB {
+
+namespace Repair {
+
+/*
+ It allocates buffers of the same page size out of large blocks, and reuses a buffer once all the references to it are released.
+ It saves a malloc and a free for each page decoded in batch, and keeps the pages decoded together close in memory.
+ The blocks are kept until both the arena and all the pages allocated from it are released, so that the peak usage, which is bounded by the caches of pager, is reserved.
+ */
+class PageArena final {
+public:
+    PageArena(size_t pageSize, SharedHighWater highWater = nullptr);
+    ~PageArena();
+
+    PageArena() = delete;
+    PageArena(const PageArena&) = delete;
+    PageArena& operator=(const PageArena&) = delete;
+
+    // It's thread-safe, and returns null data quietly if it runs out of memory.
+    UnsafeData allocatePage();
+
+    size_t getPageSize() const;
+
+    static constexpr const size_t numberOfPagesPerBlock = 32;
+
+protected:
+    class Pool;
+    class Page;
+    std::shared_ptr<Pool> m_pool;
+};
+
+} //namespace Repair
+
+} //namespace WCDB
@@ -27,12 +27,19 @@
 #include "CoreConst.h"
 #include "Notifier.hpp"
 #include "WCDBError.hpp"
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
 
 namespace WCDB {
 
 #pragma mark - PageBasedFileHandle
 PageBasedFileHandle::PageBasedFileHandle(const UnsafeStringView& path)
-: FileHandle(path), m_pageSize(0), m_cache(maxAllowedCacheMemory), m_cachePageSize(0)
+: FileHandle(path)
+, m_pageSize(0)
+, m_accessPattern(Advice::Normal)
+, m_cache(maxAllowedCacheMemory)
+, m_cachePageSize(0)
 {
     static_assert(maxAllowedCacheMemory % cacheMemoryPerRange == 0, "");
     static_assert((maxAllowedCacheMemory & maxAllowedCacheMemory - 1) == 0, "");
@@ -68,6 +75,15 @@ MappedData PageBasedFileHandle::mapPage(int pageno,
     WCTAssert(m_cachePageSize >= m_pageSize);
 
     offset_t offset = (pageno - 1) * m_pageSize + offsetWithinPage;
+    ++m_statistics.numberOfMappedPages;
+
+    if (!m_whole.empty()) {
+        if (offset >= (offset_t) m_whole.size()) {
+            return MappedData::null();
+        }
+        // It's shorter than expected if the file ends early, which is the same as ranges.
+        return m_whole.subdata(offset, std::min<size_t>(sizeWithinPage, m_whole.size() - offset));
+    }
     offset_t cachePageno = offset / m_cachePageSize;
 
     // assert same cache page
@@ -100,6 +116,10 @@ MappedData PageBasedFileHandle::mapPage(int pageno,
         markErrorAsIgnorable(false);
 
         if (!mappedData.empty()) {
+            ++m_statistics.numberOfMaps;
+            if (m_accessPattern != Advice::Normal) {
+                advise(mappedData, m_accessPattern);
+            }
             m_cache.insert(range, mappedData);
             offset_t offsetWithinCache = offset - range.location * m_cachePageSize;
             WCTAssert(offsetWithinCache < range.length * m_cachePageSize);
@@ -126,6 +146,14 @@ MappedData PageBasedFileHandle::mapPage(int pageno, SharedHighWater highWater)
     return mapPage(pageno, 0, m_pageSize, highWater);
 }
 
+bool PageBasedFileHandle::readPageQuietly(int pageno, UnsafeData& buffer) const
+{
+    WCTAssert(pageno > 0);
+    WCTAssert(m_pageSize > 0 && buffer.size() == m_pageSize);
+    return positionalRead(buffer.buffer(), m_pageSize, (offset_t) (pageno - 1) * m_pageSize)
+           == (ssize_t) m_pageSize;
+}
+
 size_t PageBasedFileHandle::cachePagePerRange() const
 {
     WCTAssert(m_cachePageSize != 0);
@@ -149,6 +177,127 @@ void PageBasedFileHandle::setPageSize(size_t pageSize)
     Range::Length restrictCachePageno
     = fileSize / m_cachePageSize + (fileSize % m_cachePageSize > 0);
     m_cache.setRange(Range(0, restrictCachePageno));
+
+    getFaults(m_statistics.minorFaults, m_statistics.majorFaults);
+    tryMapWhole(fileSize);
+}
+
+#pragma mark - Mapping
+void PageBasedFileHandle::setAccessPattern(Advice advice)
+{
+    WCTAssert(advice == Advice::Normal || advice == Advice::Sequential
+              || advice == Advice::Random);
+    if (m_accessPattern == advice) {
+        return;
+    }
+    m_accessPattern = advice;
+    if (!m_whole.empty()) {
+        advise(m_whole, m_accessPattern);
+    } else if (isOpened()) {
+        // The prefetched pages are read by positional read, which follows the readahead of the file rather than the mapped ranges.
+        advise(0, 0, m_accessPattern);
+    }
+}
+
+bool PageBasedFileHandle::isWholeMapped() const
+{
+    return !m_whole.empty();
+}
+
+bool PageBasedFileHandle::isWholeMappable(size_t fileSize)
+{
+#if defined(__linux__) || defined(__APPLE__)
+    // The address space of 32-bit process is too small to be shared with the file.
+    if (sizeof(void*) < 8 || fileSize == 0 || fileSize > maxWholeMappedSize) {
+        return false;
+    }
+#ifdef __linux__
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_AS, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY
+        && fileSize > limit.rlim_cur / 4) {
+        return false;
+    }
+#endif
+    return true;
+#else
+    WCDB_UNUSED(fileSize);
+    return false;
+#endif
+}
+
+bool PageBasedFileHandle::tryMapWhole(size_t fileSize)
+{
+    WCTAssert(m_whole.empty());
+    if (!isWholeMappable(fileSize)) {
+        return false;
+    }
+    // It's fine to fall back to the ranges.
+    markErrorAsIgnorable(true);
+    m_whole = map(0, fileSize);
+    markErrorAsIgnorable(false);
+    if (m_whole.size() != fileSize) {
+        m_whole = MappedData::null();
+        return false;
+    }
+    ++m_statistics.numberOfMaps;
+    if (m_accessPattern != Advice::Normal) {
+        advise(m_whole, m_accessPattern);
+    }
+    return true;
+}
+
+void PageBasedFileHandle::getFaults(uint64_t& minorFaults, uint64_t& majorFaults)
+{
+    minorFaults = 0;
+    majorFaults = 0;
+#ifndef _WIN32
+    struct rusage usage;
+#ifdef RUSAGE_THREAD
+    int who = RUSAGE_THREAD;
+#else
+    // RUSAGE_THREAD is missing on Darwin, where the faults of the whole process are counted.
+    int who = RUSAGE_SELF;
+#endif
+    if (getrusage(who, &usage) == 0) {
+        minorFaults = usage.ru_minflt;
+        majorFaults = usage.ru_majflt;
+    }
+#endif
+}
+
+PageBasedFileHandle::Statistics::Statistics()
+: numberOfMaps(0)
+, numberOfUnmaps(0)
+, numberOfMappedPages(0)
+, minorFaults(0)
+, majorFaults(0)
+, wholeMapped(false)
+{
+}
+
+double PageBasedFileHandle::Statistics::faultRate() const
+{
+    return numberOfMappedPages > 0 ? (double) (minorFaults + majorFaults) / numberOfMappedPages : 0;
+}
+
+PageBasedFileHandle::Statistics PageBasedFileHandle::getStatistics() const
+{
+    Statistics statistics = m_statistics;
+    statistics.numberOfUnmaps = m_cache.getNumberOfPurged();
+    statistics.wholeMapped = isWholeMapped();
+    if (m_cachePageSize == 0) {
+        statistics.minorFaults = 0;
+        statistics.majorFaults = 0;
+        return statistics;
+    }
+    uint64_t minorFaults;
+    uint64_t majorFaults;
+    getFaults(minorFaults, majorFaults);
+    statistics.minorFaults
+    = minorFaults > m_statistics.minorFaults ? minorFaults - m_statistics.minorFaults : 0;
+    statistics.majorFaults
+    = majorFaults > m_statistics.majorFaults ? majorFaults - m_statistics.majorFaults : 0;
+    return statistics;
 }
 
 #pragma mark - Cache
@@ -171,6 +320,7 @@ PageBasedFileHandle::Cache::Cache(size_t maxAllowedMemory)
 , m_range(Range::notFound())
 , m_maxAllowedMemory(maxAllowedMemory)
 , m_currentUsedMemery(0)
+, m_numberOfPurged(0)
 {
 }
 
@@ -247,6 +397,12 @@ void PageBasedFileHandle::Cache::willPurge(const Range& range, const MappedData&
 {
     WCDB_UNUSED(range);
     m_currentUsedMemery -= data.size();
+    ++m_numberOfPurged;
+}
+
+uint64_t PageBasedFileHandle::Cache::getNumberOfPurged() const
+{
+    return m_numberOfPurged;
 }
 
 PageBasedFileHandle::Cache::MapIterator
@@ -40,6 +40,8 @@ public:
     MappedData
     mapPage(int pageno, offset_t offset, size_t size, SharedHighWater highWater = nullptr);
     MappedData mapPage(int pageno, SharedHighWater highWater = nullptr);
+    // It reads the page into the buffer of page size by positional read without reporting any error, which is thread-safe and is used for prefetching.
+    bool readPageQuietly(int pageno, UnsafeData& buffer) const;
 
 protected:
     static Range
@@ -53,8 +55,47 @@ public:
 protected:
     size_t m_pageSize;
 
+#pragma mark - Mapping
+public:
+    // The whole file is mapped read-only in setPageSize if the address space allows. Otherwise, it falls back to map the ranges around the acquired pages on demand.
+    // The advice is applied to the whole mapping immediately, or to the file and the ranges mapped later.
+    void setAccessPattern(Advice advice);
+    bool isWholeMapped() const;
+
+    struct Statistics {
+        Statistics();
+        uint64_t numberOfMaps;
+        // Ranges are counted when they are purged by the handle. They are unmapped actually after the pages referring to them are released.
+        uint64_t numberOfUnmaps;
+        uint64_t numberOfMappedPages;
+        // Page faults since the page size is set. They are counted for the calling thread if the platform supports, or for the whole process.
+        uint64_t minorFaults;
+        uint64_t majorFaults;
+        bool wholeMapped;
+        // Faults per mapped page.
+        double faultRate() const;
+    };
+    Statistics getStatistics() const;
+
+protected:
+#ifdef __APPLE__
+    // The virtual address space of iOS app is a few GB, and RLIMIT_AS doesn't reflect it.
+    static constexpr const uint64_t maxWholeMappedSize = 256ULL * 1024 * 1024;
+#else
+    static constexpr const uint64_t maxWholeMappedSize = 4ULL * 1024 * 1024 * 1024;
+#endif
+    static bool isWholeMappable(size_t fileSize);
+    static void getFaults(uint64_t& minorFaults, uint64_t& majorFaults);
+    bool tryMapWhole(size_t fileSize);
+
+    Advice m_accessPattern;
+    // The whole mapping is not counted by the high water, since it's backed by file and can be reclaimed by the system at any time.
+    MappedData m_whole;
+    Statistics m_statistics;
+
 #pragma mark - Cache
 public:
+    // The whole mapping is kept since it's never remapped. Only the ranges are purged.
     void purgeAll();
     bool purgeOne();
 
@@ -77,6 +118,7 @@ protected:
         void setRange(const Range& range);
         std::pair<Range, const MappedData*> find(Location location);
         void insert(const Range& range, const MappedData& data);
+        uint64_t getNumberOfPurged() const;
 
     protected:
         MapIterator findIterator(Location location);
@@ -86,6 +128,7 @@ protected:
         void willPurge(const Range& range, const MappedData& data) override final;
         size_t m_maxAllowedMemory;
         size_t m_currentUsedMemery;
+        uint64_t m_numberOfPurged;
     };
 
     Cache m_cache;
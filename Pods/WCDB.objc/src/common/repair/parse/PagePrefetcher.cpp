@@ -0,0 +1,166 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PagePrefetcher.hpp"
+#include "Assertion.hpp"
+#include "Thread.hpp"
+#include <algorithm>
+
+namespace WCDB {
+
+namespace Repair {
+
+PagePrefetcher::PagePrefetcher(const Fetcher& fetcher)
+: m_fetcher(fetcher), m_cursor(0), m_stopped(false)
+{
+    WCTAssert(m_fetcher != nullptr);
+    m_thread = std::thread(&PagePrefetcher::loop, this);
+}
+
+PagePrefetcher::~PagePrefetcher()
+{
+    {
+        std::lock_guard<std::mutex> lockGuard(m_lock);
+        m_stopped = true;
+    }
+    m_cond.notify_all();
+    m_thread.join();
+}
+
+void PagePrefetcher::hint(const Pagenos& pagenos, size_t from)
+{
+    {
+        std::lock_guard<std::mutex> lockGuard(m_lock);
+        m_pagenos = pagenos;
+        m_cursor = from;
+        m_failed.clear();
+    }
+    m_cond.notify_all();
+}
+
+void PagePrefetcher::advance(size_t from)
+{
+    {
+        std::lock_guard<std::mutex> lockGuard(m_lock);
+        m_cursor = from;
+    }
+    m_cond.notify_all();
+}
+
+UnsafeData PagePrefetcher::take(int pageno)
+{
+    std::unique_lock<std::mutex> lockGuard(m_lock);
+    m_cond.wait(lockGuard, [this, pageno]() {
+        return m_fetching.find(pageno) == m_fetching.end();
+    });
+    auto iter = m_ready.find(pageno);
+    if (iter == m_ready.end()) {
+        return UnsafeData();
+    }
+    UnsafeData data = std::move(iter->second);
+    m_ready.erase(iter);
+    lockGuard.unlock();
+    // there is room to prefetch more
+    m_cond.notify_all();
+    return data;
+}
+
+void PagePrefetcher::loop()
+{
+    Thread::setName("WCDB.Prefetch");
+    while (true) {
+        std::vector<int> pagenos;
+        {
+            std::unique_lock<std::mutex> lockGuard(m_lock);
+            m_cond.wait(lockGuard, [this, &pagenos]() {
+                if (m_stopped) {
+                    return true;
+                }
+                pagenos = nextPagenosToFetch();
+                return !pagenos.empty();
+            });
+            if (m_stopped) {
+                break;
+            }
+            m_fetching.insert(pagenos.begin(), pagenos.end());
+        }
+        std::vector<UnsafeData> datas = m_fetcher(pagenos);
+        WCTAssert(datas.size() == pagenos.size());
+        {
+            std::lock_guard<std::mutex> lockGuard(m_lock);
+            m_fetching.clear();
+            for (size_t i = 0; i < pagenos.size(); ++i) {
+                if (i < datas.size() && !datas[i].empty()) {
+                    m_ready[pagenos[i]] = std::move(datas[i]);
+                } else {
+                    m_failed.insert(pagenos[i]);
+                }
+            }
+        }
+        m_cond.notify_all();
+    }
+}
+
+std::vector<int> PagePrefetcher::nextPagenosToFetch()
+{
+    std::vector<int> pagenos;
+    if (m_pagenos == nullptr) {
+        return pagenos;
+    }
+    tryEvict();
+    if (m_ready.size() >= 2 * numberOfPagesAhead) {
+        return pagenos;
+    }
+    size_t room = std::min(2 * numberOfPagesAhead - m_ready.size(), maxNumberOfPagesPerFetch);
+    size_t end = std::min(m_cursor + numberOfPagesAhead, m_pagenos->size());
+    for (size_t i = m_cursor; i < end && pagenos.size() < room; ++i) {
+        int pageno = (*m_pagenos)[i];
+        if (pageno > 0 && m_ready.find(pageno) == m_ready.end()
+            && m_failed.find(pageno) == m_failed.end()
+            && std::find(pagenos.begin(), pagenos.end(), pageno) == pagenos.end()) {
+            pagenos.push_back(pageno);
+        }
+    }
+    return pagenos;
+}
+
+void PagePrefetcher::tryEvict()
+{
+    if (m_ready.size() < 2 * numberOfPagesAhead) {
+        return;
+    }
+    // The pages out of the window are skipped by the crawler or hinted by the previous interior page.
+    std::set<int> window;
+    size_t end = std::min(m_cursor + numberOfPagesAhead, m_pagenos->size());
+    for (size_t i = m_cursor; i < end; ++i) {
+        window.insert((*m_pagenos)[i]);
+    }
+    for (auto iter = m_ready.begin(); iter != m_ready.end();) {
+        if (window.find(iter->first) == window.end()) {
+            iter = m_ready.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+}
+
+} //namespace Repair
+
+} //namespace WCDB
@@ -0,0 +1,85 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "UnsafeData.hpp"
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace WCDB {
+
+namespace Repair {
+
+/*
+ It reads the pages that the crawler is about to visit on a background thread, so that they are ready when acquired.
+ The crawler hints the child pages of the interior page and the index of the one it's going to visit, and the next few pages from it are prefetched.
+ Pages are fetched in small batches, so that the fetcher can read and decode them concurrently.
+ It's best-effort. The pages that are failed to prefetch or not prefetched in time are just acquired as usual.
+ */
+class PagePrefetcher final {
+public:
+    // It runs on the background thread, and returns the data of each page in order, which is null if failed.
+    typedef std::function<std::vector<UnsafeData>(const std::vector<int>& pagenos)> Fetcher;
+    PagePrefetcher(const Fetcher& fetcher);
+    ~PagePrefetcher();
+
+    PagePrefetcher() = delete;
+    PagePrefetcher(const PagePrefetcher&) = delete;
+    PagePrefetcher& operator=(const PagePrefetcher&) = delete;
+
+    // The page numbers that are not positive are skipped.
+    typedef std::shared_ptr<const std::vector<int>> Pagenos;
+    void hint(const Pagenos& pagenos, size_t from);
+    void advance(size_t from);
+
+    // It waits if the page is being prefetched, and returns null data if the page is not prefetched.
+    UnsafeData take(int pageno);
+
+    static constexpr const size_t numberOfPagesAhead = 32;
+    static constexpr const size_t maxNumberOfPagesPerFetch = 8;
+
+protected:
+    void loop();
+    std::vector<int> nextPagenosToFetch();
+    void tryEvict();
+
+    const Fetcher m_fetcher;
+
+    std::mutex m_lock;
+    std::condition_variable m_cond;
+    Pagenos m_pagenos;
+    size_t m_cursor;
+    std::set<int> m_fetching;
+    std::map<int, UnsafeData> m_ready;
+    std::set<int> m_failed;
+    bool m_stopped;
+    std::thread m_thread;
+};
+
+} //namespace Repair
+
+} //namespace WCDB
@@ -31,6 +31,7 @@
 #include "Serialization.hpp"
 #include "StringView.hpp"
 #include "ThreadedErrors.hpp"
+#include "WorkerPool.hpp"
 #include <cstring>
 
 namespace WCDB {
@@ -74,6 +75,22 @@ void Pager::setCipherContext(void* ctx)
     m_pCodec = ctx;
 }
 
+void Pager::setConcurrentCipherContexts(const std::vector<void*>& ctxs)
+{
+    WCTAssert(m_prefetcher == nullptr);
+    m_pConcurrentCodecs.clear();
+    for (void* ctx : ctxs) {
+        if (ctx != nullptr && ctx != m_pCodec) {
+            m_pConcurrentCodecs.push_back(ctx);
+        }
+    }
+}
+
+void Pager::setAccessPattern(FileHandle::Advice advice)
+{
+    m_fileHandle.setAccessPattern(advice);
+}
+
 const StringView& Pager::getPath() const
 {
     return m_fileHandle.path;
@@ -124,6 +141,7 @@ UnsafeData Pager::acquirePageData(int number, offset_t offset, size_t size)
         return m_cache.get(number).subdata(offset, size);
     }
     UnsafeData data;
+    bool prefetched = false;
     if (m_wal.containsPage(number)) {
         data = m_wal.acquirePageData(number, m_highWater);
     } else {
@@ -134,7 +152,13 @@ UnsafeData Pager::acquirePageData(int number, offset_t offset, size_t size)
             "Acquired page number: %d exceeds the page count: %d.", number, m_numberOfPages));
             return MappedData::null();
         }
-        data = m_fileHandle.mapPage(number, m_highWater);
+        if (m_prefetcher != nullptr) {
+            data = m_prefetcher->take(number);
+            prefetched = !data.empty();
+        }
+        if (!prefetched) {
+            data = m_fileHandle.mapPage(number, m_highWater);
+        }
     }
     if (data.size() != m_pageSize) {
         if (data.size() > 0) {
@@ -148,7 +172,8 @@ UnsafeData Pager::acquirePageData(int number, offset_t offset, size_t size)
         }
         return MappedData::null();
     }
-    if (m_pCodec) {
+    if (m_pCodec && !prefetched) {
+        std::lock_guard<std::mutex> lockGuard(m_codecLock);
         void* decodedBuffer = sqlite3Codec(m_pCodec, data.buffer(), number, 4);
         if (decodedBuffer == nullptr) {
             markAsCorrupted(number, "Decode page data fail!");
@@ -191,6 +216,75 @@ UnsafeData Pager::acquireHeader()
     return data;
 }
 
+#pragma mark - Prefetch
+void Pager::prefetchPages(const PagePrefetcher::Pagenos& pagenos, size_t from)
+{
+    WCTAssert(isInitialized());
+    WCTAssert(pagenos != nullptr);
+    if (m_numberOfPages <= (int) PagePrefetcher::numberOfPagesAhead) {
+        // small enough to be cached
+        return;
+    }
+    if (m_pCodec == nullptr && m_fileHandle.isWholeMapped()) {
+        // Plaintext pages refer to the whole mapping directly, and copying them ahead only costs.
+        return;
+    }
+    if (m_prefetcher == nullptr) {
+        m_arena.reset(new PageArena(m_pageSize, m_highWater));
+        m_prefetcher.reset(new PagePrefetcher([this](const std::vector<int>& numbers) {
+            return prefetchPageDatas(numbers);
+        }));
+    }
+    if (pagenos == m_hintedPagenos) {
+        m_prefetcher->advance(from);
+        return;
+    }
+    m_hintedPagenos = pagenos;
+    // The pages in wal or cache are skipped. They are checked here since the prefetcher should not visit them.
+    auto prefetchables = std::make_shared<std::vector<int>>(*pagenos);
+    for (int& number : *prefetchables) {
+        if (number <= 0 || number > m_numberOfPages || m_wal.containsPage(number)
+            || m_cache.exists(number)) {
+            number = 0;
+        }
+    }
+    m_prefetcher->hint(prefetchables, from);
+}
+
+std::vector<UnsafeData> Pager::prefetchPageDatas(const std::vector<int>& numbers)
+{
+    std::vector<UnsafeData> datas(numbers.size());
+    bool concurrent = m_pCodec != nullptr && !m_pConcurrentCodecs.empty();
+    int numberOfTasks = 1;
+    if (concurrent) {
+        numberOfTasks = (int) std::min(numbers.size(), m_pConcurrentCodecs.size());
+    }
+    WorkerPool::shared().parallel(numberOfTasks, [&](int index) {
+        // Each task has its own codec, since the decoded buffer of codec is reused.
+        void* pCodec = concurrent ? m_pConcurrentCodecs[index] : m_pCodec;
+        for (size_t i = index; i < numbers.size(); i += numberOfTasks) {
+            UnsafeData data = m_arena->allocatePage();
+            if (data.size() != (size_t) m_pageSize
+                || !m_fileHandle.readPageQuietly(numbers[i], data)) {
+                continue;
+            }
+            if (pCodec != nullptr) {
+                std::unique_lock<std::mutex> lockGuard(m_codecLock, std::defer_lock);
+                if (!concurrent) {
+                    lockGuard.lock();
+                }
+                void* decodedBuffer = sqlite3Codec(pCodec, data.buffer(), numbers[i], 4);
+                if (decodedBuffer == nullptr) {
+                    continue;
+                }
+                memcpy(data.buffer(), decodedBuffer, m_pageSize);
+            }
+            datas[i] = std::move(data);
+        }
+    });
+    return datas;
+}
+
 #pragma mark - Wal
 void Pager::setWalImportance(bool flag)
 {
@@ -253,6 +347,35 @@ bool Pager::containPageInWal(uint32_t pageno)
     return m_wal.containsPage(pageno);
 }
 
+#pragma mark - Mapping
+Pager::MappingStatistics Pager::getMappingStatistics() const
+{
+    return m_fileHandle.getStatistics();
+}
+
+void Pager::reportMappingStatistics() const
+{
+    if (!isInitialized()) {
+        return;
+    }
+    MappingStatistics statistics = getMappingStatistics();
+    if (statistics.numberOfMappedPages == 0) {
+        return;
+    }
+    Error error(Error::Code::Notice, Error::Level::Notice, "Pages are mapped.");
+    error.infos.insert_or_assign(ErrorStringKeySource, ErrorSourceRepair);
+    error.infos.insert_or_assign(ErrorStringKeyType, ErrorTypePageMapping);
+    error.infos.insert_or_assign(ErrorStringKeyAssociatePath, getPath());
+    error.infos.insert_or_assign("WholeMapped", (int) statistics.wholeMapped);
+    error.infos.insert_or_assign("Mmap", statistics.numberOfMaps);
+    error.infos.insert_or_assign("Munmap", statistics.numberOfUnmaps);
+    error.infos.insert_or_assign("MappedPages", statistics.numberOfMappedPages);
+    error.infos.insert_or_assign("MinorFaults", statistics.minorFaults);
+    error.infos.insert_or_assign("MajorFaults", statistics.majorFaults);
+    error.infos.insert_or_assign("FaultRate", statistics.faultRate());
+    Notifier::shared().notify(error);
+}
+
 #pragma mark - Error
 void Pager::markAsCorrupted(int page, const UnsafeStringView& message)
 {
@@ -27,7 +27,9 @@
 #include "ErrorProne.hpp"
 #include "HighWater.hpp"
 #include "Initializeable.hpp"
+#include "PageArena.hpp"
 #include "PageBasedFileHandle.hpp"
+#include "PagePrefetcher.hpp"
 #include "WCDBError.hpp"
 #include "Wal.hpp"
 
@@ -46,12 +48,17 @@ public:
     void setPageSize(int pageSize);
     void setReservedBytes(int reservedBytes);
     void setCipherContext(void* ctx);
+    // Those contexts decode the prefetched pages concurrently, one for each worker. They should have the same key and salt as the one of setCipherContext, and should not be used elsewhere during the lifetime of pager.
+    void setConcurrentCipherContexts(const std::vector<void*>& ctxs);
+    // Sequential for visiting pages in ascending order, and random for walking through b-trees. It can be changed between the phases of crawling.
+    void setAccessPattern(FileHandle::Advice advice);
 
     const StringView& getPath() const;
 
 protected:
     PageBasedFileHandle m_fileHandle;
     void* m_pCodec;
+    std::vector<void*> m_pConcurrentCodecs;
     friend class PagerRelated;
 
 #pragma mark - Page
@@ -67,6 +74,7 @@ public:
 
 protected:
     UnsafeData acquireHeader();
+    std::mutex m_codecLock; // the decoded buffer of codec is reused
     int m_pageSize;
     int m_reservedBytes;
     int m_numberOfPages;
@@ -98,6 +106,12 @@ protected:
     bool m_walImportance;
     bool m_skipWal;
 
+#pragma mark - Mapping
+public:
+    typedef PageBasedFileHandle::Statistics MappingStatistics;
+    MappingStatistics getMappingStatistics() const;
+    void reportMappingStatistics() const;
+
 #pragma mark - Error
 public:
     void markAsCorrupted(int page, const UnsafeStringView& message);
@@ -127,6 +141,20 @@ protected:
     void tryPurgeCache();
     Cache m_cache;
     SharedHighWater m_highWater;
+
+#pragma mark - Prefetch
+public:
+    // The crawler is going to visit pagenos[from], and then the following ones in order.
+    // It does nothing if the plaintext database is mapped as a whole, where the readahead of the mapping is enough.
+    void prefetchPages(const PagePrefetcher::Pagenos& pagenos, size_t from);
+
+protected:
+    // It runs on the thread of prefetcher. The pages are read and decoded into the arena concurrently if there are concurrent cipher contexts, and the failed ones are null.
+    std::vector<UnsafeData> prefetchPageDatas(const std::vector<int>& numbers);
+    PagePrefetcher::Pagenos m_hintedPagenos;
+    std::unique_ptr<PageArena> m_arena;
+    // It should be destructed before the others since its thread visits them.
+    std::unique_ptr<PagePrefetcher> m_prefetcher;
 };
 
 } //namespace Repair
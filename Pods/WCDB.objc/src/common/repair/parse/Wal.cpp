@@ -24,6 +24,7 @@
 
 #include "Wal.hpp"
 #include "Assertion.hpp"
+#include "Checksum.hpp"
 #include "CoreConst.h"
 #include "FileManager.hpp"
 #include "Frame.hpp"
@@ -184,29 +185,7 @@ Wal::calculateChecksum(const MappedData &data, const std::pair<uint32_t, uint32_
     WCTAssert(data.size() >= 8);
     WCTAssert((data.size() & 0x00000007) == 0);
 
-    const uint32_t *iter = reinterpret_cast<const uint32_t *>(data.buffer());
-    const uint32_t *end
-    = reinterpret_cast<const uint32_t *>(data.buffer() + data.size());
-
-    std::pair<uint32_t, uint32_t> result = checksum;
-
-    if (m_isNativeChecksum) {
-        do {
-            result.first += *iter++ + result.second;
-            result.second += *iter++ + result.first;
-        } while (iter < end);
-    } else {
-        do {
-#define BYTESWAP32(x)                                                          \
-    ((((x) & 0x000000FF) << 24) + (((x) & 0x0000FF00) << 8)                    \
-     + (((x) & 0x00FF0000) >> 8) + (((x) & 0xFF000000) >> 24))
-            result.first += BYTESWAP32(iter[0]) + result.second;
-            result.second += BYTESWAP32(iter[1]) + result.first;
-            iter += 2;
-        } while (iter < end);
-    }
-
-    return result;
+    return Checksum::wal(data.buffer(), data.size(), checksum, m_isNativeChecksum);
 }
 
 bool Wal::doInitialize()
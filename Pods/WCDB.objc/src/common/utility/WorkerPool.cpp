@@ -0,0 +1,132 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "WorkerPool.hpp"
+#include "Assertion.hpp"
+#include "CoreConst.h"
+#include "Thread.hpp"
+
+namespace WCDB {
+
+WorkerPool& WorkerPool::shared()
+{
+    static WorkerPool* s_pool = new WorkerPool(WorkerPoolName, WorkerPoolMaxNumberOfThreads);
+    return *s_pool;
+}
+
+WorkerPool::WorkerPool(const UnsafeStringView& name_, int maxNumberOfThreads)
+: name(name_), m_maxNumberOfThreads(maxNumberOfThreads), m_stopped(false)
+{
+    WCTAssert(m_maxNumberOfThreads >= 0);
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lockGuard(m_lock);
+        m_stopped = true;
+    }
+    m_pending.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+WorkerPool::Batch::Batch(const Task& task_, int numberOfTasks_)
+: task(task_), numberOfTasks(numberOfTasks_), next(0), numberOfFinished(0)
+{
+}
+
+void WorkerPool::parallel(int numberOfTasks, const Task& task)
+{
+    if (numberOfTasks <= 0) {
+        return;
+    }
+    if (numberOfTasks == 1 || m_maxNumberOfThreads == 0) {
+        for (int i = 0; i < numberOfTasks; ++i) {
+            task(i);
+        }
+        return;
+    }
+    std::shared_ptr<Batch> batch = std::make_shared<Batch>(task, numberOfTasks);
+    {
+        std::lock_guard<std::mutex> lockGuard(m_lock);
+        m_batches.push_back(batch);
+        int numberOfThreads = std::min(numberOfTasks - 1, m_maxNumberOfThreads);
+        while ((int) m_threads.size() < numberOfThreads) {
+            m_threads.emplace_back(&WorkerPool::loop, this);
+        }
+    }
+    m_pending.notify_all();
+
+    run(*batch);
+
+    std::unique_lock<std::mutex> lockGuard(m_lock);
+    m_finished.wait(lockGuard, [&batch]() {
+        return batch->numberOfFinished == batch->numberOfTasks;
+    });
+}
+
+void WorkerPool::run(Batch& batch)
+{
+    int index;
+    int numberOfFinished = 0;
+    while ((index = batch.next++) < batch.numberOfTasks) {
+        batch.task(index);
+        ++numberOfFinished;
+    }
+    if (numberOfFinished > 0) {
+        bool notify = false;
+        {
+            std::lock_guard<std::mutex> lockGuard(m_lock);
+            batch.numberOfFinished += numberOfFinished;
+            notify = batch.numberOfFinished == batch.numberOfTasks;
+        }
+        if (notify) {
+            m_finished.notify_all();
+        }
+    }
+}
+
+void WorkerPool::loop()
+{
+    Thread::setName(name);
+    while (true) {
+        std::shared_ptr<Batch> batch;
+        {
+            std::unique_lock<std::mutex> lockGuard(m_lock);
+            m_pending.wait(lockGuard, [this]() {
+                // All tasks of the front batch are taken by others.
+                while (!m_batches.empty()
+                       && m_batches.front()->next.load() >= m_batches.front()->numberOfTasks) {
+                    m_batches.pop_front();
+                }
+                return m_stopped || !m_batches.empty();
+            });
+            if (m_stopped) {
+                return;
+            }
+            batch = m_batches.front();
+        }
+        run(*batch);
+    }
+}
+
+} // namespace WCDB
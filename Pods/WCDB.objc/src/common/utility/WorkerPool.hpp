@@ -0,0 +1,73 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * WCDB available.
+ *
+ * Copyright (C) 2017 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Lock.hpp"
+#include "StringView.hpp"
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace WCDB {
+
+// Threads are created lazily and kept for reuse.
+class WorkerPool final {
+public:
+    WorkerPool(const UnsafeStringView& name, int maxNumberOfThreads);
+    ~WorkerPool();
+
+    WorkerPool() = delete;
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    static WorkerPool& shared();
+
+    const StringView name;
+
+    typedef std::function<void(int index)> Task;
+    // Run the task for each index in [0, numberOfTasks) concurrently, on the calling thread and the pooled threads.
+    // It returns after all of them are done.
+    void parallel(int numberOfTasks, const Task& task);
+
+private:
+    struct Batch {
+        Batch(const Task& task, int numberOfTasks);
+        const Task& task;
+        const int numberOfTasks;
+        std::atomic<int> next;
+        int numberOfFinished; // guarded by m_lock
+    };
+    void run(Batch& batch);
+    void loop();
+
+    const int m_maxNumberOfThreads;
+    std::mutex m_lock;
+    std::condition_variable m_pending;
+    std::condition_variable m_finished;
+    std::list<std::shared_ptr<Batch>> m_batches;
+    std::vector<std::thread> m_threads;
+    bool m_stopped;
+};
+
+} // namespace WCDB
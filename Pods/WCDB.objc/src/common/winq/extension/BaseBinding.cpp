@@ -264,7 +264,7 @@ bool BaseBinding::createTable(const UnsafeStringView &tableName, InnerHandle *ha
                 }
             }
             for (const auto &columnName : columnNames) {
-                if (columnName.hasPrefix(CompressionColumnTypePrefix)) {
+                if (WCDBIsCompressionColumn(columnName)) {
                     continue;
                 }
                 Error error(Error::Code::Mismatch, Error::Level::Notice, "Skip column");
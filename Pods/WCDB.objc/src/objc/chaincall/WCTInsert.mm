@@ -25,6 +25,8 @@
 #import "WCTInsert.h"
 #import "Assertion.hpp"
 #import "CaseInsensitiveList.hpp"
+#import "CoreConst.h"
+#import "FTSTokenCache.hpp"
 #import "WCTChainCall+Private.h"
 #import "WCTHandle+Private.h"
 #import "WCTHandle+Transaction.h"
@@ -36,6 +38,8 @@
     WCTProperties _properties;
     WCDB::StatementInsert _statement;
     NSArray<WCTObject *> *_values;
+    WCDB::FTSTokenCache _tokenCache;
+    std::vector<WCDB::StringView> _pretokenizedTexts;
 }
 
 - (instancetype)initWithHandle:(WCTHandle *)handle
@@ -94,10 +98,13 @@
     BOOL succeed = YES;
     if (_values.count > 0) {
         if (_values.count > 1) {
+            [self pretokenize];
             succeed = [_handle lazyRunTransaction:^BOOL(WCTHandle *handle) {
                 WCDB_UNUSED(handle);
                 return [self realExecute];
             }];
+            _tokenCache.clear();
+            _pretokenizedTexts.clear();
         } else {
             succeed = [self realExecute];
         }
@@ -106,6 +113,45 @@
     return succeed;
 }
 
+// Texts of the objects are tokenized before the transaction begins. It falls back to tokenize during insertion if anything fails.
+- (void)pretokenize
+{
+    WCDB::InnerHandle *handle = [_handle getOrGenerateHandle];
+    if (handle == nullptr || !handle->isFTSPretokenizeEnabled()
+        || !handle->prepareFTSTokenCache(_statement.syntax().table, _tokenCache)
+        || !_tokenCache.hasTokenizer()) {
+        return;
+    }
+    if (_properties.empty()) {
+        _properties = [_values.firstObject.class allProperties];
+    }
+    _pretokenizedTexts.reserve(_values.count * _properties.size());
+    int64_t index = 0;
+    for (WCTObject *value in _values) {
+        for (const WCTProperty &property : _properties) {
+            const std::shared_ptr<const WCTBaseAccessor> &accessor = property.getColumnBinding().getAccessor();
+            if (accessor->getColumnType() != WCDB::ColumnType::Text) {
+                continue;
+            }
+            if (accessor->getAccessorType() == WCTAccessorCpp) {
+                WCTCppAccessor<WCDB::ColumnType::Text> *textAccessor = (WCTCppAccessor<WCDB::ColumnType::Text> *) accessor.get();
+                _pretokenizedTexts.push_back(WCDB::StringView(textAccessor->getValue(value)));
+            } else {
+                NSString *text = (NSString *) ((WCTObjCAccessor *) accessor.get())->getObject(value);
+                if (text == nil) {
+                    continue;
+                }
+                _pretokenizedTexts.push_back(WCDB::StringView(text.UTF8String, [text lengthOfBytesUsingEncoding:NSUTF8StringEncoding]));
+            }
+            _tokenCache.addDocument(index, _pretokenizedTexts.back());
+        }
+        ++index;
+    }
+    if (!_tokenCache.tokenize(WCDB::FTSPretokenizeMaxNumberOfThreads)) {
+        _tokenCache.clear();
+    }
+}
+
 - (BOOL)realExecute
 {
     Class cls = _values.firstObject.class;
@@ -137,6 +183,8 @@
     if ([_handle prepare:_statement]) {
         succeed = YES;
 
+        BOOL pretokenized = _tokenCache.numberOfDocuments() > 0;
+        int64_t rowIndex = 0;
         for (WCTObject *value in _values) {
             [_handle reset];
             int index = 1;
@@ -170,7 +218,14 @@
                 }
                 ++index;
             }
-            if (![_handle step]) {
+            if (pretokenized) {
+                _tokenCache.activate(rowIndex++);
+            }
+            BOOL stepped = [_handle step];
+            if (pretokenized) {
+                WCDB::FTSTokenCache::deactivate();
+            }
+            if (!stepped) {
                 succeed = NO;
                 break;
             }
@@ -62,6 +62,21 @@ WCDB_API @interface WCTCompressionUserInfo : WCTCompressionBaseInfo
                   withMatchProperty:(const WCTProperty &)matchProperty
                       andMatchDicts:(NSDictionary<NSNumber * /* Value of match column */, NSNumber * /* ID of dict */> *)dictIds;
 
+/**
+ @brief Maintain sidecars of the specified compressing column, which are a digest of the content and the leading characters of the text.
+ Then the `=` comparing with literal values or bind parameters and the `LIKE`/`GLOB` matching with patterns that have a fixed prefix can filter rows by sidecars and only decompress the candidate rows.
+ @note It should be called after the property is configured to be compressed. Once enabled, it should not be disabled for the table, otherwise the sidecars may become stale.
+ */
+- (void)enableSidecarForProperty:(const WCTProperty &)property;
+
+/**
+ @brief Compress the values of the specified compressing column adaptively.
+ The values that are too small to be worth compressing will be stored uncompressed, and the compression level of the column without dict will be picked by the measured ratio and cpu cost.
+ The learned decisions are saved in a separate builtin table, and they don't affect reading the existing data.
+ @note It should be called after the property is configured to be compressed.
+ */
+- (void)enableAdaptiveCompressionForProperty:(const WCTProperty &)property;
+
 /**
  @brief Enable to replace original compression format.
  After activation, you can use `-[WCTDatabase stepCompression]` or `-[WCTDatabase enableAutoCompression:]` to recompress the existing data with the new compression configuration.
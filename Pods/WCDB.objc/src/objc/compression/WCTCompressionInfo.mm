@@ -86,6 +86,16 @@
     m_userInfo->addCompressingColumn(columnInfo);
 }
 
+- (void)enableSidecarForProperty:(const WCTProperty &)property
+{
+    m_userInfo->enableSidecar(property);
+}
+
+- (void)enableAdaptiveCompressionForProperty:(const WCTProperty &)property
+{
+    m_userInfo->enableAdaptiveCompression(property);
+}
+
 - (void)enableReplaceCompression
 {
     m_userInfo->enableReplaceCompresssion();
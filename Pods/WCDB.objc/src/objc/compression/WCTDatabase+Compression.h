@@ -43,6 +43,20 @@ typedef unsigned char WCTDictId;
  */
 typedef void (^WCTCompressdNotificationBlock)(WCTDatabase* _Nonnull database, WCTCompressionBaseInfo* _Nullable tableInfo);
 
+/**
+ The following are the keys in the statistics of the decompressed value cache.
+ */
+// The number of reads served by the cache.
+WCDB_EXTERN NSString* const WCTDecompressedValueCacheKeyHits;
+// The number of reads that had to decompress.
+WCDB_EXTERN NSString* const WCTDecompressedValueCacheKeyMisses;
+// Hits divided by all reads, or 0 before any read.
+WCDB_EXTERN NSString* const WCTDecompressedValueCacheKeyHitRate;
+// The total size in bytes of the decompressed values served by the cache.
+WCDB_EXTERN NSString* const WCTDecompressedValueCacheKeySavedBytes;
+// The memory in bytes currently used by the cache.
+WCDB_EXTERN NSString* const WCTDecompressedValueCacheKeyUsedBytes;
+
 WCDB_API @interface WCTDatabase(Compression)
 
 /**
@@ -72,6 +86,19 @@ WCDB_API @interface WCTDatabase(Compression)
  */
 + (BOOL)registerZSTDDict:(NSData*)dict andDictId:(WCTDictId)dictId;
 
+/**
+ @brief Set the memory budget of the decompressed values cached among all databases, 4MB by default.
+ @Note Reading the same compressed content repeatedly will hit the cache instead of decompressing it again.
+ @param budget size in bytes. 0 to disable the cache.
+ */
++ (void)setDecompressedValueCacheBudget:(NSUInteger)budget;
+
+/**
+ @brief Get the statistics of the decompressed values cached among all databases.
+ @return statistics keyed by `WCTDecompressedValueCacheKeyXXX`.
+ */
++ (NSDictionary<NSString*, NSNumber*>*)getDecompressedValueCacheStatistics;
+
 /**
  @brief Configure which tables in the current database need to compress data.
  Once configured, newly written data will be compressed immediately and synchronously,
@@ -123,6 +150,15 @@ WCDB_API @interface WCTDatabase(Compression)
  */
 - (BOOL)rollbackCompression:(nullable WCDB_ESCAPE WCTProgressUpdateBlock)onProgressUpdated;
 
+/**
+ @brief Decompress all compressed data in the database and resave them, the same as `-[WCTDatabase rollbackCompression:]`.
+ @note  If parallel is YES, the compressed data are decompressed by multiple threads in batches, while they are still resaved in a single thread.
+ The resaving will give way to the other handles that are waiting for the database lock, and the progress is reported by the count of rows resaved.
+ @param parallel decompress in parallel or not.
+ @return YES if all operation succeed.
+ */
+- (BOOL)rollbackCompression:(nullable WCDB_ESCAPE WCTProgressUpdateBlock)onProgressUpdated inParallel:(BOOL)parallel;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -30,6 +30,12 @@
 #import "WCTDatabase+Private.h"
 #import <Foundation/Foundation.h>
 
+NSString* const WCTDecompressedValueCacheKeyHits = @"Hits";
+NSString* const WCTDecompressedValueCacheKeyMisses = @"Misses";
+NSString* const WCTDecompressedValueCacheKeyHitRate = @"HitRate";
+NSString* const WCTDecompressedValueCacheKeySavedBytes = @"SavedBytes";
+NSString* const WCTDecompressedValueCacheKeyUsedBytes = @"UsedBytes";
+
 @implementation WCTDatabase (Compression)
 
 + (NSData*)trainDictWithStrings:(NSArray<NSString*>*)strings andDictId:(WCTDictId)dictId
@@ -73,6 +79,23 @@
     return WCDB::CompressionCenter::shared().registerDict(dictId, dict);
 }
 
++ (void)setDecompressedValueCacheBudget:(NSUInteger)budget
+{
+    WCDB::CompressionCenter::shared().setDecompressedValueCacheBudget(budget);
+}
+
++ (NSDictionary<NSString*, NSNumber*>*)getDecompressedValueCacheStatistics
+{
+    auto statistics = WCDB::CompressionCenter::shared().getDecompressedValueCacheStatistics();
+    return @{
+        WCTDecompressedValueCacheKeyHits : @(statistics.hits),
+        WCTDecompressedValueCacheKeyMisses : @(statistics.misses),
+        WCTDecompressedValueCacheKeyHitRate : @(statistics.hitRate()),
+        WCTDecompressedValueCacheKeySavedBytes : @(statistics.savedBytes),
+        WCTDecompressedValueCacheKeyUsedBytes : @(statistics.usedBytes),
+    };
+}
+
 - (void)setCompressionWithFilter:(WCTCompressionFilterBlock)filter
 {
     WCDB::InnerDatabase::CompressionTableFilter callback = nullptr;
@@ -85,6 +108,10 @@
         _database->setConfig(configName,
                              WCDB::CommonCore::shared().scalarFunctionConfig(WCDB::DecompressFunctionName),
                              WCDB::Configs::Priority::Higher);
+        configName = WCDB::StringView::formatted("%s%s", WCDB::ScalarFunctionConfigPrefix.data(), WCDB::DigestFunctionName.data());
+        _database->setConfig(configName,
+                             WCDB::CommonCore::shared().scalarFunctionConfig(WCDB::DigestFunctionName),
+                             WCDB::Configs::Priority::Higher);
     }
     _database->addCompression(callback);
 }
@@ -128,6 +155,11 @@
 }
 
 - (BOOL)rollbackCompression:(WCTProgressUpdateBlock)onProgressUpdated
+{
+    return [self rollbackCompression:onProgressUpdated inParallel:NO];
+}
+
+- (BOOL)rollbackCompression:(WCTProgressUpdateBlock)onProgressUpdated inParallel:(BOOL)parallel
 {
     WCDB::InnerDatabase::ProgressCallback callback = nullptr;
     if (onProgressUpdated != nil) {
@@ -135,7 +167,7 @@
             return onProgressUpdated(percentage, increment);
         };
     }
-    return _database->rollbackCompression(callback);
+    return _database->rollbackCompression(callback, parallel);
 }
 
 @end
@@ -34,4 +34,13 @@ public:
 
     static void configPinyinDict(NSDictionary<NSString*, NSArray<NSString*>*>* pinyinDict);
     static void configTraditionalChineseDict(NSDictionary<NSString*, NSString*>* traditionalChineseDict);
+
+    static bool compilePinyinDict(NSDictionary<NSString*, NSArray<NSString*>*>* pinyinDict, NSString* path);
+    static bool compileTraditionalChineseDict(NSDictionary<NSString*, NSString*>* traditionalChineseDict, NSString* path);
+    static bool configCompiledPinyinDict(NSString* path);
+    static bool configCompiledTraditionalChineseDict(NSString* path);
+
+private:
+    static WCDB::StringViewMap<std::vector<WCDB::StringView>>* createPinyinDict(NSDictionary<NSString*, NSArray<NSString*>*>* pinyinDict);
+    static WCDB::StringViewMap<WCDB::StringView>* createTraditionalChineseDict(NSDictionary<NSString*, NSString*>* traditionalChineseDict);
 };
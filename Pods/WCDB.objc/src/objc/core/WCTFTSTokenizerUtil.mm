@@ -23,6 +23,7 @@
  */
 
 #import "WCTFTSTokenizerUtil.h"
+#import "CompiledTokenizerDict.hpp"
 #import "WCTCommon.h"
 #import <CoreFoundation/CoreFoundation.h>
 #import <Foundation/Foundation.h>
@@ -72,7 +73,7 @@ void WCTFTSTokenizerUtil::configDefaultSymbolDetectorAndUnicodeNormalizer()
     });
 }
 
-void WCTFTSTokenizerUtil::configPinyinDict(NSDictionary<NSString*, NSArray<NSString*>*>* pinyinDict)
+WCDB::StringViewMap<std::vector<WCDB::StringView>>* WCTFTSTokenizerUtil::createPinyinDict(NSDictionary<NSString*, NSArray<NSString*>*>* pinyinDict)
 {
     WCDB::StringViewMap<std::vector<WCDB::StringView>>* cppPinyinDict = new WCDB::StringViewMap<std::vector<WCDB::StringView>>();
     for (NSString* character in pinyinDict.allKeys) {
@@ -91,10 +92,10 @@ void WCTFTSTokenizerUtil::configPinyinDict(NSDictionary<NSString*, NSArray<NSStr
             cppPinyinDict->insert_or_assign(key, value);
         }
     }
-    WCDB::BaseTokenizerUtil::configPinyinDict(cppPinyinDict);
+    return cppPinyinDict;
 }
 
-void WCTFTSTokenizerUtil::configTraditionalChineseDict(NSDictionary<NSString*, NSString*>* traditionalChineseDict)
+WCDB::StringViewMap<WCDB::StringView>* WCTFTSTokenizerUtil::createTraditionalChineseDict(NSDictionary<NSString*, NSString*>* traditionalChineseDict)
 {
     WCDB::StringViewMap<WCDB::StringView>* cppTraditionalChineseDict = new WCDB::StringViewMap<WCDB::StringView>();
     for (NSString* chinese in traditionalChineseDict.allKeys) {
@@ -104,5 +105,51 @@ void WCTFTSTokenizerUtil::configTraditionalChineseDict(NSDictionary<NSString*, N
         }
         cppTraditionalChineseDict->insert_or_assign(WCDB::StringView(chinese.UTF8String), WCDB::StringView(simplifiedChinese.UTF8String));
     }
-    WCDB::BaseTokenizerUtil::configTraditionalChineseDict(cppTraditionalChineseDict);
+    return cppTraditionalChineseDict;
+}
+
+void WCTFTSTokenizerUtil::configPinyinDict(NSDictionary<NSString*, NSArray<NSString*>*>* pinyinDict)
+{
+    WCDB::BaseTokenizerUtil::configPinyinDict(createPinyinDict(pinyinDict));
+}
+
+void WCTFTSTokenizerUtil::configTraditionalChineseDict(NSDictionary<NSString*, NSString*>* traditionalChineseDict)
+{
+    WCDB::BaseTokenizerUtil::configTraditionalChineseDict(createTraditionalChineseDict(traditionalChineseDict));
+}
+
+bool WCTFTSTokenizerUtil::compilePinyinDict(NSDictionary<NSString*, NSArray<NSString*>*>* pinyinDict, NSString* path)
+{
+    std::unique_ptr<WCDB::StringViewMap<std::vector<WCDB::StringView>>> cppPinyinDict(createPinyinDict(pinyinDict));
+    WCDB::Data compiled = WCDB::CompiledTokenizerDict::compile(*cppPinyinDict);
+    return !compiled.empty() && WCDB::CompiledTokenizerDict::save(compiled, path);
+}
+
+bool WCTFTSTokenizerUtil::compileTraditionalChineseDict(NSDictionary<NSString*, NSString*>* traditionalChineseDict, NSString* path)
+{
+    std::unique_ptr<WCDB::StringViewMap<WCDB::StringView>> cppTraditionalChineseDict(createTraditionalChineseDict(traditionalChineseDict));
+    WCDB::Data compiled = WCDB::CompiledTokenizerDict::compile(*cppTraditionalChineseDict);
+    return !compiled.empty() && WCDB::CompiledTokenizerDict::save(compiled, path);
+}
+
+bool WCTFTSTokenizerUtil::configCompiledPinyinDict(NSString* path)
+{
+    WCDB::CompiledTokenizerDict* dict = WCDB::CompiledTokenizerDict::load(WCDB::UnsafeStringView(path));
+    if (dict == nullptr || dict->type() != WCDB::CompiledTokenizerDict::Type::Pinyin) {
+        delete dict;
+        return false;
+    }
+    WCDB::BaseTokenizerUtil::configPinyinDict(dict);
+    return true;
+}
+
+bool WCTFTSTokenizerUtil::configCompiledTraditionalChineseDict(NSString* path)
+{
+    WCDB::CompiledTokenizerDict* dict = WCDB::CompiledTokenizerDict::load(WCDB::UnsafeStringView(path));
+    if (dict == nullptr || dict->type() != WCDB::CompiledTokenizerDict::Type::TraditionalChinese) {
+        delete dict;
+        return false;
+    }
+    WCDB::BaseTokenizerUtil::configTraditionalChineseDict(dict);
+    return true;
 }
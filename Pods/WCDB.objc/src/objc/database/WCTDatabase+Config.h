@@ -121,6 +121,15 @@ WCDB_API @interface WCTDatabase(Config)
  */
 - (void)enableLiteMode:(BOOL)enable;
 
+/**
+ @brief Enable/Disable group commit.
+ Group commit is disabled by default.
+ While it's enabled, the transactions run concurrently from different threads are merged into one transaction,
+ which shares one commit and reduces IO. Each of them runs in its own savepoint and succeeds or fails independently.
+ @warning The transactions might be run in other threads. And group commit does not work in lite mode.
+ */
+- (void)enableGroupCommit:(BOOL)enable;
+
 /**
  @brief Register custom scalar function.
  @Note  The custom scalar function needs to inherit `WCDB::AbstractScalarFunctionObject`.
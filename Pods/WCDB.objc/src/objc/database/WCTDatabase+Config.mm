@@ -100,6 +100,11 @@ static_assert((int) WCTConfigPriorityLow == (int) WCDB::Configs::Priority::Low,
     _database->setLiteModeEnable(enable);
 }
 
+- (void)enableGroupCommit:(BOOL)enable
+{
+    _database->setGroupCommitEnable(enable);
+}
+
 + (void)registerScalarFunction:(const WCDB::ScalarFunctionModule&)module named:(NSString*)name
 {
     WCDB::CommonCore::shared().registerScalarFunction(name, module);
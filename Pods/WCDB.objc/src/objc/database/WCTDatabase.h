@@ -108,6 +108,17 @@ WCDB_API @interface WCTDatabase : NSObject
  */
 - (BOOL)vacuum:(nullable WCDB_NO_ESCAPE WCTProgressUpdateBlock)onProgressUpdated;
 
+/**
+ @brief Vacuum current database, the same as `-[WCTDatabase vacuum:]`.
+ @note  If byPages is YES, the rowid tables are rebuilt by copying their b-tree pages instead of by SQL,
+ which writes the new database sequentially. It only works for the unencrypted database without auto vacuum,
+ and the tables that can't be rebuilt are still copied by SQL.
+ @param onProgressUpdated block.
+ @param byPages rebuild the rowid tables by pages or not.
+ @return YES if vacuum succeed.
+ */
+- (BOOL)vacuum:(nullable WCDB_NO_ESCAPE WCTProgressUpdateBlock)onProgressUpdated byPages:(BOOL)byPages;
+
 /**
  @brief The wrapper of `PRAGMA auto_vacuum`
  */
@@ -118,6 +129,14 @@ WCDB_API @interface WCTDatabase : NSObject
  */
 - (BOOL)incrementalVacuum:(int)pages;
 
+/**
+ @brief Configure to vacuum the database online in background.
+ It moves a bounded number of pages from the tail of file to the free pages in front in each step, and the foreground will not be blocked for long.
+ Since it only works with `PRAGMA auto_vacuum = INCREMENTAL`, the existing database should be vacuumed once by `-[WCTDatabase vacuum:]` after `-[WCTDatabase enableAutoVacuum:YES]`.
+ @param flag to enable auto incremental vacuum.
+ */
+- (void)enableAutoIncrementalVacuum:(BOOL)flag;
+
 /**
  @brief Get the most recent error for current database in the current thread.
         Since it is too cumbersome to get the error after every database operation, it‘s better to use monitoring interfaces to obtain database errors and print them to the log.
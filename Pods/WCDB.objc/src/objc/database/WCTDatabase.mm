@@ -113,6 +113,11 @@
 }
 
 - (BOOL)vacuum:(WCDB_NO_ESCAPE WCTProgressUpdateBlock)onProgressUpdated
+{
+    return [self vacuum:onProgressUpdated byPages:NO];
+}
+
+- (BOOL)vacuum:(WCDB_NO_ESCAPE WCTProgressUpdateBlock)onProgressUpdated byPages:(BOOL)byPages
 {
     WCDB::InnerDatabase::ProgressCallback callback = nullptr;
     if (onProgressUpdated != nil) {
@@ -120,7 +125,7 @@
             return onProgressUpdated(percentage, increment);
         };
     }
-    return _database->vacuum(callback);
+    return _database->vacuum(callback, byPages);
 }
 
 - (void)enableAutoVacuum:(BOOL)incremental
@@ -133,6 +138,11 @@
     return _database->incrementalVacuum(pages);
 }
 
+- (void)enableAutoIncrementalVacuum:(BOOL)flag
+{
+    WCDB::CommonCore::shared().enableAutoIncrementalVacuum(_database, flag);
+}
+
 - (WCTError *)error
 {
     return [[WCTError alloc] initWithError:_database->getThreadedError()];
@@ -97,6 +97,38 @@ WCDB_API @interface WCTDatabase(FTS)
  */
 - (void)enableAutoMergeFTS5Index:(BOOL)flag;
 
+/**
+ @brief Limit the time spent on auto-merge, in seconds of merging per second. The default budget is 0.2.
+ Within the budget, the tables whose merging saves the most query time will be merged first.
+ @param budget seconds of merging per second. Zero or negative value means unlimited.
+ */
+- (void)setAutoMergeFTS5IndexBudget:(double)budget;
+
+/**
+ @brief The number of fts5 index segments waiting for auto-merge. Each of them slows down the queries on its table.
+ */
+- (uint64_t)autoMergeFTS5IndexDebt;
+
+/**
+ @brief Enable to tokenize the texts of the objects in parallel before inserting them into a fts5 table, when more than one object are inserted at once.
+ It only works for the fts5 tables using a tokenizer implemented by WCDB or registered through `+[WCTDatabase registerTokenizer:named:]`. The tokenizer only replays the cached tokens while the write transaction is holding the lock, so the lock is released much earlier.
+ @param enable enable or not.
+ */
+- (void)enableFTS5Pretokenize:(BOOL)enable;
+
+/**
+ @brief Build the index of a fts5 table from a large amount of rows, such as importing data or rebuilding the table. It's much faster than inserting the rows one by one.
+ The automerge of the table is disabled while building, and all the segments are merged once at the end. If the table uses a tokenizer implemented by WCDB, the texts of each batch are tokenized in parallel before the batch is inserted in one transaction.
+ @Note  It can't be called in transaction.
+ @param tableName Name of the fts5 table.
+ @param columns Columns to insert the values of rows into. If the rowid is not one of them, the rows are given rowids after the existing ones.
+ @param provider Block to provide the next batch of rows, each of which contains the values of the columns in order. Return an empty array to finish, or nil to abort.
+ @return YES if succeed.
+ */
+- (BOOL)bulkBuildFTS5IndexOfTable:(NSString*)tableName
+                        onColumns:(const WCDB::Columns&)columns
+                 withRowsProvider:(WCTColumnsXRows* _Nullable (^)(void))provider;
+
 /**
  @brief Setup tokenizer with name for current database.
  @Note  You can set up the built-in tokenizers of sqlite and the tokenizers implemented by WCDB directly. If you want to use your custom tokenizer, you should firstly register it through `+[WCTDatabase registerTokenizer:named:]`.
@@ -141,6 +173,40 @@ WCDB_API @interface WCTDatabase(FTS)
  */
 + (void)configTraditionalChineseDict:(NSDictionary<NSString* /*Traditional Chinese character*/, NSString* /*Simplified Chinese character*/>*)traditionalChineseDict;
 
+/**
+ @brief Compile the pinyin mapping dictionary into a file, which can be mapped into memory and used without parsing by `+[WCTDatabase configPinYinDictWithCompiledPath:]`.
+ @Note  Only the keys with a single character are compiled.
+ @param pinyinDict Pinyin mapping dictionary.
+ @param path Path to save the compiled dictionary.
+ @return YES if succeed.
+ */
++ (BOOL)compilePinYinDict:(NSDictionary<NSString* /*Chinese character*/, NSArray<NSString*>*>* /*Pinyin array*/)pinyinDict toPath:(NSString*)path;
+
+/**
+ @brief Configure the mapping relationship between Chinese characters and their pinyin with a dictionary compiled by `+[WCTDatabase compilePinYinDict:toPath:]`. It uses less memory and is faster than `+[WCTDatabase configPinYinDict:]`.
+ @see   `WCTTokenizerPinyin`
+ @param path Path of the compiled dictionary.
+ @return NO if the file is not a valid compiled pinyin dictionary.
+ */
++ (BOOL)configPinYinDictWithCompiledPath:(NSString*)path;
+
+/**
+ @brief Compile the traditional Chinese mapping dictionary into a file, which can be mapped into memory and used without parsing by `+[WCTDatabase configTraditionalChineseDictWithCompiledPath:]`.
+ @Note  Only the keys with a single character are compiled.
+ @param traditionalChineseDict Traditional Chinese mapping dictionary.
+ @param path Path to save the compiled dictionary.
+ @return YES if succeed.
+ */
++ (BOOL)compileTraditionalChineseDict:(NSDictionary<NSString* /*Traditional Chinese character*/, NSString* /*Simplified Chinese character*/>*)traditionalChineseDict toPath:(NSString*)path;
+
+/**
+ @brief Configure the mapping relationship between traditional Chinese characters and simplified Chinese characters with a dictionary compiled by `+[WCTDatabase compileTraditionalChineseDict:toPath:]`.
+ @see   `WCTTokenizerParameter_SimplifyChinese`
+ @param path Path of the compiled dictionary.
+ @return NO if the file is not a valid compiled traditional Chinese dictionary.
+ */
++ (BOOL)configTraditionalChineseDictWithCompiledPath:(NSString*)path;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -46,6 +46,25 @@ NSString* const WCTModuleFTS5 = [NSString stringWithUTF8String:WCDB::Module::FTS
 
 NSString* const WCTAuxiliaryFunction_SubstringMatchInfo = [NSString stringWithUTF8String:WCDB::BuiltinAuxiliaryFunction::SubstringMatchInfo];
 
+// Values are copied since they are inserted after the autorelease pool of the batch is drained.
+static WCDB::Value WCTFTSBulkBuildValue(WCTValue* value)
+{
+    if ([value isKindOfClass:NSString.class]) {
+        NSString* string = value.stringValue;
+        return WCDB::StringView(string.UTF8String, [string lengthOfBytesUsingEncoding:NSUTF8StringEncoding]);
+    } else if ([value isKindOfClass:NSNumber.class]) {
+        NSNumber* number = value.numberValue;
+        if (CFNumberIsFloatType((CFNumberRef) number)) {
+            return (double) number.doubleValue;
+        }
+        return (int64_t) number.longLongValue;
+    } else if ([value isKindOfClass:NSData.class]) {
+        NSData* data = value.dataValue;
+        return WCDB::Data((const unsigned char*) data.bytes, (size_t) data.length);
+    }
+    return nullptr;
+}
+
 @implementation WCTDatabase (FTS)
 
 - (void)enableAutoMergeFTS5Index:(BOOL)flag
@@ -53,6 +72,47 @@ NSString* const WCTAuxiliaryFunction_SubstringMatchInfo = [NSString stringWithUT
     WCDB::CommonCore::shared().enableAutoMergeFTSIndex(_database, flag);
 }
 
+- (void)setAutoMergeFTS5IndexBudget:(double)budget
+{
+    _database->setMergeFTSIndexBudget(budget);
+}
+
+- (uint64_t)autoMergeFTS5IndexDebt
+{
+    return _database->getMergeFTSIndexDebt();
+}
+
+- (void)enableFTS5Pretokenize:(BOOL)enable
+{
+    _database->setFTSPretokenizeEnable(enable);
+}
+
+- (BOOL)bulkBuildFTS5IndexOfTable:(NSString*)tableName
+                        onColumns:(const WCDB::Columns&)columns
+                 withRowsProvider:(WCTColumnsXRows* (^)(void))provider
+{
+    WCTRemedialAssert(tableName.length > 0 && provider != nil, "Table name and rows provider can't be nil.", return NO;);
+    WCDB::InnerDatabase::FTSRowsProvider rowsProvider = [provider](WCDB::MultiRowsValue& rows) {
+        @autoreleasepool {
+            WCTColumnsXRows* batch = provider();
+            if (batch == nil) {
+                return false;
+            }
+            rows.reserve(batch.count);
+            for (WCTOneRow* row in batch) {
+                WCDB::OneRowValue values;
+                values.reserve(row.count);
+                for (WCTValue* value in row) {
+                    values.push_back(WCTFTSBulkBuildValue(value));
+                }
+                rows.push_back(std::move(values));
+            }
+            return true;
+        }
+    };
+    return _database->bulkBuildFTSIndex(tableName, columns, rowsProvider).succeed();
+}
+
 - (void)addTokenizer:(NSString*)tokenizerName
 {
     WCTFTSTokenizerUtil::configDefaultSymbolDetectorAndUnicodeNormalizer();
@@ -76,6 +136,26 @@ NSString* const WCTAuxiliaryFunction_SubstringMatchInfo = [NSString stringWithUT
     WCTFTSTokenizerUtil::configTraditionalChineseDict(traditionalChineseDict);
 }
 
++ (BOOL)compilePinYinDict:(NSDictionary<NSString*, NSArray<NSString*>*>*)pinyinDict toPath:(NSString*)path
+{
+    return WCTFTSTokenizerUtil::compilePinyinDict(pinyinDict, path);
+}
+
++ (BOOL)configPinYinDictWithCompiledPath:(NSString*)path
+{
+    return WCTFTSTokenizerUtil::configCompiledPinyinDict(path);
+}
+
++ (BOOL)compileTraditionalChineseDict:(NSDictionary<NSString*, NSString*>*)traditionalChineseDict toPath:(NSString*)path
+{
+    return WCTFTSTokenizerUtil::compileTraditionalChineseDict(traditionalChineseDict, path);
+}
+
++ (BOOL)configTraditionalChineseDictWithCompiledPath:(NSString*)path
+{
+    return WCTFTSTokenizerUtil::configCompiledTraditionalChineseDict(path);
+}
+
 - (void)addAuxiliaryFunction:(NSString*)auxiliaryFunctionName
 {
     WCDB::StringView configName = WCDB::StringView::formatted("%s%s", WCDB::AuxiliaryFunctionConfigPrefix.data(), auxiliaryFunctionName.UTF8String);
@@ -41,6 +41,12 @@ typedef void (^WCTMigrationFilterBlock)(WCTMigrationUserInfo*);
  */
 typedef void (^WCTMigratedNotificationBlock)(WCTDatabase* _Nonnull database, WCTMigrationBaseInfo* _Nullable tableInfo);
 
+/**
+ Triggered after each slice of migration of a table.
+ progress is in the range of [0, 1], and estimatedTime is the seconds to finish the table, which is negative if it's not estimated yet.
+ */
+typedef void (^WCTMigratingNotificationBlock)(WCTDatabase* _Nonnull database, WCTMigrationBaseInfo* _Nonnull tableInfo, double progress, double estimatedTime);
+
 WCDB_API @interface WCTDatabase(Migration)
 
 /**
@@ -59,13 +65,13 @@ WCDB_API @interface WCTDatabase(Migration)
           withFilter:(nullable WCDB_ESCAPE WCTMigrationFilterBlock)filter;
 
 /**
- @brief Manually spend about 0.01 sec. to migrate data. You can call this method periodically until all data is migrated.
+ @brief Manually spend about 0.1 sec. to migrate data. The tables to be migrated are migrated in turn, and it stops early once there are other operations waiting for the database. You can call this method periodically until all data is migrated.
  @return YES if no error occurred.
  */
 - (BOOL)stepMigration;
 
 /**
- @brief Configure the database to automatically step migration every two seconds.
+ @brief Configure the database to automatically step migration. The interval between steps is adapted to the load of the database, which is at most two seconds.
  @param flag to enable auto-migration.
  */
 - (void)enableAutoMigration:(BOOL)flag;
@@ -77,6 +83,13 @@ WCDB_API @interface WCTDatabase(Migration)
  */
 - (void)setNotificationWhenMigrated:(nullable WCDB_ESCAPE WCTMigratedNotificationBlock)onMigrated;
 
+/**
+ @brief Register a callback for the progress of migration. The callback will be called after each slice of migration of a table.
+ @param onMigrating block
+ @see   `WCTMigratingNotificationBlock`
+ */
+- (void)setNotificationWhenMigrating:(nullable WCDB_ESCAPE WCTMigratingNotificationBlock)onMigrating;
+
 /**
  @brief Check if all tables in the database has finished migration.
  @note  It only check an internal flag of database.
@@ -80,6 +80,19 @@
     _database->setNotificationWhenMigrated(callback);
 }
 
+- (void)setNotificationWhenMigrating:(WCTMigratingNotificationBlock)onMigrating
+{
+    WCDB::InnerDatabase::MigratingCallback callback = nullptr;
+    if (onMigrating != nil) {
+        callback = [onMigrating](WCDB::InnerDatabase* database, const WCDB::MigrationBaseInfo* info, const WCDB::MigrationProgress& progress) {
+            WCTMigrationBaseInfo* nsInfo = [[WCTMigrationBaseInfo alloc] initWithBaseInfo:*info];
+            WCTDatabase* nsDatabase = [[WCTDatabase alloc] initWithUnsafeDatabase:database];
+            onMigrating(nsDatabase, nsInfo, progress.getPercentage(), progress.estimatedTime);
+        };
+    }
+    _database->setNotificationWhenMigrating(callback);
+}
+
 - (BOOL)isMigrated
 {
     return _database->isMigrated();
@@ -81,6 +81,18 @@ WCDB_EXTERN NSString* const WCTDatabaseMonitorInfoKeyIndexCount;
 // The number of triggers in the current database.
 WCDB_EXTERN NSString* const WCTDatabaseMonitorInfoKeyTriggerCount;
 
+/**
+ The following are the keys in the histograms of busy waitings.
+ */
+// The number of waitings.
+WCDB_EXTERN NSString* const WCTDatabaseBusyWaitingKeyCount;
+// The total time in seconds spent on waiting.
+WCDB_EXTERN NSString* const WCTDatabaseBusyWaitingKeyTotalTime;
+// The longest time in seconds spent on a single waiting.
+WCDB_EXTERN NSString* const WCTDatabaseBusyWaitingKeyMaxTime;
+// An array of the numbers of waitings. The first one counts the waitings shorter than 1ms and the n-th one counts [2^(n-2), 2^(n-1)) ms. The last one counts all the longer waitings.
+WCDB_EXTERN NSString* const WCTDatabaseBusyWaitingKeyBuckets;
+
 WCDB_API @interface WCTDatabase(Monitor)
 
 /**
@@ -206,6 +218,13 @@ WCDB_API @interface WCTDatabase(Monitor)
  */
 + (void)globalTraceBusy:(nullable WCDB_ESCAPE WCTDatabaseBusyTraceBlock)trace withTimeOut:(double)timeOut;
 
+/**
+ @brief Histograms of the time that the handles of current database spent on waiting for the locks held by others in the current process.
+ They are keyed by the type of lock being waited for, e.g. `PagerReserved` and `ShmExclusive`. Keys of each histogram are `WCTDatabaseBusyWaitingKeyXXX`.
+ @return histograms of busy waitings.
+ */
+- (NSDictionary<NSString*, NSDictionary<NSString*, id>*>*)getBusyWaitingHistograms;
+
 @end
 
 NS_ASSUME_NONNULL_END
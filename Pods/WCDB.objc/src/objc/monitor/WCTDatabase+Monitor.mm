@@ -52,6 +52,11 @@ NSString* const WCTDatabaseMonitorInfoKeyTableCount = [NSString stringWithUTF8St
 NSString* const WCTDatabaseMonitorInfoKeyIndexCount = [NSString stringWithUTF8String:WCDB::k_MonitorInfoKeyIndexCount];
 NSString* const WCTDatabaseMonitorInfoKeyTriggerCount = [NSString stringWithUTF8String:WCDB::k_MonitorInfoKeyTriggerCount];
 
+NSString* const WCTDatabaseBusyWaitingKeyCount = @"Count";
+NSString* const WCTDatabaseBusyWaitingKeyTotalTime = @"TotalTime";
+NSString* const WCTDatabaseBusyWaitingKeyMaxTime = @"MaxTime";
+NSString* const WCTDatabaseBusyWaitingKeyBuckets = @"Buckets";
+
 @implementation WCTDatabase (Monitor)
 
 + (void)globalTraceError:(WCTErrorTraceBlock)block
@@ -188,4 +193,24 @@ NSString* const WCTDatabaseMonitorInfoKeyTriggerCount = [NSString stringWithUTF8
     }
 }
 
+- (NSDictionary<NSString*, NSDictionary<NSString*, id>*>*)getBusyWaitingHistograms
+{
+    auto histograms = WCDB::CommonCore::shared().getBusyWaitingHistograms(self.path);
+    NSMutableDictionary* nsHistograms = [[NSMutableDictionary alloc] initWithCapacity:histograms.size()];
+    for (const auto& iter : histograms) {
+        const auto& histogram = iter.second;
+        NSMutableArray* buckets = [[NSMutableArray alloc] initWithCapacity:WCDB::BusyRetryConfig::WaitingHistogram::NumberOfBuckets];
+        for (int i = 0; i < WCDB::BusyRetryConfig::WaitingHistogram::NumberOfBuckets; ++i) {
+            [buckets addObject:@(histogram.buckets[i])];
+        }
+        nsHistograms[[NSString stringWithView:iter.first]] = @{
+            WCTDatabaseBusyWaitingKeyCount : @(histogram.numberOfWaitings),
+            WCTDatabaseBusyWaitingKeyTotalTime : @(histogram.totalTime),
+            WCTDatabaseBusyWaitingKeyMaxTime : @(histogram.maxTime),
+            WCTDatabaseBusyWaitingKeyBuckets : buckets,
+        };
+    }
+    return nsHistograms;
+}
+
 @end